@@ -28,10 +28,13 @@
 // Class chunk id
 quint32 GLC_3DRep::m_ChunkId= 0xA702;
 
+QAtomicInt GLC_3DRep::m_NextBodiesRevision(0);
+
 GLC_3DRep::GLC_3DRep()
 : GLC_Rep()
 , m_pGeomList(new QList<GLC_Geometry*>)
 , m_pType(new int(GLC_Rep::GLC_VBOGEOM))
+, m_pBodiesRevision(new QAtomicInt(nextBodiesRevision()))
 {
 
 }
@@ -40,6 +43,7 @@ GLC_3DRep::GLC_3DRep(GLC_Geometry* pGeom)
 : GLC_Rep()
 , m_pGeomList(new QList<GLC_Geometry*>)
 , m_pType(new int(GLC_Rep::GLC_VBOGEOM))
+, m_pBodiesRevision(new QAtomicInt(nextBodiesRevision()))
 {
 	m_pGeomList->append(pGeom);
 	*m_pIsLoaded= true;
@@ -50,6 +54,7 @@ GLC_3DRep::GLC_3DRep(const GLC_3DRep& rep)
 : GLC_Rep(rep)
 , m_pGeomList(rep.m_pGeomList)
 , m_pType(rep.m_pType)
+, m_pBodiesRevision(rep.m_pBodiesRevision)
 {
 
 }
@@ -67,11 +72,14 @@ GLC_3DRep& GLC_3DRep::operator=(const GLC_Rep& rep)
             m_pGeomList= NULL;
             delete m_pType;
             m_pType= NULL;
+            delete m_pBodiesRevision;
+            m_pBodiesRevision= NULL;
         }
         GLC_Rep::operator=(rep);
 
 		m_pGeomList= p3DRep->m_pGeomList;
 		m_pType= p3DRep->m_pType;        
+		m_pBodiesRevision= p3DRep->m_pBodiesRevision;
 	}
 
 	return *this;
@@ -108,6 +116,9 @@ GLC_3DRep::~GLC_3DRep()
 
         delete m_pType;
         m_pType= NULL;
+
+        delete m_pBodiesRevision;
+        m_pBodiesRevision= NULL;
     }
 }
 
@@ -250,6 +261,7 @@ void GLC_3DRep::clean()
 		{
 			delete (*iGeomList);
 			iGeomList= m_pGeomList->erase(iGeomList);
+			bodiesChanged();
 		}
 		else
 		{
@@ -294,6 +306,7 @@ bool GLC_3DRep::load()
 				newRep.m_pGeomList->clear();
 				(*m_pIsLoaded)= true;
 				loadSucces= true;
+				bodiesChanged();
 			}
 		}
 	}
@@ -321,7 +334,9 @@ void GLC_3DRep::replace(GLC_Rep* pRep)
 			m_pGeomList->append(p3DRep->m_pGeomList->at(i));
 		}
 		p3DRep->m_pGeomList->clear();
+		p3DRep->bodiesChanged();
 		(*m_pIsLoaded)= true;
+		bodiesChanged();
 	}
 }
 
@@ -363,6 +378,7 @@ void GLC_3DRep::take(GLC_3DRep* pSource)
 		addGeom(pSource->geomAt(i));
 	}
 	pSource->m_pGeomList->clear();
+	pSource->bodiesChanged();
 }
 
 void GLC_3DRep::copyVboToClientSide()
@@ -397,6 +413,7 @@ void GLC_3DRep::transformSubGeometries(const GLC_Matrix4x4& matrix)
 			pCurrentMesh->transformVertice(matrix);
 		}
 	}
+	bodiesChanged();
 }
 
 void GLC_3DRep::setVboUsage(bool usage)
@@ -431,6 +448,7 @@ bool GLC_3DRep::unload()
 
 			(*m_pIsLoaded)= false;
 			unloadSucess= true;
+			bodiesChanged();
 		}
 	}
 	return unloadSucess;
@@ -448,6 +466,7 @@ void GLC_3DRep::clear3DRepGeom()
         delete (*m_pGeomList)[i];
     }
     m_pGeomList->clear();
+    bodiesChanged();
 }
 
 // Non Member methods
@@ -24,6 +24,8 @@
 #ifndef GLC_3DREP_H_
 #define GLC_3DREP_H_
 
+#include <QAtomicInt>
+
 #include "glc_geometry.h"
 #include "glc_rep.h"
 
@@ -127,6 +129,12 @@ public:
 	//! Return the volume of this 3DRep
 	double volume() const;
 
+	//! Return the revision of the bodies of this 3DRep
+	/*! The revision is shared by the copies of this 3DRep and changes each time
+	 *  their geometries are added, removed or transformed. Two different revisions are never equal*/
+	inline int bodiesRevision() const
+	{return m_pBodiesRevision->loadAcquire();}
+
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -139,6 +147,7 @@ public:
 	{
 		m_pGeomList->append(pGeom);
 		*m_pIsLoaded= true;
+		bodiesChanged();
 	}
 
 	//! Remove empty geometries and factorise materials
@@ -186,6 +195,14 @@ private:
     //! Clear current representation geometries
     void clear3DRepGeom();
 
+	//! Give a new revision to the bodies of this 3DRep
+	inline void bodiesChanged()
+	{m_pBodiesRevision->storeRelease(nextBodiesRevision());}
+
+	//! Return a revision never returned before
+	inline static int nextBodiesRevision()
+	{return m_NextBodiesRevision.fetchAndAddOrdered(1);}
+
 //////////////////////////////////////////////////////////////////////
 // Private members
 //////////////////////////////////////////////////////////////////////
@@ -196,9 +213,15 @@ private:
 	//! The Type of representation
 	int* m_pType;
 
+	//! The revision of the geometries
+	QAtomicInt* m_pBodiesRevision;
+
 	//! Class chunk id
 	static quint32 m_ChunkId;
 
+	//! The next revision of 3DRep bodies
+	static QAtomicInt m_NextBodiesRevision;
+
 };
 
 //! Non-member stream operator
@@ -25,6 +25,17 @@
 #include "../glc_fileformatexception.h"
 #include "../glc_tracelog.h"
 
+#include <QBuffer>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QAtomicInt>
+
+#include <cstring>
+
+#include "zlib.h"
+
 // The binary rep suffix
 const QString GLC_BSRep::m_Suffix("BSRep");
 
@@ -32,10 +43,55 @@ const QString GLC_BSRep::m_Suffix("BSRep");
 const QUuid GLC_BSRep::m_Uuid("{d6f97789-36a9-4c2e-b667-0e66c27f839f}");
 
 // The binary rep version
-const quint32 GLC_BSRep::m_Version= 103;
+const quint32 GLC_BSRep::m_Version= 104;
+
+// The size of a decoded chunk
+const quint32 GLC_BSRep::m_ChunkSize= 1 << 20;
 
-// Mutex used by compression
-QMutex GLC_BSRep::m_CompressionMutex;
+// The alignment of stored chunks in the file
+const quint64 GLC_BSRep::m_ChunkAlignment= 16;
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_BSRep::ChunkDecodingTask
+/*! \brief ChunkDecodingTask : Decode chunks until there is no more chunk to decode */
+//////////////////////////////////////////////////////////////////////
+class GLC_BSRep::ChunkDecodingTask : public QRunnable
+{
+public:
+	ChunkDecodingTask(const uchar* pData, const QVector<ChunkEntry>* pChunks, char* pOutput
+					  , QAtomicInt* pNextChunk, QAtomicInt* pErrorCount, QSemaphore* pFinished)
+		: QRunnable()
+		, m_pData(pData)
+		, m_pChunks(pChunks)
+		, m_pOutput(pOutput)
+		, m_pNextChunk(pNextChunk)
+		, m_pErrorCount(pErrorCount)
+		, m_pFinished(pFinished)
+	{}
+
+	virtual void run()
+	{
+		const int chunkCount= m_pChunks->size();
+		int chunkIndex= m_pNextChunk->fetchAndAddOrdered(1);
+		while (chunkIndex < chunkCount)
+		{
+			if (!GLC_BSRep::decodeChunk(m_pData, m_pChunks->at(chunkIndex), m_pOutput))
+			{
+				m_pErrorCount->fetchAndAddOrdered(1);
+			}
+			chunkIndex= m_pNextChunk->fetchAndAddOrdered(1);
+		}
+		if (NULL != m_pFinished) m_pFinished->release();
+	}
+
+private:
+	const uchar* m_pData;
+	const QVector<ChunkEntry>* m_pChunks;
+	char* m_pOutput;
+	QAtomicInt* m_pNextChunk;
+	QAtomicInt* m_pErrorCount;
+	QSemaphore* m_pFinished;
+};
 
 // Default constructor
 GLC_BSRep::GLC_BSRep(const QString& fileName, bool useCompression)
@@ -44,6 +100,7 @@ GLC_BSRep::GLC_BSRep(const QString& fileName, bool useCompression)
 , m_DataStream()
 , m_UseCompression(useCompression)
 , m_CompressionLevel(-1)
+, m_FileVersion(m_Version)
 {
 	setAbsoluteFileName(fileName);
 	m_DataStream.setVersion(QDataStream::Qt_4_6);
@@ -57,6 +114,7 @@ GLC_BSRep::GLC_BSRep(const GLC_BSRep& binaryRep)
 , m_DataStream()
 , m_UseCompression(binaryRep.m_UseCompression)
 , m_CompressionLevel(binaryRep.m_CompressionLevel)
+, m_FileVersion(binaryRep.m_FileVersion)
 {
 	m_DataStream.setVersion(QDataStream::Qt_4_6);
 	m_DataStream.setFloatingPointPrecision(binaryRep.m_DataStream.floatingPointPrecision());
@@ -111,26 +169,34 @@ GLC_3DRep GLC_BSRep::loadRep(QFile *pFile)
 			timeStampOk(QDateTime());
 			GLC_BoundingBox boundingBox;
 			m_DataStream >> boundingBox;
-			bool useCompression;
-			m_DataStream >> useCompression;
-			if (useCompression)
+			bool loadOk= true;
+			if (m_FileVersion > 103)
 			{
-				QByteArray CompresseBuffer;
-				m_DataStream >> CompresseBuffer;
-				QByteArray uncompressedBuffer= qUncompress(CompresseBuffer);
-				uncompressedBuffer.squeeze();
-				CompresseBuffer.clear();
-				CompresseBuffer.squeeze();
-				QDataStream bufferStream(uncompressedBuffer);
-				bufferStream >> loadedRep;
+				loadOk= loadChunkedRep(&loadedRep);
 			}
 			else
 			{
-				m_DataStream >> loadedRep;
+				bool useCompression;
+				m_DataStream >> useCompression;
+				if (useCompression)
+				{
+					QByteArray CompresseBuffer;
+					m_DataStream >> CompresseBuffer;
+					QByteArray uncompressedBuffer= qUncompress(CompresseBuffer);
+					uncompressedBuffer.squeeze();
+					CompresseBuffer.clear();
+					CompresseBuffer.squeeze();
+					QDataStream bufferStream(uncompressedBuffer);
+					bufferStream >> loadedRep;
+				}
+				else
+				{
+					m_DataStream >> loadedRep;
+				}
 			}
 			loadedRep.setFileName(m_FileInfo.filePath());
 
-			if (!close())
+			if (!close() || !loadOk)
 			{
 				QString message(QString("GLC_BSRep::loadRep An error occur when loading file ") + m_FileInfo.fileName());
 				GLC_FileFormatException fileFormatException(message, m_FileInfo.fileName(), GLC_FileFormatException::WrongFileFormat);
@@ -202,38 +268,25 @@ void GLC_BSRep::setAbsoluteFileName(const QString& fileName)
 
 // Save the GLC_3DRep in serialised binary
 bool GLC_BSRep::save(const GLC_3DRep& rep)
+{
+	return save(rep.lastModified(), rep.boundingBox(), serializedRep(rep));
+}
+
+// Save the given serialized representation
+bool GLC_BSRep::save(const QDateTime& lastModified, const GLC_BoundingBox& boundingBox, const QByteArray& repBuffer)
 {
 
 	//! Check if the currentFileInfo is valid and writable
     bool saveOk= open(QIODevice::WriteOnly, NULL);
 	if (saveOk)
 	{
-		writeHeader(rep.lastModified());
+		writeHeader(lastModified);
 
 		// Representation Bounding Box
-		m_DataStream << rep.boundingBox();
+		m_DataStream << boundingBox;
 
-		// Compression usage
-
-		if (m_UseCompression && (rep.faceCount() < 1000000))
-		{
-			m_DataStream << true;
-			QByteArray uncompressedBuffer;
-			{
-				QBuffer buffer(&uncompressedBuffer);
-				buffer.open(QIODevice::WriteOnly);
-				QDataStream bufferStream(&buffer);
-				bufferStream << rep;
-			}
-			m_DataStream << qCompress(uncompressedBuffer, m_CompressionLevel);
-		}
-		else
-		{
-			m_DataStream << false;
-			// Binary representation geometry
-			// Add the rep
-			m_DataStream << rep;
-		}
+		// Add the rep by chunks, compressed if compression is used
+		writeChunks(repBuffer);
 
 		// Flag the file
 		qint64 offset= sizeof(QUuid);
@@ -248,6 +301,21 @@ bool GLC_BSRep::save(const GLC_3DRep& rep)
 	return saveOk;
 }
 
+// Return the given representation serialized in the binary rep stream format
+QByteArray GLC_BSRep::serializedRep(const GLC_3DRep& rep)
+{
+	QByteArray repBuffer;
+	QBuffer buffer(&repBuffer);
+	buffer.open(QIODevice::WriteOnly);
+	QDataStream bufferStream(&buffer);
+	bufferStream.setVersion(QDataStream::Qt_4_6);
+	bufferStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+	bufferStream.setByteOrder(QDataStream::LittleEndian);
+	bufferStream << rep;
+
+	return repBuffer;
+}
+
 
 // Open the file
 bool GLC_BSRep::open(QIODevice::OpenMode mode, QFile* pFile)
@@ -335,6 +403,7 @@ bool GLC_BSRep::headerIsOk()
 	m_DataStream.setVersion(QDataStream::Qt_4_6);
 
 	bool headerOk= (uuid == m_Uuid) && (version <= m_Version) && (version > 101) && writeFinished;
+	m_FileVersion= version;
 
 	return headerOk;
 }
@@ -353,3 +422,210 @@ bool GLC_BSRep::timeStampOk(const QDateTime& timeStamp)
 	return timeStampOk;
 }
 
+// Write the given serialised representation as a table of chunks followed by aligned chunks
+void GLC_BSRep::writeChunks(const QByteArray& buffer)
+{
+	Q_ASSERT(m_pFile != NULL);
+	Q_ASSERT(m_DataStream.device() != NULL);
+
+	const quint64 bufferSize= static_cast<quint64>(buffer.size());
+
+	// Build chunks, without compression the buffer is stored in one chunk to be mapped at once
+	QVector<ChunkEntry> chunks;
+	QList<QByteArray> compressedChunks;
+	const quint64 chunkSize= m_UseCompression ? m_ChunkSize : qMax(bufferSize, quint64(1));
+	for (quint64 rawOffset= 0; rawOffset < bufferSize; rawOffset+= chunkSize)
+	{
+		ChunkEntry chunk;
+		chunk.m_Offset= 0;
+		chunk.m_RawOffset= rawOffset;
+		chunk.m_RawSize= static_cast<quint32>(qMin(chunkSize, bufferSize - rawOffset));
+		chunk.m_StoredSize= chunk.m_RawSize;
+		chunk.m_IsCompressed= false;
+
+		QByteArray compressedChunk;
+		if (m_UseCompression)
+		{
+			uLongf compressedSize= compressBound(chunk.m_RawSize);
+			compressedChunk.resize(static_cast<int>(compressedSize));
+			const int result= compress2(reinterpret_cast<Bytef*>(compressedChunk.data()), &compressedSize
+					, reinterpret_cast<const Bytef*>(buffer.constData() + rawOffset), chunk.m_RawSize, m_CompressionLevel);
+
+			// Keep the raw chunk if compression is useless
+			if ((Z_OK == result) && (compressedSize < chunk.m_RawSize))
+			{
+				compressedChunk.resize(static_cast<int>(compressedSize));
+				chunk.m_StoredSize= static_cast<quint32>(compressedSize);
+				chunk.m_IsCompressed= true;
+			}
+			else
+			{
+				compressedChunk.clear();
+			}
+		}
+		chunks.append(chunk);
+		compressedChunks.append(compressedChunk);
+	}
+
+	// The chunk table : buffer size, chunk count and 25 bytes per chunk
+	const quint32 chunkCount= static_cast<quint32>(chunks.size());
+	const quint64 tableEnd= static_cast<quint64>(m_pFile->pos()) + sizeof(quint64) + sizeof(quint32) + 25 * chunkCount;
+	quint64 offset= tableEnd;
+	for (quint32 i= 0; i < chunkCount; ++i)
+	{
+		offset= ((offset + m_ChunkAlignment - 1) / m_ChunkAlignment) * m_ChunkAlignment;
+		chunks[i].m_Offset= offset;
+		offset+= chunks.at(i).m_StoredSize;
+	}
+
+	m_DataStream << bufferSize;
+	m_DataStream << chunkCount;
+	for (quint32 i= 0; i < chunkCount; ++i)
+	{
+		const ChunkEntry& chunk= chunks.at(i);
+		m_DataStream << chunk.m_Offset << chunk.m_StoredSize << chunk.m_RawSize << chunk.m_RawOffset << chunk.m_IsCompressed;
+	}
+	Q_ASSERT(static_cast<quint64>(m_pFile->pos()) == tableEnd);
+
+	// The aligned chunks
+	for (quint32 i= 0; i < chunkCount; ++i)
+	{
+		const ChunkEntry& chunk= chunks.at(i);
+		const qint64 padding= static_cast<qint64>(chunk.m_Offset) - m_pFile->pos();
+		if (padding > 0)
+		{
+			m_pFile->write(QByteArray(static_cast<int>(padding), '\0'));
+		}
+		if (chunk.m_IsCompressed)
+		{
+			m_pFile->write(compressedChunks.at(i));
+		}
+		else
+		{
+			m_pFile->write(buffer.constData() + chunk.m_RawOffset, chunk.m_RawSize);
+		}
+	}
+}
+
+// Load the given rep from the chunks of the file (Version 104 and more)
+bool GLC_BSRep::loadChunkedRep(GLC_3DRep* pRep)
+{
+	Q_ASSERT(m_pFile != NULL);
+	Q_ASSERT(m_DataStream.device() != NULL);
+
+	quint64 bufferSize;
+	quint32 chunkCount;
+	m_DataStream >> bufferSize;
+	m_DataStream >> chunkCount;
+
+	const quint64 fileSize= static_cast<quint64>(m_pFile->size());
+	bool chunksOk= (m_DataStream.status() == QDataStream::Ok) && (bufferSize < quint64(0x7FFFFFFF)) && ((25 * quint64(chunkCount)) < fileSize);
+	QVector<ChunkEntry> chunks;
+	if (chunksOk)
+	{
+		chunks.resize(chunkCount);
+		quint64 rawOffset= 0;
+		for (quint32 i= 0; chunksOk && (i < chunkCount); ++i)
+		{
+			ChunkEntry& chunk= chunks[i];
+			m_DataStream >> chunk.m_Offset >> chunk.m_StoredSize >> chunk.m_RawSize >> chunk.m_RawOffset >> chunk.m_IsCompressed;
+			chunksOk= (m_DataStream.status() == QDataStream::Ok) && (chunk.m_RawOffset == rawOffset)
+					&& ((chunk.m_Offset + chunk.m_StoredSize) <= fileSize)
+					&& (chunk.m_IsCompressed || (chunk.m_StoredSize == chunk.m_RawSize));
+			rawOffset+= chunk.m_RawSize;
+		}
+		chunksOk= chunksOk && (rawOffset == bufferSize);
+	}
+	if (!chunksOk) return false;
+
+	// Map the file in memory, read it at once if mapping is not supported
+	uchar* pMappedData= m_pFile->map(0, m_pFile->size());
+	QByteArray fileContent;
+	const uchar* pData= pMappedData;
+	if (NULL == pMappedData)
+	{
+		const qint64 position= m_pFile->pos();
+		m_pFile->seek(0);
+		fileContent= m_pFile->readAll();
+		m_pFile->seek(position);
+		pData= reinterpret_cast<const uchar*>(fileContent.constData());
+		chunksOk= static_cast<quint64>(fileContent.size()) == fileSize;
+	}
+
+	if (chunksOk)
+	{
+		// A single raw chunk is read in place
+		QByteArray repBuffer;
+		if ((1 == chunkCount) && !chunks.at(0).m_IsCompressed)
+		{
+			repBuffer= QByteArray::fromRawData(reinterpret_cast<const char*>(pData + chunks.at(0).m_Offset), static_cast<int>(bufferSize));
+		}
+		else
+		{
+			repBuffer.resize(static_cast<int>(bufferSize));
+			chunksOk= decodeChunks(pData, chunks, repBuffer.data());
+		}
+
+		if (chunksOk)
+		{
+			QDataStream bufferStream(repBuffer);
+			bufferStream.setVersion(QDataStream::Qt_4_6);
+			bufferStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+			bufferStream.setByteOrder(QDataStream::LittleEndian);
+			bufferStream >> *pRep;
+			chunksOk= bufferStream.status() == QDataStream::Ok;
+		}
+	}
+
+	if (NULL != pMappedData) m_pFile->unmap(pMappedData);
+
+	return chunksOk;
+}
+
+// Decode the given chunks of the given data into the given output on available threads
+bool GLC_BSRep::decodeChunks(const uchar* pData, const QVector<ChunkEntry>& chunks, char* pOutput)
+{
+	QAtomicInt nextChunk(0);
+	QAtomicInt errorCount(0);
+	QSemaphore finishedTasks;
+
+	// Helper tasks are only started if a thread is free, the calling thread decode chunks too
+	int startedTaskCount= 0;
+	const int helperCount= qMin(chunks.size(), QThread::idealThreadCount()) - 1;
+	for (int i= 0; i < helperCount; ++i)
+	{
+		ChunkDecodingTask* pTask= new ChunkDecodingTask(pData, &chunks, pOutput, &nextChunk, &errorCount, &finishedTasks);
+		if (QThreadPool::globalInstance()->tryStart(pTask))
+		{
+			++startedTaskCount;
+		}
+		else
+		{
+			delete pTask;
+			break;
+		}
+	}
+
+	ChunkDecodingTask callerTask(pData, &chunks, pOutput, &nextChunk, &errorCount, NULL);
+	callerTask.run();
+	finishedTasks.acquire(startedTaskCount);
+
+	return 0 == errorCount.load();
+}
+
+// Decode the given chunk of the given data into the given output
+bool GLC_BSRep::decodeChunk(const uchar* pData, const ChunkEntry& chunk, char* pOutput)
+{
+	bool decodeOk= true;
+	if (chunk.m_IsCompressed)
+	{
+		uLongf rawSize= chunk.m_RawSize;
+		const int result= uncompress(reinterpret_cast<Bytef*>(pOutput + chunk.m_RawOffset), &rawSize, pData + chunk.m_Offset, chunk.m_StoredSize);
+		decodeOk= (Z_OK == result) && (rawSize == chunk.m_RawSize);
+	}
+	else
+	{
+		memcpy(pOutput + chunk.m_RawOffset, pData + chunk.m_Offset, chunk.m_RawSize);
+	}
+	return decodeOk;
+}
@@ -29,7 +29,7 @@
 #include <QDataStream>
 #include <QUuid>
 #include <QDateTime>
-#include <QMutex>
+#include <QVector>
 
 #include "../glc_config.h"
 #include "glc_3drep.h"
@@ -40,6 +40,25 @@
 //////////////////////////////////////////////////////////////////////
 class GLC_LIB_EXPORT GLC_BSRep
 {
+	//! \struct ChunkEntry
+	/*! \brief ChunkEntry : Location of a block of the serialised representation */
+	struct ChunkEntry
+	{
+		//! Offset of the stored block from the begining of the file
+		quint64 m_Offset;
+		//! Size of the stored block
+		quint32 m_StoredSize;
+		//! Size of the decoded block
+		quint32 m_RawSize;
+		//! Offset of the decoded block in the serialised representation
+		quint64 m_RawOffset;
+		//! Flag to know if the stored block is compressed
+		bool m_IsCompressed;
+	};
+
+	//! Task used to decode chunks in a worker thread
+	class ChunkDecodingTask;
+
 //////////////////////////////////////////////////////////////////////
 /*! @name Constructor */
 //@{
@@ -78,6 +97,10 @@ public:
 
 	//! Return bsrep version
 	static quint32 version();
+
+	//! Return the given representation serialized in the binary rep stream format
+	/*! The result can be saved later, from any thread, with save(QDateTime, GLC_BoundingBox, QByteArray)*/
+	static QByteArray serializedRep(const GLC_3DRep&);
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -91,6 +114,9 @@ public:
 	//! Save the GLC_3DRep in serialised binary
 	bool save(const GLC_3DRep&);
 
+	//! Save the given serialized representation with the given time stamp and bounding box
+	bool save(const QDateTime&, const GLC_BoundingBox&, const QByteArray&);
+
 	//! Set the compression usage for saving a 3DREP in binary format
 	inline void setCompressionUsage(bool usage)
 	{m_UseCompression= usage;}
@@ -121,6 +147,18 @@ private:
 	//! Check the time Stamp
 	bool timeStampOk(const QDateTime&);
 
+	//! Write the given serialised representation as a table of chunks followed by aligned chunks
+	void writeChunks(const QByteArray& buffer);
+
+	//! Load the given rep from the chunks of the file (Version 104 and more)
+	bool loadChunkedRep(GLC_3DRep* pRep);
+
+	//! Decode the given chunks of the given data into the given output on available threads
+	static bool decodeChunks(const uchar* pData, const QVector<ChunkEntry>& chunks, char* pOutput);
+
+	//! Decode the given chunk of the given data into the given output
+	static bool decodeChunk(const uchar* pData, const ChunkEntry& chunk, char* pOutput);
+
 //////////////////////////////////////////////////////////////////////
 // Private members
 //////////////////////////////////////////////////////////////////////
@@ -134,6 +172,12 @@ private:
 	//! The binary rep version
 	static const quint32 m_Version;
 
+	//! The size of a decoded chunk
+	static const quint32 m_ChunkSize;
+
+	//! The alignment of stored chunks in the file
+	static const quint64 m_ChunkAlignment;
+
 	//! the Binary representation file informations
 	QFileInfo m_FileInfo;
 
@@ -149,8 +193,8 @@ private:
 	//! The compression level
 	int m_CompressionLevel;
 
-	//! Compression Mutex
-	static QMutex m_CompressionMutex;
+	//! The version of the opened file
+	quint32 m_FileVersion;
 
 };
 
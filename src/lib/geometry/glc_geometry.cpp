@@ -293,6 +293,7 @@ void GLC_Geometry::render(const GLC_RenderProperties& renderProperties)
 			glPropGeom(renderProperties);
 		}
 
+		GLC_ContextManager::instance()->currentContext()->updateMatrixUniforms();
 		glDraw(renderProperties);
 
 		m_IsSelected= false;
@@ -27,6 +27,8 @@
 #include "../glc_context.h"
 #include "../glc_contextmanager.h"
 
+#include <QOpenGLExtraFunctions>
+
 // Class chunk id
 quint32 GLC_Mesh::m_ChunkId= 0xA701;
 
@@ -257,6 +259,32 @@ IndexList GLC_Mesh::getEquivalentTrianglesStripsFansIndex(int lod, GLC_uint mate
 	return subject;
 }
 
+int GLC_Mesh::coarsestLod(double maximumAccuracy) const
+{
+	int lod= m_MeshData.lodCount() - 1;
+	while ((lod > 0) && (m_MeshData.getLod(lod)->accuracy() > maximumAccuracy)) --lod;
+
+	return qMax(lod, 0);
+}
+
+int GLC_Mesh::lodIndexOf(int lodValue) const
+{
+	// LOD values from 0 to 100 are spread over the LOD of the mesh
+	const int numberOfLod= m_MeshData.lodCount();
+	const int lod= (lodValue * numberOfLod) / 100;
+
+	return qBound(0, lod, qMax(numberOfLod - 1, 0));
+}
+
+int GLC_Mesh::lodValueOf(int lod) const
+{
+	const int numberOfLod= m_MeshData.lodCount();
+	if ((lod <= 0) || (numberOfLod < 2)) return 0;
+
+	lod= qMin(lod, numberOfLod - 1);
+	return qMin(((100 * lod) + numberOfLod - 1) / numberOfLod, 100);
+}
+
 // Return the number of triangles
 int GLC_Mesh::numberOfTriangles(int lod, GLC_uint materialId) const
 {
@@ -746,18 +774,7 @@ void GLC_Mesh::finish()
 // Set the lod Index
 void GLC_Mesh::setCurrentLod(const int value)
 {
-	if (value)
-	{
-		const int numberOfLod= m_MeshData.lodCount();
-		// Clamp value to number of load
-		m_CurrentLod= static_cast<int>((static_cast<double>(value) / 100.0) * numberOfLod);
-		if (m_CurrentLod >= numberOfLod) m_CurrentLod = numberOfLod - 1;
-		if (m_CurrentLod < 0) m_CurrentLod = 0;
-	}
-	else
-	{
-		m_CurrentLod= 0;
-	}
+	m_CurrentLod= lodIndexOf(value);
 }
 // Replace the Master material
 void GLC_Mesh::replaceMasterMaterial(GLC_Material* pMat)
@@ -1100,6 +1117,102 @@ void GLC_Mesh::glDraw(const GLC_RenderProperties& renderProperties)
 	GLC_RenderStatistics::addTriangles(m_MeshData.trianglesCount(m_CurrentLod));
 }
 
+void GLC_Mesh::beginPrimitiveGroupsRendering(int lod)
+{
+	Q_ASSERT(m_GeometryIsValid || !m_MeshData.positionSizeIsSet());
+	Q_ASSERT(!m_ColorPearVertex && !m_IsSelected);
+	m_CurrentLod= lod;
+
+	if (GLC_Geometry::vboIsUsed())
+	{
+		m_MeshData.createVBOs();
+
+		// Create VBO and IBO
+		if (!m_GeometryIsValid && !m_MeshData.positionSizeIsSet())
+		{
+			fillVbosAndIbos();
+		}
+
+		// Activate mesh VBOs and IBO of the current LOD
+		activateVboAndIbo();
+	}
+	else
+	{
+		if (!m_GeometryIsValid)
+		{
+			m_MeshData.initPositionSize();
+		}
+		activateVertexArray();
+	}
+	m_GeometryIsValid= true;
+}
+
+void GLC_Mesh::drawPrimitiveGroup(GLC_PrimitiveGroup* pGroup)
+{
+	GLC_ContextManager::instance()->currentContext()->updateMatrixUniforms();
+	if (GLC_Geometry::vboIsUsed())
+	{
+		vboDrawPrimitivesOf(pGroup);
+	}
+	else
+	{
+		vertexArrayDrawPrimitivesOf(pGroup);
+	}
+}
+
+void GLC_Mesh::drawPrimitiveGroupInstanced(GLC_PrimitiveGroup* pGroup, int instanceCount)
+{
+	QOpenGLExtraFunctions* pGlFunctions= QOpenGLContext::currentContext()->extraFunctions();
+
+	// With VBO the indexes are offsets in the IBO
+	const bool useVbo= GLC_Geometry::vboIsUsed();
+	const GLuint* pIndexData= useVbo ? NULL : m_MeshData.indexVectorHandle(m_CurrentLod)->constData();
+
+	// Draw triangles
+	if (pGroup->containsTriangles())
+	{
+		const GLvoid* pOffset= useVbo ? pGroup->trianglesIndexOffset() : &pIndexData[pGroup->trianglesIndexOffseti()];
+		pGlFunctions->glDrawElementsInstanced(GL_TRIANGLES, pGroup->trianglesIndexSize(), GL_UNSIGNED_INT, pOffset, instanceCount);
+	}
+
+	// Draw Triangles strip
+	if (pGroup->containsStrip())
+	{
+		const GLsizei stripsCount= static_cast<GLsizei>(pGroup->stripsSizes().size());
+		for (GLint i= 0; i < stripsCount; ++i)
+		{
+			const GLvoid* pOffset= useVbo ? pGroup->stripsOffset().at(i) : &pIndexData[pGroup->stripsOffseti().at(i)];
+			pGlFunctions->glDrawElementsInstanced(GL_TRIANGLE_STRIP, pGroup->stripsSizes().at(i), GL_UNSIGNED_INT, pOffset, instanceCount);
+		}
+	}
+
+	// Draw Triangles fan
+	if (pGroup->containsFan())
+	{
+		const GLsizei fansCount= static_cast<GLsizei>(pGroup->fansSizes().size());
+		for (GLint i= 0; i < fansCount; ++i)
+		{
+			const GLvoid* pOffset= useVbo ? pGroup->fansOffset().at(i) : &pIndexData[pGroup->fansOffseti().at(i)];
+			pGlFunctions->glDrawElementsInstanced(GL_TRIANGLE_FAN, pGroup->fansSizes().at(i), GL_UNSIGNED_INT, pOffset, instanceCount);
+		}
+	}
+}
+
+void GLC_Mesh::endPrimitiveGroupsRendering()
+{
+	// Restore client state
+	GLC_Context* pContext= GLC_ContextManager::instance()->currentContext();
+	pContext->glcDisableVertexClientState();
+	pContext->glcDisableNormalClientState();
+	pContext->glcDisableTextureClientState();
+
+	if (GLC_Geometry::vboIsUsed())
+	{
+		QOpenGLBuffer::release(QOpenGLBuffer::IndexBuffer);
+		QOpenGLBuffer::release(QOpenGLBuffer::VertexBuffer);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////
 // Private services Functions
 //////////////////////////////////////////////////////////////////////
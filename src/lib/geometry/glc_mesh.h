@@ -158,6 +158,14 @@ public:
 	inline bool containsLod(int lod) const
 	{return (NULL != m_MeshData.getLod(lod));}
 
+	//! Return the primitive groups of the specified LOD or NULL
+	inline const LodPrimitiveGroups* lodPrimitiveGroups(int lod) const
+	{return m_PrimitiveGroups.value(lod, NULL);}
+
+	//! Return the current LOD index
+	inline int currentLodIndex() const
+	{return m_CurrentLod;}
+
 	//! Return true if the specified LOD contains the specified material
 	inline bool lodContainsMaterial(int lod, GLC_uint materialId) const
 	{
@@ -173,6 +181,15 @@ public:
 		return m_MeshData.getLod(lod)->accuracy();
 	}
 
+	//! Return the coarsest LOD whose accuracy is below the given accuracy, 0 if there is none
+	int coarsestLod(double maximumAccuracy) const;
+
+	//! Return the LOD index selected by the given LOD value
+	int lodIndexOf(int lodValue) const;
+
+	//! Return the smallest LOD value which selects the given LOD index
+	int lodValueOf(int lod) const;
+
 	//! Return the next primitive local id
 	inline GLC_uint nextPrimitiveLocalId() const
 	{return m_NextPrimitiveLocalId;}
@@ -309,6 +326,23 @@ public:
 /*! \name OpenGL Functions*/
 //@{
 //////////////////////////////////////////////////////////////////////
+public:
+	//! Make the VBOs or vertex arrays of the specified LOD current
+	/*! Used to draw primitive groups of several instances with the same material
+	 *  Must be followed by endPrimitiveGroupsRendering()*/
+	void beginPrimitiveGroupsRendering(int lod);
+
+	//! Draw the given primitive group of the current LOD
+	/*! The material of the group must have been executed*/
+	void drawPrimitiveGroup(GLC_PrimitiveGroup* pGroup);
+
+	//! Draw the given primitive group of the current LOD for the given number of instances
+	/*! The instanced shader must be used and the instance matrices must be set*/
+	void drawPrimitiveGroupInstanced(GLC_PrimitiveGroup* pGroup, int instanceCount);
+
+	//! Restore the client state changed by beginPrimitiveGroupsRendering()
+	void endPrimitiveGroupsRendering();
+
 protected:
 
 	//! Virtual interface for OpenGL Geometry set up.
@@ -28,6 +28,7 @@
 #include "../glc_ext.h"
 #include "../shading/glc_selectionmaterial.h"
 #include "../glc_context.h"
+#include "../glc_contextmanager.h"
 
 // The maximum point size
 float GLC_PointSprite::m_MaxSize= -1.0f;
@@ -172,6 +173,7 @@ void GLC_PointSprite::render(const GLC_RenderProperties& renderProperties)
     glTexEnvf(GL_POINT_SPRITE, GL_COORD_REPLACE, GL_TRUE);
 
     glEnable(GL_POINT_SPRITE);
+    GLC_ContextManager::instance()->currentContext()->updateMatrixUniforms();
     glDraw(renderProperties);
 
     glPopAttrib();
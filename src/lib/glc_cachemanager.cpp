@@ -22,13 +22,501 @@
 //! \file glc_cachemanager.cpp implementation of the GLC_CacheManager class.
 
 #include "glc_cachemanager.h"
+#include "glc_errorlog.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QPair>
 #include <QtDebug>
 
+#include <algorithm>
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <cstdio>
+#endif
+
+namespace
+{
+// Prefix of binary rep being written
+const QChar temporaryPrefix('~');
+
+// Age in seconds after which an orphan temporary file is removed
+const int orphanTemporaryAge= 24 * 3600;
+
+// Return the index key of the given context and file
+inline QString entryKey(const QString& context, const QString& fileName)
+{
+	return context + '/' + fileName;
+}
+
+// Return the last access time of the given file in msecs since epoch
+inline qint64 lastAccessOf(const QFileInfo& fileInfo)
+{
+	QDateTime lastAccess(fileInfo.lastRead());
+	if (!lastAccess.isValid()) lastAccess= fileInfo.lastModified();
+	return lastAccess.toMSecsSinceEpoch();
+}
+
+// Replace the target file by the source file in one step
+// Readers see either the old or the new target, never a missing one
+bool replaceFile(const QString& source, const QString& target)
+{
+#if defined(Q_OS_WIN)
+	const QString nativeSource(QDir::toNativeSeparators(source));
+	const QString nativeTarget(QDir::toNativeSeparators(target));
+	return MoveFileExW(reinterpret_cast<const wchar_t*>(nativeSource.utf16())
+			, reinterpret_cast<const wchar_t*>(nativeTarget.utf16())
+			, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return ::rename(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#endif
+}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Index, write queue and statistics of a cache directory
+//////////////////////////////////////////////////////////////////////
+class GLC_CacheManager::CacheData
+{
+public:
+	//! A cache entry
+	struct Entry
+	{
+		Entry()
+		: m_RepTimeStamp()
+		, m_FileModified()
+		, m_Size(0)
+		, m_LastAccess(0)
+		, m_HeaderIsChecked(false)
+		, m_IsPending(false)
+		, m_PinCount(0)
+		{}
+
+		//! Time stamp of the representation, valid when known
+		QDateTime m_RepTimeStamp;
+		//! Last modification of the cache file
+		QDateTime m_FileModified;
+		//! Size of the cache file
+		qint64 m_Size;
+		//! Last access in msecs since epoch
+		qint64 m_LastAccess;
+		//! True if the cache file header has been checked
+		bool m_HeaderIsChecked;
+		//! True if the cache file is waiting to be written
+		bool m_IsPending;
+		//! Number of loadings in progress of the cache file, a pinned entry is not evicted
+		int m_PinCount;
+	};
+
+	explicit CacheData(const QString& path);
+	~CacheData();
+
+	//! Return true if the given entry is usable, if pin is true a usable entry is pinned
+	bool isUsable(const QString& key, const QString& absoluteFileName, const QDateTime& timeStamp, bool pin= false);
+
+	//! Unpin the given entry pinned by isUsable
+	void unpin(const QString& key);
+
+	//! Flag the given entry as pending, return false if it is already pending
+	bool addPendingEntry(const QString& key);
+
+	//! Write the given serialized representation in the cache
+	bool write(const QString& key, const QString& absoluteFileName, const QDateTime& timeStamp
+			, const GLC_BoundingBox& boundingBox, const QByteArray& repBuffer, bool useCompression, int compressionLevel);
+
+	//! Build the index if it is not done yet, mutex must be locked
+	void indexIfNeeded();
+
+	//! Scan the cache directory and update the index, mutex must be locked
+	void scan();
+
+	//! Remove least recently used entries until the cache fit its maximum size, mutex must be locked
+	void evictIfNeeded();
+
+	//! Return the absolute file name of the given key
+	inline QString absoluteFileName(const QString& key) const
+	{return m_Path + '/' + key + '.' + GLC_BSRep::suffix();}
+
+	//! The cache directory absolute path
+	const QString m_Path;
+
+	//! Protect everything below
+	QMutex m_Mutex;
+
+	//! The index of cache entries
+	QHash<QString, Entry> m_Index;
+
+	//! True if the cache directory has been scanned
+	bool m_IsIndexed;
+
+	//! The size of indexed entries
+	qint64 m_Size;
+
+	//! The maximum size of the cache (0 : unlimited)
+	qint64 m_MaximumSize;
+
+	//! Statistics
+	quint64 m_HitCount;
+	quint64 m_MissCount;
+	quint64 m_BytesWritten;
+	quint64 m_EvictionCount;
+
+	//! The number of pending writes
+	int m_PendingWriteCount;
+
+	//! Used to generate unique temporary file name
+	QAtomicInt m_TemporaryId;
+
+	//! Thread pool of background writes
+	QThreadPool m_ThreadPool;
+};
+
+GLC_CacheManager::CacheData::CacheData(const QString& path)
+: m_Path(path)
+, m_Mutex()
+, m_Index()
+, m_IsIndexed(false)
+, m_Size(0)
+, m_MaximumSize(0)
+, m_HitCount(0)
+, m_MissCount(0)
+, m_BytesWritten(0)
+, m_EvictionCount(0)
+, m_PendingWriteCount(0)
+, m_TemporaryId(0)
+, m_ThreadPool()
+{
+	// Write one binary rep at a time to avoid disk contention
+	m_ThreadPool.setMaxThreadCount(1);
+}
+
+GLC_CacheManager::CacheData::~CacheData()
+{
+	m_ThreadPool.waitForDone();
+}
+
+bool GLC_CacheManager::CacheData::isUsable(const QString& key, const QString& absoluteFileName, const QDateTime& timeStamp, bool pin)
+{
+	const QFileInfo fileInfo(absoluteFileName);
+	const bool fileIsReadable= fileInfo.exists() && fileInfo.isReadable();
+	const QDateTime fileModified(fileInfo.lastModified());
+
+	QMutexLocker locker(&m_Mutex);
+	indexIfNeeded();
+	QHash<QString, Entry>::iterator iEntry= m_Index.find(key);
+	if ((iEntry != m_Index.end()) && iEntry.value().m_IsPending)
+	{
+		++m_MissCount;
+		return false;
+	}
+	if (!fileIsReadable)
+	{
+		// Removed by another process
+		if (iEntry != m_Index.end())
+		{
+			m_Size-= iEntry.value().m_Size;
+			m_Index.erase(iEntry);
+		}
+		++m_MissCount;
+		return false;
+	}
+	if ((iEntry == m_Index.end()) || (iEntry.value().m_Size != fileInfo.size()) || (iEntry.value().m_FileModified != fileModified))
+	{
+		// New entry or entry replaced by another process
+		if (iEntry != m_Index.end()) m_Size-= iEntry.value().m_Size;
+		Entry entry;
+		entry.m_FileModified= fileModified;
+		entry.m_Size= fileInfo.size();
+		entry.m_LastAccess= lastAccessOf(fileInfo);
+		iEntry= m_Index.insert(key, entry);
+		m_Size+= entry.m_Size;
+	}
+
+	bool usable;
+	const Entry& entry= iEntry.value();
+	if (entry.m_HeaderIsChecked && (!timeStamp.isValid() || entry.m_RepTimeStamp.isValid()))
+	{
+		usable= !timeStamp.isValid() || (timeStamp == entry.m_RepTimeStamp);
+	}
+	else
+	{
+		// Don't keep other threads waiting while reading the header
+		locker.unlock();
+		GLC_BSRep binaryRep;
+		binaryRep.setAbsoluteFileName(absoluteFileName);
+		usable= binaryRep.isUsable(timeStamp);
+		locker.relock();
+
+		iEntry= m_Index.find(key);
+		if (usable && (iEntry != m_Index.end()) && (iEntry.value().m_FileModified == fileModified))
+		{
+			iEntry.value().m_HeaderIsChecked= true;
+			if (timeStamp.isValid()) iEntry.value().m_RepTimeStamp= timeStamp;
+		}
+	}
+
+	if (usable && pin)
+	{
+		// The entry may have been removed while reading the header
+		if ((iEntry != m_Index.end()) && !iEntry.value().m_IsPending) ++(iEntry.value().m_PinCount);
+		else usable= false;
+	}
+
+	if (usable)
+	{
+		++m_HitCount;
+		if (iEntry != m_Index.end()) iEntry.value().m_LastAccess= QDateTime::currentMSecsSinceEpoch();
+	}
+	else
+	{
+		++m_MissCount;
+	}
+	return usable;
+}
+
+void GLC_CacheManager::CacheData::unpin(const QString& key)
+{
+	QMutexLocker locker(&m_Mutex);
+	QHash<QString, Entry>::iterator iEntry= m_Index.find(key);
+	if ((iEntry != m_Index.end()) && (iEntry.value().m_PinCount > 0))
+	{
+		--(iEntry.value().m_PinCount);
+	}
+}
+
+bool GLC_CacheManager::CacheData::addPendingEntry(const QString& key)
+{
+	QMutexLocker locker(&m_Mutex);
+	indexIfNeeded();
+	QHash<QString, Entry>::iterator iEntry= m_Index.find(key);
+	if (iEntry != m_Index.end())
+	{
+		if (iEntry.value().m_IsPending) return false;
+		iEntry.value().m_IsPending= true;
+	}
+	else
+	{
+		Entry entry;
+		entry.m_LastAccess= QDateTime::currentMSecsSinceEpoch();
+		entry.m_IsPending= true;
+		m_Index.insert(key, entry);
+	}
+	++m_PendingWriteCount;
+	return true;
+}
+
+bool GLC_CacheManager::CacheData::write(const QString& key, const QString& absoluteFileName, const QDateTime& timeStamp
+		, const GLC_BoundingBox& boundingBox, const QByteArray& repBuffer, bool useCompression, int compressionLevel)
+{
+	// Write in a temporary file of the same directory and rename it when complete
+	const QFileInfo targetInfo(absoluteFileName);
+	const QString temporaryFileName(targetInfo.absolutePath() + '/' + temporaryPrefix
+			+ QString::number(QCoreApplication::applicationPid()) + '_' + QString::number(m_TemporaryId.fetchAndAddOrdered(1))
+			+ '_' + targetInfo.fileName());
+
+	GLC_BSRep binaryRep(temporaryFileName, useCompression);
+	binaryRep.setCompressionLevel(compressionLevel);
+	bool writeOk= binaryRep.save(timeStamp, boundingBox, repBuffer);
+	if (writeOk && !replaceFile(temporaryFileName, absoluteFileName))
+	{
+		// Fallback, only succeeds when no entry has been written meanwhile
+		writeOk= QFile::rename(temporaryFileName, absoluteFileName);
+	}
+	if (!writeOk) QFile::remove(temporaryFileName);
+
+	const QFileInfo writtenInfo(absoluteFileName);
+
+	QMutexLocker locker(&m_Mutex);
+	int pinCount= 0;
+	QHash<QString, Entry>::iterator iEntry= m_Index.find(key);
+	if (iEntry != m_Index.end())
+	{
+		if (iEntry.value().m_IsPending) --m_PendingWriteCount;
+		pinCount= iEntry.value().m_PinCount;
+		m_Size-= iEntry.value().m_Size;
+		m_Index.erase(iEntry);
+	}
+	if (writeOk)
+	{
+		Entry entry;
+		entry.m_PinCount= pinCount;
+		entry.m_RepTimeStamp= timeStamp;
+		entry.m_FileModified= writtenInfo.lastModified();
+		entry.m_Size= writtenInfo.size();
+		entry.m_LastAccess= QDateTime::currentMSecsSinceEpoch();
+		entry.m_HeaderIsChecked= true;
+		m_Index.insert(key, entry);
+		m_Size+= entry.m_Size;
+		m_BytesWritten+= static_cast<quint64>(entry.m_Size);
+
+		evictIfNeeded();
+	}
+
+	return writeOk;
+}
+
+void GLC_CacheManager::CacheData::indexIfNeeded()
+{
+	if (!m_IsIndexed)
+	{
+		scan();
+		m_IsIndexed= true;
+	}
+}
+
+void GLC_CacheManager::CacheData::scan()
+{
+	const QDateTime now(QDateTime::currentDateTime());
+	const QString filter(QString("*.") + GLC_BSRep::suffix());
+	QHash<QString, Entry> index;
+	qint64 size= 0;
+
+	const QDir cacheDir(m_Path);
+	const QStringList contextList(cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot));
+	const int contextCount= contextList.count();
+	for (int i= 0; i < contextCount; ++i)
+	{
+		const QString& context= contextList.at(i);
+		const QFileInfoList fileList(QDir(cacheDir.filePath(context)).entryInfoList(QStringList(filter), QDir::Files));
+		const int fileCount= fileList.count();
+		for (int j= 0; j < fileCount; ++j)
+		{
+			const QFileInfo& fileInfo= fileList.at(j);
+			const QString fileName(fileInfo.fileName());
+			if (fileName.startsWith(temporaryPrefix))
+			{
+				// Left by a crashed process
+				if (fileInfo.lastModified().secsTo(now) > orphanTemporaryAge) QFile::remove(fileInfo.absoluteFilePath());
+				continue;
+			}
+			const QString key(entryKey(context, fileName.left(fileName.length() - GLC_BSRep::suffix().length() - 1)));
+			const QDateTime fileModified(fileInfo.lastModified());
+			QHash<QString, Entry>::const_iterator iEntry= m_Index.constFind(key);
+			Entry entry;
+			if ((iEntry != m_Index.constEnd()) && !iEntry.value().m_IsPending
+					&& (iEntry.value().m_Size == fileInfo.size()) && (iEntry.value().m_FileModified == fileModified))
+			{
+				entry= iEntry.value();
+			}
+			else
+			{
+				entry.m_FileModified= fileModified;
+				entry.m_Size= fileInfo.size();
+				entry.m_LastAccess= lastAccessOf(fileInfo);
+			}
+			index.insert(key, entry);
+			size+= entry.m_Size;
+		}
+	}
+
+	// Keep pending entries
+	QHash<QString, Entry>::const_iterator iEntry= m_Index.constBegin();
+	while (iEntry != m_Index.constEnd())
+	{
+		if (iEntry.value().m_IsPending)
+		{
+			QHash<QString, Entry>::iterator iScannedEntry= index.find(iEntry.key());
+			if (iScannedEntry != index.end()) size-= iScannedEntry.value().m_Size;
+			index.insert(iEntry.key(), iEntry.value());
+			size+= iEntry.value().m_Size;
+		}
+		++iEntry;
+	}
+
+	m_Index.swap(index);
+	m_Size= size;
+}
+
+void GLC_CacheManager::CacheData::evictIfNeeded()
+{
+	if ((0 == m_MaximumSize) || (m_Size <= m_MaximumSize)) return;
+
+	// Take into account entries written or removed by other processes
+	scan();
+	if (m_Size <= m_MaximumSize) return;
+
+	QList<QPair<qint64, QString> > accessList;
+	QHash<QString, Entry>::const_iterator iEntry= m_Index.constBegin();
+	while (iEntry != m_Index.constEnd())
+	{
+		if (!iEntry.value().m_IsPending && (0 == iEntry.value().m_PinCount))
+		{
+			accessList.append(qMakePair(iEntry.value().m_LastAccess, iEntry.key()));
+		}
+		++iEntry;
+	}
+	std::sort(accessList.begin(), accessList.end());
+
+	const int count= accessList.count();
+	for (int i= 0; (i < count) && (m_Size > m_MaximumSize); ++i)
+	{
+		const QString& key= accessList.at(i).second;
+		const QString fileName(absoluteFileName(key));
+		// A file in use can't be removed on some platforms
+		if (QFile::remove(fileName) || !QFile::exists(fileName))
+		{
+			m_Size-= m_Index.value(key).m_Size;
+			m_Index.remove(key);
+			++m_EvictionCount;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Background write of a binary rep
+//////////////////////////////////////////////////////////////////////
+class GLC_CacheManager::WriteTask : public QRunnable
+{
+public:
+	WriteTask(CacheData* pCacheData, const QString& key, const QString& absoluteFileName, const GLC_3DRep& rep
+			, bool useCompression, int compressionLevel)
+	: QRunnable()
+	, m_pCacheData(pCacheData)
+	, m_Key(key)
+	, m_AbsoluteFileName(absoluteFileName)
+	, m_TimeStamp(rep.lastModified())
+	, m_BoundingBox(rep.boundingBox())
+	, m_RepBuffer(GLC_BSRep::serializedRep(rep))
+	, m_UseCompression(useCompression)
+	, m_CompressionLevel(compressionLevel)
+	{}
+
+	virtual void run()
+	{
+		const bool writeOk= m_pCacheData->write(m_Key, m_AbsoluteFileName, m_TimeStamp, m_BoundingBox
+				, m_RepBuffer, m_UseCompression, m_CompressionLevel);
+		if (!writeOk)
+		{
+			QStringList stringList("GLC_CacheManager::addToCache");
+			stringList.append("Unable to write " + m_AbsoluteFileName);
+			GLC_ErrorLog::addError(stringList);
+		}
+	}
+
+private:
+	//! The cache data, which wait for this task before being deleted
+	CacheData* m_pCacheData;
+	const QString m_Key;
+	const QString m_AbsoluteFileName;
+	const QDateTime m_TimeStamp;
+	const GLC_BoundingBox m_BoundingBox;
+	const QByteArray m_RepBuffer;
+	const bool m_UseCompression;
+	const int m_CompressionLevel;
+};
 
 GLC_CacheManager::GLC_CacheManager(const QString& path)
 : m_Dir()
 , m_UseCompression(true)
 , m_CompressionLevel(-1)
+, m_UseWriteBehind(false)
+, m_pCacheData()
 {
 	if (! path.isEmpty())
 	{
@@ -38,6 +526,7 @@ GLC_CacheManager::GLC_CacheManager(const QString& path)
 			m_Dir.setPath(path);
 		}
 	}
+	m_pCacheData= QSharedPointer<CacheData>(new CacheData(m_Dir.absolutePath()));
 }
 
 // Copy constructor
@@ -45,6 +534,8 @@ GLC_CacheManager::GLC_CacheManager(const GLC_CacheManager& cacheManager)
 :m_Dir(cacheManager.m_Dir)
 , m_UseCompression(cacheManager.m_UseCompression)
 , m_CompressionLevel(cacheManager.m_CompressionLevel)
+, m_UseWriteBehind(cacheManager.m_UseWriteBehind)
+, m_pCacheData(cacheManager.m_pCacheData)
 {
 
 }
@@ -55,6 +546,8 @@ GLC_CacheManager& GLC_CacheManager::operator=(const GLC_CacheManager& cacheManag
 	m_Dir= cacheManager.m_Dir;
 	m_UseCompression= cacheManager.m_UseCompression;
 	m_CompressionLevel= cacheManager.m_CompressionLevel;
+	m_UseWriteBehind= cacheManager.m_UseWriteBehind;
+	m_pCacheData= cacheManager.m_pCacheData;
 
 	return *this;
 }
@@ -96,40 +589,62 @@ bool GLC_CacheManager::isCashed(const QString& context, const QString& fileName)
 {
 	if (! isReadable()) return false;
 
-	QFileInfo fileInfo(m_Dir.absolutePath() + QDir::separator() + context + QDir::separator() + fileName + '.' + GLC_BSRep::suffix());
+	QFileInfo fileInfo(binaryRepFileName(context, fileName));
 	return fileInfo.exists();
 }
 
 // Return True if the cached file is usable
 bool GLC_CacheManager::isUsable(const QDateTime& timeStamp, const QString& context, const QString& fileName) const
 {
-	bool result= isCashed(context, fileName);
-
-	if (result)
+	if (! isReadable())
 	{
-		QFileInfo cacheFileInfo(m_Dir.absolutePath() + QDir::separator() + context + QDir::separator() + fileName+ '.' + GLC_BSRep::suffix());
-		//result= result && (timeStamp == cacheFileInfo.lastModified());
-		result= result && cacheFileInfo.isReadable();
-		if (result)
-		{
-			GLC_BSRep binaryRep;
-			binaryRep.setAbsoluteFileName(cacheFileInfo.absoluteFilePath());
-			result= result && binaryRep.isUsable(timeStamp);
-		}
+		QMutexLocker locker(&m_pCacheData->m_Mutex);
+		++m_pCacheData->m_MissCount;
+		return false;
 	}
 
-	return result;
+	return m_pCacheData->isUsable(entryKey(context, fileName), binaryRepFileName(context, fileName), timeStamp);
 }
 
 // Return the binary serialized representation of the specified file
 GLC_BSRep GLC_CacheManager::binary3DRep(const QString& context, const QString& fileName) const
 {
-	const QString absoluteFileName(m_Dir.absolutePath() + QDir::separator() + context + QDir::separator() + fileName + '.' + GLC_BSRep::suffix());
-	GLC_BSRep binaryRep(absoluteFileName);
+	GLC_BSRep binaryRep(binaryRepFileName(context, fileName));
 
 	return binaryRep;
 }
 
+// Load in the given rep the cached file if it is usable
+bool GLC_CacheManager::loadCachedRep(const QDateTime& timeStamp, const QString& context, const QString& fileName, GLC_3DRep* pRep) const
+{
+	Q_ASSERT(NULL != pRep);
+	if (! isReadable())
+	{
+		QMutexLocker locker(&m_pCacheData->m_Mutex);
+		++m_pCacheData->m_MissCount;
+		return false;
+	}
+
+	const QString key(entryKey(context, fileName));
+	const QString binaryFileName(binaryRepFileName(context, fileName));
+	if (!m_pCacheData->isUsable(key, binaryFileName, timeStamp, true)) return false;
+
+	// The entry is pinned until it is loaded
+	try
+	{
+		GLC_BSRep binaryRep(binaryFileName);
+		*pRep= binaryRep.loadRep();
+	}
+	catch (...)
+	{
+		m_pCacheData->unpin(key);
+		throw;
+	}
+	m_pCacheData->unpin(key);
+
+	return true;
+}
+
 // Add the specified file in the cache
 bool GLC_CacheManager::addToCache(const QString& context, const GLC_3DRep& rep)
 {
@@ -140,7 +655,7 @@ bool GLC_CacheManager::addToCache(const QString& context, const GLC_3DRep& rep)
 		QFileInfo contextCacheInfo(m_Dir.absolutePath() + QDir::separator() + context);
 		if (! contextCacheInfo.exists())
 		{
-			addedToCache= m_Dir.mkdir(context);
+			addedToCache= m_Dir.mkdir(context) || contextCacheInfo.exists();
 		}
 		if (addedToCache)
 		{
@@ -153,16 +668,85 @@ bool GLC_CacheManager::addToCache(const QString& context, const GLC_3DRep& rep)
 			{
 				repFileName= QFileInfo(repFileName).fileName();
 			}
-			const QString binaryFileName= contextCacheInfo.filePath() + QDir::separator() + repFileName;
-			GLC_BSRep binariRep(binaryFileName, m_UseCompression);
-			binariRep.setCompressionLevel(m_CompressionLevel);
-			addedToCache= binariRep.save(rep);
+			const QString key(entryKey(context, repFileName));
+			const QString binaryFileName(binaryRepFileName(context, repFileName));
+			if (m_UseWriteBehind)
+			{
+				// Serialize now, compress and write in background
+				if (m_pCacheData->addPendingEntry(key))
+				{
+					m_pCacheData->m_ThreadPool.start(new WriteTask(m_pCacheData.data(), key, binaryFileName, rep, m_UseCompression, m_CompressionLevel));
+				}
+			}
+			else
+			{
+				addedToCache= m_pCacheData->write(key, binaryFileName, rep.lastModified(), rep.boundingBox()
+						, GLC_BSRep::serializedRep(rep), m_UseCompression, m_CompressionLevel);
+			}
 		}
 	}
 
 	return addedToCache;
 }
 
+// Return the maximum size in bytes of the cache
+qint64 GLC_CacheManager::maximumSize() const
+{
+	QMutexLocker locker(&m_pCacheData->m_Mutex);
+	return m_pCacheData->m_MaximumSize;
+}
+
+// Return the size in bytes of the indexed cache entries
+qint64 GLC_CacheManager::size() const
+{
+	QMutexLocker locker(&m_pCacheData->m_Mutex);
+	m_pCacheData->indexIfNeeded();
+	return m_pCacheData->m_Size;
+}
+
+// Return the number of indexed cache entries
+int GLC_CacheManager::entryCount() const
+{
+	QMutexLocker locker(&m_pCacheData->m_Mutex);
+	m_pCacheData->indexIfNeeded();
+	return m_pCacheData->m_Index.count() - m_pCacheData->m_PendingWriteCount;
+}
+
+// Return the number of usable cache queries
+quint64 GLC_CacheManager::hitCount() const
+{
+	QMutexLocker locker(&m_pCacheData->m_Mutex);
+	return m_pCacheData->m_HitCount;
+}
+
+// Return the number of unusable cache queries
+quint64 GLC_CacheManager::missCount() const
+{
+	QMutexLocker locker(&m_pCacheData->m_Mutex);
+	return m_pCacheData->m_MissCount;
+}
+
+// Return the number of bytes written in the cache
+quint64 GLC_CacheManager::bytesWritten() const
+{
+	QMutexLocker locker(&m_pCacheData->m_Mutex);
+	return m_pCacheData->m_BytesWritten;
+}
+
+// Return the number of entries evicted from the cache
+quint64 GLC_CacheManager::evictionCount() const
+{
+	QMutexLocker locker(&m_pCacheData->m_Mutex);
+	return m_pCacheData->m_EvictionCount;
+}
+
+// Return the number of binary rep waiting to be written
+int GLC_CacheManager::pendingWriteCount() const
+{
+	QMutexLocker locker(&m_pCacheData->m_Mutex);
+	return m_pCacheData->m_PendingWriteCount;
+}
+
 //////////////////////////////////////////////////////////////////////
 //Set Functions
 //////////////////////////////////////////////////////////////////////
@@ -176,8 +760,46 @@ bool GLC_CacheManager::setCachePath(const QString& path)
 
 	if (result)
 	{
+		const qint64 maxSize= maximumSize();
 		m_Dir.setPath(path);
+		// The index belong to the previous directory
+		m_pCacheData= QSharedPointer<CacheData>(new CacheData(m_Dir.absolutePath()));
+		m_pCacheData->m_MaximumSize= maxSize;
 	}
 	return result;
 }
 
+// Set the maximum size in bytes of the cache
+void GLC_CacheManager::setMaximumSize(qint64 size)
+{
+	QMutexLocker locker(&m_pCacheData->m_Mutex);
+	m_pCacheData->m_MaximumSize= qMax(Q_INT64_C(0), size);
+	m_pCacheData->indexIfNeeded();
+	m_pCacheData->evictIfNeeded();
+}
+
+// Wait until all pending binary rep are written
+void GLC_CacheManager::waitForPendingWrites()
+{
+	m_pCacheData->m_ThreadPool.waitForDone();
+}
+
+// Reset hit, miss, written bytes and eviction counters
+void GLC_CacheManager::resetStatistics()
+{
+	QMutexLocker locker(&m_pCacheData->m_Mutex);
+	m_pCacheData->m_HitCount= 0;
+	m_pCacheData->m_MissCount= 0;
+	m_pCacheData->m_BytesWritten= 0;
+	m_pCacheData->m_EvictionCount= 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+// Return the absolute file name of the binary rep of the given context and file
+QString GLC_CacheManager::binaryRepFileName(const QString& context, const QString& fileName) const
+{
+	return m_Dir.absolutePath() + QDir::separator() + context + QDir::separator() + fileName + '.' + GLC_BSRep::suffix();
+}
@@ -27,6 +27,7 @@
 #include <QDir>
 #include <QString>
 #include <QDateTime>
+#include <QSharedPointer>
 #include "geometry/glc_bsrep.h"
 
 #include "glc_config.h"
@@ -37,10 +38,25 @@
 
 /*! By default the binary rep are compressed with a default
  * compression level
+ *
+ * The cache keeps an in-memory index of its entries (context, file name,
+ * representation time stamp and size) so that usability queries don't have to
+ * open the binary rep each time. Copies of a cache manager share the same index,
+ * write queue and statistics.\n
+ * Binary rep are written into a temporary file which is renamed when complete,
+ * so that other threads and processes sharing the cache directory never see a
+ * partially written file. If write-behind is enabled, they are written by a
+ * background thread.\n
+ * If a maximum size is set, the least recently used entries are removed
+ * when the cache grows over this size. Entries being loaded by loadCachedRep()
+ * are never removed.
  */
 //////////////////////////////////////////////////////////////////////
 class GLC_LIB_EXPORT GLC_CacheManager
 {
+	class CacheData;
+	class WriteTask;
+
 public:
 //////////////////////////////////////////////////////////////////////
 /*! @name Constructor */
@@ -87,6 +103,11 @@ public:
 	//! Return the binary serialized representation of the specified file
 	GLC_BSRep binary3DRep(const QString&, const QString&) const;
 
+	//! Load in the given rep the cached file if it is usable, return true on success
+	/*! The entry cannot be evicted between its usability check and its loading.
+	 *  Throw GLC_FileFormatException if the usable binary rep can't be loaded*/
+	bool loadCachedRep(const QDateTime& timeStamp, const QString& context, const QString& fileName, GLC_3DRep* pRep) const;
+
 	//! Add the specified file in the cache
 	bool addToCache(const QString&, const GLC_3DRep&);
 
@@ -98,6 +119,34 @@ public:
 	inline int compressionLevel() const
 	{return m_CompressionLevel;}
 
+	//! Return true if binary rep are written in background by addToCache (false by default)
+	inline bool writeBehindIsUsed() const
+	{return m_UseWriteBehind;}
+
+	//! Return the maximum size in bytes of the cache (0 : unlimited)
+	qint64 maximumSize() const;
+
+	//! Return the size in bytes of the indexed cache entries
+	qint64 size() const;
+
+	//! Return the number of indexed cache entries
+	int entryCount() const;
+
+	//! Return the number of usable cache queries
+	quint64 hitCount() const;
+
+	//! Return the number of unusable cache queries
+	quint64 missCount() const;
+
+	//! Return the number of bytes written in the cache
+	quint64 bytesWritten() const;
+
+	//! Return the number of entries evicted from the cache
+	quint64 evictionCount() const;
+
+	//! Return the number of binary rep waiting to be written
+	int pendingWriteCount() const;
+
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -116,8 +165,29 @@ public:
 	//! Set the cache compression level
 	inline void setCompressionLevel(int level)
 	{m_CompressionLevel= level;}
+
+	//! Set write-behind usage of addToCache
+	inline void setWriteBehindUsage(bool use)
+	{m_UseWriteBehind= use;}
+
+	//! Set the maximum size in bytes of the cache (0 : unlimited)
+	/*! Least recently used entries are evicted if the cache is bigger*/
+	void setMaximumSize(qint64 size);
+
+	//! Wait until all pending binary rep are written
+	void waitForPendingWrites();
+
+	//! Reset hit, miss, written bytes and eviction counters
+	void resetStatistics();
 //@}
 
+//////////////////////////////////////////////////////////////////////
+// Private services function
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Return the absolute file name of the binary rep of the given context and file
+	QString binaryRepFileName(const QString& context, const QString& fileName) const;
+
 //////////////////////////////////////////////////////////////////////
 // Private members
 //////////////////////////////////////////////////////////////////////
@@ -131,6 +201,12 @@ private:
 
 	//! The compression level
 	int m_CompressionLevel;
+
+	//! Write binary rep in background
+	bool m_UseWriteBehind;
+
+	//! Index, write queue and statistics shared by copies of this cache manager
+	QSharedPointer<CacheData> m_pCacheData;
 };
 
 #endif /* GLC_CACHEMANAGER_H_ */
@@ -22,10 +22,12 @@
 //! \file glc_context.cpp implementation of the GLC_Context class.
 
 #include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 
 #include "glc_context.h"
 #include "glc_contextmanager.h"
 #include "shading/glc_shader.h"
+#include "shading/glc_oitrenderer.h"
 
 #include "glc_state.h"
 
@@ -34,13 +36,15 @@ GLC_Context::GLC_Context(QOpenGLContext *pOpenGLContext, QSurface *pSurface)
     , m_pOpenGLContext(pOpenGLContext)
     , m_pSurface(pSurface)
     , m_ContextSharedData()
+    , m_InstanceMatrixBuffer(QOpenGLBuffer::VertexBuffer)
+    , m_pOitRenderer(NULL)
 {
     connect(m_pOpenGLContext, SIGNAL(aboutToBeDestroyed()), this, SLOT(openGLContextDestroyed()), Qt::DirectConnection);
 }
 
 GLC_Context::~GLC_Context()
 {
-
+    delete m_pOitRenderer;
 }
 
 GLC_Context *GLC_Context::current()
@@ -53,6 +57,15 @@ GLC_Context *GLC_Context::current()
 // Get Functions
 //////////////////////////////////////////////////////////////////////
 
+GLC_OitRenderer* GLC_Context::oitRenderer()
+{
+    if (NULL == m_pOitRenderer)
+    {
+        m_pOitRenderer= new GLC_OitRenderer();
+    }
+    return m_pOitRenderer;
+}
+
 void GLC_Context::glcUseVertexPointer(const GLvoid *pointer)
 {
     Q_ASSERT(m_pOpenGLContext);
@@ -242,6 +255,64 @@ void GLC_Context::glcDisableColorClientState()
 
 }
 
+void GLC_Context::glcSetInstanceMatrices(const QVector<GLfloat>& matrices)
+{
+    Q_ASSERT(m_pOpenGLContext);
+    if (!m_InstanceMatrixBuffer.isCreated())
+    {
+        m_InstanceMatrixBuffer.create();
+        m_InstanceMatrixBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    }
+    m_InstanceMatrixBuffer.bind();
+    const int dataSize= matrices.size() * static_cast<int>(sizeof(GLfloat));
+    if (dataSize > m_InstanceMatrixBuffer.size())
+    {
+        m_InstanceMatrixBuffer.allocate(matrices.constData(), dataSize);
+    }
+    else
+    {
+        m_InstanceMatrixBuffer.write(0, matrices.constData(), dataSize);
+    }
+    QOpenGLBuffer::release(QOpenGLBuffer::VertexBuffer);
+}
+
+void GLC_Context::glcUseInstanceMatrixPointer(int firstInstance)
+{
+    Q_ASSERT(m_pOpenGLContext);
+    Q_ASSERT(m_InstanceMatrixBuffer.isCreated());
+    GLC_Shader* pShader= GLC_Shader::currentShaderHandle();
+    Q_ASSERT((NULL != pShader) && (pShader->instanceMatrixAttributeId() != -1));
+    QOpenGLExtraFunctions* pGlFunctions= m_pOpenGLContext->extraFunctions();
+
+    // A mat4 attribute use 4 consecutive locations, one for each column
+    const GLsizei stride= 16 * sizeof(GLfloat);
+    const GLuint location= pShader->instanceMatrixAttributeId();
+    const char* pOffset= reinterpret_cast<const char*>(static_cast<quintptr>(firstInstance) * stride);
+    m_InstanceMatrixBuffer.bind();
+    for (GLuint i= 0; i < 4; ++i)
+    {
+        pGlFunctions->glVertexAttribPointer(location + i, 4, GL_FLOAT, GL_FALSE, stride, pOffset + (i * 4 * sizeof(GLfloat)));
+        pGlFunctions->glEnableVertexAttribArray(location + i);
+        pGlFunctions->glVertexAttribDivisor(location + i, 1);
+    }
+    QOpenGLBuffer::release(QOpenGLBuffer::VertexBuffer);
+}
+
+void GLC_Context::glcDisableInstanceMatrixClientState()
+{
+    Q_ASSERT(m_pOpenGLContext);
+    GLC_Shader* pShader= GLC_Shader::currentShaderHandle();
+    Q_ASSERT((NULL != pShader) && (pShader->instanceMatrixAttributeId() != -1));
+    QOpenGLExtraFunctions* pGlFunctions= m_pOpenGLContext->extraFunctions();
+
+    const GLuint location= pShader->instanceMatrixAttributeId();
+    for (GLuint i= 0; i < 4; ++i)
+    {
+        pGlFunctions->glVertexAttribDivisor(location + i, 0);
+        pGlFunctions->glDisableVertexAttribArray(location + i);
+    }
+}
+
 bool GLC_Context::makeCurrent()
 {
     Q_ASSERT(m_pOpenGLContext && m_pSurface);
@@ -290,8 +361,22 @@ void GLC_Context::unuseDefaultShader()
     m_ContextSharedData->unuseDefaultShader();
 }
 
+bool GLC_Context::useInstancedShader()
+{
+    Q_ASSERT(m_pOpenGLContext);
+    return m_ContextSharedData->useInstancedShader();
+}
+
+void GLC_Context::unuseInstancedShader()
+{
+    Q_ASSERT(m_pOpenGLContext);
+    m_ContextSharedData->unuseInstancedShader();
+}
+
 void GLC_Context::openGLContextDestroyed()
 {
+    m_InstanceMatrixBuffer.destroy();
+    if (NULL != m_pOitRenderer) m_pOitRenderer->clear();
     m_ContextSharedData.clear();
     emit destroyed(this);
 }
@@ -27,6 +27,7 @@
 #include <QtOpenGL>
 #include <QGLFormat>
 #include <QSharedPointer>
+#include <QOpenGLBuffer>
 #include <QtDebug>
 
 #include "glc_config.h"
@@ -35,6 +36,7 @@
 #include "glc_uniformshaderdata.h"
 
 class GLC_ContextSharedData;
+class GLC_OitRenderer;
 class QOpenGLContext;
 class QSurface;
 
@@ -110,6 +112,9 @@ public:
     inline QOpenGLContext* contextHandle() const
     {return m_pOpenGLContext;}
 
+    //! Return the order independent transparency renderer of this context
+    GLC_OitRenderer* oitRenderer();
+
 //@}
 //////////////////////////////////////////////////////////////////////
 /*! \name OpenGL Functions*/
@@ -199,6 +204,16 @@ public:
     //! Disable the color client state
     void glcDisableColorClientState();
 
+    //! Upload the per instance model matrices used by instanced draws
+    /*! The vector contains 16 floats for each instance*/
+    void glcSetInstanceMatrices(const QVector<GLfloat>& matrices);
+
+    //! Use the uploaded model matrices as per instance attribute from the given instance index
+    void glcUseInstanceMatrixPointer(int firstInstance);
+
+    //! Disable the per instance model matrix attribute
+    void glcDisableInstanceMatrixClientState();
+
 //@}
 //////////////////////////////////////////////////////////////////////
 /*! \name Set Functions*/
@@ -216,12 +231,23 @@ public:
 	inline void updateUniformVariables()
     {m_ContextSharedData->updateUniformVariables(this);}
 
+    //! Update matrix uniform variables of the current shader if matrices have changed
+    /*! Must be called before drawing with the current matrices*/
+    inline void updateMatrixUniforms()
+    {m_ContextSharedData->updateMatrixUniforms();}
+
     //! Use the default shader
     void useDefaultShader();
 
     //! UnUse the default shader
     inline void unuseDefaultShader();
 
+    //! Use the instanced shader, return false if it can't be used
+    bool useInstancedShader();
+
+    //! UnUse the instanced shader
+    void unuseInstancedShader();
+
     inline void shareWith(GLC_Context *pContext= 0)
     {m_ContextSharedData= pContext->m_ContextSharedData;}
 
@@ -244,6 +270,12 @@ private:
 
 	//! The context shared data
 	QSharedPointer<GLC_ContextSharedData> m_ContextSharedData;
+
+	//! The per instance model matrices buffer
+	QOpenGLBuffer m_InstanceMatrixBuffer;
+
+	//! The order independent transparency renderer
+	GLC_OitRenderer* m_pOitRenderer;
 };
 
 #endif /* GLC_CONTEXT_H_ */
@@ -26,29 +26,28 @@
 #include "glc_contextshareddata.h"
 #include "shading/glc_shader.h"
 #include "glc_state.h"
+#include "glc_exception.h"
+#include "glc_errorlog.h"
 
 GLC_ContextSharedData::GLC_ContextSharedData()
     : m_pDefaultShader(NULL)
+    , m_pInstancedShader(NULL)
+    , m_InstancedShaderIsValid(true)
     , m_IsClean(false)
-    , m_CurrentMatrixMode()
-    , m_MatrixStackHash()
+    , m_CurrentMatrixMode(GL_MODELVIEW)
+    , m_CurrentStack(ModelViewStack)
+    , m_MatrixUniformsAreDirty(true)
     , m_UniformShaderData()
     , m_ColorMaterialIsEnable()
     , m_LightingIsEnable()
     , m_TwoSidedLighting()
     , m_LightsEnableState()
 {
-    QStack<GLC_Matrix4x4>* pStack1= new QStack<GLC_Matrix4x4>();
-    pStack1->push(GLC_Matrix4x4());
-    m_MatrixStackHash.insert(GL_MODELVIEW, pStack1);
-
-    QStack<GLC_Matrix4x4>* pStack2= new QStack<GLC_Matrix4x4>();
-    pStack2->push(GLC_Matrix4x4());
-    m_MatrixStackHash.insert(GL_PROJECTION, pStack2);
-
-    QStack<GLC_Matrix4x4>* pStack3= new QStack<GLC_Matrix4x4>();
-    pStack3->push(GLC_Matrix4x4());
-    m_MatrixStackHash.insert(GL_TEXTURE, pStack3);
+    for (int i= 0; i < MatrixStackCount; ++i)
+    {
+        m_MatrixStacks[i].resize(InitialStackDepth);
+        m_StackTop[i]= 0;
+    }
 
     m_ColorMaterialIsEnable.push(false);
     m_LightingIsEnable.push(false);
@@ -59,14 +58,8 @@ GLC_ContextSharedData::GLC_ContextSharedData()
 
 GLC_ContextSharedData::~GLC_ContextSharedData()
 {
-    QHash<GLenum, QStack<GLC_Matrix4x4>* >::iterator iStack= m_MatrixStackHash.begin();
-    while (iStack != m_MatrixStackHash.end())
-    {
-        delete iStack.value();
-        ++iStack;
-    }
-
     delete m_pDefaultShader;
+    delete m_pInstancedShader;
 }
 
 void GLC_ContextSharedData::init()
@@ -97,11 +90,32 @@ void GLC_ContextSharedData::unuseDefaultShader()
     m_pDefaultShader->unuse();
 }
 
+bool GLC_ContextSharedData::useInstancedShader()
+{
+    Q_ASSERT(m_IsClean);
+    if (NULL == m_pInstancedShader) initInstancedShader();
+    if (m_InstancedShaderIsValid)
+    {
+        m_pInstancedShader->use();
+    }
+    return m_InstancedShaderIsValid;
+}
+
+void GLC_ContextSharedData::unuseInstancedShader()
+{
+    Q_ASSERT(NULL != m_pInstancedShader);
+    m_pInstancedShader->unuse();
+}
+
 void GLC_ContextSharedData::glcMatrixMode(GLenum mode)
 {
     Q_ASSERT((mode == GL_MODELVIEW) || (mode == GL_PROJECTION) || (mode == GL_TEXTURE));
 
     m_CurrentMatrixMode= mode;
+    if (GL_MODELVIEW == mode) m_CurrentStack= ModelViewStack;
+    else if (GL_PROJECTION == mode) m_CurrentStack= ProjectionStack;
+    else m_CurrentStack= TextureStack;
+
 #ifdef GLC_OPENGL_ES_2
 
 #else
@@ -111,22 +125,28 @@ void GLC_ContextSharedData::glcMatrixMode(GLenum mode)
 
 void GLC_ContextSharedData::glcLoadIdentity()
 {
-    m_MatrixStackHash.value(m_CurrentMatrixMode)->top().setToIdentity();
+    currentMatrix().setToIdentity();
+    currentMatrixChanged();
 
-#ifdef GLC_OPENGL_ES_2
-    m_UniformShaderData.setModelViewProjectionMatrix(m_MatrixStackHash.value(GL_MODELVIEW)->top(), m_MatrixStackHash.value(GL_PROJECTION)->top());
-#else
-    if (GLC_Shader::hasActiveShader())
-    {
-        m_UniformShaderData.setModelViewProjectionMatrix(m_MatrixStackHash.value(GL_MODELVIEW)->top(), m_MatrixStackHash.value(GL_PROJECTION)->top());
-    }
+#ifndef GLC_OPENGL_ES_2
     glLoadIdentity();
 #endif
 }
 
 void GLC_ContextSharedData::glcPushMatrix()
 {
-    m_MatrixStackHash.value(m_CurrentMatrixMode)->push(m_MatrixStackHash.value(m_CurrentMatrixMode)->top());
+    int& top= m_StackTop[m_CurrentStack];
+    QVector<GLC_Matrix4x4>& stack= m_MatrixStacks[m_CurrentStack];
+    const GLC_Matrix4x4 topMatrix(stack.at(top));
+    if ((top + 1) < stack.size())
+    {
+        stack[top + 1]= topMatrix;
+    }
+    else
+    {
+        stack.append(topMatrix);
+    }
+    ++top;
 
 #ifndef GLC_OPENGL_ES_2
     glPushMatrix();
@@ -135,45 +155,36 @@ void GLC_ContextSharedData::glcPushMatrix()
 
 void GLC_ContextSharedData::glcPopMatrix()
 {
-    m_MatrixStackHash.value(m_CurrentMatrixMode)->pop();
-
-#ifdef GLC_OPENGL_ES_2
-    this->glcLoadMatrix(m_MatrixStackHash.value(m_CurrentMatrixMode)->top());
-#else
-    if (GLC_Shader::hasActiveShader())
+    int& top= m_StackTop[m_CurrentStack];
+    Q_ASSERT(top > 0);
+    if (top > 0)
     {
-        this->glcLoadMatrix(m_MatrixStackHash.value(m_CurrentMatrixMode)->top());
+        --top;
+        currentMatrixChanged();
     }
+
+#ifndef GLC_OPENGL_ES_2
     glPopMatrix();
 #endif
 }
 
 void GLC_ContextSharedData::glcLoadMatrix(const GLC_Matrix4x4 &matrix)
 {
-    m_MatrixStackHash.value(m_CurrentMatrixMode)->top()= matrix;
+    currentMatrix()= matrix;
+    currentMatrixChanged();
 
-#ifdef GLC_OPENGL_ES_2
-    m_UniformShaderData.setModelViewProjectionMatrix(m_MatrixStackHash.value(GL_MODELVIEW)->top(), m_MatrixStackHash.value(GL_PROJECTION)->top());
-#else
-    if (GLC_Shader::hasActiveShader())
-    {
-        m_UniformShaderData.setModelViewProjectionMatrix(m_MatrixStackHash.value(GL_MODELVIEW)->top(), m_MatrixStackHash.value(GL_PROJECTION)->top());
-    }
+#ifndef GLC_OPENGL_ES_2
     ::glLoadMatrixd(matrix.getData());
 #endif
 }
 
 void GLC_ContextSharedData::glcMultMatrix(const GLC_Matrix4x4 &matrix)
 {
-    const GLC_Matrix4x4 current= m_MatrixStackHash.value(m_CurrentMatrixMode)->top();
-    m_MatrixStackHash.value(m_CurrentMatrixMode)->top()= current * matrix;
-#ifdef GLC_OPENGL_ES_2
-    m_UniformShaderData.setModelViewProjectionMatrix(m_MatrixStackHash.value(GL_MODELVIEW)->top(), m_MatrixStackHash.value(GL_PROJECTION)->top());
-#else
-    if (GLC_Shader::hasActiveShader())
-    {
-        m_UniformShaderData.setModelViewProjectionMatrix(m_MatrixStackHash.value(GL_MODELVIEW)->top(), m_MatrixStackHash.value(GL_PROJECTION)->top());
-    }
+    GLC_Matrix4x4& current= currentMatrix();
+    current= current * matrix;
+    currentMatrixChanged();
+
+#ifndef GLC_OPENGL_ES_2
     ::glMultMatrixd(matrix.getData());
 #endif
 }
@@ -298,6 +309,16 @@ void GLC_ContextSharedData::glcDisableLight(GLenum lightId)
    }
 }
 
+void GLC_ContextSharedData::uploadMatrixUniforms()
+{
+    // Without active shader, uniforms are updated when a shader is used
+    if (GLC_Shader::hasActiveShader())
+    {
+        m_UniformShaderData.setModelViewProjectionMatrix(modelViewMatrix(), projectionMatrix());
+        m_MatrixUniformsAreDirty= false;
+    }
+}
+
 void GLC_ContextSharedData::initDefaultShader()
 {
     QFile vertexShader(":/GLC_lib_Shaders/default_vert");
@@ -310,6 +331,27 @@ void GLC_ContextSharedData::initDefaultShader()
     m_pDefaultShader->createAndCompileProgrammShader();
 }
 
+void GLC_ContextSharedData::initInstancedShader()
+{
+    QFile vertexShader(":/GLC_lib_Shaders/instanced_vert");
+    Q_ASSERT(vertexShader.exists());
+
+    QFile fragmentShader(":/GLC_lib_Shaders/instanced_frag");
+    Q_ASSERT(fragmentShader.exists());
+
+    m_pInstancedShader= new GLC_Shader(vertexShader, fragmentShader);
+    try
+    {
+        m_pInstancedShader->createAndCompileProgrammShader();
+        m_InstancedShaderIsValid= (m_pInstancedShader->instanceMatrixAttributeId() != -1);
+    }
+    catch (GLC_Exception& e)
+    {
+        GLC_ErrorLog::addError(e.what());
+        m_InstancedShaderIsValid= false;
+    }
+}
+
 void GLC_ContextSharedData::initLightEnableState()
 {
     const int count= GLC_Light::maxLightCount();
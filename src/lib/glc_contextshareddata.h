@@ -49,12 +49,12 @@ public:
 public:
 
     //! Return the model view matrix
-    inline GLC_Matrix4x4 modelViewMatrix() const
-    {Q_ASSERT(m_MatrixStackHash.contains(GL_MODELVIEW)); return m_MatrixStackHash.value(GL_MODELVIEW)->top();}
+    inline const GLC_Matrix4x4& modelViewMatrix() const
+    {return m_MatrixStacks[ModelViewStack][m_StackTop[ModelViewStack]];}
 
     //! Return the projection matrix
-    inline GLC_Matrix4x4 projectionMatrix() const
-    {Q_ASSERT(m_MatrixStackHash.contains(GL_PROJECTION)); return m_MatrixStackHash.value(GL_PROJECTION)->top();}
+    inline const GLC_Matrix4x4& projectionMatrix() const
+    {return m_MatrixStacks[ProjectionStack][m_StackTop[ProjectionStack]];}
 
     //! Return lighting enable state
     inline bool lightingIsEnable() const
@@ -84,7 +84,12 @@ public:
 
     //! Update uniform variable
     inline void updateUniformVariables(GLC_Context* pContext)
-    {m_UniformShaderData.updateAll(pContext);}
+    {m_UniformShaderData.updateAll(pContext); m_MatrixUniformsAreDirty= false;}
+
+    //! Update matrix uniform variables of the current shader if matrices have changed
+    /*! Matrix functions only update the matrix stacks, this function must be called before drawing*/
+    inline void updateMatrixUniforms()
+    {if (m_MatrixUniformsAreDirty) uploadMatrixUniforms();}
 
     //! Use the default shader
     void useDefaultShader();
@@ -92,6 +97,13 @@ public:
     //! UnUse the default shader
     void unuseDefaultShader();
 
+    //! Use the instanced shader, return false if it can't be used
+    /*! The shader is built on first use*/
+    bool useInstancedShader();
+
+    //! UnUse the instanced shader
+    void unuseInstancedShader();
+
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -142,18 +154,58 @@ public:
 //@}
 
 private:
+    //! Matrix stack index of matrix modes
+    enum MatrixStackIndex
+    {
+        ModelViewStack= 0,
+        ProjectionStack= 1,
+        TextureStack= 2,
+        MatrixStackCount= 3
+    };
+
+    //! Initial depth of matrix stacks, stacks grow if needed
+    enum {InitialStackDepth= 32};
+
+    //! Return the top of the current matrix stack
+    inline GLC_Matrix4x4& currentMatrix()
+    {return m_MatrixStacks[m_CurrentStack][m_StackTop[m_CurrentStack]];}
+
+    //! The top of the current matrix stack have changed
+    inline void currentMatrixChanged()
+    {m_MatrixUniformsAreDirty= m_MatrixUniformsAreDirty || (m_CurrentStack != TextureStack);}
+
+    //! Upload matrix uniform variables to the current shader
+    void uploadMatrixUniforms();
+
     void initDefaultShader();
+    void initInstancedShader();
     void initLightEnableState();
 
 private:
     GLC_Shader* m_pDefaultShader;
+
+    //! The shader used to draw instances of a mesh with one draw call
+    GLC_Shader* m_pInstancedShader;
+
+    //! False if the instanced shader can't be built
+    bool m_InstancedShaderIsValid;
+
     bool m_IsClean;
 
     //! The current matrix mode
     GLenum m_CurrentMatrixMode;
 
-    //! Mapping between matrixMode and matrix stack
-    QHash<GLenum, QStack<GLC_Matrix4x4>* > m_MatrixStackHash;
+    //! The current matrix stack index
+    int m_CurrentStack;
+
+    //! Matrix stack of each matrix mode
+    QVector<GLC_Matrix4x4> m_MatrixStacks[MatrixStackCount];
+
+    //! Index of the top of each matrix stack
+    int m_StackTop[MatrixStackCount];
+
+    //! True if matrix uniform variables of the current shader are not up to date
+    bool m_MatrixUniformsAreDirty;
 
     //! The uniform data of the current shader
     GLC_UniformShaderData m_UniformShaderData;
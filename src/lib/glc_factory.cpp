@@ -264,6 +264,11 @@ GLC_FileLoader* GLC_Factory::createFileLoader() const
     return new GLC_FileLoader;
 }
 
+GLC_AsyncFileLoader* GLC_Factory::createAsyncFileLoader() const
+{
+	return new GLC_AsyncFileLoader;
+}
+
 GLC_Material* GLC_Factory::createMaterial() const
 {
 	return new GLC_Material();
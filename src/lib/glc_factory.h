@@ -51,6 +51,7 @@
 #include "viewport/glc_movercontroller.h"
 #include "viewport/glc_viewport.h"
 #include "io/glc_fileloader.h"
+#include "io/glc_asyncfileloader.h"
 
 // end of class to built
 
@@ -141,6 +142,9 @@ public:
 	//! Create a GLC_FileLoader
 	GLC_FileLoader* createFileLoader() const;
 
+	//! Create a GLC_AsyncFileLoader
+	GLC_AsyncFileLoader* createAsyncFileLoader() const;
+
 	//! Create default material
 	GLC_Material* createMaterial() const;
 
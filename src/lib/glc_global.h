@@ -72,6 +72,9 @@ namespace glc
 	//! Return the encoded color of the id
 	inline void encodeRgbId(GLC_uint, GLubyte*);
 
+	//! Return the hash value of the given triplet of integers, used by vertex index keys
+	inline uint hashTriplet(uint, uint, uint);
+
 	const int GLC_DISCRET= 70;
 	const int GLC_POLYDISCRET= 60;
 
@@ -156,6 +159,15 @@ void glc::encodeRgbId(GLC_uint id, GLubyte* colorId)
 	colorId[3]= static_cast<GLubyte>((id >> (3 * 8)) & 0xFF);
 }
 
+// Return the hash value of the given triplet of integers
+uint glc::hashTriplet(uint value1, uint value2, uint value3)
+{
+	uint hash= value1 * 73856093u;
+	hash^= value2 * 19349663u;
+	hash^= value3 * 83492791u;
+	return hash;
+}
+
 
 #endif //GLC_GLOBAL_H_
 
@@ -27,6 +27,12 @@
 bool GLC_RenderStatistics::m_IsActivated= false;
 unsigned int GLC_RenderStatistics::m_LastRenderGeometryCount= 0;
 unsigned long GLC_RenderStatistics::m_LastRenderPolygonCount= 0;
+unsigned int GLC_RenderStatistics::m_LastRenderSavedStateChangeCount= 0;
+unsigned int GLC_RenderStatistics::m_LastRenderSavedDrawCallCount= 0;
+unsigned int GLC_RenderStatistics::m_LastRenderSortedTransparentInstanceCount= 0;
+qint64 GLC_RenderStatistics::m_LastRenderTransparencySortTime= 0;
+unsigned int GLC_RenderStatistics::m_LastRenderOccludedInstanceCount= 0;
+unsigned int GLC_RenderStatistics::m_LastRenderOcclusionQueryCount= 0;
 
 GLC_RenderStatistics::GLC_RenderStatistics()
 {
@@ -57,6 +63,36 @@ unsigned long GLC_RenderStatistics::triangleCount()
 	return m_LastRenderPolygonCount;
 }
 
+unsigned int GLC_RenderStatistics::savedStateChangeCount()
+{
+	return m_LastRenderSavedStateChangeCount;
+}
+
+unsigned int GLC_RenderStatistics::savedDrawCallCount()
+{
+	return m_LastRenderSavedDrawCallCount;
+}
+
+unsigned int GLC_RenderStatistics::sortedTransparentInstanceCount()
+{
+	return m_LastRenderSortedTransparentInstanceCount;
+}
+
+qint64 GLC_RenderStatistics::transparencySortTime()
+{
+	return m_LastRenderTransparencySortTime;
+}
+
+unsigned int GLC_RenderStatistics::occludedInstanceCount()
+{
+	return m_LastRenderOccludedInstanceCount;
+}
+
+unsigned int GLC_RenderStatistics::occlusionQueryCount()
+{
+	return m_LastRenderOcclusionQueryCount;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Set methods
 //////////////////////////////////////////////////////////////////////
@@ -69,6 +105,12 @@ void GLC_RenderStatistics::reset()
 {
 	m_LastRenderGeometryCount= 0;
 	m_LastRenderPolygonCount= 0;
+	m_LastRenderSavedStateChangeCount= 0;
+	m_LastRenderSavedDrawCallCount= 0;
+	m_LastRenderSortedTransparentInstanceCount= 0;
+	m_LastRenderTransparencySortTime= 0;
+	m_LastRenderOccludedInstanceCount= 0;
+	m_LastRenderOcclusionQueryCount= 0;
 }
 
 void GLC_RenderStatistics::addBodies(unsigned int bodies)
@@ -86,3 +128,44 @@ void GLC_RenderStatistics::addTriangles(unsigned int triangles)
 		m_LastRenderPolygonCount+= triangles;
 	}
 }
+
+void GLC_RenderStatistics::addSavedStateChanges(unsigned int stateChanges)
+{
+	if (m_IsActivated)
+	{
+		m_LastRenderSavedStateChangeCount+= stateChanges;
+	}
+}
+
+void GLC_RenderStatistics::addSavedDrawCalls(unsigned int drawCalls)
+{
+	if (m_IsActivated)
+	{
+		m_LastRenderSavedDrawCallCount+= drawCalls;
+	}
+}
+
+void GLC_RenderStatistics::addTransparencySort(unsigned int instanceCount, qint64 time)
+{
+	if (m_IsActivated)
+	{
+		m_LastRenderSortedTransparentInstanceCount+= instanceCount;
+		m_LastRenderTransparencySortTime+= time;
+	}
+}
+
+void GLC_RenderStatistics::addOccludedInstances(unsigned int instanceCount)
+{
+	if (m_IsActivated)
+	{
+		m_LastRenderOccludedInstanceCount+= instanceCount;
+	}
+}
+
+void GLC_RenderStatistics::addOcclusionQueries(unsigned int queryCount)
+{
+	if (m_IsActivated)
+	{
+		m_LastRenderOcclusionQueryCount+= queryCount;
+	}
+}
@@ -55,6 +55,24 @@ public:
 
 	//! Return current triangles count
 	static unsigned long triangleCount();
+
+	//! Return the number of state changes saved by state sorting
+	static unsigned int savedStateChangeCount();
+
+	//! Return the number of draw calls saved by instanced rendering
+	static unsigned int savedDrawCallCount();
+
+	//! Return the number of transparent instances sorted by depth
+	static unsigned int sortedTransparentInstanceCount();
+
+	//! Return the time spent to sort transparent instances in nanoseconds
+	static qint64 transparencySortTime();
+
+	//! Return the number of instances hidden by occlusion culling
+	static unsigned int occludedInstanceCount();
+
+	//! Return the number of issued occlusion queries
+	static unsigned int occlusionQueryCount();
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -74,6 +92,21 @@ public:
 	//! Add Triangles to the current tringle count
 	static void addTriangles(unsigned int triangles);
 
+	//! Add state changes to the current saved state change count
+	static void addSavedStateChanges(unsigned int stateChanges);
+
+	//! Add draw calls to the current saved draw call count
+	static void addSavedDrawCalls(unsigned int drawCalls);
+
+	//! Add a sort of transparent instances of the given size and duration in nanoseconds
+	static void addTransparencySort(unsigned int instanceCount, qint64 time);
+
+	//! Add instances to the current occluded instance count
+	static void addOccludedInstances(unsigned int instanceCount);
+
+	//! Add queries to the current occlusion query count
+	static void addOcclusionQueries(unsigned int queryCount);
+
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -89,6 +122,24 @@ private:
 
 	//! Last render polygon count
 	static unsigned long m_LastRenderPolygonCount;
+
+	//! Last render saved state change count
+	static unsigned int m_LastRenderSavedStateChangeCount;
+
+	//! Last render saved draw call count
+	static unsigned int m_LastRenderSavedDrawCallCount;
+
+	//! Last render sorted transparent instance count
+	static unsigned int m_LastRenderSortedTransparentInstanceCount;
+
+	//! Last render transparency sort time
+	static qint64 m_LastRenderTransparencySortTime;
+
+	//! Last render occluded instance count
+	static unsigned int m_LastRenderOccludedInstanceCount;
+
+	//! Last render occlusion query count
+	static unsigned int m_LastRenderOcclusionQueryCount;
 };
 
 #endif /* GLC_RENDERSTATISTICS_H_ */
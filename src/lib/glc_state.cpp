@@ -50,6 +50,17 @@ GLC_CacheManager GLC_State::m_CacheManager;
 
 bool GLC_State::m_IsSpacePartitionningActivated= false;
 bool GLC_State::m_IsFrustumCullingActivated= false;
+bool GLC_State::m_IsParallelLoadingActivated= false;
+bool GLC_State::m_IsStateSortingActivated= false;
+bool GLC_State::m_IsInstancingSupported= false;
+bool GLC_State::m_IsInstancingActivated= false;
+bool GLC_State::m_IsTransparencySortingActivated= false;
+bool GLC_State::m_IsOrderIndependentTransparencyActivated= false;
+bool GLC_State::m_IsParallelFramePreparationActivated= false;
+bool GLC_State::m_IsOcclusionCullingActivated= false;
+bool GLC_State::m_IsSoftwareOcclusionCullingActivated= false;
+bool GLC_State::m_IsScreenSpaceErrorLodActivated= false;
+bool GLC_State::m_IsStlVertexWeldingActivated= false;
 bool GLC_State::m_IsValid= false;
 
 GLC_State::~GLC_State()
@@ -151,6 +162,62 @@ bool GLC_State::isFrustumCullingActivated()
     return m_IsFrustumCullingActivated;
 }
 
+bool GLC_State::isParallelLoadingActivated()
+{
+    return m_IsParallelLoadingActivated;
+}
+
+bool GLC_State::isStateSortingActivated()
+{
+    return m_IsStateSortingActivated;
+}
+
+bool GLC_State::instancingSupported()
+{
+    Q_ASSERT(m_IsValid);
+    return m_IsInstancingSupported;
+}
+
+bool GLC_State::isInstancingActivated()
+{
+    return m_IsInstancingActivated;
+}
+
+bool GLC_State::isTransparencySortingActivated()
+{
+    return m_IsTransparencySortingActivated;
+}
+
+bool GLC_State::isOrderIndependentTransparencyActivated()
+{
+    return m_IsOrderIndependentTransparencyActivated;
+}
+
+bool GLC_State::isParallelFramePreparationActivated()
+{
+    return m_IsParallelFramePreparationActivated;
+}
+
+bool GLC_State::isOcclusionCullingActivated()
+{
+    return m_IsOcclusionCullingActivated;
+}
+
+bool GLC_State::isSoftwareOcclusionCullingActivated()
+{
+    return m_IsSoftwareOcclusionCullingActivated;
+}
+
+bool GLC_State::isScreenSpaceErrorLodActivated()
+{
+    return m_IsScreenSpaceErrorLodActivated;
+}
+
+bool GLC_State::isStlVertexWeldingActivated()
+{
+    return m_IsStlVertexWeldingActivated;
+}
+
 void GLC_State::init()
 {
     if (!m_IsValid)
@@ -159,6 +226,7 @@ void GLC_State::init()
         setPointSpriteSupport();
         setFrameBufferSupport();
         setFrameBufferBlitSupport();
+        setInstancingSupport();
         m_Version= (char *) glGetString(GL_VERSION);
         m_Vendor= (char *) glGetString(GL_VENDOR);
         m_Renderer= (char *) glGetString(GL_RENDERER);
@@ -193,6 +261,15 @@ void GLC_State::setFrameBufferBlitSupport()
     m_IsFrameBufferBlitSupported= QOpenGLFramebufferObject::hasOpenGLFramebufferBlit();
 }
 
+void GLC_State::setInstancingSupport()
+{
+    // The instanced shader use the fixed pipeline state of desktop OpenGL
+    const QOpenGLContext* pContext= QOpenGLContext::currentContext();
+    const QSurfaceFormat format= pContext->format();
+    m_IsInstancingSupported= !pContext->isOpenGLES() && (format.profile() != QSurfaceFormat::CoreProfile)
+            && (format.version() >= qMakePair(3, 3));
+}
+
 void GLC_State::setGlslUsage(const bool glslUsage)
 {
     m_UseShader= glslUsage;
@@ -237,3 +314,53 @@ void GLC_State::setFrustumCullingUsage(bool usage)
 {
     m_IsFrustumCullingActivated= usage;
 }
+
+void GLC_State::setParallelLoadingUsage(bool usage)
+{
+    m_IsParallelLoadingActivated= usage;
+}
+
+void GLC_State::setStateSortingUsage(bool usage)
+{
+    m_IsStateSortingActivated= usage;
+}
+
+void GLC_State::setInstancingUsage(bool usage)
+{
+    m_IsInstancingActivated= usage;
+}
+
+void GLC_State::setTransparencySortingUsage(bool usage)
+{
+    m_IsTransparencySortingActivated= usage;
+}
+
+void GLC_State::setOrderIndependentTransparencyUsage(bool usage)
+{
+    m_IsOrderIndependentTransparencyActivated= usage;
+}
+
+void GLC_State::setParallelFramePreparationUsage(bool usage)
+{
+    m_IsParallelFramePreparationActivated= usage;
+}
+
+void GLC_State::setOcclusionCullingUsage(bool usage)
+{
+    m_IsOcclusionCullingActivated= usage;
+}
+
+void GLC_State::setSoftwareOcclusionCullingUsage(bool usage)
+{
+    m_IsSoftwareOcclusionCullingActivated= usage;
+}
+
+void GLC_State::setScreenSpaceErrorLodUsage(bool usage)
+{
+    m_IsScreenSpaceErrorLodActivated= usage;
+}
+
+void GLC_State::setStlVertexWeldingUsage(bool usage)
+{
+    m_IsStlVertexWeldingActivated= usage;
+}
@@ -101,6 +101,39 @@ public:
 	//! Return true if frustum culling is activated
 	static bool isFrustumCullingActivated();
 
+	//! Return true if file loaders are allowed to use several threads
+	static bool isParallelLoadingActivated();
+
+	//! Return true if collections sort draws by material and VBO
+	static bool isStateSortingActivated();
+
+	//! Return true if instanced rendering is supported
+	static bool instancingSupported();
+
+	//! Return true if occurrences of the same mesh are drawn with instanced rendering
+	static bool isInstancingActivated();
+
+	//! Return true if transparent instances are drawn back to front
+	static bool isTransparencySortingActivated();
+
+	//! Return true if transparent instances are drawn with order independent transparency
+	static bool isOrderIndependentTransparencyActivated();
+
+	//! Return true if bodies LOD are chosen by several threads before drawing
+	static bool isParallelFramePreparationActivated();
+
+	//! Return true if instances hidden by other instances are culled with occlusion queries
+	static bool isOcclusionCullingActivated();
+
+	//! Return true if instances hidden by large instances are culled with a software depth buffer
+	static bool isSoftwareOcclusionCullingActivated();
+
+	//! Return true if the LOD of meshes are chosen from the screen space error of their accuracy
+	static bool isScreenSpaceErrorLodActivated();
+
+	//! Return true if the STL loader welds the vertices of binary STL
+	static bool isStlVertexWeldingActivated();
+
 	//! Return true valid
 	static bool isValid();
 //@}
@@ -152,6 +185,45 @@ public:
 	//! Set the frustum culling usage
 	static void setFrustumCullingUsage(bool);
 
+	//! Set the parallel loading usage
+	static void setParallelLoadingUsage(bool);
+
+	//! Set the state sorting usage
+	static void setStateSortingUsage(bool);
+
+	//! Set the instancing support
+	static void setInstancingSupport();
+
+	//! Set the instanced rendering usage
+	/*! Instanced rendering is used only if it's supported and GLSL is used*/
+	static void setInstancingUsage(bool);
+
+	//! Set the transparency sorting usage
+	static void setTransparencySortingUsage(bool);
+
+	//! Set the order independent transparency usage
+	/*! If order independent transparency is not supported, transparency sorting is used*/
+	static void setOrderIndependentTransparencyUsage(bool);
+
+	//! Set the parallel frame preparation usage
+	static void setParallelFramePreparationUsage(bool);
+
+	//! Set the occlusion culling usage
+	/*! Occlusion culling is used only if occlusion queries are supported*/
+	static void setOcclusionCullingUsage(bool);
+
+	//! Set the software occlusion culling usage
+	/*! If activated, it is used instead of occlusion queries*/
+	static void setSoftwareOcclusionCullingUsage(bool);
+
+	//! Set the screen space error LOD usage
+	/*! The maximum screen space error is set with GLC_Viewport::setScreenSpaceError()*/
+	static void setScreenSpaceErrorLodUsage(bool);
+
+	//! Set the vertex welding usage of the STL loader
+	/*! If activated, binary STL are loaded as indexed meshes with shared vertices*/
+	static void setStlVertexWeldingUsage(bool);
+
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -197,6 +269,39 @@ private:
 	//! Frustum culling activated
 	static bool m_IsFrustumCullingActivated;
 
+	//! Parallel loading activated
+	static bool m_IsParallelLoadingActivated;
+
+	//! State sorting activated
+	static bool m_IsStateSortingActivated;
+
+	//! Instancing supported
+	static bool m_IsInstancingSupported;
+
+	//! Instanced rendering activated
+	static bool m_IsInstancingActivated;
+
+	//! Transparency sorting activated
+	static bool m_IsTransparencySortingActivated;
+
+	//! Order independent transparency activated
+	static bool m_IsOrderIndependentTransparencyActivated;
+
+	//! Parallel frame preparation activated
+	static bool m_IsParallelFramePreparationActivated;
+
+	//! Occlusion culling activated
+	static bool m_IsOcclusionCullingActivated;
+
+	//! Software occlusion culling activated
+	static bool m_IsSoftwareOcclusionCullingActivated;
+
+	//! Screen space error LOD activated
+	static bool m_IsScreenSpaceErrorLodActivated;
+
+	//! STL vertex welding activated
+	static bool m_IsStlVertexWeldingActivated;
+
 	//! Frame buffer supported
 	static bool m_IsFrameBufferSupported;
 
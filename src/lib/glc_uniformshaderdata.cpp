@@ -28,6 +28,47 @@
 #include "glc_uniformshaderdata.h"
 
 
+namespace
+{
+// Compute the inverse transpose of the upper 3x3 part of the given matrix
+// The inverse transpose of a matrix is its cofactor matrix divided by its determinant
+void normalMatrix(const GLC_Matrix4x4& matrix, GLfloat result[3][3])
+{
+	if (matrix.type() == GLC_Matrix4x4::Identity)
+	{
+		for (int i= 0; i < 3; ++i)
+		{
+			for (int j= 0; j < 3; ++j) result[i][j]= (i == j) ? 1.0f : 0.0f;
+		}
+		return;
+	}
+
+	// Columns of the upper 3x3 part, the cofactor matrix columns are their cross products
+	const double* m= matrix.getData();
+	const double c0[3]= {m[0], m[1], m[2]};
+	const double c1[3]= {m[4], m[5], m[6]};
+	const double c2[3]= {m[8], m[9], m[10]};
+
+	double cofactor[3][3];
+	cofactor[0][0]= c1[1] * c2[2] - c1[2] * c2[1];
+	cofactor[0][1]= c1[2] * c2[0] - c1[0] * c2[2];
+	cofactor[0][2]= c1[0] * c2[1] - c1[1] * c2[0];
+	cofactor[1][0]= c2[1] * c0[2] - c2[2] * c0[1];
+	cofactor[1][1]= c2[2] * c0[0] - c2[0] * c0[2];
+	cofactor[1][2]= c2[0] * c0[1] - c2[1] * c0[0];
+	cofactor[2][0]= c0[1] * c1[2] - c0[2] * c1[1];
+	cofactor[2][1]= c0[2] * c1[0] - c0[0] * c1[2];
+	cofactor[2][2]= c0[0] * c1[1] - c0[1] * c1[0];
+
+	const double determinant= c0[0] * cofactor[0][0] + c0[1] * cofactor[0][1] + c0[2] * cofactor[0][2];
+	const double invDeterminant= (0.0 != determinant) ? (1.0 / determinant) : 1.0;
+	for (int i= 0; i < 3; ++i)
+	{
+		for (int j= 0; j < 3; ++j) result[i][j]= static_cast<GLfloat>(cofactor[i][j] * invDeterminant);
+	}
+}
+}
+
 GLC_UniformShaderData::GLC_UniformShaderData()
 {
 
@@ -100,16 +141,8 @@ void GLC_UniformShaderData::setModelViewProjectionMatrix(const GLC_Matrix4x4& mo
 	}
 
 	// Set the transpose of inv model view matrix (For normal computation)
-	GLC_Matrix4x4 invTransposeModelView= modelView.inverted();
-	invTransposeModelView.transpose();
 	GLfloat invTmdv[3][3];
-	{
-		const double* data= invTransposeModelView.getData();
-
-		invTmdv[0][0]= static_cast<GLfloat>(data[0]); invTmdv[1][0]= static_cast<GLfloat>(data[4]); invTmdv[2][0]= static_cast<GLfloat>(data[8]);
-		invTmdv[0][1]= static_cast<GLfloat>(data[1]); invTmdv[1][1]= static_cast<GLfloat>(data[5]); invTmdv[2][1]= static_cast<GLfloat>(data[9]);
-		invTmdv[0][2]= static_cast<GLfloat>(data[2]); invTmdv[1][2]= static_cast<GLfloat>(data[6]); invTmdv[2][2]= static_cast<GLfloat>(data[10]);
-	}
+	normalMatrix(modelView, invTmdv);
 
 	Q_ASSERT(GLC_Shader::hasActiveShader());
 
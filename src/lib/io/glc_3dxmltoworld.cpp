@@ -28,6 +28,7 @@
 #include "../geometry/glc_mesh.h"
 #include "../geometry/glc_3drep.h"
 #include "glc_xmlutil.h"
+#include "glc_numberparser.h"
 
 // Quazip library
 #include "../3rdparty/quazip/quazip.h"
@@ -37,6 +38,10 @@
 #include <QFileInfo>
 #include <QSet>
 #include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
 
 //using namespace glcXmlUtil;
 
@@ -44,6 +49,126 @@ QMutex GLC_3dxmlToWorld::m_ZipMutex;
 
 static qint64 chunckSize = 10000000;
 
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_3dxmlToWorld::ExternRepLoadingTask
+/*! \brief ExternRepLoadingTask : Load a set of extern representations
+ *  with its own GLC_3dxmlToWorld and its own archive handle */
+//////////////////////////////////////////////////////////////////////
+class GLC_3dxmlToWorld::ExternRepLoadingTask : public QRunnable
+{
+public:
+	ExternRepLoadingTask(const GLC_3dxmlToWorld* pMaster, QVector<GLC_3DRep>* pResult, QAtomicInt* pLoadedRepCount)
+		: QRunnable()
+		, m_pMaster(pMaster)
+		, m_pResult(pResult)
+		, m_pLoadedRepCount(pLoadedRepCount)
+		, m_IndexList()
+		, m_FileNameList()
+		, m_AttachedFileNames()
+		, m_ErrorMessage()
+		, m_Materials()
+		, m_ClonedMaterials()
+		, m_CreatedMaterials()
+	{
+		setAutoDelete(false);
+	}
+
+	//! Set the copies of the master materials given to the worker
+	inline void setMaterials(const MaterialHash& materials)
+	{m_Materials = materials;}
+
+	//! Add the representation of the given file name to load at the given result index
+	inline void addRepresentation(int index, const QString& fileName)
+	{
+		m_IndexList.append(index);
+		m_FileNameList.append(fileName);
+	}
+
+	//! Return the set of file attached by the loaded representations
+	inline QSet<QString> attachedFileNames() const
+	{return m_AttachedFileNames;}
+
+	//! Return the error message, empty if no error occurs
+	inline QString errorMessage() const
+	{return m_ErrorMessage;}
+
+	//! Return the list of result index of the representations
+	inline QList<int> indexList() const
+	{return m_IndexList;}
+
+	//! Return the used copies of master materials with their master material key
+	inline QHash<GLC_Material*, QString> clonedMaterials() const
+	{return m_ClonedMaterials;}
+
+	//! Return the used materials created by the worker
+	inline QList<GLC_Material*> createdMaterials() const
+	{return m_CreatedMaterials;}
+
+	virtual void run()
+	{
+		// The worker owns the copies of the master materials
+		GLC_3dxmlToWorld worker;
+		if (!worker.initExternRepWorker(m_pMaster, m_Materials))
+		{
+			m_ErrorMessage = QString("Unable to open ") + m_pMaster->m_FileName;
+			m_pLoadedRepCount->fetchAndAddOrdered(m_IndexList.size());
+			return;
+		}
+		const int count = m_IndexList.size();
+		for (int i = 0; i < count; ++i)
+		{
+			if (m_pMaster->isInterrupted())
+			{
+				m_pLoadedRepCount->fetchAndAddOrdered(count - i);
+				break;
+			}
+			try
+			{
+				(*m_pResult)[m_IndexList.at(i)] = worker.loadExternRep(m_FileNameList.at(i));
+			}
+			catch (GLC_Exception& e)
+			{
+				m_ErrorMessage = e.what();
+				m_pLoadedRepCount->fetchAndAddOrdered(count - i);
+				return;
+			}
+			m_pLoadedRepCount->fetchAndAddOrdered(1);
+		}
+		m_AttachedFileNames = worker.m_SetOfAttachedFileName;
+
+		// Keep the materials used by the representations, the others are deleted with the worker
+		MaterialHash::const_iterator iMaterial = worker.m_MaterialHash.constBegin();
+		while (worker.m_MaterialHash.constEnd() != iMaterial)
+		{
+			GLC_Material* pMaterial = iMaterial.value();
+			if (!pMaterial->isUnused())
+			{
+				if (m_Materials.contains(iMaterial.key()))
+				{
+					m_ClonedMaterials.insert(pMaterial, iMaterial.key());
+				}
+				else
+				{
+					m_CreatedMaterials.append(pMaterial);
+				}
+			}
+			++iMaterial;
+		}
+	}
+
+private:
+	const GLC_3dxmlToWorld* m_pMaster;
+	QVector<GLC_3DRep>* m_pResult;
+	QAtomicInt* m_pLoadedRepCount;
+	QList<int> m_IndexList;
+	QStringList m_FileNameList;
+	QSet<QString> m_AttachedFileNames;
+	QString m_ErrorMessage;
+	MaterialHash m_Materials;
+	QHash<GLC_Material*, QString> m_ClonedMaterials;
+	QList<GLC_Material*> m_CreatedMaterials;
+};
+
 GLC_3dxmlToWorld::GLC_3dxmlToWorld()
 	: QObject()
 	, m_pStreamReader(NULL)
@@ -76,6 +201,7 @@ GLC_3dxmlToWorld::GLC_3dxmlToWorld()
 	, m_ByteArrayList()
 	, m_IsVersion3(false)
 	, m_UseZipMutex(true)
+	, m_pInterruptionFlag(NULL)
 {
 
 }
@@ -215,14 +341,9 @@ GLC_3DRep GLC_3dxmlToWorld::create3DrepFrom3dxmlRep(const QString& fileName, boo
 
 	if (QFileInfo(m_CurrentFileName).suffix().toLower() == "3dxml")
 	{
-		if (GLC_State::cacheIsUsed() && GLC_State::currentCacheManager().isUsable(m_CurrentDateTime, QFileInfo(m_FileName).baseName(), QFileInfo(m_CurrentFileName).fileName()))
-		{
-			GLC_CacheManager cacheManager = GLC_State::currentCacheManager();
-
-			GLC_BSRep binaryRep = cacheManager.binary3DRep(QFileInfo(m_FileName).baseName(), QFileInfo(m_CurrentFileName).fileName());
-			resultRep = binaryRep.loadRep();
-		}
-		else
+		const bool loadedFromCache = GLC_State::cacheIsUsed()
+				&& GLC_State::currentCacheManager().loadCachedRep(m_CurrentDateTime, QFileInfo(m_FileName).baseName(), QFileInfo(m_CurrentFileName).fileName(), &resultRep);
+		if (!loadedFromCache)
 		{
 			if (setStreamReaderToFile(m_CurrentFileName, true))
 			{
@@ -244,13 +365,9 @@ GLC_3DRep GLC_3dxmlToWorld::create3DrepFrom3dxmlRep(const QString& fileName, boo
 	}
 	else if ((QFileInfo(m_CurrentFileName).suffix().toLower() == "3drep") || (QFileInfo(m_CurrentFileName).suffix().toLower() == "xml"))
 	{
-		if (GLC_State::cacheIsUsed() && GLC_State::currentCacheManager().isUsable(m_CurrentDateTime, QFileInfo(m_FileName).baseName(), QFileInfo(m_CurrentFileName).fileName()))
-		{
-			GLC_CacheManager cacheManager = GLC_State::currentCacheManager();
-			GLC_BSRep binaryRep = cacheManager.binary3DRep(QFileInfo(m_FileName).baseName(), QFileInfo(m_CurrentFileName).fileName());
-			resultRep = binaryRep.loadRep();
-		}
-		else
+		const bool loadedFromCache = GLC_State::cacheIsUsed()
+				&& GLC_State::currentCacheManager().loadCachedRep(m_CurrentDateTime, QFileInfo(m_FileName).baseName(), QFileInfo(m_CurrentFileName).fileName(), &resultRep);
+		if (!loadedFromCache)
 		{
 			if (setStreamReaderToFile(m_CurrentFileName, true))
 			{
@@ -477,9 +594,12 @@ void GLC_3dxmlToWorld::loadProductStructure()
 			{
 				QString referenceName = pInstance->name();
 				referenceName = referenceName.left(pInstance->name().lastIndexOf('.'));
-				QStringList stringList(m_FileName);
-				stringList.append("Reference not found : " + referenceName);
-				GLC_ErrorLog::addError(stringList);
+				if (!isInterrupted())
+				{
+					QStringList stringList(m_FileName);
+					stringList.append("Reference not found : " + referenceName);
+					GLC_ErrorLog::addError(stringList);
+				}
 				pRef = new GLC_StructReference(referenceName);
 			}
 
@@ -783,7 +903,7 @@ void GLC_3dxmlToWorld::loadExternalRef3D()
 	emit currentQuantum(currentQuantumValue);
 
 	SetOfExtRef::iterator iExtRef = m_SetOfExtRef.begin();
-	while (iExtRef != m_SetOfExtRef.constEnd())
+	while ((iExtRef != m_SetOfExtRef.constEnd()) && !isInterrupted())
 	{
 
 		m_CurrentFileName = (*iExtRef);
@@ -794,12 +914,10 @@ void GLC_3dxmlToWorld::loadExternalRef3D()
 			m_CurrentDateTime = QFileInfo(QFileInfo(m_FileName).absolutePath() + QDir::separator() + QFileInfo(m_CurrentFileName).fileName()).lastModified();
 		}
 
-		if (!m_LoadStructureOnly && GLC_State::cacheIsUsed() && GLC_State::currentCacheManager().isUsable(m_CurrentDateTime, QFileInfo(m_FileName).baseName(), m_CurrentFileName))
+		GLC_3DRep cachedRep;
+		if (!m_LoadStructureOnly && GLC_State::cacheIsUsed() && GLC_State::currentCacheManager().loadCachedRep(m_CurrentDateTime, QFileInfo(m_FileName).baseName(), m_CurrentFileName, &cachedRep))
 		{
-			GLC_CacheManager cacheManager = GLC_State::currentCacheManager();
-
-			GLC_BSRep binaryRep = cacheManager.binary3DRep(QFileInfo(m_FileName).baseName(), m_CurrentFileName);
-			GLC_3DRep* pRep = new GLC_3DRep(binaryRep.loadRep());
+			GLC_3DRep* pRep = new GLC_3DRep(cachedRep);
 
 			setRepresentationFileName(pRep);
 
@@ -1238,57 +1356,37 @@ void GLC_3dxmlToWorld::loadFace(GLC_Mesh* pMesh, const int lod, double accuracy)
 	// Trying to find triangles
 	if (!triangles.isEmpty())
 	{
-		// For 3dvia mesh
-		if (triangles.contains(','))
-		{
-			triangles.remove(',');
-		}
-		QTextStream trianglesStream(&triangles);
+		// For 3dvia mesh, commas are parsed as separator
 		IndexList trianglesIndex;
-		QString buff;
-		while ((!trianglesStream.atEnd()))
-		{
-			trianglesStream >> buff;
-			trianglesIndex.append(buff.toUInt());
-		}
+		glc::parseIndexes(QStringRef(&triangles), &trianglesIndex);
 		pMesh->addTriangles(pCurrentMaterial, trianglesIndex, lod, accuracy);
 	}
 	// Trying to find trips
 	if (!strips.isEmpty())
 	{
-
-		QStringList stripsList(strips.split(","));
-		const int size = stripsList.size();
-		for (int i = 0; i < size; ++i)
+		int stripStart= 0;
+		while (stripStart < strips.size())
 		{
-			//qDebug() << "Strip " << stripsList.at(i);
-			QTextStream stripsStream(&stripsList[i]);
+			int stripEnd= strips.indexOf(',', stripStart);
+			if (-1 == stripEnd) stripEnd= strips.size();
 			IndexList stripsIndex;
-			QString buff;
-			while ((!stripsStream.atEnd()))
-			{
-				stripsStream >> buff;
-				stripsIndex.append(buff.toUInt());
-			}
+			glc::parseIndexes(strips.midRef(stripStart, stripEnd - stripStart), &stripsIndex);
 			pMesh->addTrianglesStrip(pCurrentMaterial, stripsIndex, lod, accuracy);
+			stripStart= stripEnd + 1;
 		}
 	}
 	// Trying to find fans
 	if (!fans.isEmpty())
 	{
-		QStringList fansList(fans.split(","));
-		const int size = fansList.size();
-		for (int i = 0; i < size; ++i)
+		int fanStart= 0;
+		while (fanStart < fans.size())
 		{
-			QTextStream fansStream(&fansList[i]);
+			int fanEnd= fans.indexOf(',', fanStart);
+			if (-1 == fanEnd) fanEnd= fans.size();
 			IndexList fansIndex;
-			QString buff;
-			while ((!fansStream.atEnd()))
-			{
-				fansStream >> buff;
-				fansIndex.append(buff.toUInt());
-			}
+			glc::parseIndexes(fans.midRef(fanStart, fanEnd - fanStart), &fansIndex);
 			pMesh->addTrianglesFan(pCurrentMaterial, fansIndex, lod, accuracy);
+			fanStart= fanEnd + 1;
 		}
 	}
 
@@ -1297,24 +1395,16 @@ void GLC_3dxmlToWorld::loadFace(GLC_Mesh* pMesh, const int lod, double accuracy)
 // Load polyline
 void GLC_3dxmlToWorld::loadPolyline(GLC_Mesh* pMesh)
 {
-	QString data = readAttribute("vertices", true);
+	const QString data = readAttribute("vertices", true);
 
-	data.replace(',', ' ');
-	QTextStream dataStream(&data);
-	QList<GLfloat> values;
-	QString buff;
-	while ((!dataStream.atEnd()))
+	GLfloatVector values;
+	if (glc::parseFloats(QStringRef(&data), &values) && ((values.size() % 3) == 0))
 	{
-		dataStream >> buff;
-		values.append(buff.toFloat());
-	}
-	if ((values.size() % 3) == 0)
-	{
-		pMesh->addVerticeGroup(values.toVector());
+		pMesh->addVerticeGroup(values);
 	}
 	else
 	{
-		QString message(QString("polyline buffer is not a multiple of 3 ") + m_CurrentFileName);
+		QString message(QString("polyline buffer is not valid or is not a multiple of 3 ") + m_CurrentFileName);
 
 		QStringList stringList(message);
 		GLC_ErrorLog::addError(stringList);
@@ -1780,74 +1870,55 @@ void GLC_3dxmlToWorld::loadExternRepresentations()
 
 	QHash<const unsigned int, GLC_3DRep> repHash;
 
-	// Progress bar variables
-	const int size = m_ReferenceRepHash.size();
-	int previousQuantumValue = 0;
-	int currentQuantumValue = 0;
-	int currentFileIndex = 0;
-	emit currentQuantum(currentQuantumValue);
-
-	// Load all external rep
-	ReferenceRepHash::iterator iRefRep = m_ReferenceRepHash.begin();
-	while (iRefRep != m_ReferenceRepHash.constEnd())
+	if (!m_LoadStructureOnly && GLC_State::isParallelLoadingActivated() && (m_ReferenceRepHash.size() > 1))
+	{
+		loadExternRepresentationsInParallel(&repHash);
+	}
+	else
 	{
-		m_CurrentFileName = iRefRep.value();
-		const unsigned int id = iRefRep.key();
+		// Progress bar variables
+		const int size = m_ReferenceRepHash.size();
+		int previousQuantumValue = 0;
+		int currentFileIndex = 0;
+		emit currentQuantum(previousQuantumValue);
 
-		if (!m_IsInArchive)
+		// Load all external rep
+		ReferenceRepHash::iterator iRefRep = m_ReferenceRepHash.begin();
+		while ((iRefRep != m_ReferenceRepHash.constEnd()) && !isInterrupted())
 		{
-			// Get the 3DXML time stamp
-			m_CurrentDateTime = QFileInfo(QFileInfo(m_FileName).absolutePath() + QDir::separator() + QFileInfo(m_CurrentFileName).fileName()).lastModified();
-		}
+			m_CurrentFileName = iRefRep.value();
+			const unsigned int id = iRefRep.key();
 
-
-		if (!m_LoadStructureOnly && setStreamReaderToFile(m_CurrentFileName))
-		{
-			GLC_3DRep representation;
-			if (GLC_State::cacheIsUsed() && GLC_State::currentCacheManager().isUsable(m_CurrentDateTime, QFileInfo(m_FileName).baseName(), QFileInfo(m_CurrentFileName).fileName()))
+			if (!m_LoadStructureOnly)
 			{
-				GLC_CacheManager cacheManager = GLC_State::currentCacheManager();
-				GLC_BSRep binaryRep = cacheManager.binary3DRep(QFileInfo(m_FileName).baseName(), QFileInfo(m_CurrentFileName).fileName());
-				representation = binaryRep.loadRep();
-				setRepresentationFileName(&representation);
+				GLC_3DRep representation(loadExternRep(m_CurrentFileName));
+				if (!representation.isEmpty())
+				{
+					repHash.insert(id, representation);
+				}
 			}
 			else
 			{
-				representation = loadCurrentExtRep();
-				representation.clean();
-			}
-			if (!representation.isEmpty())
-			{
+				GLC_3DRep representation;
+				if (m_IsInArchive)
+				{
+					representation.setFileName(glc::builtArchiveString(m_FileName, m_CurrentFileName));
+				}
+				else
+				{
+					const QString repFileName = glc::builtFileString(m_FileName, m_CurrentFileName);
+					representation.setFileName(repFileName);
+					m_SetOfAttachedFileName << glc::archiveEntryFileName(repFileName);
+				}
+
 				repHash.insert(id, representation);
 			}
-		}
-		else if (m_LoadStructureOnly)
-		{
-			GLC_3DRep representation;
-			if (m_IsInArchive)
-			{
-				representation.setFileName(glc::builtArchiveString(m_FileName, m_CurrentFileName));
-			}
-			else
-			{
-				const QString repFileName = glc::builtFileString(m_FileName, m_CurrentFileName);
-				representation.setFileName(repFileName);
-				m_SetOfAttachedFileName << glc::archiveEntryFileName(repFileName);
-			}
 
-			repHash.insert(id, representation);
-		}
+			// Progrees bar indicator
+			emitProgress(++currentFileIndex, size, &previousQuantumValue);
 
-		// Progrees bar indicator
-		++currentFileIndex;
-		currentQuantumValue = static_cast<int>((static_cast<double>(currentFileIndex) / size) * 100);
-		if (currentQuantumValue > previousQuantumValue)
-		{
-			emit currentQuantum(currentQuantumValue);
+			++iRefRep;
 		}
-		previousQuantumValue = currentQuantumValue;
-
-		++iRefRep;
 	}
 
 	// Attach the ref to the structure reference
@@ -1882,6 +1953,216 @@ void GLC_3dxmlToWorld::loadExternRepresentations()
 
 }
 
+// Load the extern representations on a pool of threads and store them in the given hash
+void GLC_3dxmlToWorld::loadExternRepresentationsInParallel(QHash<const unsigned int, GLC_3DRep>* pRepHash)
+{
+	// Sort representation by id in order to have a deterministic result
+	QList<unsigned int> repIdList = m_ReferenceRepHash.keys();
+	qSort(repIdList);
+	const int size = repIdList.size();
+
+	QVector<GLC_3DRep> representations(size);
+	QAtomicInt loadedRepCount(0);
+	QStringList errorList;
+
+	const int workerCount = qBound(1, QThread::idealThreadCount(), size);
+	QList<ExternRepLoadingTask*> taskList;
+	for (int i = 0; i < workerCount; ++i)
+	{
+		// Materials are not thread safe, each worker uses its own copies
+		MaterialHash materials;
+		MaterialHash::const_iterator iMaterial = m_MaterialHash.constBegin();
+		while (m_MaterialHash.constEnd() != iMaterial)
+		{
+			materials.insert(iMaterial.key(), new GLC_Material(*(iMaterial.value())));
+			++iMaterial;
+		}
+		ExternRepLoadingTask* pTask = new ExternRepLoadingTask(this, &representations, &loadedRepCount);
+		pTask->setMaterials(materials);
+		taskList.append(pTask);
+	}
+	// Interleave the representations in order to balance workers load
+	for (int i = 0; i < size; ++i)
+	{
+		const unsigned int id = repIdList.at(i);
+		taskList[i % workerCount]->addRepresentation(i, m_ReferenceRepHash.value(id));
+	}
+
+	// Progress bar variables
+	int previousQuantumValue = 0;
+	emit currentQuantum(previousQuantumValue);
+
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(workerCount);
+	for (int i = 0; i < workerCount; ++i)
+	{
+		threadPool.start(taskList.at(i));
+	}
+	while (!threadPool.waitForDone(50))
+	{
+		emitProgress(loadedRepCount.load(), size, &previousQuantumValue);
+	}
+	emitProgress(size, size, &previousQuantumValue);
+
+	for (int i = 0; i < workerCount; ++i)
+	{
+		ExternRepLoadingTask* pTask = taskList.at(i);
+		m_SetOfAttachedFileName.unite(pTask->attachedFileNames());
+		if (!pTask->errorMessage().isEmpty())
+		{
+			errorList.append(pTask->errorMessage());
+		}
+	}
+	if (errorList.isEmpty())
+	{
+		mergeExternRepMaterials(taskList, &representations);
+	}
+	qDeleteAll(taskList);
+
+	if (!errorList.isEmpty())
+	{
+		QString message(QString("GLC_3dxmlToWorld::loadExternRepresentationsInParallel ") + errorList.join(" "));
+		GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
+		clear();
+		throw(fileFormatException);
+	}
+
+	for (int i = 0; i < size; ++i)
+	{
+		if (!representations.at(i).isEmpty())
+		{
+			pRepHash->insert(repIdList.at(i), representations.at(i));
+		}
+	}
+}
+
+// Replace the materials of the representations loaded by the given tasks with shared materials
+void GLC_3dxmlToWorld::mergeExternRepMaterials(const QList<ExternRepLoadingTask*>& taskList, QVector<GLC_3DRep>* pRepresentations)
+{
+	// Materials created by workers, by hash code
+	QHash<uint, GLC_Material*> createdMaterialHash;
+
+	const int taskCount = taskList.size();
+	for (int taskIndex = 0; taskIndex < taskCount; ++taskIndex)
+	{
+		const ExternRepLoadingTask* pTask = taskList.at(taskIndex);
+
+		// Copies of master materials are replaced by the master material and
+		// materials created by several workers are replaced by the first one
+		QHash<GLC_Material*, GLC_Material*> replacementHash;
+		const QHash<GLC_Material*, QString> clonedMaterials(pTask->clonedMaterials());
+		QHash<GLC_Material*, QString>::const_iterator iClone = clonedMaterials.constBegin();
+		while (clonedMaterials.constEnd() != iClone)
+		{
+			replacementHash.insert(iClone.key(), m_MaterialHash.value(iClone.value()));
+			++iClone;
+		}
+		const QList<GLC_Material*> createdMaterials(pTask->createdMaterials());
+		const int createdCount = createdMaterials.size();
+		for (int i = 0; i < createdCount; ++i)
+		{
+			GLC_Material* pMaterial = createdMaterials.at(i);
+			const uint code = pMaterial->hashCode();
+			if (createdMaterialHash.contains(code))
+			{
+				replacementHash.insert(pMaterial, createdMaterialHash.value(code));
+			}
+			else
+			{
+				createdMaterialHash.insert(code, pMaterial);
+			}
+		}
+		if (replacementHash.isEmpty()) continue;
+
+		const QList<int> indexList(pTask->indexList());
+		const int repCount = indexList.size();
+		for (int repIndex = 0; repIndex < repCount; ++repIndex)
+		{
+			GLC_3DRep& representation = (*pRepresentations)[indexList.at(repIndex)];
+			const int bodyCount = representation.numberOfBody();
+			for (int body = 0; body < bodyCount; ++body)
+			{
+				GLC_Mesh* pMesh = dynamic_cast<GLC_Mesh*>(representation.geomAt(body));
+				if (NULL == pMesh) continue;
+				const QList<GLC_Material*> materials(pMesh->materialSet().toList());
+				const int materialCount = materials.size();
+				for (int i = 0; i < materialCount; ++i)
+				{
+					GLC_Material* pMaterial = materials.at(i);
+					if (replacementHash.contains(pMaterial))
+					{
+						pMesh->replaceMaterial(pMaterial->id(), replacementHash.value(pMaterial));
+					}
+				}
+			}
+		}
+	}
+}
+
+// Load and return the extern representation of the given file name
+GLC_3DRep GLC_3dxmlToWorld::loadExternRep(const QString& fileName)
+{
+	m_CurrentFileName = fileName;
+	if (!m_IsInArchive)
+	{
+		// Get the 3DXML time stamp
+		m_CurrentDateTime = QFileInfo(QFileInfo(m_FileName).absolutePath() + QDir::separator() + QFileInfo(m_CurrentFileName).fileName()).lastModified();
+	}
+
+	GLC_3DRep representation;
+	if (setStreamReaderToFile(m_CurrentFileName))
+	{
+		if (GLC_State::cacheIsUsed() && GLC_State::currentCacheManager().loadCachedRep(m_CurrentDateTime, QFileInfo(m_FileName).baseName(), QFileInfo(m_CurrentFileName).fileName(), &representation))
+		{
+			setRepresentationFileName(&representation);
+		}
+		else
+		{
+			representation = loadCurrentExtRep();
+			representation.clean();
+		}
+	}
+	return representation;
+}
+
+// Init this worker from the given 3dxml loader in order to load extern representations
+bool GLC_3dxmlToWorld::initExternRepWorker(const GLC_3dxmlToWorld* pMaster, const MaterialHash& materials)
+{
+	m_FileName = pMaster->m_FileName;
+	m_IsInArchive = pMaster->m_IsInArchive;
+	m_CurrentDateTime = pMaster->m_CurrentDateTime;
+	m_IsVersion3 = pMaster->m_IsVersion3;
+	m_TextureImagesHash = pMaster->m_TextureImagesHash;
+
+	// The worker owns the given copies of the master materials
+	m_MaterialHash = materials;
+
+	// Each worker use its own archive handle
+	m_UseZipMutex = false;
+	if (m_IsInArchive)
+	{
+		m_p3dxmlArchive = new QuaZip(m_FileName);
+		if (!m_p3dxmlArchive->open(QuaZip::mdUnzip))
+		{
+			delete m_p3dxmlArchive;
+			m_p3dxmlArchive = NULL;
+			return false;
+		}
+	}
+	return true;
+}
+
+// Emit the current quantum if the given progress has changed
+void GLC_3dxmlToWorld::emitProgress(int currentIndex, int size, int* pPreviousQuantumValue)
+{
+	const int currentQuantumValue = static_cast<int>((static_cast<double>(currentIndex) / size) * 100);
+	if (currentQuantumValue > *pPreviousQuantumValue)
+	{
+		emit currentQuantum(currentQuantumValue);
+	}
+	*pPreviousQuantumValue = currentQuantumValue;
+}
+
 // Return the instance of the current extern representation
 GLC_3DRep GLC_3dxmlToWorld::loadCurrentExtRep()
 {
@@ -2338,25 +2619,18 @@ void GLC_3dxmlToWorld::loadRep(GLC_Mesh* pMesh)
 void GLC_3dxmlToWorld::loadVertexBuffer(GLC_Mesh* pMesh)
 {
 	{
-		QString verticePosition = getContent(m_pStreamReader, "Positions").replace(',', ' ');
+		const QString verticePosition = getContent(m_pStreamReader, "Positions");
 		//qDebug() << "Position " << verticePosition;
 		checkForXmlError("Error while retrieving Position ContentVertexBuffer");
 		// Load Vertice position
-		QTextStream verticeStream(&verticePosition);
-		QList<GLfloat> verticeValues;
-		QString buff;
-		while ((!verticeStream.atEnd()))
+		GLfloatVector verticeValues;
+		if (glc::parseFloats(QStringRef(&verticePosition), &verticeValues) && ((verticeValues.size() % 3) == 0))
 		{
-			verticeStream >> buff;
-			verticeValues.append(buff.toFloat());
-		}
-		if ((verticeValues.size() % 3) == 0)
-		{
-			pMesh->addVertice(verticeValues.toVector());
+			pMesh->addVertice(verticeValues);
 		}
 		else
 		{
-			QString message(QString("Vertice buffer is not a multiple of 3 ") + m_CurrentFileName);
+			QString message(QString("Vertice buffer is not valid or is not a multiple of 3 ") + m_CurrentFileName);
 
 			QStringList stringList(message);
 			GLC_ErrorLog::addError(stringList);
@@ -2368,25 +2642,18 @@ void GLC_3dxmlToWorld::loadVertexBuffer(GLC_Mesh* pMesh)
 	}
 
 	{
-		QString normals = getContent(m_pStreamReader, "Normals").replace(',', ' ');
+		const QString normals = getContent(m_pStreamReader, "Normals");
 		//qDebug() << "Normals " << normals;
 		checkForXmlError("Error while retrieving Normals values");
 		// Load Vertice Normals
-		QTextStream normalsStream(&normals);
-		QList<GLfloat> normalValues;
-		QString buff;
-		while ((!normalsStream.atEnd()))
-		{
-			normalsStream >> buff;
-			normalValues.append(buff.toFloat());
-		}
-		if ((normalValues.size() % 3) == 0)
+		GLfloatVector normalValues;
+		if (glc::parseFloats(QStringRef(&normals), &normalValues) && ((normalValues.size() % 3) == 0))
 		{
-			pMesh->addNormals(normalValues.toVector());
+			pMesh->addNormals(normalValues);
 		}
 		else
 		{
-			QString message(QString("Normal buffer is not a multiple of 3 ") + m_CurrentFileName);
+			QString message(QString("Normal buffer is not valid or is not a multiple of 3 ") + m_CurrentFileName);
 
 			QStringList stringList(message);
 			GLC_ErrorLog::addError(stringList);
@@ -2402,24 +2669,16 @@ void GLC_3dxmlToWorld::loadVertexBuffer(GLC_Mesh* pMesh)
 	{
 		if ((QXmlStreamReader::StartElement == m_pStreamReader->tokenType()) && (m_pStreamReader->name() == "TextureCoordinates"))
 		{
-			QString texels = getContent(m_pStreamReader, "TextureCoordinates").replace(',', ' ');
+			const QString texels = getContent(m_pStreamReader, "TextureCoordinates");
 			checkForXmlError("Error while retrieving Texture coordinates");
-			QTextStream texelStream(&texels);
-			QList<GLfloat> texelValues;
-			QString buff;
-			while ((!texelStream.atEnd()))
-			{
-				texelStream >> buff;
-				texelValues.append(buff.toFloat());
-			}
-
-			if ((texelValues.size() % 2) == 0)
+			GLfloatVector texelValues;
+			if (glc::parseFloats(QStringRef(&texels), &texelValues) && ((texelValues.size() % 2) == 0))
 			{
-				pMesh->addTexels(texelValues.toVector());
+				pMesh->addTexels(texelValues);
 			}
 			else
 			{
-				QString message(QString("Texel buffer is not a multiple of 2 ") + m_CurrentFileName);
+				QString message(QString("Texel buffer is not valid or is not a multiple of 2 ") + m_CurrentFileName);
 
 				QStringList stringList(message);
 				GLC_ErrorLog::addError(stringList);
@@ -31,6 +31,7 @@
 #include <QHash>
 #include <QSet>
 #include <QDateTime>
+#include <QAtomicInt>
 #include "../maths/glc_matrix4x4.h"
 #include "../sceneGraph/glc_3dviewinstance.h"
 
@@ -131,6 +132,9 @@ class GLC_LIB_EXPORT GLC_3dxmlToWorld : public QObject
 	typedef QHash<const QString, GLC_Material*> MaterialHash;
 	typedef QHash<const unsigned int, QString> ReferenceRepHash;
 
+	//! Task used to load a part of the extern representations in a worker thread
+	class ExternRepLoadingTask;
+
 //////////////////////////////////////////////////////////////////////
 /*! @name Constructor / Destructor */
 //@{
@@ -156,6 +160,11 @@ public:
 	inline QStringList listOfAttachedFileName() const
 	{return m_SetOfAttachedFileName.toList();}
 
+	//! Set the flag which interrupt the loading of representations when it is not 0
+	/*! The loaded world contains the representations loaded before the interruption*/
+	inline void setInterruptionFlag(const QAtomicInt* pFlag)
+	{m_pInterruptionFlag= pFlag;}
+
 
 //@}
 
@@ -258,6 +267,26 @@ private:
 	//! Load the extern representation
 	void loadExternRepresentations();
 
+	//! Load the extern representations on a pool of threads and store them in the given hash
+	void loadExternRepresentationsInParallel(QHash<const unsigned int, GLC_3DRep>* pRepHash);
+
+	//! Load and return the extern representation of the given file name
+	GLC_3DRep loadExternRep(const QString& fileName);
+
+	//! Init this worker from the given 3dxml loader in order to load extern representations
+	/*! The worker takes the ownership of the given materials*/
+	bool initExternRepWorker(const GLC_3dxmlToWorld* pMaster, const MaterialHash& materials);
+
+	//! Replace the materials of the representations loaded by the given tasks with shared materials
+	void mergeExternRepMaterials(const QList<ExternRepLoadingTask*>& taskList, QVector<GLC_3DRep>* pRepresentations);
+
+	//! Emit the current quantum if the given progress has changed
+	void emitProgress(int currentIndex, int size, int* pPreviousQuantumValue);
+
+	//! Return true if the loading has been interrupted
+	inline bool isInterrupted() const
+	{return (NULL != m_pInterruptionFlag) && (0 != m_pInterruptionFlag->load());}
+
 	//! Return the instance of the current extern representation
 	GLC_3DRep loadCurrentExtRep();
 
@@ -406,6 +435,9 @@ private:
     //! Flag to know if zip mutex must be used
     bool m_UseZipMutex;
 
+	//! Loading is interrupted when the flag is not 0
+	const QAtomicInt* m_pInterruptionFlag;
+
 };
 
 QXmlStreamReader::TokenType GLC_3dxmlToWorld::readNext()
@@ -0,0 +1,332 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+
+//! \file glc_asyncfileloader.cpp implementation of the GLC_AsyncFileLoader class.
+
+#include "glc_asyncfileloader.h"
+#include "glc_fileloader.h"
+#include "glc_3dxmltoworld.h"
+
+#include "../sceneGraph/glc_structreference.h"
+#include "../geometry/glc_3drep.h"
+#include "../glc_exception.h"
+#include "../glc_errorlog.h"
+
+#include <QThread>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_AsyncFileLoader::LoadingThread
+/*! \brief LoadingThread : The worker thread of an asynchronous loader */
+//////////////////////////////////////////////////////////////////////
+class GLC_AsyncFileLoader::LoadingThread : public QThread
+{
+public:
+	explicit LoadingThread(GLC_AsyncFileLoader* pLoader)
+	: QThread()
+	, m_pLoader(pLoader)
+	{}
+
+protected:
+	virtual void run()
+	{
+		m_pLoader->run();
+	}
+
+private:
+	GLC_AsyncFileLoader* m_pLoader;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Constructor
+//////////////////////////////////////////////////////////////////////
+GLC_AsyncFileLoader::GLC_AsyncFileLoader(QObject* pParent)
+: QObject(pParent)
+, m_pLoadingThread(NULL)
+, m_FileName()
+, m_LoadingMode(CompleteWorld)
+, m_IsLoading(false)
+, m_Canceled(0)
+, m_Mutex()
+, m_World()
+, m_AttachedFileNames()
+, m_ErrorMessage()
+, m_Success(false)
+, m_LoadedRepresentations()
+, m_RepresentationCount(0)
+, m_LoadedRepresentationCount(0)
+{
+	m_pLoadingThread= new LoadingThread(this);
+}
+
+GLC_AsyncFileLoader::~GLC_AsyncFileLoader()
+{
+	cancel();
+	m_pLoadingThread->wait();
+	delete m_pLoadingThread;
+
+	const int count= m_LoadedRepresentations.count();
+	for (int i= 0; i < count; ++i)
+	{
+		delete m_LoadedRepresentations.at(i).second;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Get Functions
+//////////////////////////////////////////////////////////////////////
+
+GLC_World GLC_AsyncFileLoader::world() const
+{
+	QMutexLocker locker(&m_Mutex);
+	return m_World;
+}
+
+QStringList GLC_AsyncFileLoader::attachedFileNames() const
+{
+	QMutexLocker locker(&m_Mutex);
+	return m_AttachedFileNames;
+}
+
+QString GLC_AsyncFileLoader::errorMessage() const
+{
+	QMutexLocker locker(&m_Mutex);
+	return m_ErrorMessage;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+bool GLC_AsyncFileLoader::load(const QString& fileName, LoadingMode mode)
+{
+	if (m_IsLoading) return false;
+
+	m_FileName= fileName;
+	m_LoadingMode= mode;
+	m_IsLoading= true;
+	m_Canceled.store(0);
+	m_World= GLC_World();
+	m_AttachedFileNames.clear();
+	m_ErrorMessage.clear();
+	m_Success= false;
+	m_RepresentationCount= 0;
+	m_LoadedRepresentationCount= 0;
+
+	m_pLoadingThread->start();
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Public slots
+//////////////////////////////////////////////////////////////////////
+
+void GLC_AsyncFileLoader::cancel()
+{
+	m_Canceled.store(1);
+}
+
+bool GLC_AsyncFileLoader::wait(unsigned long time)
+{
+	const bool isFinished= m_pLoadingThread->wait(time);
+	if (isFinished)
+	{
+		loadingFinished();
+	}
+	return isFinished;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private slots
+//////////////////////////////////////////////////////////////////////
+
+void GLC_AsyncFileLoader::publishStructure()
+{
+	if (m_IsLoading && !isCanceled())
+	{
+		emit structureLoaded();
+	}
+}
+
+void GLC_AsyncFileLoader::integrateRepresentations()
+{
+	QList<QPair<GLC_StructReference*, GLC_3DRep*> > loadedRepresentations;
+	{
+		QMutexLocker locker(&m_Mutex);
+		loadedRepresentations.swap(m_LoadedRepresentations);
+	}
+	const int count= loadedRepresentations.count();
+	if (0 == count) return;
+
+	for (int i= 0; i < count; ++i)
+	{
+		GLC_StructReference* pReference= loadedRepresentations.at(i).first;
+		GLC_3DRep* pRep= loadedRepresentations.at(i).second;
+		if (!isCanceled())
+		{
+			pReference->loadRepresentation(pRep);
+		}
+		delete pRep;
+	}
+	m_LoadedRepresentationCount+= count;
+	if (!isCanceled())
+	{
+		emit representationsLoaded(m_LoadedRepresentationCount, m_RepresentationCount);
+	}
+}
+
+void GLC_AsyncFileLoader::loadingFinished()
+{
+	if (!m_IsLoading || m_pLoadingThread->isRunning()) return;
+
+	integrateRepresentations();
+	m_IsLoading= false;
+
+	bool success;
+	{
+		QMutexLocker locker(&m_Mutex);
+		success= m_Success && !isCanceled();
+		if (!success) m_World= GLC_World();
+	}
+	emit finished(success);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_AsyncFileLoader::run()
+{
+	QFile file(m_FileName);
+	try
+	{
+		if ((StructureFirst == m_LoadingMode) && (QFileInfo(file).suffix().toLower() == "3dxml"))
+		{
+			loadStructureFirst(&file);
+		}
+		else
+		{
+			loadCompleteWorld(&file);
+		}
+	}
+	catch (GLC_Exception& e)
+	{
+		QMutexLocker locker(&m_Mutex);
+		m_ErrorMessage= e.what();
+		m_Success= false;
+	}
+
+	QMetaObject::invokeMethod(this, "loadingFinished", Qt::QueuedConnection);
+}
+
+void GLC_AsyncFileLoader::loadCompleteWorld(QFile* pFile)
+{
+	GLC_FileLoader loader;
+	connect(&loader, SIGNAL(currentQuantum(int)), this, SIGNAL(currentQuantum(int)));
+	loader.setInterruptionFlag(&m_Canceled);
+
+	QStringList attachedFileNames;
+	GLC_World world= loader.createWorldFromFile(*pFile, &attachedFileNames);
+
+	// The world is shared with the thread of the loader
+	QMutexLocker locker(&m_Mutex);
+	m_World= world;
+	m_AttachedFileNames= attachedFileNames;
+	m_Success= true;
+	world= GLC_World();
+}
+
+void GLC_AsyncFileLoader::loadStructureFirst(QFile* pFile)
+{
+	QList<QPair<GLC_StructReference*, QString> > representationsToLoad;
+	{
+		GLC_3dxmlToWorld structureLoader;
+		connect(&structureLoader, SIGNAL(currentQuantum(int)), this, SIGNAL(currentQuantum(int)));
+		GLC_World* pWorld= structureLoader.createWorldFrom3dxml(*pFile, true);
+
+		// Representations to load after the structure
+		const QList<GLC_StructReference*> referenceList(pWorld->references());
+		const int referenceCount= referenceList.count();
+		for (int i= 0; i < referenceCount; ++i)
+		{
+			GLC_StructReference* pReference= referenceList.at(i);
+			if (pReference->hasRepresentation() && !pReference->representationIsLoaded())
+			{
+				const QString fileName(pReference->representationFileName());
+				if (!fileName.isEmpty()) representationsToLoad.append(qMakePair(pReference, fileName));
+			}
+		}
+
+		QMutexLocker locker(&m_Mutex);
+		m_World= *pWorld;
+		delete pWorld;
+		m_AttachedFileNames= structureLoader.listOfAttachedFileName();
+		m_RepresentationCount= representationsToLoad.count();
+	}
+	QMetaObject::invokeMethod(this, "publishStructure", Qt::QueuedConnection);
+
+	const int count= representationsToLoad.count();
+	int previousQuantumValue= 0;
+	for (int i= 0; (i < count) && !isCanceled(); ++i)
+	{
+		GLC_3DRep* pRep= NULL;
+		try
+		{
+			GLC_3dxmlToWorld repLoader;
+			pRep= new GLC_3DRep(repLoader.create3DrepFrom3dxmlRep(representationsToLoad.at(i).second));
+		}
+		catch (GLC_Exception& e)
+		{
+			QStringList stringList("GLC_AsyncFileLoader::loadStructureFirst");
+			stringList.append(e.what());
+			GLC_ErrorLog::addError(stringList);
+		}
+
+		if (NULL != pRep)
+		{
+			bool postIntegration;
+			{
+				QMutexLocker locker(&m_Mutex);
+				postIntegration= m_LoadedRepresentations.isEmpty();
+				m_LoadedRepresentations.append(qMakePair(representationsToLoad.at(i).first, pRep));
+			}
+			// Representations loaded meanwhile are integrated by the same call
+			if (postIntegration)
+			{
+				QMetaObject::invokeMethod(this, "integrateRepresentations", Qt::QueuedConnection);
+			}
+		}
+
+		const int currentQuantumValue= static_cast<int>((static_cast<double>(i + 1) / count) * 100);
+		if (currentQuantumValue > previousQuantumValue)
+		{
+			emit currentQuantum(currentQuantumValue);
+			previousQuantumValue= currentQuantumValue;
+		}
+	}
+
+	QMutexLocker locker(&m_Mutex);
+	m_Success= true;
+}
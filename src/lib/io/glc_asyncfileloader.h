@@ -0,0 +1,225 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+
+//! \file glc_asyncfileloader.h interface for the GLC_AsyncFileLoader class.
+
+#ifndef GLC_ASYNCFILELOADER_H_
+#define GLC_ASYNCFILELOADER_H_
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QAtomicInt>
+#include <climits>
+
+#include "../sceneGraph/glc_world.h"
+
+#include "../glc_config.h"
+
+class QFile;
+class GLC_StructReference;
+class GLC_3DRep;
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_AsyncFileLoader
+/*! \brief GLC_AsyncFileLoader : Create a GLC_World from file on a worker thread */
+
+/*! GLC_AsyncFileLoader loads a 3D model with a GLC_FileLoader on its own thread
+ *  and signals the end of the loading with finished(bool).
+ *
+ *  With the StructureFirst mode, the structure of a 3DXML file is published
+ *  with structureLoaded() and the representations are then loaded one by one
+ *  on the worker thread and added to the world in the thread of the loader.
+ *  The structure of the world must not be modified until the loading is finished.
+ *
+ *  The loading can be canceled at any time, the 3DXML loader stops between
+ *  two representations, others loaders result is discarded.
+ */
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_AsyncFileLoader : public QObject
+{
+	Q_OBJECT
+
+	class LoadingThread;
+
+public:
+	//! The loading mode
+	enum LoadingMode
+	{
+		CompleteWorld,
+		StructureFirst
+	};
+
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	explicit GLC_AsyncFileLoader(QObject* pParent= NULL);
+
+	//! Cancel the current loading and wait for the worker thread
+	virtual ~GLC_AsyncFileLoader();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return true if a loading is in progress
+	inline bool isRunning() const
+	{return m_IsLoading;}
+
+	//! Return true if the current or last loading has been canceled
+	inline bool isCanceled() const
+	{return 0 != m_Canceled.load();}
+
+	//! Return the loaded world
+	/*! The world is valid after structureLoaded() or a successful finished()*/
+	GLC_World world() const;
+
+	//! Return the list of attached file name of the loaded world
+	QStringList attachedFileNames() const;
+
+	//! Return the error message of the last loading, empty if no error occurs
+	QString errorMessage() const;
+
+	//! Return the number of representations to load after the structure
+	inline int representationCount() const
+	{return m_RepresentationCount;}
+
+	//! Return the number of representations loaded after the structure
+	inline int loadedRepresentationCount() const
+	{return m_LoadedRepresentationCount;}
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Start the loading of the given file with the given mode
+	/*! Return false if a loading is already in progress*/
+	bool load(const QString& fileName, LoadingMode mode= CompleteWorld);
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Public slots
+//////////////////////////////////////////////////////////////////////
+public slots:
+	//! Cancel the current loading
+	void cancel();
+
+	//! Wait for the end of the current loading, return false on timeout
+	/*! If the loading is finished, finished() is emitted before returning*/
+	bool wait(unsigned long time= ULONG_MAX);
+
+//////////////////////////////////////////////////////////////////////
+// Qt Signals
+//////////////////////////////////////////////////////////////////////
+signals:
+	//! For progress bar management
+	void currentQuantum(int);
+
+	//! The structure of the world is available, its representations are not loaded
+	void structureLoaded();
+
+	//! Representations have been loaded and added to the world
+	void representationsLoaded(int loadedCount, int representationCount);
+
+	//! The loading is finished, success is false on error or cancel
+	void finished(bool success);
+
+//////////////////////////////////////////////////////////////////////
+// Private slots
+//////////////////////////////////////////////////////////////////////
+private slots:
+	//! Emit structureLoaded in the thread of the loader
+	void publishStructure();
+
+	//! Add loaded representations to the world in the thread of the loader
+	void integrateRepresentations();
+
+	//! End the loading in the thread of the loader
+	void loadingFinished();
+
+//////////////////////////////////////////////////////////////////////
+// Private services functions
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Load the file, called by the worker thread
+	void run();
+
+	//! Load the complete world
+	void loadCompleteWorld(QFile* pFile);
+
+	//! Load the structure of the 3DXML and then its representations
+	void loadStructureFirst(QFile* pFile);
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! The worker thread
+	LoadingThread* m_pLoadingThread;
+
+	//! The file to load
+	QString m_FileName;
+
+	//! The loading mode
+	LoadingMode m_LoadingMode;
+
+	//! True from load() to finished()
+	bool m_IsLoading;
+
+	//! Not 0 if the loading is canceled
+	QAtomicInt m_Canceled;
+
+	//! Protect members shared with the worker thread
+	mutable QMutex m_Mutex;
+
+	//! The loaded world
+	GLC_World m_World;
+
+	//! The attached file names
+	QStringList m_AttachedFileNames;
+
+	//! The error message
+	QString m_ErrorMessage;
+
+	//! True if the world has been loaded
+	bool m_Success;
+
+	//! Representations loaded by the worker thread and not yet added to the world
+	QList<QPair<GLC_StructReference*, GLC_3DRep*> > m_LoadedRepresentations;
+
+	//! Number of representations to load after the structure
+	int m_RepresentationCount;
+
+	//! Number of representations added to the world
+	int m_LoadedRepresentationCount;
+};
+
+#endif /* GLC_ASYNCFILELOADER_H_ */
@@ -26,12 +26,37 @@
 #include "../maths/glc_geomtools.h"
 #include "../glc_factory.h"
 #include "glc_xmlutil.h"
+#include "glc_numberparser.h"
+#include "../glc_state.h"
+
+#include <QRunnable>
 
 static QString prefixNodeId= "GLC_LIB_COLLADA_ID_";
 static int currentNodeId= 0;
 
 using namespace glcXmlUtil;
 
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_ColladaToWorld::MeshBuildingTask
+/*! \brief MeshBuildingTask : Build a mesh from its collada primitives */
+//////////////////////////////////////////////////////////////////////
+class GLC_ColladaToWorld::MeshBuildingTask : public QRunnable
+{
+public:
+	explicit MeshBuildingTask(MeshInfo* pMeshInfo)
+		: QRunnable()
+		, m_pMeshInfo(pMeshInfo)
+	{}
+
+	virtual void run()
+	{
+		GLC_ColladaToWorld::buildMesh(m_pMeshInfo);
+	}
+
+private:
+	MeshInfo* m_pMeshInfo;
+};
+
 // Default constructor
 GLC_ColladaToWorld::GLC_ColladaToWorld()
 : QObject()
@@ -60,6 +85,7 @@ GLC_ColladaToWorld::GLC_ColladaToWorld()
 , m_CurrentOffset(0)
 , m_ListOfAttachedFileName()
 , m_TransparentIsRgbZero(false)
+, m_ThreadPool()
 {
 	currentNodeId= 0;
 }
@@ -269,6 +295,9 @@ void GLC_ColladaToWorld::clear()
 	delete m_pMeshInfo;
 	m_pMeshInfo= NULL;
 
+	// Meshes can be built by worker threads
+	m_ThreadPool.waitForDone();
+
 	// Delete all geometry from the geometry hash
 	QHash<const QString, MeshInfo*>::iterator iGeomHash= m_GeometryHash.begin();
 	while (m_GeometryHash.constEnd() != iGeomHash)
@@ -772,6 +801,7 @@ void GLC_ColladaToWorld::loadGeometry()
 	if (!id.isEmpty())
 	{
 		m_GeometryHash.insert(id, m_pMeshInfo);
+		buildCurrentMesh();
 		m_pMeshInfo= NULL;
 	}
 }
@@ -805,7 +835,7 @@ void GLC_ColladaToWorld::loadVertexBulkData()
 	// load Vertex Bulk data id
 	m_CurrentId= readAttribute("id", true);
 	//qDebug() << "id=" << m_CurrentId;
-	QList<float> vertices;
+	GLfloatVector vertices;
 
 	while (endElementNotReached(m_pStreamReader, "source"))
 	{
@@ -815,15 +845,11 @@ void GLC_ColladaToWorld::loadVertexBulkData()
 			if ((currentElementName == "float_array"))
 			{
 				int count= readAttribute("count", true).toInt();
-				QString array= getContent("float_array");
-				QStringList list= array.split(' ');
+				const QString array= getContent("float_array");
+				vertices.reserve(count);
+				if (!glc::parseFloats(QStringRef(&array), &vertices)) throwException("Unable to convert float_array to float");
 				// Check the array size
-				if (count != list.size()) throwException("float_array size not match");
-
-				for (int i= 0; i < count; ++i)
-				{
-					vertices.append(list.at(i).toFloat());
-				}
+				if (count != vertices.size()) throwException("float_array size not match");
 			}
 			else if (currentElementName == "technique_common") loadTechniqueCommon();
 		}
@@ -904,68 +930,30 @@ void GLC_ColladaToWorld::loadPolylist()
 	// The number of polygon
 	const int polygonCount= readAttribute("count", true).toInt();
 
-	// The material id
-	const QString materialId= readAttribute("material", false);
-
-	// Offsets and data source list
-	QList<InputData> inputDataList;
-
-	// Polygon number of vertice list
-	QList<int> vcountList;
-
-	// Polygon index list
-	QList<int> polyIndexList;
+	PrimitiveData primitive;
+	primitive.m_MaterialId= readAttribute("material", false);
 
 	while (endElementNotReached(m_pStreamReader, "polylist"))
 	{
 		if (QXmlStreamReader::StartElement == m_pStreamReader->tokenType())
 		{
 			const QStringRef currentElementName= m_pStreamReader->name();
-			if ((currentElementName == "input") && vcountList.isEmpty())
+			if ((currentElementName == "input") && primitive.m_VCount.isEmpty())
 			{
-				InputData currentInput;
-				// Get input data offset
-				currentInput.m_Offset= readAttribute("offset", true).toInt();
-				// Get input data semantic
-				const QString semantic= readAttribute("semantic", true);
-				if (semantic == "VERTEX") currentInput.m_Semantic= VERTEX;
-				else if (semantic == "NORMAL") currentInput.m_Semantic= NORMAL;
-				else if (semantic == "TEXCOORD") currentInput.m_Semantic= TEXCOORD;
-				else throwException("Source semantic :" + semantic + "Not supported");
-				// Get input data source id
-				currentInput.m_Source= readAttribute("source", true).remove('#');
-
-				// Bypasss vertices indirection
-				if (m_VerticesSourceHash.contains(currentInput.m_Source))
-				{
-					currentInput.m_Source= m_VerticesSourceHash.value(currentInput.m_Source);
-				}
-				inputDataList.append(currentInput);
+				primitive.m_Inputs.append(loadInput());
 			}
-			else if ((currentElementName == "vcount") && (inputDataList.size() > 0))
+			else if ((currentElementName == "vcount") && (primitive.m_Inputs.size() > 0))
 			{
-				QString vcountString= getContent("vcount");
-				QStringList vcountStringList= vcountString.split(' ');
-				if (vcountStringList.size() != polygonCount) throwException("vcount size not match");
-				bool toIntOK;
-				for (int i= 0; i < polygonCount; ++i)
-				{
-					vcountList.append(vcountStringList.at(i).toInt(&toIntOK));
-					if (!toIntOK) throwException("Unable to convert string :" + vcountStringList.at(i) + " To int");
-				}
+				const QString vcountString= getContent("vcount");
+				primitive.m_VCount.reserve(polygonCount);
+				if (!glc::parseIntegers(QStringRef(&vcountString), &(primitive.m_VCount))) throwException("Unable to convert vcount to int");
+				if (primitive.m_VCount.size() != polygonCount) throwException("vcount size not match");
 			}
-			else if ((currentElementName == "p") && !vcountList.isEmpty() && polyIndexList.isEmpty())
+			else if ((currentElementName == "p") && !primitive.m_VCount.isEmpty() && primitive.m_Index.isEmpty())
 			{
 				{ // Fill index List
-					QString pString= getContent("p");
-					QStringList pStringList= pString.split(' ');
-					bool toIntOK;
-					const int size= pStringList.size();
-					for (int i= 0; i < size; ++i)
-					{
-						polyIndexList.append(pStringList.at(i).toInt(&toIntOK));
-						if (!toIntOK) throwException("Unable to convert string :" + pStringList.at(i) + " To int");
-					}
+					const QString pString= getContent("p");
+					if (!glc::parseIntegers(QStringRef(&pString), &(primitive.m_Index))) throwException("Unable to convert p to int");
 				}
 
 			}
@@ -973,7 +961,7 @@ void GLC_ColladaToWorld::loadPolylist()
 		m_pStreamReader->readNext();
 	}
 	// Add the polylist to the current mesh
-	addPolylistToCurrentMesh(inputDataList, vcountList, polyIndexList, materialId);
+	addPrimitiveToCurrentMesh(primitive);
 
 	updateProgressBar();
 }
@@ -981,435 +969,378 @@ void GLC_ColladaToWorld::loadPolylist()
 // Load Polygons
 void GLC_ColladaToWorld::loadPolygons()
 {
-	// The material id
-	const QString materialId= readAttribute("material", false);
-
-	// Offsets and data source list
-	QList<InputData> inputDataList;
-
-	// Polygon number of vertice list
-	QList<int> vcountList;
+	PrimitiveData primitive;
+	primitive.m_MaterialId= readAttribute("material", false);
 
-	// The input number
-	int inputCount= 0;
-	// Polygon index list
-	QList<int> polyIndexList;
+	// The number of index by vertice
+	int indexStride= 0;
 	while (endElementNotReached(m_pStreamReader, "polygons"))
 	{
 		if (QXmlStreamReader::StartElement == m_pStreamReader->tokenType())
 		{
 			const QStringRef currentElementName= m_pStreamReader->name();
-			if ((currentElementName == "input") && vcountList.isEmpty())
+			if ((currentElementName == "input") && primitive.m_VCount.isEmpty())
 			{
-				++inputCount;
-				InputData currentInput;
-				// Get input data offset
-				currentInput.m_Offset= readAttribute("offset", true).toInt();
-				// Get input data semantic
-				const QString semantic= readAttribute("semantic", true);
-				if (semantic == "VERTEX") currentInput.m_Semantic= VERTEX;
-				else if (semantic == "NORMAL") currentInput.m_Semantic= NORMAL;
-				else if (semantic == "TEXCOORD") currentInput.m_Semantic= TEXCOORD;
-				else throwException("Source semantic :" + semantic + "Not supported");
-				// Get input data source id
-				currentInput.m_Source= readAttribute("source", true).remove('#');
-
-				// Bypasss vertices indirection
-				if (m_VerticesSourceHash.contains(currentInput.m_Source))
-				{
-					currentInput.m_Source= m_VerticesSourceHash.value(currentInput.m_Source);
-				}
-				inputDataList.append(currentInput);
+				primitive.m_Inputs.append(loadInput());
+				indexStride= qMax(indexStride, primitive.m_Inputs.last().m_Offset + 1);
 			}
-			else if (currentElementName == "p")
+			else if ((currentElementName == "p") && (indexStride > 0))
 			{
 				{ // Fill index List
-					QString pString= getContent("p");
-					QStringList pStringList= pString.split(' ');
-					bool toIntOK;
-					const int size= pStringList.size();
-					for (int i= 0; i < size; ++i)
-					{
-						polyIndexList.append(pStringList.at(i).toInt(&toIntOK));
-						if (!toIntOK) throwException("Unable to convert string :" + pStringList.at(i) + " To int");
-					}
+					const QString pString= getContent("p");
+					const int previousSize= primitive.m_Index.size();
+					if (!glc::parseIntegers(QStringRef(&pString), &(primitive.m_Index))) throwException("Unable to convert p to int");
 					// Add the polygon size in vcountList
-					vcountList.append(size / inputCount);
+					primitive.m_VCount.append((primitive.m_Index.size() - previousSize) / indexStride);
 				}
 			}
 		}
 		m_pStreamReader->readNext();
 	}
 	// Add the polylist to the current mesh
-	addPolylistToCurrentMesh(inputDataList, vcountList, polyIndexList, materialId);
+	addPrimitiveToCurrentMesh(primitive);
 
 	updateProgressBar();
 }
 
-// Add the polylist to the current mesh
-void GLC_ColladaToWorld::addPolylistToCurrentMesh(const QList<InputData>& inputDataList, const QList<int>& vcountList, const QList<int>& polyIndexList, const QString& materialId)
+// Load triangles
+void  GLC_ColladaToWorld::loadTriangles()
 {
-	//qDebug() << "GLC_ColladaToWorld::addPolylistToCurrentMesh";
-
-	const int polygonCount= vcountList.size();
-	const int inputDataCount= inputDataList.size();
-	const int polyIndexCount= polyIndexList.size();
+	//qDebug() << "GLC_ColladaToWorld::loadTriangles()";
+	PrimitiveData primitive;
+	primitive.m_MaterialId= readAttribute("material", false);
 
-	// Flag to know if the polylist has normal
-	bool hasNormals= false;
-	bool hasTexture= false;
-	// Check the existance of data source
-	for (int dataIndex= 0; dataIndex < inputDataCount; ++dataIndex)
+	while (endElementNotReached(m_pStreamReader, "triangles"))
 	{
-		const QString source= inputDataList.at(dataIndex).m_Source;
-		if ( !m_BulkDataHash.contains(source))
+		if (QXmlStreamReader::StartElement == m_pStreamReader->tokenType())
 		{
-			throwException(" Source : " + source + " Not found");
-		}
-		if (inputDataList.at(dataIndex).m_Semantic == NORMAL) hasNormals= true;
-		if (inputDataList.at(dataIndex).m_Semantic == TEXCOORD) hasTexture= true;
-	}
+			const QStringRef currentElementName= m_pStreamReader->name();
+			if ((currentElementName == "input") && primitive.m_Index.isEmpty())
+			{
+				primitive.m_Inputs.append(loadInput());
+			}
+			else if ((currentElementName == "p") && primitive.m_Index.isEmpty())
+			{
+				{ // Fill index List
+					const QString pString= getContent("p");
+					if (!glc::parseIntegers(QStringRef(&pString), &(primitive.m_Index))) throwException("Unable to convert p to int");
+				}
 
-	int maxOffset= 0;
-	for (int i= 0; i < inputDataCount; ++i)
-	{
-		if (inputDataList.at(i).m_Offset > maxOffset)
-		{
-			maxOffset= inputDataList.at(i).m_Offset;
+			}
 		}
+		m_pStreamReader->readNext();
 	}
-	//qDebug() << " Max Offset :" << maxOffset;
 
-	// the polygonIndex of the polylist
-	QList<int> polygonIndex;
+	// Add the triangles to the current mesh
+	addPrimitiveToCurrentMesh(primitive);
 
-	// Fill the mapping, bulk data and index list of the current mesh info
-	for (int i= 0; i < polyIndexCount; i+= maxOffset + 1)
-	{
-		// Create and set the current vertice index
-		ColladaVertice currentVertice;
-		for (int dataIndex= 0; dataIndex < inputDataCount; ++dataIndex)
-		{
-			currentVertice.m_Values[inputDataList.at(dataIndex).m_Semantic]= polyIndexList.at(i + inputDataList.at(dataIndex).m_Offset);
-		}
+	updateProgressBar();
 
-		if (m_pMeshInfo->m_Mapping.contains(currentVertice))
-		{
-			// Add the the index to the polygon index
-			polygonIndex.append(m_pMeshInfo->m_Mapping.value(currentVertice));
-		}
-		else
-		{
-			// Add the current vertice to the current mesh info mapping hash table and increment the freeIndex
-			m_pMeshInfo->m_Mapping.insert(currentVertice, (m_pMeshInfo->m_FreeIndex)++);
-			// Add the the index to the polygon index
-			polygonIndex.append(m_pMeshInfo->m_Mapping.value(currentVertice));
+}
 
-			// Add the bulk data associated to the current vertice to the current mesh info
-			for (int dataIndex= 0; dataIndex < inputDataCount; ++dataIndex)
-			{
-				// The current input data
-				InputData currentInputData= inputDataList.at(dataIndex);
-				// QHash iterator on the right QList<float>
-				BulkDataHash::const_iterator iBulkHash= m_BulkDataHash.find(currentInputData.m_Source);
-				int stride;
-				if (m_DataAccessorHash.contains(currentInputData.m_Source))
-				{
-					stride= m_DataAccessorHash.value(currentInputData.m_Source).m_Stride;
-				}
-				else if (currentInputData.m_Semantic != TEXCOORD) stride= 3; else stride= 2;
-				// Firts value
-				m_pMeshInfo->m_Datas[currentInputData.m_Semantic].append(iBulkHash.value().at(polyIndexList.at(i + currentInputData.m_Offset) * stride));
-				// Second value
-				m_pMeshInfo->m_Datas[currentInputData.m_Semantic].append(iBulkHash.value().at(polyIndexList.at(i + currentInputData.m_Offset) * stride + 1));
-				// Fird value
-				if (currentInputData.m_Semantic != TEXCOORD)
-				{
-					m_pMeshInfo->m_Datas[currentInputData.m_Semantic].append(iBulkHash.value().at(polyIndexList.at(i + currentInputData.m_Offset) * stride + 2));
-				}
-			}
-			// Avoid problem wich occur with mesh containing materials with and without texture
-			if (!hasTexture)
-			{
-				m_pMeshInfo->m_Datas[TEXCOORD].append(0.0);
-			}
+// Load an input of a primitive element
+GLC_ColladaToWorld::InputData GLC_ColladaToWorld::loadInput()
+{
+	InputData currentInput;
+	// Get input data offset
+	currentInput.m_Offset= readAttribute("offset", true).toInt();
+	// Get input data semantic
+	const QString semantic= readAttribute("semantic", true);
+	if (semantic == "VERTEX") currentInput.m_Semantic= VERTEX;
+	else if (semantic == "NORMAL") currentInput.m_Semantic= NORMAL;
+	else if (semantic == "TEXCOORD") currentInput.m_Semantic= TEXCOORD;
+	else throwException("Source semantic :" + semantic + "Not supported");
+	// Get input data source id
+	currentInput.m_Source= readAttribute("source", true).remove('#');
+
+	// Bypasss vertices indirection
+	if (m_VerticesSourceHash.contains(currentInput.m_Source))
+	{
+		currentInput.m_Source= m_VerticesSourceHash.value(currentInput.m_Source);
+	}
+	return currentInput;
+}
 
-		}
-	}
+// Add the given primitive to the current mesh and resolve its sources
+void GLC_ColladaToWorld::addPrimitiveToCurrentMesh(const PrimitiveData& primitive)
+{
+	// Bulk data are shared with the mesh info so the worker thread never reads reader hash tables
+	const int inputDataCount= primitive.m_Inputs.size();
+	for (int dataIndex= 0; dataIndex < inputDataCount; ++dataIndex)
+	{
+		const InputData& currentInputData= primitive.m_Inputs.at(dataIndex);
+		if (m_pMeshInfo->m_Sources.contains(currentInputData.m_Source)) continue;
 
-	// Save mesh info index offset
-	const int indexOffset= m_pMeshInfo->m_Index.size();
-	// Triangulate the polygons of the polylist
-	// Input polygon index must start from 0 and succesive : (0 1 2 3 4)
-	QList<GLuint> onePolygonIndex;
-	for (int i= 0; i < polygonCount; ++i)
-	{
-		const int polygonSize= vcountList.at(i);
-		Q_ASSERT(polygonSize > 2);
-		for (int i= 0; i < polygonSize; ++i)
-		{
-			onePolygonIndex.append(polygonIndex.takeFirst());
-		}
-		// Triangulate the current polygon if the polygon as more than 3 vertice
-		if (polygonSize > 3)
+		BulkDataHash::const_iterator iBulkHash= m_BulkDataHash.constFind(currentInputData.m_Source);
+		if (m_BulkDataHash.constEnd() == iBulkHash)
 		{
-			glc::triangulatePolygon(&onePolygonIndex, m_pMeshInfo->m_Datas.at(VERTEX));
+			throwException(" Source : " + currentInputData.m_Source + " Not found");
 		}
-		// Add index to the mesh info
-		//Q_ASSERT(not onePolygonIndex.isEmpty());
-		if (!onePolygonIndex.isEmpty())
+		SourceData sourceData;
+		sourceData.m_Values= iBulkHash.value();
+		if (m_DataAccessorHash.contains(currentInputData.m_Source))
 		{
-			m_pMeshInfo->m_Index.append(onePolygonIndex);
+			sourceData.m_Stride= m_DataAccessorHash.value(currentInputData.m_Source).m_Stride;
 		}
-		else
-		{
-			QStringList stringList(m_FileName);
-			stringList.append("Unable to triangulate a polygon of " + m_pMeshInfo->m_pMesh->name());
-			GLC_ErrorLog::addError(stringList);
-		}
-		onePolygonIndex.clear();
-	}
+		else if (currentInputData.m_Semantic != TEXCOORD) sourceData.m_Stride= 3; else sourceData.m_Stride= 2;
 
-	// Check if normal computation is needed
-	if (!hasNormals)
-	{
-		qDebug() << "Compute Normals with offset " << indexOffset;
-		computeNormalOfCurrentPrimitiveOfCurrentMesh(indexOffset);
+		m_pMeshInfo->m_Sources.insert(currentInputData.m_Source, sourceData);
 	}
-
-	// Add material the current mesh info
-	MatOffsetSize matInfo;
-	matInfo.m_Offset= indexOffset;
-	matInfo.m_size= m_pMeshInfo->m_Index.size() - indexOffset;
-	m_pMeshInfo->m_Materials.insert(materialId, matInfo);
-
+	m_pMeshInfo->m_Primitives.append(primitive);
 }
-// Compute Normals for the current primitive element of the current mesh
-void GLC_ColladaToWorld::computeNormalOfCurrentPrimitiveOfCurrentMesh(int indexOffset)
+
+// Build the current mesh on a worker thread or immediately
+void GLC_ColladaToWorld::buildCurrentMesh()
 {
-	const QList<float>* pData= &(m_pMeshInfo->m_Datas.at(VERTEX));
-	// Fill the list of normal
-	QList<float>* pNormal= &(m_pMeshInfo->m_Datas[NORMAL]);
-	const int normalOffset= pNormal->size();
-	const int normalCount= pData->size() - normalOffset;
-	for (int i= 0; i < normalCount; ++i)
+	if (GLC_State::isParallelLoadingActivated())
 	{
-		pNormal->append(0.0f);
+		// The mesh info is not accessed by the reader until createMesh()
+		m_ThreadPool.start(new MeshBuildingTask(m_pMeshInfo));
 	}
-	// Compute the normals and add them to the current mesh info
-	const int size= m_pMeshInfo->m_Index.size() - indexOffset;
-	double xn, yn, zn;
-
-
-	for (int i= indexOffset; i < size; i+=3)
+	else
 	{
-		// Vertex 1
-		xn= pData->at(m_pMeshInfo->m_Index.at(i) * 3);
-		yn= pData->at(m_pMeshInfo->m_Index.at(i) * 3 + 1);
-		zn= pData->at(m_pMeshInfo->m_Index.at(i) * 3 + 2);
-		const GLC_Vector3d vect1(xn, yn, zn);
-
-		// Vertex 2
-		xn= pData->at(m_pMeshInfo->m_Index.at(i + 1) * 3);
-		yn= pData->at(m_pMeshInfo->m_Index.at(i + 1) * 3  + 1);
-		zn= pData->at(m_pMeshInfo->m_Index.at(i + 1) * 3 + 2);
-		const GLC_Vector3d vect2(xn, yn, zn);
-
-		// Vertex 3
-		xn= pData->at(m_pMeshInfo->m_Index.at(i + 2) * 3);
-		yn= pData->at(m_pMeshInfo->m_Index.at(i + 2) * 3 + 1);
-		zn= pData->at(m_pMeshInfo->m_Index.at(i + 2) * 3 + 2);
-		const GLC_Vector3d vect3(xn, yn, zn);
-
-		const GLC_Vector3d edge1(vect3 - vect2);
-		const GLC_Vector3d edge2(vect1 - vect2);
-
-		GLC_Vector3d normal(edge1 ^ edge2);
-		normal.normalize();
-
-		GLC_Vector3df curNormal= normal.toVector3df();
-		for (int curVertex= 0; curVertex < 3; ++curVertex)
-		{
-			(*pNormal)[m_pMeshInfo->m_Index.at(i + curVertex) * 3]= curNormal.x();
-			(*pNormal)[m_pMeshInfo->m_Index.at(i + curVertex) * 3 + 1]= curNormal.y();
-			(*pNormal)[m_pMeshInfo->m_Index.at(i + curVertex) * 3 + 2]= curNormal.z();
-		}
+		buildMesh(m_pMeshInfo);
 	}
 }
 
-// Load triangles
-void  GLC_ColladaToWorld::loadTriangles()
+// Build the given mesh info from its primitives
+void GLC_ColladaToWorld::buildMesh(MeshInfo* pMeshInfo)
 {
-	//qDebug() << "GLC_ColladaToWorld::loadTriangles()";
-	// The material id
-	const QString materialId= readAttribute("material", false);
-
-	// Offsets and data source list
-	QList<InputData> inputDataList;
-
-	// triangle index list
-	QList<int> trianglesIndexList;
-
-	while (endElementNotReached(m_pStreamReader, "triangles"))
+	// Texels are added to all vertices if one primitive is textured
+	bool meshHasTexture= false;
+	const int primitiveCount= pMeshInfo->m_Primitives.size();
+	for (int i= 0; (i < primitiveCount) && !meshHasTexture; ++i)
 	{
-		if (QXmlStreamReader::StartElement == m_pStreamReader->tokenType())
+		const QList<InputData>& inputs= pMeshInfo->m_Primitives.at(i).m_Inputs;
+		const int inputCount= inputs.size();
+		for (int dataIndex= 0; dataIndex < inputCount; ++dataIndex)
 		{
-			const QStringRef currentElementName= m_pStreamReader->name();
-			if ((currentElementName == "input") && trianglesIndexList.isEmpty())
-			{
-				InputData currentInput;
-				// Get input data offset
-				currentInput.m_Offset= readAttribute("offset", true).toInt();
-				// Get input data semantic
-				const QString semantic= readAttribute("semantic", true);
-				if (semantic == "VERTEX") currentInput.m_Semantic= VERTEX;
-				else if (semantic == "NORMAL") currentInput.m_Semantic= NORMAL;
-				else if (semantic == "TEXCOORD") currentInput.m_Semantic= TEXCOORD;
-				else throwException("Source semantic :" + semantic + "Not supported");
-				// Get input data source id
-				currentInput.m_Source= readAttribute("source", true).remove('#');
-
-				// Bypasss vertices indirection
-				if (m_VerticesSourceHash.contains(currentInput.m_Source))
-				{
-					currentInput.m_Source= m_VerticesSourceHash.value(currentInput.m_Source);
-				}
-				inputDataList.append(currentInput);
-			}
-			else if ((currentElementName == "p") && trianglesIndexList.isEmpty())
-			{
-				{ // Fill index List
-					QString pString= getContent("p");
-					QStringList pStringList= pString.split(' ');
-					bool toIntOK;
-					const int size= pStringList.size();
-					for (int i= 0; i < size; ++i)
-					{
-						trianglesIndexList.append(pStringList.at(i).toInt(&toIntOK));
-						if (!toIntOK) throwException("Unable to convert string :" + pStringList.at(i) + " To int");
-					}
-				}
-
-			}
+			meshHasTexture= meshHasTexture || (inputs.at(dataIndex).m_Semantic == TEXCOORD);
 		}
-		m_pStreamReader->readNext();
 	}
 
-	// Add the polylist to the current mesh
-	addTrianglesToCurrentMesh(inputDataList, trianglesIndexList, materialId);
+	// Mapping between collada vertice and mesh index
+	QHash<ColladaVertice, GLuint> mapping;
+	bool success= true;
+	for (int i= 0; (i < primitiveCount) && success; ++i)
+	{
+		success= addPrimitiveToMesh(pMeshInfo, pMeshInfo->m_Primitives.at(i), &mapping, meshHasTexture);
+	}
+	pMeshInfo->m_Primitives.clear();
+	pMeshInfo->m_Sources.clear();
+	if (!success) return;
 
-	updateProgressBar();
+	// Add Bulk Data to the mesh
+	GLC_Mesh* pMesh= pMeshInfo->m_pMesh;
+	pMesh->addVertice(pMeshInfo->m_Datas.at(VERTEX));
+	pMeshInfo->m_Datas[VERTEX].clear();
+
+	pMesh->addNormals(pMeshInfo->m_Datas.at(NORMAL));
+	pMeshInfo->m_Datas[NORMAL].clear();
 
+	if (!pMeshInfo->m_Datas.at(TEXCOORD).isEmpty())
+	{
+		pMesh->addTexels(pMeshInfo->m_Datas.at(TEXCOORD));
+		pMeshInfo->m_Datas[TEXCOORD].clear();
+	}
 }
 
-// Add the triangles to current mesh
-void GLC_ColladaToWorld::addTrianglesToCurrentMesh(const QList<InputData>& inputDataList, const QList<int>& trianglesIndexList, const QString& materialId)
+// De-interleave and triangulate the given primitive and add it to the given mesh info
+bool GLC_ColladaToWorld::addPrimitiveToMesh(MeshInfo* pMeshInfo, const PrimitiveData& primitive, QHash<ColladaVertice, GLuint>* pMapping, bool meshHasTexture)
 {
-	//qDebug() << "GLC_ColladaToWorld::addTrianglesToCurrentMesh";
-
+	// Keep the first input of each semantic
+	QList<InputData> inputDataList;
+	QList<const SourceData*> sourceList;
+	bool semanticIsUsed[3]= {false, false, false};
+	int maxOffset= 0;
+	const int primitiveInputCount= primitive.m_Inputs.size();
+	for (int i= 0; i < primitiveInputCount; ++i)
+	{
+		const InputData& currentInputData= primitive.m_Inputs.at(i);
+		maxOffset= qMax(maxOffset, currentInputData.m_Offset);
+		if (semanticIsUsed[currentInputData.m_Semantic]) continue;
+		semanticIsUsed[currentInputData.m_Semantic]= true;
+		inputDataList.append(currentInputData);
+		sourceList.append(&(pMeshInfo->m_Sources.constFind(currentInputData.m_Source).value()));
+	}
+	const bool hasNormals= semanticIsUsed[NORMAL];
+	const bool hasTexture= semanticIsUsed[TEXCOORD];
 	const int inputDataCount= inputDataList.size();
-	const int trianglesIndexCount= trianglesIndexList.size();
 
-	// Flag to know if the polylist has normal
-	bool hasNormals= false;
-	bool hasTexture= false;
+	const int indexStride= maxOffset + 1;
+	const int verticeCount= primitive.m_Index.size() / indexStride;
 
-	// Check the existance of data source
-	for (int dataIndex= 0; dataIndex < inputDataCount; ++dataIndex)
+	// Mesh index of each vertice of the primitive
+	QVector<GLuint> verticeIndex(verticeCount);
+	GLuint freeIndex= static_cast<GLuint>(pMeshInfo->m_Datas.at(VERTEX).size() / 3);
+	for (int i= 0; i < verticeCount; ++i)
 	{
-		const QString source= inputDataList.at(dataIndex).m_Source;
-		if ( !m_BulkDataHash.contains(source))
+		const int* pColladaIndex= primitive.m_Index.constData() + (i * indexStride);
+
+		// Create and set the current vertice index
+		ColladaVertice currentVertice;
+		for (int dataIndex= 0; dataIndex < inputDataCount; ++dataIndex)
 		{
-			throwException(" Source : " + source + " Not found");
+			currentVertice.m_Values[inputDataList.at(dataIndex).m_Semantic]= pColladaIndex[inputDataList.at(dataIndex).m_Offset];
 		}
-		if (inputDataList.at(dataIndex).m_Semantic == NORMAL) hasNormals= true;
-		if (inputDataList.at(dataIndex).m_Semantic == TEXCOORD) hasTexture= true;
-	}
 
-	int maxOffset= 0;
-	for (int i= 0; i < inputDataCount; ++i)
-	{
-		if (inputDataList.at(i).m_Offset > maxOffset)
+		QHash<ColladaVertice, GLuint>::const_iterator iVertice= pMapping->constFind(currentVertice);
+		if (pMapping->constEnd() != iVertice)
 		{
-			maxOffset= inputDataList.at(i).m_Offset;
+			verticeIndex[i]= iVertice.value();
+			continue;
 		}
-	}
-	//qDebug() << " Triangles Max Offset :" << maxOffset;
-
-	// the polygonIndex of the polylist
-	QList<GLuint> trianglesIndex;
 
-	// Fill the mapping, bulk data and index list of the current mesh info
-	for (int i= 0; i < trianglesIndexCount; i+= maxOffset + 1)
-	{
-		// Create and set the current vertice index
-		ColladaVertice currentVertice;
+		// Add the bulk data associated to the current vertice to the mesh info
 		for (int dataIndex= 0; dataIndex < inputDataCount; ++dataIndex)
 		{
-			currentVertice.m_Values[inputDataList.at(dataIndex).m_Semantic]= trianglesIndexList.at(i + inputDataList.at(dataIndex).m_Offset);
+			const InputData& currentInputData= inputDataList.at(dataIndex);
+			const SourceData* pSourceData= sourceList.at(dataIndex);
+			const int componentCount= (currentInputData.m_Semantic != TEXCOORD) ? 3 : 2;
+			const int valueIndex= pColladaIndex[currentInputData.m_Offset] * pSourceData->m_Stride;
+			if ((valueIndex < 0) || ((valueIndex + componentCount) > pSourceData->m_Values.size()))
+			{
+				pMeshInfo->m_ErrorMessage= "Index out of range in source : " + currentInputData.m_Source;
+				return false;
+			}
+			GLfloatVector& data= pMeshInfo->m_Datas[currentInputData.m_Semantic];
+			const GLfloat* pValues= pSourceData->m_Values.constData() + valueIndex;
+			for (int component= 0; component < componentCount; ++component)
+			{
+				data.append(pValues[component]);
+			}
 		}
-
-		if (m_pMeshInfo->m_Mapping.contains(currentVertice))
+		// Avoid problem wich occur with mesh containing materials with and without texture
+		if (meshHasTexture && !hasTexture)
 		{
-			// Add the the index to the triangles index
-			trianglesIndex.append(m_pMeshInfo->m_Mapping.value(currentVertice));
+			pMeshInfo->m_Datas[TEXCOORD].append(0.0f);
+			pMeshInfo->m_Datas[TEXCOORD].append(0.0f);
 		}
-		else
-		{
-			// Add the current vertice to the current mesh info mapping hash table and increment the freeIndex
-			m_pMeshInfo->m_Mapping.insert(currentVertice, (m_pMeshInfo->m_FreeIndex)++);
-			// Add the the index to the triangles index
-			trianglesIndex.append(m_pMeshInfo->m_Mapping.value(currentVertice));
 
-			// Add the bulk data associated to the current vertice to the current mesh info
-			for (int dataIndex= 0; dataIndex < inputDataCount; ++dataIndex)
+		pMapping->insert(currentVertice, freeIndex);
+		verticeIndex[i]= freeIndex++;
+	}
+
+	// Save mesh info index offset
+	const int indexOffset= pMeshInfo->m_Index.size();
+
+	if (primitive.m_VCount.isEmpty())
+	{
+		// Triangles
+		const int triangleIndexCount= verticeCount - (verticeCount % 3);
+		for (int i= 0; i < triangleIndexCount; ++i)
+		{
+			pMeshInfo->m_Index.append(verticeIndex.at(i));
+		}
+	}
+	else
+	{
+		// Triangulate the polygons with their own positions
+		// Input polygon index must start from 0 and succesive : (0 1 2 3 4)
+		const GLfloatVector& positions= pMeshInfo->m_Datas.at(VERTEX);
+		QList<GLuint> onePolygonIndex;
+		QList<float> onePolygonPositions;
+		int firstVertice= 0;
+		const int polygonCount= primitive.m_VCount.size();
+		for (int i= 0; i < polygonCount; ++i)
+		{
+			const int polygonSize= primitive.m_VCount.at(i);
+			if ((polygonSize < 0) || ((firstVertice + polygonSize) > verticeCount))
 			{
-				// The current input data
-				InputData currentInputData= inputDataList.at(dataIndex);
-				// QHash iterator on the right QList<float>
-				BulkDataHash::const_iterator iBulkHash= m_BulkDataHash.find(currentInputData.m_Source);
-				int stride;
-				if (m_DataAccessorHash.contains(currentInputData.m_Source))
+				pMeshInfo->m_ErrorMessage= "vcount and p size not match";
+				return false;
+			}
+			if (polygonSize == 3)
+			{
+				for (int j= 0; j < 3; ++j)
+				{
+					pMeshInfo->m_Index.append(verticeIndex.at(firstVertice + j));
+				}
+			}
+			else if (polygonSize > 3)
+			{
+				for (int j= 0; j < polygonSize; ++j)
 				{
-					stride= m_DataAccessorHash.value(currentInputData.m_Source).m_Stride;
+					const int positionIndex= verticeIndex.at(firstVertice + j) * 3;
+					onePolygonIndex.append(j);
+					onePolygonPositions.append(positions.at(positionIndex));
+					onePolygonPositions.append(positions.at(positionIndex + 1));
+					onePolygonPositions.append(positions.at(positionIndex + 2));
 				}
-				else if (currentInputData.m_Semantic != TEXCOORD) stride= 3; else stride= 2;
-				// Firts value
-				m_pMeshInfo->m_Datas[currentInputData.m_Semantic].append(iBulkHash.value().at(trianglesIndexList.at(i + currentInputData.m_Offset) * stride));
-				// Second value
-				m_pMeshInfo->m_Datas[currentInputData.m_Semantic].append(iBulkHash.value().at(trianglesIndexList.at(i + currentInputData.m_Offset) * stride + 1));
-				// Fird value
-				if (currentInputData.m_Semantic != TEXCOORD)
+				glc::triangulatePolygon(&onePolygonIndex, onePolygonPositions);
+
+				// Add index to the mesh info
+				const int triangleIndexCount= onePolygonIndex.size();
+				if (triangleIndexCount > 0)
 				{
-					m_pMeshInfo->m_Datas[currentInputData.m_Semantic].append(iBulkHash.value().at(trianglesIndexList.at(i + currentInputData.m_Offset) * stride + 2));
+					for (int j= 0; j < triangleIndexCount; ++j)
+					{
+						pMeshInfo->m_Index.append(verticeIndex.at(firstVertice + onePolygonIndex.at(j)));
+					}
 				}
-				// Avoid problem wich occur with mesh containing materials with and without texture
-				if (!hasTexture)
+				else
 				{
-					m_pMeshInfo->m_Datas[TEXCOORD].append(0.0);
+					QStringList stringList("GLC_ColladaToWorld::addPrimitiveToMesh");
+					stringList.append("Unable to triangulate a polygon of " + pMeshInfo->m_pMesh->name());
+					GLC_ErrorLog::addError(stringList);
 				}
+				onePolygonIndex.clear();
+				onePolygonPositions.clear();
 			}
+			firstVertice+= polygonSize;
 		}
 	}
 
-	// Save mesh info index offset
-	const int indexOffset= m_pMeshInfo->m_Index.size();
-
-	// Add index to the mesh info
-	m_pMeshInfo->m_Index.append(trianglesIndex);
-
 	// Check if normal computation is needed
 	if (!hasNormals)
 	{
-		computeNormalOfCurrentPrimitiveOfCurrentMesh(indexOffset);
+		computeNormalOfPrimitive(pMeshInfo, indexOffset);
 	}
 
 	// Add material the current mesh info
 	MatOffsetSize matInfo;
 	matInfo.m_Offset= indexOffset;
-	matInfo.m_size= m_pMeshInfo->m_Index.size() - indexOffset;
-	m_pMeshInfo->m_Materials.insertMulti(materialId, matInfo);
+	matInfo.m_size= pMeshInfo->m_Index.size() - indexOffset;
+	pMeshInfo->m_Materials.insertMulti(primitive.m_MaterialId, matInfo);
+
+	return true;
+}
+
+// Compute Normals of the given mesh info from the specified index offset
+void GLC_ColladaToWorld::computeNormalOfPrimitive(MeshInfo* pMeshInfo, int indexOffset)
+{
+	const GLfloatVector& positions= pMeshInfo->m_Datas.at(VERTEX);
+	// Fill the list of normal
+	GLfloatVector& normals= pMeshInfo->m_Datas[NORMAL];
+	normals.resize(positions.size());
+
+	// Compute the normals and add them to the current mesh info
+	const IndexList& index= pMeshInfo->m_Index;
+	const int size= index.size();
+	for (int i= indexOffset; (i + 2) < size; i+= 3)
+	{
+		const int index1= index.at(i) * 3;
+		const int index2= index.at(i + 1) * 3;
+		const int index3= index.at(i + 2) * 3;
+		const GLC_Vector3d vect1(positions.at(index1), positions.at(index1 + 1), positions.at(index1 + 2));
+		const GLC_Vector3d vect2(positions.at(index2), positions.at(index2 + 1), positions.at(index2 + 2));
+		const GLC_Vector3d vect3(positions.at(index3), positions.at(index3 + 1), positions.at(index3 + 2));
 
+		const GLC_Vector3d edge1(vect3 - vect2);
+		const GLC_Vector3d edge2(vect1 - vect2);
+
+		GLC_Vector3d normal(edge1 ^ edge2);
+		normal.normalize();
+
+		const GLC_Vector3df curNormal= normal.toVector3df();
+		for (int curVertex= 0; curVertex < 3; ++curVertex)
+		{
+			const int normalIndex= index.at(i + curVertex) * 3;
+			normals[normalIndex]= curNormal.x();
+			normals[normalIndex + 1]= curNormal.y();
+			normals[normalIndex + 2]= curNormal.z();
+		}
+	}
 }
 
 // Load the library nodes
@@ -1837,27 +1768,16 @@ void GLC_ColladaToWorld::linkTexturesToMaterials()
 void GLC_ColladaToWorld::createMesh()
 {
 	//qDebug() << "GLC_ColladaToWorld::createMesh()";
+	// Wait for meshes built by worker threads
+	m_ThreadPool.waitForDone();
+
 	QHash<const QString, MeshInfo*>::iterator iMeshInfo= m_GeometryHash.begin();
 	while (m_GeometryHash.constEnd() != iMeshInfo)
 	{
 		MeshInfo* pCurrentMeshInfo= iMeshInfo.value();
-		// Add Bulk Data to the mesh
-		// Add vertice
-		pCurrentMeshInfo->m_pMesh->addVertice(pCurrentMeshInfo->m_Datas.at(VERTEX).toVector());
-		//qDebug() << "Add " << pCurrentMeshInfo->m_Datas[VERTEX].size() << " Vertice";
-		pCurrentMeshInfo->m_Datas[VERTEX].clear();
-
-		// Add Normal
-		pCurrentMeshInfo->m_pMesh->addNormals(pCurrentMeshInfo->m_Datas.at(NORMAL).toVector());
-		//qDebug() << "Add " << pCurrentMeshInfo->m_Datas[NORMAL].size() << " Normal";
-		pCurrentMeshInfo->m_Datas[NORMAL].clear();
-
-		// Add texel if necessary
-		//qDebug() << "Add " << pCurrentMeshInfo->m_Datas[TEXCOORD].size() << " texel";
-		if (!pCurrentMeshInfo->m_Datas.at(TEXCOORD).isEmpty())
+		if (!pCurrentMeshInfo->m_ErrorMessage.isEmpty())
 		{
-			pCurrentMeshInfo->m_pMesh->addTexels(pCurrentMeshInfo->m_Datas.at(TEXCOORD).toVector());
-			pCurrentMeshInfo->m_Datas[TEXCOORD].clear();
+			throwException("Geometry " + iMeshInfo.key() + " : " + pCurrentMeshInfo->m_ErrorMessage);
 		}
 
 		// Add face index and material to the mesh
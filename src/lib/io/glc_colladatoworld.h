@@ -30,10 +30,13 @@
 #include <QXmlStreamReader>
 #include <QHash>
 #include <QColor>
+#include <QVector>
+#include <QThreadPool>
 
 #include "../shading/glc_material.h"
 #include "../geometry/glc_mesh.h"
 #include "../sceneGraph/glc_structoccurrence.h"
+#include "../glc_global.h"
 
 #include "../glc_config.h"
 
@@ -48,6 +51,8 @@ class GLC_LIB_EXPORT GLC_ColladaToWorld : public QObject
 private:
 	Q_OBJECT
 
+	class MeshBuildingTask;
+
 	// The 3 supported semantic
 	enum Semantic
 	{ // Values are very important !
@@ -63,19 +68,38 @@ private:
 		QString m_Source;
 		Semantic m_Semantic;
 	};
+
+	// Bulk data of an input source
+	struct SourceData
+	{
+		GLfloatVector m_Values;
+		int m_Stride;
+	};
+
+	// A polylist, polygons or triangles element
+	struct PrimitiveData
+	{
+		// Inputs of the primitive
+		QList<InputData> m_Inputs;
+		// Polygon number of vertice, empty for triangles
+		QVector<int> m_VCount;
+		// Collada index of the primitive
+		QVector<int> m_Index;
+		// The material id
+		QString m_MaterialId;
+	};
 public:
 	// Collada Vertice (Position index, Normal index and TexCoord index)
 	struct ColladaVertice
 	{
 		ColladaVertice()
-		: m_Values(3)
 		{
 			m_Values[0]= 0;
 			m_Values[1]= 0;
 			m_Values[2]= 0;
 		}
 
-		QVector<int> m_Values;
+		int m_Values[3];
 	};
 private:
 
@@ -104,25 +128,29 @@ private:
 	{
 		MeshInfo()
 		: m_pMesh(NULL)
+		, m_Primitives()
+		, m_Sources()
 		, m_Datas(3)
-		, m_Mapping()
 		, m_Index()
-		, m_FreeIndex(0)
+		, m_Materials()
+		, m_ErrorMessage()
 		{}
 
 		~MeshInfo() {delete m_pMesh;}
 		// Mesh of the mesh info
 		GLC_Mesh* m_pMesh;
+		// Primitives to add to the mesh
+		QList<PrimitiveData> m_Primitives;
+		// Bulk data used by the primitives
+		QHash<QString, SourceData> m_Sources;
 		// Bulk data vector (Position, normal, texel)
-		QVector<QList<float> > m_Datas;
-		// Mapping between collada vertice and index
-		QHash<ColladaVertice, GLuint> m_Mapping;
+		QVector<GLfloatVector> m_Datas;
 		// Triangle index
 		IndexList m_Index;
-		// Next index Position
-		GLuint m_FreeIndex;
 		// QHash containing material id and associated offset and size
 		QHash<QString, MatOffsetSize> m_Materials;
+		// Error which occurs while building the mesh
+		QString m_ErrorMessage;
 	};
 
 	// The collada Node
@@ -152,7 +180,7 @@ private:
 	};
 
 	typedef QHash<const QString, GLC_Material*> MaterialHash;
-	typedef QHash<const QString, QList<float> > BulkDataHash;
+	typedef QHash<const QString, GLfloatVector> BulkDataHash;
 	typedef QHash<const QString, Accessor> DataAccessorHash;
 //////////////////////////////////////////////////////////////////////
 /*! @name Constructor / Destructor */
@@ -291,17 +319,26 @@ private:
 	//! Load Polygons
 	void loadPolygons();
 
-	//! Add the polylist to the current mesh
-	void addPolylistToCurrentMesh(const QList<InputData>&, const QList<int>&, const QList<int>&, const QString&);
-
-	//! Compute Normals for the current primitive element of the current mesh from the specified offset
-	void computeNormalOfCurrentPrimitiveOfCurrentMesh(int offset);
-
 	//! Load triangles
 	void loadTriangles();
 
-	//! Add the triangles to current mesh
-	void addTrianglesToCurrentMesh(const QList<InputData>&, const QList<int>&, const QString&);
+	//! Load an input of a primitive element
+	InputData loadInput();
+
+	//! Add the given primitive to the current mesh and resolve its sources
+	void addPrimitiveToCurrentMesh(const PrimitiveData& primitive);
+
+	//! Build the current mesh on a worker thread or immediately
+	void buildCurrentMesh();
+
+	//! Build the given mesh info from its primitives, called by worker threads
+	static void buildMesh(MeshInfo* pMeshInfo);
+
+	//! De-interleave and triangulate the given primitive and add it to the given mesh info
+	static bool addPrimitiveToMesh(MeshInfo* pMeshInfo, const PrimitiveData& primitive, QHash<ColladaVertice, GLuint>* pMapping, bool meshHasTexture);
+
+	//! Compute Normals of the given mesh info from the specified index offset
+	static void computeNormalOfPrimitive(MeshInfo* pMeshInfo, int indexOffset);
 
 	//! Load the library nodes
 	void loadLibraryNodes();
@@ -442,13 +479,21 @@ private:
 	//! The transparent mode is RGB_ZERO
 	bool m_TransparentIsRgbZero;
 
+	//! Meshes are built by worker threads while the file is read
+	QThreadPool m_ThreadPool;
+
 };
 
 // To use ColladaVertice as a QHash key
 inline bool operator==(const GLC_ColladaToWorld::ColladaVertice& vertice1, const GLC_ColladaToWorld::ColladaVertice& vertice2)
-{ return (vertice1.m_Values == vertice2.m_Values);}
+{
+	return (vertice1.m_Values[0] == vertice2.m_Values[0]) && (vertice1.m_Values[1] == vertice2.m_Values[1])
+			&& (vertice1.m_Values[2] == vertice2.m_Values[2]);
+}
 
 inline uint qHash(const GLC_ColladaToWorld::ColladaVertice& vertice)
-{ return qHash(QString::number(vertice.m_Values.at(0)) + QString::number(vertice.m_Values.at(1)) + QString::number(vertice.m_Values.at(2)));}
+{
+	return glc::hashTriplet(static_cast<uint>(vertice.m_Values[0]), static_cast<uint>(vertice.m_Values[1]), static_cast<uint>(vertice.m_Values[2]));
+}
 
 #endif /* GLC_COLLADATOWORLD_H_ */
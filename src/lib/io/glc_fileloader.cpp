@@ -43,6 +43,7 @@
 // Constructor
 //////////////////////////////////////////////////////////////////////
 GLC_FileLoader::GLC_FileLoader()
+: m_pInterruptionFlag(NULL)
 {
 }
 
@@ -122,6 +123,7 @@ GLC_World GLC_FileLoader::createWorldFromFile(QFile &file, QStringList* pAttache
 	{
 		GLC_3dxmlToWorld d3dxmlToWorld;
 		connect(&d3dxmlToWorld, SIGNAL(currentQuantum(int)), this, SIGNAL(currentQuantum(int)));
+		d3dxmlToWorld.setInterruptionFlag(m_pInterruptionFlag);
 		pWorld= d3dxmlToWorld.createWorldFrom3dxml(file, false);
 		if (NULL != pAttachedFileName)
 		{
@@ -32,6 +32,7 @@
 #include <QTextStream>
 #include <QColor>
 #include <QList>
+#include <QAtomicInt>
 
 #include "../glc_config.h"
 
@@ -65,6 +66,11 @@ public:
 public:
 	//! Create a GLC_World from a file
 	GLC_World createWorldFromFile(QFile &file, QStringList* pAttachedFileName= NULL);
+
+	//! Set the flag which interrupt the loading when it is not 0
+	/*! Only supported by the 3DXML loader*/
+	inline void setInterruptionFlag(const QAtomicInt* pFlag)
+	{m_pInterruptionFlag= pFlag;}
 //@}
 
 
@@ -78,6 +84,8 @@ public:
 // Private members
 //////////////////////////////////////////////////////////////////////
 private:
+	//! Loading is interrupted when the flag is not 0
+	const QAtomicInt* m_pInterruptionFlag;
 };
 
 #endif /*GLC_FILELOADER_H_*/
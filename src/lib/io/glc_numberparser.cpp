@@ -0,0 +1,343 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+
+//! \file glc_numberparser.cpp implementation of text to number parsing functions
+
+#include "glc_numberparser.h"
+
+#include <QtGlobal>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define GLC_NUMBERPARSER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+// Powers of ten exactly represented by a double
+const double powerOfTen[]= {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+							1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Maximum number of significant digits accumulated in the mantissa
+const int maxSignificantDigits= 19;
+
+inline bool isSeparator(ushort c)
+{
+	return (c == ' ') || (c == ',') || (c == '\n') || (c == '\r') || (c == '\t');
+}
+
+template <typename Char>
+inline bool isDigit(Char c)
+{
+	return static_cast<unsigned int>(c - '0') <= 9u;
+}
+
+// Return the number of consecutive decimal digits from the given position
+inline int digitRunLength(const ushort* pBegin, const ushort* pEnd)
+{
+	const ushort* p= pBegin;
+#ifdef GLC_NUMBERPARSER_SSE2
+	// Test 8 chars at a time : c is a digit if (c - '0') <= 9 as unsigned
+	const __m128i zeroChar= _mm_set1_epi16('0');
+	const __m128i nine= _mm_set1_epi16(9);
+	const __m128i zero= _mm_setzero_si128();
+	while ((pEnd - p) >= 8)
+	{
+		const __m128i chars= _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		const __m128i value= _mm_sub_epi16(chars, zeroChar);
+		const __m128i digits= _mm_cmpeq_epi16(_mm_subs_epu16(value, nine), zero);
+		const int mask= _mm_movemask_epi8(digits);
+		if (mask != 0xFFFF)
+		{
+			int count= 0;
+			while (mask & (1 << (2 * count))) ++count;
+			return static_cast<int>(p - pBegin) + count;
+		}
+		p+= 8;
+	}
+#endif
+	while ((p < pEnd) && isDigit(*p)) ++p;
+
+	return static_cast<int>(p - pBegin);
+}
+
+inline int digitRunLength(const char* pBegin, const char* pEnd)
+{
+	const char* p= pBegin;
+	while ((p < pEnd) && isDigit(*p)) ++p;
+
+	return static_cast<int>(p - pBegin);
+}
+
+// Skip separators, return false if the end is reached
+inline bool skipSeparators(const ushort*& p, const ushort* pEnd)
+{
+	while ((p < pEnd) && isSeparator(*p)) ++p;
+	return p < pEnd;
+}
+
+// Move to the end of the current token
+inline void skipToken(const ushort*& p, const ushort* pEnd)
+{
+	while ((p < pEnd) && !isSeparator(*p)) ++p;
+}
+
+// Accumulate the given digits in the mantissa, return the exponent correction
+template <typename Char>
+inline int accumulateDigits(const Char* p, int count, quint64* pMantissa, int* pSignificantDigits)
+{
+	int ignoredDigits= 0;
+	for (int i= 0; i < count; ++i)
+	{
+		if (*pSignificantDigits < maxSignificantDigits)
+		{
+			*pMantissa= (*pMantissa * 10) + (p[i] - '0');
+			if (0 != *pMantissa) ++(*pSignificantDigits);
+		}
+		else
+		{
+			++ignoredDigits;
+		}
+	}
+	return ignoredDigits;
+}
+
+// Parse the float at the given position, return false if there is no valid number
+template <typename Char>
+bool parseFloatValue(const Char*& p, const Char* pEnd, double* pValue)
+{
+	const Char* pStart= p;
+	bool isNegative= false;
+	if ((*p == '-') || (*p == '+'))
+	{
+		isNegative= (*p == '-');
+		++p;
+	}
+
+	quint64 mantissa= 0;
+	int significantDigits= 0;
+	int exponent= 0;
+
+	// Integer part
+	int count= digitRunLength(p, pEnd);
+	bool hasDigits= count > 0;
+	exponent+= accumulateDigits(p, count, &mantissa, &significantDigits);
+	p+= count;
+
+	// Fractional part
+	if ((p < pEnd) && (*p == '.'))
+	{
+		++p;
+		count= digitRunLength(p, pEnd);
+		hasDigits= hasDigits || (count > 0);
+		const int ignoredDigits= accumulateDigits(p, count, &mantissa, &significantDigits);
+		exponent-= count - ignoredDigits;
+		p+= count;
+	}
+	if (!hasDigits)
+	{
+		p= pStart;
+		return false;
+	}
+
+	// Exponent part
+	if ((p < pEnd) && ((*p == 'e') || (*p == 'E')))
+	{
+		++p;
+		bool exponentIsNegative= false;
+		if ((p < pEnd) && ((*p == '-') || (*p == '+')))
+		{
+			exponentIsNegative= (*p == '-');
+			++p;
+		}
+		count= digitRunLength(p, pEnd);
+		if (0 == count)
+		{
+			p= pStart;
+			return false;
+		}
+		int exponentValue= 0;
+		for (int i= 0; (i < count) && (exponentValue < 10000); ++i)
+		{
+			exponentValue= (exponentValue * 10) + (p[i] - '0');
+		}
+		exponent+= exponentIsNegative ? -exponentValue : exponentValue;
+		p+= count;
+	}
+
+	double value= static_cast<double>(mantissa);
+	if (0 != mantissa)
+	{
+		if ((exponent < 0) && (exponent >= -22)) value/= powerOfTen[-exponent];
+		else if ((exponent > 0) && (exponent <= 22)) value*= powerOfTen[exponent];
+		else if (0 != exponent) value*= pow(10.0, exponent);
+	}
+	*pValue= isNegative ? -value : value;
+
+	return true;
+}
+
+// Parse the integer at the given position, return false if there is no valid integer
+template <typename Char>
+bool parseIntegerValue(const Char*& p, const Char* pEnd, qint64* pValue)
+{
+	const Char* pStart= p;
+	bool isNegative= false;
+	if ((*p == '-') || (*p == '+'))
+	{
+		isNegative= (*p == '-');
+		++p;
+	}
+	const int count= digitRunLength(p, pEnd);
+	if ((0 == count) || (count > 18))
+	{
+		p= pStart;
+		return false;
+	}
+	qint64 value= 0;
+	for (int i= 0; i < count; ++i)
+	{
+		value= (value * 10) + (p[i] - '0');
+	}
+	p+= count;
+	*pValue= isNegative ? -value : value;
+
+	return true;
+}
+
+// Parse the float token at the given position, return false if the token is not a valid number
+inline bool parseFloat(const ushort*& p, const ushort* pEnd, double* pValue)
+{
+	const ushort* pStart= p;
+	if (parseFloatValue(p, pEnd, pValue) && ((p == pEnd) || isSeparator(*p))) return true;
+	p= pStart;
+	return false;
+}
+
+// Parse the integer token at the given position, return false if the token is not a valid integer
+inline bool parseInteger(const ushort*& p, const ushort* pEnd, qint64* pValue)
+{
+	const ushort* pStart= p;
+	if (parseIntegerValue(p, pEnd, pValue) && ((p == pEnd) || isSeparator(*p))) return true;
+	p= pStart;
+	return false;
+}
+
+// Return the token at the given position as a string without copying it
+inline QString rawToken(const ushort* pBegin, const ushort* pEnd)
+{
+	return QString::fromRawData(reinterpret_cast<const QChar*>(pBegin), static_cast<int>(pEnd - pBegin));
+}
+
+template <typename Container, typename T>
+bool parseFloatsTo(const QStringRef& string, Container* pResult)
+{
+	const ushort* p= reinterpret_cast<const ushort*>(string.unicode());
+	const ushort* pEnd= p + string.size();
+	bool success= true;
+	while (success && skipSeparators(p, pEnd))
+	{
+		double value;
+		if (parseFloat(p, pEnd, &value))
+		{
+			pResult->append(static_cast<T>(value));
+		}
+		else
+		{
+			// Let Qt handle special values as "inf" or "nan"
+			const ushort* pTokenStart= p;
+			skipToken(p, pEnd);
+			const float tokenValue= rawToken(pTokenStart, p).toFloat(&success);
+			if (success) pResult->append(static_cast<T>(tokenValue));
+		}
+	}
+	return success;
+}
+
+template <typename Container, typename T>
+bool parseIntegersTo(const QStringRef& string, Container* pResult, bool acceptNegative)
+{
+	const ushort* p= reinterpret_cast<const ushort*>(string.unicode());
+	const ushort* pEnd= p + string.size();
+	bool success= true;
+	while (success && skipSeparators(p, pEnd))
+	{
+		qint64 value;
+		success= parseInteger(p, pEnd, &value) && (acceptNegative || (value >= 0));
+		if (success) pResult->append(static_cast<T>(value));
+	}
+	return success;
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////
+// Number parsing Functions
+//////////////////////////////////////////////////////////////////////
+
+bool glc::parseFloats(const QStringRef& string, GLfloatVector* pResult)
+{
+	return parseFloatsTo<GLfloatVector, GLfloat>(string, pResult);
+}
+
+bool glc::parseFloats(const QStringRef& string, QList<float>* pResult)
+{
+	return parseFloatsTo<QList<float>, float>(string, pResult);
+}
+
+bool glc::parseIndexes(const QStringRef& string, IndexList* pResult)
+{
+	return parseIntegersTo<IndexList, GLuint>(string, pResult, false);
+}
+
+bool glc::parseIntegers(const QStringRef& string, QList<int>* pResult)
+{
+	return parseIntegersTo<QList<int>, int>(string, pResult, true);
+}
+
+bool glc::parseIntegers(const QStringRef& string, QVector<int>* pResult)
+{
+	return parseIntegersTo<QVector<int>, int>(string, pResult, true);
+}
+
+const char* glc::parseFloat(const char* pBegin, const char* pEnd, float* pValue)
+{
+	double value;
+	if ((pBegin < pEnd) && parseFloatValue(pBegin, pEnd, &value))
+	{
+		*pValue= static_cast<float>(value);
+		return pBegin;
+	}
+	return NULL;
+}
+
+const char* glc::parseInteger(const char* pBegin, const char* pEnd, int* pValue)
+{
+	qint64 value;
+	if ((pBegin < pEnd) && parseIntegerValue(pBegin, pEnd, &value))
+	{
+		*pValue= static_cast<int>(value);
+		return pBegin;
+	}
+	return NULL;
+}
@@ -0,0 +1,76 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+
+//! \file glc_numberparser.h declaration of text to number parsing functions
+
+#ifndef GLC_NUMBERPARSER_H_
+#define GLC_NUMBERPARSER_H_
+
+#include <QString>
+#include <QList>
+#include <QVector>
+
+#include "../glc_global.h"
+
+#include "../glc_config.h"
+
+namespace glc
+{
+//////////////////////////////////////////////////////////////////////
+/*! \name Number parsing Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+	/*! Numbers of the given string are separated by white spaces or commas.
+	 *  Parsed numbers are appended to the given container without any
+	 *  temporary allocation.
+	 *  Return false if a token of the string is not a number */
+
+	//! Parse the floats of the given string and append them to the given vector
+	GLC_LIB_EXPORT bool parseFloats(const QStringRef& string, GLfloatVector* pResult);
+
+	//! Parse the floats of the given string and append them to the given list
+	GLC_LIB_EXPORT bool parseFloats(const QStringRef& string, QList<float>* pResult);
+
+	//! Parse the unsigned integers of the given string and append them to the given index list
+	GLC_LIB_EXPORT bool parseIndexes(const QStringRef& string, IndexList* pResult);
+
+	//! Parse the integers of the given string and append them to the given list
+	GLC_LIB_EXPORT bool parseIntegers(const QStringRef& string, QList<int>* pResult);
+
+	//! Parse the integers of the given string and append them to the given vector
+	GLC_LIB_EXPORT bool parseIntegers(const QStringRef& string, QVector<int>* pResult);
+
+	/*! The following functions parse the number starting at the beginning of
+	 *  the given 8 bits characters range, the number can be followed by any character.
+	 *  Return the position following the number or NULL if there is no valid number */
+
+	//! Parse the float at the beginning of the given characters
+	GLC_LIB_EXPORT const char* parseFloat(const char* pBegin, const char* pEnd, float* pValue);
+
+	//! Parse the integer at the beginning of the given characters
+	GLC_LIB_EXPORT const char* parseInteger(const char* pBegin, const char* pEnd, int* pValue);
+
+//@}
+
+};
+
+#endif /* GLC_NUMBERPARSER_H_ */
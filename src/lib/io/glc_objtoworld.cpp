@@ -28,6 +28,7 @@
 #include "glc_objtoworld.h"
 #include "../sceneGraph/glc_world.h"
 #include "glc_objmtlloader.h"
+#include "glc_numberparser.h"
 #include "../glc_fileformatexception.h"
 #include "../maths/glc_geomtools.h"
 #include "../sceneGraph/glc_structreference.h"
@@ -35,6 +36,400 @@
 #include "../sceneGraph/glc_structoccurrence.h"
 #include <QTextStream>
 #include <QFileInfo>
+#include <QPair>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+
+#include <cstring>
+#include <climits>
+
+namespace
+{
+// Minimum size of a chunk of the OBJ file parsed by a thread
+const qint64 minimumChunkSize= 1 << 20;
+
+inline bool isBlank(char c)
+{
+	return (c == ' ') || (c == '\t') || (c == '\r');
+}
+
+// Skip blanks, return false if the end is reached
+inline bool skipBlanks(const char*& p, const char* pEnd)
+{
+	while ((p < pEnd) && isBlank(*p)) ++p;
+	return p < pEnd;
+}
+
+// Return true if the line ending at the given new line character continues on the next line
+inline bool isContinuedLine(const char* pBegin, const char* pNewLine)
+{
+	const char* p= pNewLine;
+	if ((p > pBegin) && (*(p - 1) == '\r')) --p;
+	return (p > pBegin) && (*(p - 1) == '\\');
+}
+
+// Return true if the given keyword is equal to the given string
+inline bool isKeyword(const char* pKeyword, int length, const char* string)
+{
+	return (static_cast<int>(strlen(string)) == length) && (0 == memcmp(pKeyword, string, length));
+}
+}
+
+//////////////////////////////////////////////////////////////////////
+//! \struct GLC_ObjToWorld::ObjChunk
+/*! \brief ObjChunk : A line aligned part of the OBJ file and its parsed content
+ *
+ *  Indexes of faces are stored 0 based, negative indexes are stored
+ *  relatively to the first element of the chunk and resolved when the chunk is merged */
+//////////////////////////////////////////////////////////////////////
+struct GLC_ObjToWorld::ObjChunk
+{
+	enum RecordType
+	{
+		Face,
+		Group,
+		Material
+	};
+
+	enum RelativeIndex
+	{
+		RelativePosition= 1,
+		RelativeTexel= 2,
+		RelativeNormal= 4
+	};
+
+	// A face, group or material record, in file order
+	struct Record
+	{
+		RecordType m_Type;
+		//! Line number in the chunk
+		int m_Line;
+		//! First face vertex or name index
+		int m_First;
+		//! Number of face vertex
+		int m_Count;
+		bool m_HasTexel;
+		bool m_HasNormal;
+	};
+
+	// A vertex of a face
+	struct FaceVertex
+	{
+		int m_Position;
+		int m_Texel;
+		int m_Normal;
+		int m_RelativeMask;
+	};
+
+	ObjChunk(const char* pBegin, const char* pEnd)
+	: m_pBegin(pBegin)
+	, m_pEnd(pEnd)
+	, m_Positions()
+	, m_Normals()
+	, m_Texels()
+	, m_Records()
+	, m_FaceVertices()
+	, m_Names()
+	, m_Warnings()
+	, m_LineCount(0)
+	, m_ErrorMessage()
+	, m_ErrorLine(0)
+	, m_ErrorType(GLC_FileFormatException::WrongFileFormat)
+	, m_LineBase(0)
+	, m_PositionBase(0)
+	, m_NormalBase(0)
+	, m_TexelBase(0)
+	{}
+
+	//! Parse the lines of the chunk
+	void parse();
+
+	//! Parse the given line
+	void parseLine(const char* p, const char* pEnd, int line);
+
+	//! Parse the components of a vector, return false if a component is not valid
+	bool parseVector(const char* p, const char* pEnd, int size, int requiredSize, GLfloatVector* pVector);
+
+	//! Parse the vertice of a face
+	void parseFace(const char* p, const char* pEnd, int line);
+
+	//! Parse the index of a face vertex component
+	bool parseIndex(const char*& p, const char* pEnd, int count, int relativeFlag, int* pIndex, int* pRelativeMask);
+
+	//! Add a group or material record with the given name
+	void addNamedRecord(RecordType type, const char* p, const char* pEnd, int line, bool firstWordOnly);
+
+	//! Set the parsing error
+	void setError(const QString& message, int line, GLC_FileFormatException::ExceptionType type);
+
+	//! Return true if an error occurs during parsing
+	inline bool hasError() const
+	{return !m_ErrorMessage.isEmpty();}
+
+	const char* m_pBegin;
+	const char* m_pEnd;
+
+	GLfloatVector m_Positions;
+	GLfloatVector m_Normals;
+	GLfloatVector m_Texels;
+	QVector<Record> m_Records;
+	QVector<FaceVertex> m_FaceVertices;
+	QStringList m_Names;
+	QList<QPair<int, QString> > m_Warnings;
+	int m_LineCount;
+
+	QString m_ErrorMessage;
+	int m_ErrorLine;
+	GLC_FileFormatException::ExceptionType m_ErrorType;
+
+	//! Offsets of the chunk in the whole file, set before merging
+	int m_LineBase;
+	int m_PositionBase;
+	int m_NormalBase;
+	int m_TexelBase;
+};
+
+void GLC_ObjToWorld::ObjChunk::parse()
+{
+	QByteArray mergedLine;
+	const char* p= m_pBegin;
+	while ((p < m_pEnd) && !hasError())
+	{
+		++m_LineCount;
+		const char* pNewLine= static_cast<const char*>(memchr(p, '\n', m_pEnd - p));
+		if (NULL == pNewLine) pNewLine= m_pEnd;
+
+		if (isContinuedLine(p, pNewLine))
+		{
+			// Merge multi line in one
+			const int line= m_LineCount;
+			mergedLine.clear();
+			mergedLine.append(p, static_cast<int>(pNewLine - p));
+			while (isContinuedLine(p, pNewLine) && (pNewLine < m_pEnd))
+			{
+				mergedLine.replace('\\', ' ');
+				p= pNewLine + 1;
+				++m_LineCount;
+				pNewLine= static_cast<const char*>(memchr(p, '\n', m_pEnd - p));
+				if (NULL == pNewLine) pNewLine= m_pEnd;
+				mergedLine.append(p, static_cast<int>(pNewLine - p));
+			}
+			parseLine(mergedLine.constData(), mergedLine.constData() + mergedLine.size(), line);
+		}
+		else
+		{
+			parseLine(p, pNewLine, m_LineCount);
+		}
+		p= (pNewLine < m_pEnd) ? pNewLine + 1 : m_pEnd;
+	}
+}
+
+void GLC_ObjToWorld::ObjChunk::parseLine(const char* p, const char* pEnd, int line)
+{
+	if (!skipBlanks(p, pEnd)) return;
+
+	const char* pKeyword= p;
+	while ((p < pEnd) && !isBlank(*p)) ++p;
+	const int keywordLength= static_cast<int>(p - pKeyword);
+
+	if (isKeyword(pKeyword, keywordLength, "v"))
+	{
+		if (!parseVector(p, pEnd, 3, 3, &m_Positions))
+		{
+			m_Warnings.append(qMakePair(line, QString("failed to convert vector component to float")));
+		}
+	}
+	else if (isKeyword(pKeyword, keywordLength, "vt"))
+	{
+		if (!parseVector(p, pEnd, 2, 1, &m_Texels))
+		{
+			setError("failed to convert vector component to float", line, GLC_FileFormatException::WrongFileFormat);
+		}
+	}
+	else if (isKeyword(pKeyword, keywordLength, "vn"))
+	{
+		if (!parseVector(p, pEnd, 3, 3, &m_Normals))
+		{
+			m_Warnings.append(qMakePair(line, QString("failed to convert normal component to float")));
+		}
+	}
+	else if (isKeyword(pKeyword, keywordLength, "f"))
+	{
+		parseFace(p, pEnd, line);
+	}
+	else if (isKeyword(pKeyword, keywordLength, "usemtl"))
+	{
+		addNamedRecord(Material, p, pEnd, line, true);
+	}
+	else if (isKeyword(pKeyword, keywordLength, "g") || isKeyword(pKeyword, keywordLength, "o"))
+	{
+		addNamedRecord(Group, p, pEnd, line, false);
+	}
+}
+
+bool GLC_ObjToWorld::ObjChunk::parseVector(const char* p, const char* pEnd, int size, int requiredSize, GLfloatVector* pVector)
+{
+	float values[3]= {0.0f, 0.0f, 0.0f};
+	bool parseOk= true;
+	for (int i= 0; parseOk && (i < size); ++i)
+	{
+		if (!skipBlanks(p, pEnd))
+		{
+			// Missing optional components are set to 0
+			parseOk= (i >= requiredSize);
+			break;
+		}
+		const char* pNext= glc::parseFloat(p, pEnd, &values[i]);
+		parseOk= (NULL != pNext) && ((pNext == pEnd) || isBlank(*pNext));
+		p= pNext;
+	}
+	// Always add the vector to keep the following index valid
+	for (int i= 0; i < size; ++i)
+	{
+		pVector->append(parseOk ? values[i] : 0.0f);
+	}
+
+	return parseOk;
+}
+
+void GLC_ObjToWorld::ObjChunk::parseFace(const char* p, const char* pEnd, int line)
+{
+	Record record;
+	record.m_Type= Face;
+	record.m_Line= line;
+	record.m_First= m_FaceVertices.size();
+	record.m_Count= 0;
+	record.m_HasTexel= false;
+	record.m_HasNormal= false;
+
+	const int positionCount= m_Positions.size() / 3;
+	const int texelCount= m_Texels.size() / 2;
+	const int normalCount= m_Normals.size() / 3;
+
+	while (skipBlanks(p, pEnd))
+	{
+		FaceVertex vertex;
+		vertex.m_Texel= -1;
+		vertex.m_Normal= -1;
+		vertex.m_RelativeMask= 0;
+		bool hasTexel= false;
+		bool hasNormal= false;
+
+		// Vertex formats : v, v/vt, v//vn, v/vt/vn
+		bool parseOk= parseIndex(p, pEnd, positionCount, RelativePosition, &vertex.m_Position, &vertex.m_RelativeMask);
+		if (parseOk && (p < pEnd) && (*p == '/'))
+		{
+			++p;
+			if ((p < pEnd) && (*p != '/'))
+			{
+				hasTexel= true;
+				parseOk= parseIndex(p, pEnd, texelCount, RelativeTexel, &vertex.m_Texel, &vertex.m_RelativeMask);
+			}
+			if (parseOk && (p < pEnd) && (*p == '/'))
+			{
+				++p;
+				hasNormal= true;
+				parseOk= parseIndex(p, pEnd, normalCount, RelativeNormal, &vertex.m_Normal, &vertex.m_RelativeMask);
+			}
+		}
+		if (!parseOk || ((p < pEnd) && !isBlank(*p)))
+		{
+			setError("failed to convert String to int", line, GLC_FileFormatException::WrongFileFormat);
+			return;
+		}
+
+		if (0 == record.m_Count)
+		{
+			record.m_HasTexel= hasTexel;
+			record.m_HasNormal= hasNormal;
+		}
+		else if ((record.m_HasTexel != hasTexel) || (record.m_HasNormal != hasNormal))
+		{
+			setError("this Obj file type is not supported", line, GLC_FileFormatException::FileNotSupported);
+			return;
+		}
+		m_FaceVertices.append(vertex);
+		++record.m_Count;
+	}
+	m_Records.append(record);
+}
+
+bool GLC_ObjToWorld::ObjChunk::parseIndex(const char*& p, const char* pEnd, int count, int relativeFlag, int* pIndex, int* pRelativeMask)
+{
+	int index;
+	const char* pNext= glc::parseInteger(p, pEnd, &index);
+	if ((NULL == pNext) || (0 == index)) return false;
+	p= pNext;
+
+	if (index > 0)
+	{
+		*pIndex= index - 1;
+	}
+	else
+	{
+		// Relative to the last element, can be negative if it is in a previous chunk
+		*pIndex= count + index;
+		*pRelativeMask|= relativeFlag;
+	}
+	return true;
+}
+
+void GLC_ObjToWorld::ObjChunk::addNamedRecord(RecordType type, const char* p, const char* pEnd, int line, bool firstWordOnly)
+{
+	// Words are separated by a single space
+	QByteArray name;
+	while (skipBlanks(p, pEnd))
+	{
+		const char* pWord= p;
+		while ((p < pEnd) && !isBlank(*p)) ++p;
+		if (!name.isEmpty()) name.append(' ');
+		name.append(pWord, static_cast<int>(p - pWord));
+		if (firstWordOnly) break;
+	}
+
+	Record record;
+	record.m_Type= type;
+	record.m_Line= line;
+	record.m_First= m_Names.size();
+	record.m_Count= 0;
+	record.m_HasTexel= false;
+	record.m_HasNormal= false;
+	m_Names.append(QString::fromLocal8Bit(name.constData(), name.size()));
+	m_Records.append(record);
+}
+
+void GLC_ObjToWorld::ObjChunk::setError(const QString& message, int line, GLC_FileFormatException::ExceptionType type)
+{
+	m_ErrorMessage= message;
+	m_ErrorLine= line;
+	m_ErrorType= type;
+}
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_ObjToWorld::ChunkParsingTask
+/*! \brief ChunkParsingTask : Parse a chunk of the OBJ file */
+//////////////////////////////////////////////////////////////////////
+class GLC_ObjToWorld::ChunkParsingTask : public QRunnable
+{
+public:
+	ChunkParsingTask(ObjChunk* pChunk, QAtomicInt* pParsedChunkCount)
+	: QRunnable()
+	, m_pChunk(pChunk)
+	, m_pParsedChunkCount(pParsedChunkCount)
+	{}
+
+	virtual void run()
+	{
+		m_pChunk->parse();
+		m_pParsedChunkCount->fetchAndAddOrdered(1);
+	}
+
+private:
+	ObjChunk* m_pChunk;
+	QAtomicInt* m_pParsedChunkCount;
+};
 
 //////////////////////////////////////////////////////////////////////
 // Constructor
@@ -45,20 +440,12 @@ GLC_ObjToWorld::GLC_ObjToWorld()
 , m_pMtlLoader(NULL)
 , m_CurrentLineNumber(0)
 , m_pCurrentObjMesh(NULL)
-, m_FaceType(notSet)
 , m_CurrentMeshMaterials()
 , m_CurrentMaterialName("GLC_Default")
 , m_ListOfAttachedFileName()
 , m_Positions()
 , m_Normals()
 , m_Texels()
-, m_VerticeIndex(0)
-, m_NormalIndex(0)
-, m_TextureIndex(0)
-, m_VerticeOffset(0)
-, m_NormalOffset(0)
-, m_TextureOffset(0)
-, m_ResetIndex(false)
 {
 }
 
@@ -92,107 +479,128 @@ GLC_World* GLC_ObjToWorld::CreateWorldFromObj(QFile &file)
 	//////////////////////////////////////////////////////////////////
 	m_pWorld= new GLC_World;
 
-	// Create Working variables
-	int currentQuantumValue= 0;
-	int previousQuantumValue= 0;
-	int numberOfLine= 0;
-
-	// Create the input file stream
-	QTextStream objStream(&file);
-
-	// QString buffer
-	QString lineBuff;
-
-	QString mtlLibLine;
-
-	//////////////////////////////////////////////////////////////////
-	// Searching mtllib attribute
-	//////////////////////////////////////////////////////////////////
-	while (!objStream.atEnd() && !lineBuff.contains("mtllib"))
+	// Map the file, read it if it can't be mapped
+	const qint64 size= file.size();
+	QByteArray fileContent;
+	const char* pData= NULL;
+	if (size > 0)
 	{
-		++numberOfLine;
-		lineBuff= objStream.readLine();
-		if (lineBuff.contains("mtllib")) mtlLibLine= lineBuff;
+		pData= reinterpret_cast<const char*>(file.map(0, size));
 	}
-
-	//////////////////////////////////////////////////////////////////
-	// Count the number of lines of the OBJ file
-	//////////////////////////////////////////////////////////////////
-	while (!objStream.atEnd())
+	if (NULL == pData)
 	{
-		++numberOfLine;
-		objStream.readLine();
+		fileContent= file.readAll();
+		pData= fileContent.constData();
 	}
 
 	//////////////////////////////////////////////////////////////////
-	// Reset the stream
+	// Searching mtllib attribute
 	//////////////////////////////////////////////////////////////////
-	objStream.resetStatus();
-	objStream.seek(0);
+	QString mtlLibLine;
+	{
+		const QByteArray data(QByteArray::fromRawData(pData, static_cast<int>(qMin(size, static_cast<qint64>(INT_MAX)))));
+		const int mtlLibIndex= data.indexOf("mtllib");
+		if (-1 != mtlLibIndex)
+		{
+			const int lineBegin= data.lastIndexOf('\n', mtlLibIndex) + 1;
+			int lineEnd= data.indexOf('\n', mtlLibIndex);
+			if (-1 == lineEnd) lineEnd= data.size();
+			mtlLibLine= QString::fromLocal8Bit(pData + lineBegin, lineEnd - lineBegin).trimmed();
+		}
+	}
+	loadMaterials(mtlLibLine);
 
 	//////////////////////////////////////////////////////////////////
-	// if mtl file found, load it
+	// Parse the file by chunks
 	//////////////////////////////////////////////////////////////////
-	QString mtlLibFileName(getMtlLibFileName(mtlLibLine));
-	if (!mtlLibFileName.isEmpty())
+	emit currentQuantum(0);
+	QList<ObjChunk*> chunkList= parseChunks(pData, size);
+	const int chunkCount= chunkList.size();
+
+	// Compute chunks offsets and check errors
+	int lineCount= 0;
+	int positionCount= 0;
+	int normalCount= 0;
+	int texelCount= 0;
+	for (int i= 0; i < chunkCount; ++i)
 	{
-		m_pMtlLoader= new GLC_ObjMtlLoader(mtlLibFileName);
-		if (!m_pMtlLoader->loadMaterials())
+		ObjChunk* pChunk= chunkList.at(i);
+		pChunk->m_LineBase= lineCount;
+		pChunk->m_PositionBase= positionCount;
+		pChunk->m_NormalBase= normalCount;
+		pChunk->m_TexelBase= texelCount;
+		lineCount+= pChunk->m_LineCount;
+		positionCount+= pChunk->m_Positions.size() / 3;
+		normalCount+= pChunk->m_Normals.size() / 3;
+		texelCount+= pChunk->m_Texels.size() / 2;
+
+		for (int j= 0; j < pChunk->m_Warnings.size(); ++j)
 		{
-			delete m_pMtlLoader;
-			m_pMtlLoader= NULL;
-			if (!mtlLibLine.isEmpty())
-			{
-				QStringList stringList(m_FileName);
-				stringList.append("Open Material File : " + mtlLibFileName + " failed");
-				GLC_ErrorLog::addError(stringList);
-			}
+			QString message= "GLC_ObjToWorld::CreateWorldFromObj " + m_FileName + " " + pChunk->m_Warnings.at(j).second;
+			message.append("\nAt line : ");
+			message.append(QString::number(pChunk->m_LineBase + pChunk->m_Warnings.at(j).first));
+			QStringList stringList(m_FileName);
+			stringList.append(message);
+			GLC_ErrorLog::addError(stringList);
 		}
-		else
+
+		if (pChunk->hasError())
 		{
-			// Update Attached file name list
-			m_ListOfAttachedFileName << mtlLibFileName;
-			m_ListOfAttachedFileName << m_pMtlLoader->listOfAttachedFileName();
+			QString message= "GLC_ObjToWorld::CreateWorldFromObj " + m_FileName + " " + pChunk->m_ErrorMessage;
+			message.append("\nAt line : ");
+			message.append(QString::number(pChunk->m_LineBase + pChunk->m_ErrorLine));
+			GLC_FileFormatException fileFormatException(message, m_FileName, pChunk->m_ErrorType);
+			qDeleteAll(chunkList);
+			file.close();
+			clear();
+			throw(fileFormatException);
 		}
 	}
-	else
+
+	// Gather bulk data of all chunks
+	m_Positions.reserve(positionCount * 3);
+	m_Normals.reserve(normalCount * 3);
+	m_Texels.reserve(texelCount * 2);
+	for (int i= 0; i < chunkCount; ++i)
 	{
-		//qDebug() << "GLC_ObjToWorld::CreateWorldFromObj: mtl file not found";
+		ObjChunk* pChunk= chunkList.at(i);
+		m_Positions+= pChunk->m_Positions;
+		pChunk->m_Positions.clear();
+		m_Normals+= pChunk->m_Normals;
+		pChunk->m_Normals.clear();
+		m_Texels+= pChunk->m_Texels;
+		pChunk->m_Texels.clear();
 	}
+	// Chunks don't reference file data anymore
+	file.close();
+	fileContent.clear();
 
 	//////////////////////////////////////////////////////////////////
-	// Read Buffer and create the world
+	// Merge the chunks and create the world
 	//////////////////////////////////////////////////////////////////
-	emit currentQuantum(currentQuantumValue);
-	m_CurrentLineNumber= 0;
-    m_VerticeIndex= 0;
-    m_NormalIndex= 0;
-    m_TextureIndex= 0;
-
-    m_VerticeOffset= 0;
-    m_NormalOffset= 0;
-    m_TextureOffset= 0;
-
-	while (!objStream.atEnd())
+	int previousQuantumValue= 50;
+	try
 	{
-		++m_CurrentLineNumber;
-		lineBuff= objStream.readLine();
-
-		mergeLines(&lineBuff, &objStream);
-
-		scanLigne(lineBuff);
-		currentQuantumValue = static_cast<int>((static_cast<double>(m_CurrentLineNumber) / numberOfLine) * 100);
-		if (currentQuantumValue > previousQuantumValue)
+		for (int i= 0; i < chunkCount; ++i)
 		{
-			emit currentQuantum(currentQuantumValue);
+			mergeChunk(*chunkList.at(i));
+			delete chunkList.at(i);
+			chunkList[i]= NULL;
+			emitProgress(i + 1, chunkCount, 50, 100, &previousQuantumValue);
 		}
-		previousQuantumValue= currentQuantumValue;
-
 	}
-	file.close();
+	catch (GLC_FileFormatException&)
+	{
+		qDeleteAll(chunkList);
+		throw;
+	}
 
 	addCurrentObjMeshToWorld();
 
+	m_Positions.clear();
+	m_Normals.clear();
+	m_Texels.clear();
+
 	//! Test if there is meshes in the world
 	if (m_pWorld->rootOccurrence()->childCount() == 0)
 	{
@@ -241,80 +649,111 @@ QString GLC_ObjToWorld::getMtlLibFileName(QString line)
 	return mtlFileName;
 }
 
-// Scan a line previously extracted from OBJ file
-void GLC_ObjToWorld::scanLigne(QString &line)
+// Load the materials of the mtl file referenced by the given line
+void GLC_ObjToWorld::loadMaterials(const QString& mtlLibLine)
 {
-	line= line.trimmed();
-	// Search Vertexs vectors
-	if (line.startsWith("v ")|| line.startsWith(QString("v") + QString(QChar(9))))
+	QString mtlLibFileName(getMtlLibFileName(mtlLibLine));
+	if (!mtlLibFileName.isEmpty())
 	{
-        if (m_ResetIndex)
-        {
-            m_VerticeOffset+= m_VerticeIndex;
-            m_NormalOffset+= m_NormalIndex;
-            m_TextureOffset+= m_TextureIndex;
-
-            m_VerticeIndex= 0;
-            m_TextureIndex= 0;
-            m_NormalIndex= 0;
-            m_ResetIndex= false;
-        }
-		line.remove(0,2); // Remove first 2 char
-		m_Positions.append(extract3dVect(line));
-		m_FaceType = notSet;
-        ++m_VerticeIndex;
+		m_pMtlLoader= new GLC_ObjMtlLoader(mtlLibFileName);
+		if (!m_pMtlLoader->loadMaterials())
+		{
+			delete m_pMtlLoader;
+			m_pMtlLoader= NULL;
+			if (!mtlLibLine.isEmpty())
+			{
+				QStringList stringList(m_FileName);
+				stringList.append("Open Material File : " + mtlLibFileName + " failed");
+				GLC_ErrorLog::addError(stringList);
+			}
+		}
+		else
+		{
+			// Update Attached file name list
+			m_ListOfAttachedFileName << mtlLibFileName;
+			m_ListOfAttachedFileName << m_pMtlLoader->listOfAttachedFileName();
+		}
 	}
+}
 
-	// Search texture coordinate vectors
-	else if (line.startsWith("vt ")|| line.startsWith(QString("vt") + QString(QChar(9))))
+// Split the given data in line aligned chunks and parse them in parallel
+QList<GLC_ObjToWorld::ObjChunk*> GLC_ObjToWorld::parseChunks(const char* pData, qint64 size)
+{
+	const int threadCount= qMax(1, QThread::idealThreadCount());
+	const int maxChunkCount= static_cast<int>(qBound(Q_INT64_C(1), size / minimumChunkSize, static_cast<qint64>(threadCount * 4)));
+
+	// A chunk end after a line which doesn't continue on the next line
+	QList<ObjChunk*> chunkList;
+	const char* pEnd= pData + size;
+	const char* pBegin= pData;
+	for (int i= 1; i < maxChunkCount; ++i)
 	{
-		line.remove(0,3); // Remove first 3 char
-		m_Texels.append(extract2dVect(line));
-		m_FaceType = notSet;
-        ++m_TextureIndex;
+		const char* p= qMax(pBegin, pData + (size * i) / maxChunkCount);
+		const char* pNewLine= static_cast<const char*>(memchr(p, '\n', pEnd - p));
+		while ((NULL != pNewLine) && isContinuedLine(pBegin, pNewLine))
+		{
+			pNewLine= static_cast<const char*>(memchr(pNewLine + 1, '\n', pEnd - pNewLine - 1));
+		}
+		if (NULL == pNewLine) break;
+		chunkList.append(new ObjChunk(pBegin, pNewLine + 1));
+		pBegin= pNewLine + 1;
 	}
+	chunkList.append(new ObjChunk(pBegin, pEnd));
 
-	// Search normals vectors
-	else if (line.startsWith("vn ") || line.startsWith(QString("vn") + QString(QChar(9))))
+	const int chunkCount= chunkList.size();
+	QAtomicInt parsedChunkCount(0);
+	int previousQuantumValue= 0;
+	if (1 == chunkCount)
 	{
-		line.remove(0,3); // Remove first 3 char
-		m_Normals.append(extract3dVect(line));
-		m_FaceType = notSet;
-        ++m_NormalIndex;
+		chunkList.first()->parse();
 	}
-
-	// Search faces to update index
-	else if (line.startsWith("f ") || line.startsWith(QString("f") + QString(QChar(9))))
+	else
 	{
-        m_ResetIndex= true;
-		// If there is no group or object in the OBJ file
-		if (NULL == m_pCurrentObjMesh)
-			{
-				changeGroup("GLC_Default");
-				//qDebug() << "Default group " << line;
-			}
-		line.remove(0,2); // Remove first 2 char
-		extractFaceIndex(line);
+		QThreadPool threadPool;
+		threadPool.setMaxThreadCount(qMin(threadCount, chunkCount));
+		for (int i= 0; i < chunkCount; ++i)
+		{
+			threadPool.start(new ChunkParsingTask(chunkList.at(i), &parsedChunkCount));
+		}
+		while (!threadPool.waitForDone(50))
+		{
+			emitProgress(parsedChunkCount.load(), chunkCount, 0, 50, &previousQuantumValue);
+		}
 	}
+	emitProgress(chunkCount, chunkCount, 0, 50, &previousQuantumValue);
 
-	// Search Material
-	else if (line.startsWith("usemtl ") || line.startsWith(QString("usemtl") + QString(QChar(9))))
-	{
-		line.remove(0,7); // Remove first 7 char
-		setCurrentMaterial(line);
-		m_FaceType = notSet;
-	}
+	return chunkList;
+}
 
-	// Search Group
-	else if (line.startsWith("g ") || line.startsWith("o ") || line.startsWith(QString("g") + QString(QChar(9)))
-			|| line.startsWith(QString("o") + QString(QChar(9))))
+// Merge the given parsed chunk into the world
+void GLC_ObjToWorld::mergeChunk(const ObjChunk& chunk)
+{
+	const int recordCount= chunk.m_Records.size();
+	for (int i= 0; i < recordCount; ++i)
 	{
-		m_FaceType = notSet;
-		line.remove(0,2); // Remove first 2 char
-		changeGroup(line);
+		const ObjChunk::Record& record= chunk.m_Records.at(i);
+		m_CurrentLineNumber= chunk.m_LineBase + record.m_Line;
+		if (ObjChunk::Face == record.m_Type)
+		{
+			// If there is no group or object in the OBJ file
+			if (NULL == m_pCurrentObjMesh)
+			{
+				changeGroup("GLC_Default");
+			}
+			addFace(chunk, i);
+		}
+		else if (ObjChunk::Group == record.m_Type)
+		{
+			changeGroup(chunk.m_Names.at(record.m_First));
+		}
+		else
+		{
+			QString materialName(chunk.m_Names.at(record.m_First));
+			setCurrentMaterial(materialName);
+		}
 	}
-
 }
+
 // Change current group
 void GLC_ObjToWorld::changeGroup(QString line)
 {
@@ -356,100 +795,27 @@ void GLC_ObjToWorld::changeGroup(QString line)
 
 }
 
-// Extract a Vector from a string
-QList<float> GLC_ObjToWorld::extract3dVect(QString &line)
-{
-	float x=0.0f;
-	float y=0.0f;
-	float z=0.0f;
-
-	QList<float> vectResult;
-	QTextStream stringVecteur(&line);
-
-	QString xString, yString, zString;
-
-	if (((stringVecteur >> xString >> yString >> zString).status() == QTextStream::Ok))
-	{
-		bool xOk, yOk, zOk;
-		x= xString.toFloat(&xOk);
-		y= yString.toFloat(&yOk);
-		z= zString.toFloat(&zOk);
-		if (!(xOk && yOk && zOk))
-		{
-			QString message= "GLC_ObjToWorld::extract3dVect " + m_FileName + " failed to convert vector component to float";
-			message.append("\nAt ligne : ");
-			message.append(QString::number(m_CurrentLineNumber));
-			QStringList stringList(m_FileName);
-			stringList.append(message);
-			GLC_ErrorLog::addError(stringList);
-
-			//GLC_FileFormatException fileFormatException(message, m_FileName);
-			//clear();
-			//throw(fileFormatException);
-		}
-		else
-		{
-			vectResult << x << y << z;
-		}
-	}
-
-	return vectResult;
-
-}
-
-// Extract a Vector from a string
-QList<float> GLC_ObjToWorld::extract2dVect(QString &line)
+// Add the face of the given record of the given chunk
+void GLC_ObjToWorld::addFace(const ObjChunk& chunk, int recordIndex)
 {
-	float x=0.0f;
-	float y=0.0f;
-	QList<float> vectResult;
-	QTextStream stringVecteur(&line);
-
-	QString xString, yString;
-
-	if (((stringVecteur >> xString >> yString).status() == QTextStream::Ok))
-	{
-		bool xOk, yOk;
-		x= xString.toFloat(&xOk);
-		y= yString.toFloat(&yOk);
-		if (!(xOk && yOk))
-		{
-			QString message= "GLC_ObjToWorld::extract2dVect " + m_FileName + " failed to convert vector component to double";
-			message.append("\nAt ligne : ");
-			message.append(QString::number(m_CurrentLineNumber));
-			GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
-			clear();
-			throw(fileFormatException);
-		}
-		vectResult << x << y;
-	}
-
-	return vectResult;
-}
-
-// Extract a face from a string
-void GLC_ObjToWorld::extractFaceIndex(QString &line)
-{
-	QString buff;
-
-	int coordinateIndex;
-	int normalIndex;
-	int textureCoordinateIndex;
+	const ObjChunk::Record& record= chunk.m_Records.at(recordIndex);
 
 	QList<GLuint> currentFaceIndex;
-	//////////////////////////////////////////////////////////////////
-	// Parse the line containing face index
-	//////////////////////////////////////////////////////////////////
-	QTextStream streamFace(&line);
-	while ((!streamFace.atEnd()))
+	for (int i= 0; i < record.m_Count; ++i)
 	{
-		streamFace >> buff;
-		extractVertexIndex(buff, coordinateIndex, normalIndex, textureCoordinateIndex);
+		const ObjChunk::FaceVertex& vertex= chunk.m_FaceVertices.at(record.m_First + i);
+		int coordinateIndex= vertex.m_Position;
+		if (vertex.m_RelativeMask & ObjChunk::RelativePosition) coordinateIndex+= chunk.m_PositionBase;
+		int textureCoordinateIndex= vertex.m_Texel;
+		if (vertex.m_RelativeMask & ObjChunk::RelativeTexel) textureCoordinateIndex+= chunk.m_TexelBase;
+		int normalIndex= vertex.m_Normal;
+		if (vertex.m_RelativeMask & ObjChunk::RelativeNormal) normalIndex+= chunk.m_NormalBase;
 
 		ObjVertice currentVertice(coordinateIndex, normalIndex, textureCoordinateIndex);
-		if (m_pCurrentObjMesh->m_ObjVerticeIndexMap.contains(currentVertice))
+		QHash<ObjVertice, GLuint>::const_iterator iVertice= m_pCurrentObjMesh->m_ObjVerticeIndexMap.constFind(currentVertice);
+		if (m_pCurrentObjMesh->m_ObjVerticeIndexMap.constEnd() != iVertice)
 		{
-			currentFaceIndex.append(m_pCurrentObjMesh->m_ObjVerticeIndexMap.value(currentVertice));
+			currentFaceIndex.append(iVertice.value());
 		}
 		else
 		{
@@ -457,7 +823,7 @@ void GLC_ObjToWorld::extractFaceIndex(QString &line)
 			m_pCurrentObjMesh->m_Positions.append(m_Positions.value(coordinateIndex * 3));
 			m_pCurrentObjMesh->m_Positions.append(m_Positions.value(coordinateIndex * 3 + 1));
 			m_pCurrentObjMesh->m_Positions.append(m_Positions.value(coordinateIndex * 3 + 2));
-			if (-1 != normalIndex)
+			if (record.m_HasNormal)
 			{
 				// Add Normal to the mesh bulk data
 				m_pCurrentObjMesh->m_Normals.append(m_Normals.value(normalIndex * 3));
@@ -471,7 +837,7 @@ void GLC_ObjToWorld::extractFaceIndex(QString &line)
 				m_pCurrentObjMesh->m_Normals.append(0.0f);
 				m_pCurrentObjMesh->m_Normals.append(0.0f);
 			}
-			if (-1 != textureCoordinateIndex)
+			if (record.m_HasTexel)
 			{
 				// Add texture coordinate to the mesh bulk data
 				m_pCurrentObjMesh->m_Texels.append(m_Texels.value(textureCoordinateIndex * 2));
@@ -490,7 +856,6 @@ void GLC_ObjToWorld::extractFaceIndex(QString &line)
 			// Increment next free index
 			++(m_pCurrentObjMesh->m_NextFreeIndex);
 		}
-
 	}
 	//////////////////////////////////////////////////////////////////
 	// Check the number of face's vertex
@@ -499,27 +864,19 @@ void GLC_ObjToWorld::extractFaceIndex(QString &line)
 	if (size < 3)
 	{
 		QStringList stringList(m_FileName);
-		stringList.append("GLC_ObjToWorld::extractFaceIndex Face with less than 3 vertex found");
+		stringList.append("GLC_ObjToWorld::addFace Face with less than 3 vertex found");
 		GLC_ErrorLog::addError(stringList);
 		return;
 	}
 	//////////////////////////////////////////////////////////////////
 	// Add the face to the current mesh
 	//////////////////////////////////////////////////////////////////
-	if ((m_FaceType == coordinateAndNormal) || (m_FaceType == coordinateAndTextureAndNormal))
+	if (size > 3)
 	{
-		if (size > 3)
-		{
-			glc::triangulatePolygon(&currentFaceIndex, m_pCurrentObjMesh->m_Positions);
-		}
-		m_pCurrentObjMesh->m_Index.append(currentFaceIndex);
+		glc::triangulatePolygon(&currentFaceIndex, m_pCurrentObjMesh->m_Positions);
 	}
-	else if (m_FaceType != notSet)
+	if (!record.m_HasNormal)
 	{
-		if (size > 3)
-		{
-			glc::triangulatePolygon(&currentFaceIndex, m_pCurrentObjMesh->m_Positions);
-		}
 		// Comput the face normal
 		if (currentFaceIndex.size() < 3) return;
 		GLC_Vector3df normal= computeNormal(currentFaceIndex.at(0), currentFaceIndex.at(1), currentFaceIndex.at(2));
@@ -535,20 +892,10 @@ void GLC_ObjToWorld::extractFaceIndex(QString &line)
 
 			++iIndexSet;
 		}
-
-		m_pCurrentObjMesh->m_Index.append(currentFaceIndex);
-
-	}
-	else
-	{
-		QString message= "GLC_ObjToWorld::extractFaceIndex " + m_FileName + " unknow face type";
-		message.append("\nAt line : ");
-		message.append(QString::number(m_CurrentLineNumber));
-		GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::FileNotSupported);
-		clear();
-		throw(fileFormatException);
 	}
+	m_pCurrentObjMesh->m_Index.append(currentFaceIndex);
 }
+
 //! Set Current material index
 void GLC_ObjToWorld::setCurrentMaterial(QString &line)
 {
@@ -606,217 +953,6 @@ void GLC_ObjToWorld::setCurrentMaterial(QString &line)
 	}
 
 }
-// Extract a vertex from a string
-void GLC_ObjToWorld::extractVertexIndex(QString line, int &Coordinate, int &Normal, int &TextureCoordinate)
-{
- 	if (m_FaceType == notSet)
- 	{
- 		setObjType(line);
- 	}
-
- 	if (m_FaceType == coordinateAndTextureAndNormal)
- 	{
-		// Replace "/" with " "
-		line.replace('/', ' ');
-		QTextStream streamVertex(&line);
-		QString coordinateString, textureCoordinateString, normalString;
-	 	if ((streamVertex >> coordinateString >> textureCoordinateString >> normalString).status() == QTextStream::Ok)
-		{
-			bool coordinateOk, textureCoordinateOk, normalOk;
-			Coordinate= coordinateString.toInt(&coordinateOk);
-			--Coordinate;
-			TextureCoordinate= textureCoordinateString.toInt(&textureCoordinateOk);
-			--TextureCoordinate;
-			Normal= normalString.toInt(&normalOk);
-			--Normal;
-			if (!(coordinateOk && textureCoordinateOk && normalOk))
-			{
-				QString message= "GLC_ObjToWorld::extractVertexIndex " + m_FileName + " failed to convert String to int";
-				message.append("\nAt line : ");
-				message.append(QString::number(m_CurrentLineNumber));
-				GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
-				clear();
-				throw(fileFormatException);
-			}
-            else if (Coordinate < 0)
-            {
-                Coordinate= m_VerticeIndex + m_VerticeOffset + Coordinate + 1;
-                Normal= m_NormalIndex + m_NormalOffset + Normal + 1;
-                TextureCoordinate= m_TextureIndex + m_TextureOffset + TextureCoordinate + 1;
-            }
-		}
-		else
-		{
-			QString message= "GLC_ObjToWorld::extractVertexIndex Obj file " + m_FileName + " type is not supported";
-			message.append("\nAt line : ");
-			message.append(QString::number(m_CurrentLineNumber));
-			GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::FileNotSupported);
-			clear();
-			throw(fileFormatException);
-		}
-
- 	}
- 	else if (m_FaceType == coordinateAndTexture)
- 	{
-		// Replace "/" with " "
-		line.replace('/', ' ');
-		QTextStream streamVertex(&line);
-		QString coordinateString, textureCoordinateString;
-	 	if ((streamVertex >> coordinateString >> textureCoordinateString).status() == QTextStream::Ok)
-		{
-			bool coordinateOk, textureCoordinateOk;
-			Coordinate= coordinateString.toInt(&coordinateOk);
-			--Coordinate;
-			TextureCoordinate= textureCoordinateString.toInt(&textureCoordinateOk);
-			--TextureCoordinate;
-			Normal= -1;
-			if (!(coordinateOk && textureCoordinateOk))
-			{
-				QString message= "GLC_ObjToWorld::extractVertexIndex " + m_FileName +  "failed to convert String to int";
-				message.append("\nAt line : ");
-				message.append(QString::number(m_CurrentLineNumber));
-				GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
-				clear();
-				throw(fileFormatException);
-			}
-            else if (Coordinate < 0)
-            {
-                Coordinate= m_VerticeIndex + m_VerticeOffset + Coordinate + 1;
-                TextureCoordinate= m_TextureIndex + m_TextureOffset + TextureCoordinate + 1;
-            }
-		}
-		else
-		{
-			QString message= "GLC_ObjToWorld::extractVertexIndex " + m_FileName + " this Obj file type is not supported";
-			message.append("\nAt line : ");
-			message.append(QString::number(m_CurrentLineNumber));
-			GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::FileNotSupported);
-			clear();
-			throw(fileFormatException);
-		}
- 	}
- 	else if (m_FaceType == coordinateAndNormal)
- 	{
-		// Replace "/" with " "
-		line.replace('/', ' ');
-		QTextStream streamVertex(&line);
-		QString coordinateString, normalString;
-	 	if ((streamVertex >> coordinateString >> normalString).status() == QTextStream::Ok)
-		{
-			bool coordinateOk, normalOk;
-			Coordinate= coordinateString.toInt(&coordinateOk);
-			--Coordinate;
-			TextureCoordinate= -1;
-			Normal= normalString.toInt(&normalOk);
-			--Normal;
-			if (!(coordinateOk && normalOk))
-			{
-				QString message= "GLC_ObjToWorld::extractVertexIndex " + m_FileName + " failed to convert String to int";
-				message.append("\nAt line : ");
-				message.append(QString::number(m_CurrentLineNumber));
-				GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
-				clear();
-				throw(fileFormatException);
-			}
-            else if (Coordinate < 0)
-            {
-                Coordinate= m_VerticeIndex + m_VerticeOffset + Coordinate + 1;
-                Normal= m_NormalIndex + m_NormalOffset + Normal + 1;
-            }
-
-		}
-		else
-		{
-			QString message= "GLC_ObjToWorld::extractVertexIndex " + m_FileName + " this Obj file type is not supported";
-			message.append("\nAt line : ");
-			message.append(QString::number(m_CurrentLineNumber));
-			GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::FileNotSupported);
-			clear();
-			throw(fileFormatException);
-		}
- 	}
-  	else if (m_FaceType == coordinate)
- 	{
- 		QTextStream streamVertex(&line);
- 		QString coordinateString;
-	 	if ((streamVertex >> coordinateString).status() == QTextStream::Ok)
-		{
-			bool coordinateOk;
-			Coordinate= coordinateString.toInt(&coordinateOk);
-			--Coordinate;
-			TextureCoordinate= -1;
-			Normal= -1;
-			if (!coordinateOk)
-			{
-				QString message= "GLC_ObjToWorld::extractVertexIndex "  + m_FileName + " failed to convert String to int";
-				message.append("\nAt line : ");
-				message.append(QString::number(m_CurrentLineNumber));
-				GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
-				clear();
-				throw(fileFormatException);
-			}
-            else if (Coordinate < 0)
-            {
-                Coordinate= m_VerticeIndex + m_VerticeOffset + Coordinate + 1;
-            }
-		}
-		else
-		{
-			QString message= "GLC_ObjToWorld::extractVertexIndex Obj " + m_FileName + " file type is not supported";
-			message.append("\nAt line : ");
-			message.append(QString::number(m_CurrentLineNumber));
-			GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::FileNotSupported);
-			clear();
-			throw(fileFormatException);
-		}
- 	}
- 	else
- 	{
-		QString message= "GLC_ObjToWorld::extractVertexIndex OBJ file " + m_FileName + " not reconize";
-		message.append("\nAt line : ");
-		message.append(QString::number(m_CurrentLineNumber));
-		GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::FileNotSupported);
-		clear();
-		throw(fileFormatException);
- 	}
-
-}
-
-// set the OBJ File type
-void GLC_ObjToWorld::setObjType(QString& ligne)
-{
-    const QRegExp coordinateOnlyRegExp("^[-+]?\\d{1,}$"); // ex. 10
-    const QRegExp coordinateTextureNormalRegExp("^[-+]?\\d{1,}/[-+]?\\d{1,}/[-+]?\\d{1,}$"); // ex. 10/30/54
-    const QRegExp coordinateNormalRegExp("^[-+]?\\d{1,}//[-+]?\\d{1,}$"); // ex. 10//54
-    const QRegExp coordinateTextureRegExp("^[-+]?\\d{1,}/[-+]?\\d{1,}$"); // ex. 10/56
-
- 	if (coordinateTextureNormalRegExp.exactMatch(ligne))
- 	{
- 		m_FaceType= coordinateAndTextureAndNormal;
- 	}
- 	else if (coordinateTextureRegExp.exactMatch(ligne))
- 	{
- 		m_FaceType= coordinateAndTexture;
- 	}
- 	else if (coordinateNormalRegExp.exactMatch(ligne))
- 	{
- 		m_FaceType= coordinateAndNormal;
- 	}
-  	else if (coordinateOnlyRegExp.exactMatch(ligne))
- 	{
- 		m_FaceType= coordinate;
- 	}
- 	else
- 	{
-		QString message= "GLC_ObjToWorld::setObjType OBJ file " + m_FileName + " not reconize";
-		message.append("\nAt line : ");
-		message.append(QString::number(m_CurrentLineNumber));
-		GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::FileNotSupported);
-		clear();
-		throw(fileFormatException);
- 	}
-}
-
 // compute face normal
 GLC_Vector3df GLC_ObjToWorld::computeNormal(GLuint index1, GLuint index2, GLuint index3)
 {
@@ -867,18 +1003,6 @@ void GLC_ObjToWorld::clear()
 	}
 
 }
-// Merge Mutli line in one
-void GLC_ObjToWorld::mergeLines(QString* pLineBuff, QTextStream* p0bjStream)
-{
-	if (pLineBuff->endsWith(QChar('\\')))
-	{
-		pLineBuff->replace(QChar('\\'), QChar(' '));
-		pLineBuff->append(p0bjStream->readLine());
-		++m_CurrentLineNumber;
-		mergeLines(pLineBuff, p0bjStream);
-	}
-}
-
 // Add the current Obj mesh to the world
 void GLC_ObjToWorld::addCurrentObjMeshToWorld()
 {
@@ -946,4 +1070,13 @@ void GLC_ObjToWorld::addCurrentObjMeshToWorld()
 	}
 }
 
-
+// Emit progress of the given step in the given range of the loading
+void GLC_ObjToWorld::emitProgress(int currentIndex, int size, int rangeBegin, int rangeEnd, int* pPreviousQuantumValue)
+{
+	const int currentQuantumValue= rangeBegin + static_cast<int>((static_cast<double>(currentIndex) / size) * (rangeEnd - rangeBegin));
+	if (currentQuantumValue > *pPreviousQuantumValue)
+	{
+		emit currentQuantum(currentQuantumValue);
+		*pPreviousQuantumValue= currentQuantumValue;
+	}
+}
@@ -38,18 +38,10 @@
 #include "../maths/glc_vector2df.h"
 #include "../maths/glc_vector3df.h"
 #include "../geometry/glc_mesh.h"
+#include "../glc_global.h"
 
 #include "../glc_config.h"
 
-enum FaceType
-{
-	notSet,
-	coordinate,
-	coordinateAndTexture,
-	coordinateAndNormal,
-	coordinateAndTextureAndNormal
-};
-
 class GLC_World;
 class GLC_ObjMtlLoader;
 
@@ -63,32 +55,37 @@ class GLC_ObjMtlLoader;
  * 		- Face
  * 		- Texture coordinate
  * 		- Normal coordinate
+ *
+ * The file is memory mapped and split in line aligned chunks which
+ * are parsed at byte level on several threads. Parsed chunks are
+ * then merged in file order into the meshs of the world.
   */
 //////////////////////////////////////////////////////////////////////
 class GLC_LIB_EXPORT GLC_ObjToWorld : public QObject
 {
 	Q_OBJECT
 
+	struct ObjChunk;
+	class ChunkParsingTask;
+
 public:
 	// OBJ Vertice (Position index, Normal index and TexCoord index)
 	struct ObjVertice
 	{
 		ObjVertice()
-		: m_Values(3)
 		{
 			m_Values[0]= 0;
 			m_Values[1]= 0;
 			m_Values[2]= 0;
 		}
 		ObjVertice(int v1, int v2, int v3)
-		: m_Values(3)
 		{
 			m_Values[0]= v1;
 			m_Values[1]= v2;
 			m_Values[2]= v3;
 		}
 
-		QVector<int> m_Values;
+		int m_Values[3];
 	};
 
 	// Material assignement
@@ -172,42 +169,35 @@ private:
 	//! Return the name of the mtl file
 	QString getMtlLibFileName(QString);
 
-	//! Scan a line previously extracted from OBJ file
-	void scanLigne(QString &);
+	//! Load the materials of the mtl file referenced by the given line
+	void loadMaterials(const QString& mtlLibLine);
 
-	//! Change current group
-	void changeGroup(QString);
+	//! Split the given data in line aligned chunks and parse them in parallel
+	QList<ObjChunk*> parseChunks(const char* pData, qint64 size);
 
-	//! Extract a 3D Vector from a string
-	QList<float> extract3dVect(QString &);
+	//! Merge the given parsed chunk into the world
+	void mergeChunk(const ObjChunk& chunk);
 
-	//! Extract a 2D Vector from a string
-	QList<float> extract2dVect(QString &);
+	//! Change current group
+	void changeGroup(QString);
 
-	//! Extract a face from a string
-	void extractFaceIndex(QString &);
+	//! Add the face of the given record of the given chunk
+	void addFace(const ObjChunk& chunk, int recordIndex);
 
 	//! Set Current material index
 	void setCurrentMaterial(QString &line);
 
-	//! Extract a vertex from a string
-	void extractVertexIndex(QString ligne, int &Coordinate, int &Normal, int &TextureCoordinate);
-
-	//! set the OBJ File type
-	void setObjType(QString &);
-
 	//! compute face normal
 	GLC_Vector3df computeNormal(GLuint, GLuint, GLuint);
 
 	//! clear objToWorld allocate memmory
 	void clear();
 
-	//! Merge Mutli line in one
-	void mergeLines(QString*, QTextStream*);
-
 	//! Add the current Obj mesh to the world
 	void addCurrentObjMeshToWorld();
 
+	//! Emit progress of the given step in the given range of the loading
+	void emitProgress(int currentIndex, int size, int rangeBegin, int rangeEnd, int* pPreviousQuantumValue);
 
 
 //////////////////////////////////////////////////////////////////////
@@ -235,9 +225,6 @@ private:
 	//! The current mesh
 	CurrentObjMesh* m_pCurrentObjMesh;
 
-	//! Face type
-	FaceType m_FaceType;
-
 	//! List of material already used by the current mesh
 	QHash<QString, int> m_CurrentMeshMaterials;
 
@@ -248,33 +235,27 @@ private:
 	QStringList m_ListOfAttachedFileName;
 
 	//! The position bulk data
-	QList<float> m_Positions;
+	GLfloatVector m_Positions;
 
 	//! The normal bulk data
-	QList<float> m_Normals;
+	GLfloatVector m_Normals;
 
 	//! The texture coordinate bulk data
-	QList<float> m_Texels;
-
-    int m_VerticeIndex;
-    int m_NormalIndex;
-    int m_TextureIndex;
-
-    int m_VerticeOffset;
-    int m_NormalOffset;
-    int m_TextureOffset;
-
-
-    bool m_ResetIndex;
+	GLfloatVector m_Texels;
 
 };
 
 // To use ObjVertice as a QHash key
 inline bool operator==(const GLC_ObjToWorld::ObjVertice& vertice1, const GLC_ObjToWorld::ObjVertice& vertice2)
-{ return (vertice1.m_Values == vertice2.m_Values);}
+{
+	return (vertice1.m_Values[0] == vertice2.m_Values[0]) && (vertice1.m_Values[1] == vertice2.m_Values[1])
+			&& (vertice1.m_Values[2] == vertice2.m_Values[2]);
+}
 
 inline uint qHash(const GLC_ObjToWorld::ObjVertice& vertice)
-{ return qHash(QString::number(vertice.m_Values.at(0)) + QString::number(vertice.m_Values.at(1)) + QString::number(vertice.m_Values.at(2)));}
+{
+	return glc::hashTriplet(static_cast<uint>(vertice.m_Values[0]), static_cast<uint>(vertice.m_Values[1]), static_cast<uint>(vertice.m_Values[2]));
+}
 
 
 #endif /*GLC_OBJTOWORLD_H_*/
@@ -28,10 +28,72 @@
 #include "../sceneGraph/glc_structreference.h"
 #include "../sceneGraph/glc_structinstance.h"
 #include "../sceneGraph/glc_structoccurrence.h"
+#include "../maths/glc_utils_maths.h"
+#include "../glc_state.h"
 
 #include <QTextStream>
 #include <QFileInfo>
 #include <QDataStream>
+#include <QtEndian>
+
+#include <cstring>
+#include <cmath>
+#include <climits>
+
+// Size of a binary STL header, number of facets included
+static const qint64 binaryStlHeaderSize= 84;
+// Size of a binary STL facet : normal, 3 vertices and attribute byte count
+static const qint64 binaryStlFacetSize= 50;
+// Empty slot of the vertex welding hash table
+static const GLuint emptySlot= 0xFFFFFFFF;
+// Default crease angle in degrees of vertex welding
+static const double defaultWeldingCreaseAngle= 30.0;
+
+// Decode the 12 little endian floats of the given binary STL facet
+static inline void decodeFacet(const uchar* pFacet, GLfloat* pDest)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+	memcpy(pDest, pFacet, 12 * sizeof(GLfloat));
+#else
+	for (int i= 0; i < 12; ++i)
+	{
+		const quint32 value= qFromLittleEndian<quint32>(pFacet + 4 * i);
+		memcpy(pDest + i, &value, sizeof(GLfloat));
+	}
+#endif
+}
+
+// Return the hash value of the given vertex
+static inline GLuint vertexHash(const GLfloat* pVertex)
+{
+	quint32 bits[3];
+	memcpy(bits, pVertex, 3 * sizeof(GLfloat));
+	quint32 hash= bits[0];
+	hash= (hash * 0x9E3779B1u) ^ bits[1];
+	hash= (hash * 0x9E3779B1u) ^ bits[2];
+	hash^= hash >> 15;
+	hash*= 0x85EBCA6Bu;
+	hash^= hash >> 13;
+	return hash;
+}
+
+// Rebuild the given vertex welding hash table with the double of its size
+static void growVertexTable(QVector<GLuint>* pTable, const GLfloatVector& positions)
+{
+	pTable->fill(emptySlot, 2 * pTable->size());
+	const GLuint mask= static_cast<GLuint>(pTable->size() - 1);
+	GLuint* pSlots= pTable->data();
+	const GLuint vertexCount= static_cast<GLuint>(positions.size() / 3);
+	for (GLuint i= 0; i < vertexCount; ++i)
+	{
+		GLuint slot= vertexHash(positions.constData() + 3 * i) & mask;
+		while (emptySlot != pSlots[slot])
+		{
+			slot= (slot + 1) & mask;
+		}
+		pSlots[slot]= i;
+	}
+}
 
 GLC_StlToWorld::GLC_StlToWorld()
 : QObject()
@@ -44,6 +106,8 @@ GLC_StlToWorld::GLC_StlToWorld()
 , m_VertexBulk()
 , m_NormalBulk()
 , m_CurrentIndex(0)
+, m_WeldVertices(GLC_State::isStlVertexWeldingActivated())
+, m_WeldingCreaseAngle(defaultWeldingCreaseAngle)
 {
 
 }
@@ -81,6 +145,9 @@ GLC_World* GLC_StlToWorld::CreateWorldFromStl(QFile &file)
 	int previousQuantumValue= 0;
 	int numberOfLine= 0;
 
+	// A binary STL size is known from its number of facets
+	const bool stlIsBinary= isBinaryStl(file);
+
 	// Attach the stream to the file
 	m_StlStream.setDevice(&file);
 
@@ -92,7 +159,7 @@ GLC_World* GLC_StlToWorld::CreateWorldFromStl(QFile &file)
     // And test if the STL file is ASCII
 	//////////////////////////////////////////////////////////////////
     bool stlIsAscii= false;
-	while (!m_StlStream.atEnd())
+	while (!stlIsBinary && !m_StlStream.atEnd())
 	{
 		++numberOfLine;
         const QString currentLine= m_StlStream.readLine();
@@ -132,12 +199,6 @@ GLC_World* GLC_StlToWorld::CreateWorldFromStl(QFile &file)
 
 		file.reset();
 		LoadBinariStl(file);
-		m_pCurrentMesh->addTriangles(NULL, m_CurrentFace);
-		m_CurrentFace.clear();
-		m_pCurrentMesh->addVertice(m_VertexBulk.toVector());
-		m_VertexBulk.clear();
-		m_pCurrentMesh->addNormals(m_NormalBulk.toVector());
-		m_NormalBulk.clear();
 		m_pCurrentMesh->finish();
 		GLC_3DRep* pRep= new GLC_3DRep(m_pCurrentMesh);
 		m_pCurrentMesh= NULL;
@@ -360,84 +421,253 @@ GLC_Vector3df GLC_StlToWorld::extract3dVect(QString &line)
 // Load Binarie STL File
 void GLC_StlToWorld::LoadBinariStl(QFile &file)
 {
-	// Create Working variables
-	int currentQuantumValue= 0;
-	int previousQuantumValue= 0;
-
-	QDataStream stlBinFile(&file);
-	stlBinFile.setVersion(QDataStream::Qt_4_6);
-	stlBinFile.setFloatingPointPrecision(QDataStream::SinglePrecision);
-	stlBinFile.setByteOrder(QDataStream::LittleEndian);
+	// Map the file in memory, if mapping is not supported read it at once
+	const qint64 fileSize= file.size();
+	uchar* pMappedData= file.map(0, fileSize);
+	QByteArray fileContent;
+	const uchar* pData= pMappedData;
+	qint64 dataSize= fileSize;
+	if (NULL == pMappedData)
+	{
+		file.reset();
+		fileContent= file.readAll();
+		pData= reinterpret_cast<const uchar*>(fileContent.constData());
+		dataSize= fileContent.size();
+	}
 
-	// Skip 80 Bytes STL header
-	int SkipedData= stlBinFile.skipRawData(80);
-	// Check if an error occur
-	if (-1 == SkipedData)
+	// Read the number of facet after the 80 Bytes STL header
+	if (dataSize < binaryStlHeaderSize)
+	{
+		if (NULL != pMappedData) file.unmap(pMappedData);
+		QString message= "GLC_StlToWorld::LoadBinariStl : Failed to read the number of facets of binary STL";
+		GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
+		clear();
+		throw(fileFormatException);
+	}
+	const quint32 numberOfFacet= qFromLittleEndian<quint32>(pData + 80);
+	if ((binaryStlHeaderSize + binaryStlFacetSize * static_cast<qint64>(numberOfFacet)) > dataSize)
 	{
-		QString message= "GLC_StlToWorld::LoadBinariStl : Failed to skip Header of binary STL";
+		if (NULL != pMappedData) file.unmap(pMappedData);
+		QString message= "GLC_StlToWorld::LoadBinariStl : Failed to read the facets of binary STL";
 		GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
 		clear();
 		throw(fileFormatException);
 	}
-	// Read the number of facet
-	quint32 numberOfFacet= 0;
-	stlBinFile >> numberOfFacet;
-	// Check if an error occur
-	if (QDataStream::Ok != stlBinFile.status())
+	// The 9 coordinates of each facet must fit in a mesh vector
+	if ((9 * static_cast<qint64>(numberOfFacet)) > static_cast<qint64>(INT_MAX))
 	{
-		QString message= "GLC_StlToWorld::LoadBinariStl : Failed to read the number of facets of binary STL";
+		if (NULL != pMappedData) file.unmap(pMappedData);
+		QString message= "GLC_StlToWorld::LoadBinariStl : Too many facets in binary STL";
 		GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
 		clear();
 		throw(fileFormatException);
 	}
+
+	if (m_WeldVertices)
+	{
+		decodeAndWeldBinaryFacets(pData + binaryStlHeaderSize, numberOfFacet);
+	}
+	else
+	{
+		decodeBinaryFacets(pData + binaryStlHeaderSize, numberOfFacet);
+	}
+
+	if (NULL != pMappedData) file.unmap(pMappedData);
+}
+
+// Return true if the given file size match a binary STL file
+bool GLC_StlToWorld::isBinaryStl(QFile &file)
+{
+	const qint64 fileSize= file.size();
+	bool isBinary= false;
+	if ((fileSize >= binaryStlHeaderSize) && file.seek(80))
+	{
+		const QByteArray numberOfFacetData(file.read(4));
+		if (numberOfFacetData.size() == 4)
+		{
+			const quint32 numberOfFacet= qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(numberOfFacetData.constData()));
+			isBinary= (binaryStlHeaderSize + binaryStlFacetSize * static_cast<qint64>(numberOfFacet)) == fileSize;
+		}
+	}
+	file.reset();
+
+	return isBinary;
+}
+
+// Decode the given binary STL facets into the current mesh
+void GLC_StlToWorld::decodeBinaryFacets(const uchar* pFacets, quint32 numberOfFacet)
+{
+	int previousQuantumValue= 0;
+	const quint32 progressStep= qMax(numberOfFacet / 100, quint32(1));
+
+	const int facetCount= static_cast<int>(numberOfFacet);
+	GLfloatVector positions(9 * facetCount);
+	GLfloatVector normals(9 * facetCount);
+	IndexList index;
+	index.reserve(3 * facetCount);
+
+	GLfloat* pPosition= positions.data();
+	GLfloat* pNormal= normals.data();
+	GLfloat facet[12];
 	for (quint32 i= 0; i < numberOfFacet; ++i)
 	{
-		// Extract the facet normal
-		float nx, ny, nz;
-		stlBinFile >> nx >> ny >> nz;
-		// Check if an error occur
-		if (QDataStream::Ok != stlBinFile.status())
+		decodeFacet(pFacets + binaryStlFacetSize * i, facet);
+		memcpy(pPosition, facet + 3, 9 * sizeof(GLfloat));
+		pPosition+= 9;
+		for (int j= 0; j < 3; ++j)
 		{
-			QString message= "GLC_StlToWorld::LoadBinariStl : Failed to read the Normal of binary STL";
-			GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
-			clear();
-			throw(fileFormatException);
+			memcpy(pNormal, facet, 3 * sizeof(GLfloat));
+			pNormal+= 3;
+			index.append(m_CurrentIndex);
+			++m_CurrentIndex;
+		}
+
+		if (((i + 1) % progressStep) == 0)
+		{
+			emitProgress(i + 1, numberOfFacet, &previousQuantumValue);
+		}
+	}
+
+	m_pCurrentMesh->addVertice(positions);
+	m_pCurrentMesh->addNormals(normals);
+	m_pCurrentMesh->addTriangles(NULL, index);
+}
+
+// Decode and weld the given binary STL facets into the current mesh
+void GLC_StlToWorld::decodeAndWeldBinaryFacets(const uchar* pFacets, quint32 numberOfFacet)
+{
+	int previousQuantumValue= 0;
+	const quint32 progressStep= qMax(numberOfFacet / 100, quint32(1));
+
+	// A closed mesh has about half as many vertices as facets
+	const int facetCount= static_cast<int>(numberOfFacet);
+	GLfloatVector positions;
+	positions.reserve(3 * facetCount);
+	GLfloatVector normals;
+	normals.reserve(3 * facetCount);
+	IndexList index;
+	index.reserve(3 * facetCount);
+
+	// Normal of the first facet of each vertex, used to keep sharp edges
+	GLfloatVector firstNormals;
+	firstNormals.reserve(3 * facetCount);
+	const GLfloat minimumCosine= static_cast<GLfloat>(cos(glc::toRadian(m_WeldingCreaseAngle)));
+
+	// Open addressing hash table of vertex index, vertices are hashed on their position
+	int tableSize= 16;
+	while (tableSize < facetCount) tableSize*= 2;
+	QVector<GLuint> vertexTable(tableSize, emptySlot);
+	GLuint mask= static_cast<GLuint>(tableSize - 1);
+
+	GLfloat facet[12];
+	for (quint32 i= 0; i < numberOfFacet; ++i)
+	{
+		decodeFacet(pFacets + binaryStlFacetSize * i, facet);
+
+		// Unit normal of the facet, computed from its vertices if the file doesn't give it
+		GLfloat* pFacetNormal= facet;
+		GLfloat norm= sqrt(pFacetNormal[0] * pFacetNormal[0] + pFacetNormal[1] * pFacetNormal[1] + pFacetNormal[2] * pFacetNormal[2]);
+		if (norm == 0.0f)
+		{
+			const GLfloat u[3]= {facet[6] - facet[3], facet[7] - facet[4], facet[8] - facet[5]};
+			const GLfloat v[3]= {facet[9] - facet[3], facet[10] - facet[4], facet[11] - facet[5]};
+			pFacetNormal[0]= u[1] * v[2] - u[2] * v[1];
+			pFacetNormal[1]= u[2] * v[0] - u[0] * v[2];
+			pFacetNormal[2]= u[0] * v[1] - u[1] * v[0];
+			norm= sqrt(pFacetNormal[0] * pFacetNormal[0] + pFacetNormal[1] * pFacetNormal[1] + pFacetNormal[2] * pFacetNormal[2]);
+		}
+		if (norm > 0.0f)
+		{
+			pFacetNormal[0]/= norm;
+			pFacetNormal[1]/= norm;
+			pFacetNormal[2]/= norm;
 		}
 
-		// Extract the 3 Vertexs
 		for (int j= 0; j < 3; ++j)
 		{
-			float x, y, z;
-			stlBinFile >> x >> y >> z;
-			// Check if an error occur
-			if (QDataStream::Ok != stlBinFile.status())
+			GLfloat* pVertex= facet + 3 + 3 * j;
+			// Adding 0 turns -0.0 into 0.0 so both have the same key
+			pVertex[0]+= 0.0f;
+			pVertex[1]+= 0.0f;
+			pVertex[2]+= 0.0f;
+
+			// Look for a vertex at the same position whose first facet is not across a sharp edge
+			GLuint slot= vertexHash(pVertex) & mask;
+			GLuint vertexIndex= vertexTable.at(slot);
+			while (emptySlot != vertexIndex)
 			{
-				QString message= "GLC_StlToWorld::LoadBinariStl : Failed to read the Vertex of binary STL";
-				GLC_FileFormatException fileFormatException(message, m_FileName, GLC_FileFormatException::WrongFileFormat);
-				clear();
-				throw(fileFormatException);
+				if (memcmp(positions.constData() + 3 * vertexIndex, pVertex, 3 * sizeof(GLfloat)) == 0)
+				{
+					const GLfloat* pFirstNormal= firstNormals.constData() + 3 * vertexIndex;
+					const GLfloat cosine= pFirstNormal[0] * pFacetNormal[0] + pFirstNormal[1] * pFacetNormal[1] + pFirstNormal[2] * pFacetNormal[2];
+					if (cosine >= minimumCosine) break;
+				}
+				slot= (slot + 1) & mask;
+				vertexIndex= vertexTable.at(slot);
 			}
-			m_VertexBulk.append(x);
-			m_VertexBulk.append(y);
-			m_VertexBulk.append(z);
 
-			m_NormalBulk.append(nx);
-			m_NormalBulk.append(ny);
-			m_NormalBulk.append(nz);
+			if (emptySlot == vertexIndex)
+			{
+				vertexIndex= static_cast<GLuint>(positions.size() / 3);
+				vertexTable[slot]= vertexIndex;
+				positions << pVertex[0] << pVertex[1] << pVertex[2];
+				normals << pFacetNormal[0] << pFacetNormal[1] << pFacetNormal[2];
+				firstNormals << pFacetNormal[0] << pFacetNormal[1] << pFacetNormal[2];
+
+				// Keep the load factor of the table under 0.5
+				if ((2 * (vertexIndex + 1)) > static_cast<GLuint>(vertexTable.size()))
+				{
+					growVertexTable(&vertexTable, positions);
+					mask= static_cast<GLuint>(vertexTable.size() - 1);
+				}
+			}
+			else
+			{
+				// The welded vertex normal is the sum of its facets normal
+				GLfloat* pNormal= normals.data() + 3 * vertexIndex;
+				pNormal[0]+= pFacetNormal[0];
+				pNormal[1]+= pFacetNormal[1];
+				pNormal[2]+= pFacetNormal[2];
+			}
+			index.append(m_CurrentIndex + vertexIndex);
+		}
 
-			m_CurrentFace.append(m_CurrentIndex);
-			++m_CurrentIndex;
+		if (((i + 1) % progressStep) == 0)
+		{
+			emitProgress(i + 1, numberOfFacet, &previousQuantumValue);
 		}
-		currentQuantumValue = static_cast<int>((static_cast<double>(i + 1) / numberOfFacet) * 100);
-		if (currentQuantumValue > previousQuantumValue)
+	}
+	vertexTable.clear();
+	firstNormals.clear();
+
+	// Normalize welded vertex normals
+	const int vertexCount= positions.size() / 3;
+	GLfloat* pNormal= normals.data();
+	for (int i= 0; i < vertexCount; ++i)
+	{
+		const GLfloat norm= sqrt(pNormal[0] * pNormal[0] + pNormal[1] * pNormal[1] + pNormal[2] * pNormal[2]);
+		if (norm > 0.0f)
 		{
-			emit currentQuantum(currentQuantumValue);
+			pNormal[0]/= norm;
+			pNormal[1]/= norm;
+			pNormal[2]/= norm;
 		}
-		previousQuantumValue= currentQuantumValue;
+		pNormal+= 3;
+	}
+	m_CurrentIndex+= static_cast<GLuint>(vertexCount);
 
-		// Skip 2 fill-bytes not needed !!!!
-		stlBinFile.skipRawData(2);
+	m_pCurrentMesh->addVertice(positions);
+	m_pCurrentMesh->addNormals(normals);
+	m_pCurrentMesh->addTriangles(NULL, index);
+}
 
+// Emit the current quantum if the given progress has changed
+void GLC_StlToWorld::emitProgress(quint32 current, quint32 total, int* pPreviousQuantumValue)
+{
+	const int currentQuantumValue= static_cast<int>((static_cast<double>(current) / total) * 100);
+	if (currentQuantumValue > *pPreviousQuantumValue)
+	{
+		emit currentQuantum(currentQuantumValue);
 	}
+	*pPreviousQuantumValue= currentQuantumValue;
 }
-
@@ -67,6 +67,24 @@ public:
 public:
 	//! Create and return an GLC_World* from an input STL File
 	GLC_World* CreateWorldFromStl(QFile &file);
+
+	//! Set vertex welding of binary STL (Create an indexed mesh with shared vertices)
+	/*! By default, vertex welding is set with GLC_State::setStlVertexWeldingUsage()*/
+	inline void setVertexWelding(bool weld)
+	{m_WeldVertices= weld;}
+
+	//! Return true if vertices of binary STL are welded
+	inline bool vertexWelding() const
+	{return m_WeldVertices;}
+
+	//! Set the crease angle in degrees of vertex welding
+	/*! Vertices of facets whose normals make a greater angle are not welded, so sharp edges are kept*/
+	inline void setWeldingCreaseAngle(double angle)
+	{m_WeldingCreaseAngle= angle;}
+
+	//! Return the crease angle in degrees of vertex welding
+	inline double weldingCreaseAngle() const
+	{return m_WeldingCreaseAngle;}
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -83,6 +101,17 @@ private:
 	//! Load Binarie STL File
 	void LoadBinariStl(QFile &);
 
+	//! Return true if the given file size match a binary STL file
+	static bool isBinaryStl(QFile &);
+
+	//! Decode the given binary STL facets into the current mesh
+	void decodeBinaryFacets(const uchar* pFacets, quint32 numberOfFacet);
+
+	//! Decode and weld the given binary STL facets into the current mesh
+	void decodeAndWeldBinaryFacets(const uchar* pFacets, quint32 numberOfFacet);
+
+	//! Emit the current quantum if the given progress has changed
+	void emitProgress(quint32 current, quint32 total, int* pPreviousQuantumValue);
 
 
 //@}
@@ -123,6 +152,12 @@ private:
 
 	//! The current index
 	GLuint m_CurrentIndex;
+
+	//! Weld vertices of binary STL
+	bool m_WeldVertices;
+
+	//! Crease angle in degrees of vertex welding
+	double m_WeldingCreaseAngle;
 };
 
 #endif /*GLC_STLTOWORLD_H_*/
@@ -28,7 +28,325 @@
 #include "../glc_exception.h"
 #include "../geometry/glc_mesh.h"
 
+#include "zlib.h"
+
 #include <QFileInfo>
+#include <QBuffer>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <cmath>
+
+namespace
+{
+// Append the given float to the given string the way QString::number(float) does
+// ('g' format, 6 significant digits) without going through the locale
+void appendFloat(QByteArray* pString, float value)
+{
+	double number= value;
+	if ((number != number) || (qAbs(number) > 3.5e38))
+	{
+		// Let Qt handle nan and inf
+		pString->append(QByteArray::number(number));
+		return;
+	}
+	if (0.0 == number)
+	{
+		pString->append('0');
+		return;
+	}
+	if (number < 0.0)
+	{
+		pString->append('-');
+		number= -number;
+	}
+
+	// Compute the 6 significant digits
+	int exponent= static_cast<int>(floor(log10(number)));
+	quint64 digits= static_cast<quint64>(number * pow(10.0, 5 - exponent) + 0.5);
+	if (digits < 100000)
+	{
+		--exponent;
+		digits= static_cast<quint64>(number * pow(10.0, 5 - exponent) + 0.5);
+	}
+	if (digits >= 1000000)
+	{
+		++exponent;
+		digits= (digits + 5) / 10;
+	}
+	char digitChars[6];
+	for (int i= 5; i >= 0; --i)
+	{
+		digitChars[i]= static_cast<char>('0' + (digits % 10));
+		digits/= 10;
+	}
+	int significantCount= 6;
+	while ((significantCount > 1) && ('0' == digitChars[significantCount - 1])) --significantCount;
+
+	if ((exponent < -4) || (exponent >= 6))
+	{
+		// Scientific notation
+		pString->append(digitChars[0]);
+		if (significantCount > 1)
+		{
+			pString->append('.');
+			pString->append(digitChars + 1, significantCount - 1);
+		}
+		pString->append(exponent < 0 ? "e-" : "e+");
+		const int absExponent= qAbs(exponent);
+		if (absExponent < 10) pString->append('0');
+		pString->append(QByteArray::number(absExponent));
+	}
+	else if (exponent < 0)
+	{
+		pString->append("0.");
+		for (int i= -1; i > exponent; --i) pString->append('0');
+		pString->append(digitChars, significantCount);
+	}
+	else
+	{
+		pString->append(digitChars, exponent + 1);
+		if (significantCount > (exponent + 1))
+		{
+			pString->append('.');
+			pString->append(digitChars + exponent + 1, significantCount - exponent - 1);
+		}
+	}
+}
+
+// Append the given indexes separated by space to the given string
+void appendIndexes(QByteArray* pString, const QVector<GLuint>& indexes)
+{
+	const int size= indexes.size();
+	char buffer[16];
+	for (int i= 0; i < size; ++i)
+	{
+		if (i > 0) pString->append(' ');
+		GLuint value= indexes.at(i);
+		int length= 0;
+		do
+		{
+			buffer[length++]= static_cast<char>('0' + (value % 10));
+			value/= 10;
+		} while (0 != value);
+		while (length > 0) pString->append(buffer[--length]);
+	}
+}
+
+// Return the 3DXML string of the given vector ("x y z, x y z" for dimension 3)
+QString vectorString(const GLfloatVector& vector, int dimension)
+{
+	QByteArray result;
+	const int size= vector.size();
+	result.reserve(size * 10);
+	for (int i= 0; i < size; ++i)
+	{
+		if (i > 0) result.append(((i % dimension) == 0) ? ", " : " ");
+		appendFloat(&result, vector.at(i));
+	}
+	return QString::fromLatin1(result);
+}
+
+// Return the 3DXML string of the given strips or fans
+QString indexListString(const QList<QVector<GLuint> >& indexList)
+{
+	QByteArray result;
+	const int count= indexList.size();
+	for (int i= 0; i < count; ++i)
+	{
+		if (i > 0) result.append(',');
+		appendIndexes(&result, indexList.at(i));
+	}
+	return QString::fromLatin1(result);
+}
+
+// Raw deflate the given data as a zip entry, return false on failure
+bool deflateRaw(const QByteArray& input, QByteArray* pOutput)
+{
+	z_stream stream;
+	stream.zalloc= Z_NULL;
+	stream.zfree= Z_NULL;
+	stream.opaque= Z_NULL;
+	if (Z_OK != deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY))
+	{
+		return false;
+	}
+	pOutput->resize(static_cast<int>(deflateBound(&stream, static_cast<uLong>(input.size()))));
+	stream.next_in= reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));
+	stream.avail_in= static_cast<uInt>(input.size());
+	stream.next_out= reinterpret_cast<Bytef*>(pOutput->data());
+	stream.avail_out= static_cast<uInt>(pOutput->size());
+	const bool success= (Z_STREAM_END == deflate(&stream, Z_FINISH));
+	pOutput->resize(static_cast<int>(stream.total_out));
+	deflateEnd(&stream);
+	return success;
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////
+// Snapshot of a representation, taken from the thread owning the world
+//////////////////////////////////////////////////////////////////////
+struct GLC_WorldTo3dxml::FaceData
+{
+	FaceData()
+	: m_Triangles()
+	, m_Strips()
+	, m_Fans()
+	, m_DiffuseColor()
+	, m_MaterialId(0)
+	{}
+	QVector<GLuint> m_Triangles;
+	QList<QVector<GLuint> > m_Strips;
+	QList<QVector<GLuint> > m_Fans;
+	QColor m_DiffuseColor;
+	unsigned int m_MaterialId;
+};
+
+struct GLC_WorldTo3dxml::LodData
+{
+	LodData()
+	: m_Accuracy(0.0)
+	, m_Faces()
+	{}
+	double m_Accuracy;
+	QList<FaceData> m_Faces;
+};
+
+struct GLC_WorldTo3dxml::MeshData
+{
+	MeshData()
+	: m_Id(0)
+	, m_Lods()
+	, m_Positions()
+	, m_Normals()
+	, m_Texels()
+	, m_HasWire(false)
+	, m_WireColor()
+	, m_WirePositions()
+	, m_WirePolylineOffsets()
+	, m_WirePolylineSizes()
+	{}
+	unsigned int m_Id;
+	QList<LodData> m_Lods;
+	GLfloatVector m_Positions;
+	GLfloatVector m_Normals;
+	GLfloatVector m_Texels;
+	bool m_HasWire;
+	QColor m_WireColor;
+	GLfloatVector m_WirePositions;
+	QVector<GLuint> m_WirePolylineOffsets;
+	QVector<GLsizei> m_WirePolylineSizes;
+};
+
+struct GLC_WorldTo3dxml::RepData
+{
+	RepData()
+	: m_Id(0)
+	, m_ExportMaterial(true)
+	, m_Meshes()
+	{}
+	unsigned int m_Id;
+	bool m_ExportMaterial;
+	QList<MeshData> m_Meshes;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Format and compress a representation snapshot on a worker thread
+//////////////////////////////////////////////////////////////////////
+class GLC_WorldTo3dxml::RepWritingTask : public QRunnable
+{
+public:
+	//! The file is written in the given path, or compressed in memory if the path is empty
+	RepWritingTask(RepData* pRepData, const QString& fileName, const QString& absolutePath, const QAtomicInt* pIsCanceled)
+	: QRunnable()
+	, m_pRepData(pRepData)
+	, m_FileName(fileName)
+	, m_AbsolutePath(absolutePath)
+	, m_pIsCanceled(pIsCanceled)
+	, m_Data()
+	, m_Crc(0)
+	, m_UncompressedSize(0)
+	, m_ErrorMessage()
+	, m_Done()
+	{
+		setAutoDelete(false);
+	}
+
+	virtual ~RepWritingTask()
+	{
+		delete m_pRepData;
+	}
+
+	virtual void run()
+	{
+		if (0 == m_pIsCanceled->load()) writeRep();
+
+		// Release the snapshot as soon as possible
+		delete m_pRepData;
+		m_pRepData= NULL;
+		m_Done.release();
+	}
+
+	//! Wait until the task is done
+	inline void waitForDone()
+	{m_Done.acquire();}
+
+	inline QString fileName() const
+	{return m_FileName;}
+
+	inline const QByteArray& data() const
+	{return m_Data;}
+
+	inline quint32 crc() const
+	{return m_Crc;}
+
+	inline ulong uncompressedSize() const
+	{return m_UncompressedSize;}
+
+	inline QString errorMessage() const
+	{return m_ErrorMessage;}
+
+private:
+	void writeRep()
+	{
+		QByteArray document;
+		QBuffer buffer(&document);
+		buffer.open(QIODevice::WriteOnly);
+		QXmlStreamWriter streamWriter(&buffer);
+		streamWriter.setAutoFormatting(true);
+		GLC_WorldTo3dxml::write3DRepDocument(&streamWriter, *m_pRepData);
+		buffer.close();
+
+		if (m_AbsolutePath.isEmpty())
+		{
+			m_UncompressedSize= static_cast<ulong>(document.size());
+			m_Crc= static_cast<quint32>(crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(document.constData()), static_cast<uInt>(document.size())));
+			if (!deflateRaw(document, &m_Data))
+			{
+				m_ErrorMessage= QString("GLC_WorldTo3dxml::RepWritingTask Unable to compress ") + m_FileName;
+			}
+		}
+		else
+		{
+			QFile file(m_AbsolutePath + m_FileName);
+			if (!file.open(QIODevice::WriteOnly) || (file.write(document) != document.size()))
+			{
+				m_ErrorMessage= QString("GLC_WorldTo3dxml::RepWritingTask Unable to create ") + m_FileName;
+			}
+		}
+	}
+
+	RepData* m_pRepData;
+	const QString m_FileName;
+	const QString m_AbsolutePath;
+	const QAtomicInt* m_pIsCanceled;
+	QByteArray m_Data;
+	quint32 m_Crc;
+	ulong m_UncompressedSize;
+	QString m_ErrorMessage;
+	QSemaphore m_Done;
+};
 
 GLC_WorldTo3dxml::GLC_WorldTo3dxml(const GLC_World& world, bool threaded)
 : QObject()
@@ -58,6 +376,7 @@ GLC_WorldTo3dxml::GLC_WorldTo3dxml(const GLC_World& world, bool threaded)
 , m_pReadWriteLock(NULL)
 , m_pIsInterupted(NULL)
 , m_IsThreaded(threaded)
+, m_UseParallelExport(true)
 {
 	m_World.rootOccurrence()->updateOccurrenceNumber(1);
 }
@@ -103,7 +422,11 @@ bool GLC_WorldTo3dxml::exportTo3dxml(const QString& filename, GLC_WorldTo3dxml::
 		// Export the assembly structure from the list of structure reference
 		exportAssemblyStructure();
 
-		if (m_ExportType != StructureOnly)
+		if ((m_ExportType != StructureOnly) && m_UseParallelExport && (m_ReferenceRepTo3dxmlFileName.size() > 1))
+		{
+			write3DRepsInParallel();
+		}
+		else if (m_ExportType != StructureOnly)
 		{
 			int previousQuantumValue= 0;
 			int currentQuantumValue= 0;
@@ -455,31 +778,201 @@ void GLC_WorldTo3dxml::write3DRep(const GLC_3DRep* pRep, const QString& fileName
 {
 	setStreamWriterToFile(fileName);
 
-	m_pOutStream->writeStartDocument();
-	m_pOutStream->writeStartElement("XMLRepresentation");
-	m_pOutStream->writeAttribute("version", "1.2");
-	m_pOutStream->writeAttribute("xmlns", "http://www.3ds.com/xsd/3DXML");
-	m_pOutStream->writeAttribute("xmlns:xsi", "http://www.w3.org/2001/XMLSchema-instance");
-	m_pOutStream->writeAttribute("xmlns:xlink", "http://www.w3.org/1999/xlink");
-	m_pOutStream->writeAttribute("xsi:schemaLocation", "http://www.3ds.com/xsd/3DXML ./3DXMLMesh.xsd");
+	RepData repData;
+	get3DRepData(pRep, &repData);
+	write3DRepDocument(m_pOutStream, repData);
+}
+
+void GLC_WorldTo3dxml::write3DRepsInParallel()
+{
+	int previousQuantumValue= 0;
+	int currentQuantumValue= 0;
+	emit currentQuantum(currentQuantumValue);
+
+	// Formatted entries are written in order by this thread
+	const bool compressed= (NULL != m_p3dxmlArchive);
+	if (compressed) closeCurrentZipFile();
+
+	const int threadCount= qMax(1, QThread::idealThreadCount());
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(threadCount);
+
+	// Limit the number of formatted representations waiting for the writer
+	const int maxPendingCount= 2 * threadCount;
+	QAtomicInt isCanceled(0);
+	QList<RepWritingTask*> pendingTasks;
+
+	QString errorMessage;
+	int currentRepIndex= 0;
+	const int size= m_ReferenceRepTo3dxmlFileName.size();
+	QHash<const GLC_3DRep*, QString>::const_iterator iRep= m_ReferenceRepTo3dxmlFileName.constBegin();
+	while ((currentRepIndex < size) && errorMessage.isEmpty() && continu())
+	{
+		// Snapshot the next representations and queue their formatting
+		while ((m_ReferenceRepTo3dxmlFileName.constEnd() != iRep) && (pendingTasks.size() < maxPendingCount))
+		{
+			RepData* pRepData= new RepData;
+			get3DRepData(iRep.key(), pRepData);
+			const QString absolutePath(compressed ? QString() : m_AbsolutePath);
+			RepWritingTask* pTask= new RepWritingTask(pRepData, iRep.value(), absolutePath, &isCanceled);
+			pendingTasks.append(pTask);
+			threadPool.start(pTask);
+			++iRep;
+		}
+
+		RepWritingTask* pTask= pendingTasks.takeFirst();
+		pTask->waitForDone();
+		errorMessage= pTask->errorMessage();
+		if (errorMessage.isEmpty() && compressed)
+		{
+			// Append the compressed entry to the archive
+			QuaZipNewInfo quazipNewInfo(pTask->fileName());
+			quazipNewInfo.uncompressedSize= pTask->uncompressedSize();
+			QuaZipFile zipFile(m_p3dxmlArchive);
+			if (zipFile.open(QIODevice::WriteOnly, quazipNewInfo, NULL, pTask->crc(), Z_DEFLATED, Z_DEFAULT_COMPRESSION, true))
+			{
+				zipFile.write(pTask->data());
+				zipFile.close();
+			}
+			if (UNZ_OK != zipFile.getZipError())
+			{
+				errorMessage= QString("GLC_WorldTo3dxml::write3DRepsInParallel Unable to create ") + pTask->fileName();
+			}
+		}
+		delete pTask;
+
+		// Progrees bar indicator
+		++currentRepIndex;
+		currentQuantumValue = static_cast<int>((static_cast<double>(currentRepIndex) / size) * 100);
+		if (currentQuantumValue > previousQuantumValue)
+		{
+			emit currentQuantum(currentQuantumValue);
+		}
+		previousQuantumValue= currentQuantumValue;
+		if (!m_IsThreaded)
+		{
+			QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+		}
+	}
+
+	// Discard the remaining work on interruption or error
+	isCanceled.fetchAndStoreOrdered(1);
+	threadPool.waitForDone();
+	qDeleteAll(pendingTasks);
+
+	if (!errorMessage.isEmpty())
+	{
+		GLC_Exception fileException(errorMessage);
+		throw(fileException);
+	}
+}
+
+void GLC_WorldTo3dxml::closeCurrentZipFile()
+{
+	delete m_pOutStream;
+	m_pOutStream= NULL;
+	if (NULL != m_pCurrentZipFile)
+	{
+		m_pCurrentZipFile->close();
+		delete m_pCurrentZipFile;
+		m_pCurrentZipFile= NULL;
+	}
+}
+
+void GLC_WorldTo3dxml::get3DRepData(const GLC_3DRep* pRep, RepData* pRepData)
+{
+	// Ids are given in the same order as the sequential writing
+	pRepData->m_Id= ++m_CurrentId;
+	pRepData->m_ExportMaterial= m_ExportMaterial;
 
-	m_pOutStream->writeStartElement("Root"); // Root
-	m_pOutStream->writeAttribute("xsi:type", "BagRepType");
-	m_pOutStream->writeAttribute("id", QString::number(++m_CurrentId));
 	const int bodyCount= pRep->numberOfBody();
 	for (int i= 0; i < bodyCount; ++i)
 	{
-		GLC_Mesh* pMesh= dynamic_cast<GLC_Mesh*>(pRep->geomAt(i));
-		if (NULL != pMesh)
+		const GLC_Mesh* pMesh= dynamic_cast<GLC_Mesh*>(pRep->geomAt(i));
+		if (NULL == pMesh) continue;
+
+		MeshData meshData;
+		meshData.m_Id= ++m_CurrentId;
+
+		// Get the list of material id
+		QList<GLC_uint> materialList= pMesh->materialIds();
+		const int materialCount= materialList.size();
+		const int lodCount= pMesh->lodCount();
+		for (int lod= 0; lod < lodCount; ++lod)
 		{
-			writeGeometry(pMesh);
+			LodData lodData;
+			lodData.m_Accuracy= pMesh->getLodAccuracy(lod);
+			for (int matIndex= 0; matIndex < materialCount; ++matIndex)
+			{
+				const GLC_uint materialId= materialList.at(matIndex);
+				if (pMesh->lodContainsMaterial(lod, materialId))
+				{
+					FaceData faceData;
+					if (pMesh->containsTriangles(lod, materialId))
+					{
+						faceData.m_Triangles= pMesh->getTrianglesIndex(lod, materialId);
+					}
+					if (pMesh->containsStrips(lod, materialId))
+					{
+						faceData.m_Strips= pMesh->getStripsIndex(lod, materialId);
+					}
+					if (pMesh->containsFans(lod, materialId))
+					{
+						faceData.m_Fans= pMesh->getFansIndex(lod, materialId);
+					}
+					const GLC_Material* pMaterial= pMesh->material(materialId);
+					faceData.m_DiffuseColor= pMaterial->diffuseColor();
+					faceData.m_MaterialId= m_MaterialIdToMaterialId.value(pMaterial->id());
+					lodData.m_Faces.append(faceData);
+				}
+			}
+			meshData.m_Lods.append(lodData);
 		}
+
+		// Bulk data are read back from the VBO if needed, so it must be done here
+		meshData.m_Positions= pMesh->positionVector();
+		meshData.m_Normals= pMesh->normalVector();
+		meshData.m_Texels= pMesh->texelVector();
+
+		meshData.m_HasWire= !pMesh->wireDataIsEmpty();
+		if (meshData.m_HasWire)
+		{
+			meshData.m_WireColor= pMesh->wireColor();
+			meshData.m_WirePositions= pMesh->wirePositionVector();
+			const int polylineCount= pMesh->wirePolylineCount();
+			for (int polyline= 0; polyline < polylineCount; ++polyline)
+			{
+				meshData.m_WirePolylineOffsets.append(pMesh->wirePolylineOffset(polyline));
+				meshData.m_WirePolylineSizes.append(pMesh->wirePolylineSize(polyline));
+			}
+		}
+		pRepData->m_Meshes.append(meshData);
+	}
+}
+
+void GLC_WorldTo3dxml::write3DRepDocument(QXmlStreamWriter* pOutStream, const RepData& repData)
+{
+	pOutStream->writeStartDocument();
+	pOutStream->writeStartElement("XMLRepresentation");
+	pOutStream->writeAttribute("version", "1.2");
+	pOutStream->writeAttribute("xmlns", "http://www.3ds.com/xsd/3DXML");
+	pOutStream->writeAttribute("xmlns:xsi", "http://www.w3.org/2001/XMLSchema-instance");
+	pOutStream->writeAttribute("xmlns:xlink", "http://www.w3.org/1999/xlink");
+	pOutStream->writeAttribute("xsi:schemaLocation", "http://www.3ds.com/xsd/3DXML ./3DXMLMesh.xsd");
+
+	pOutStream->writeStartElement("Root"); // Root
+	pOutStream->writeAttribute("xsi:type", "BagRepType");
+	pOutStream->writeAttribute("id", QString::number(repData.m_Id));
+	const int meshCount= repData.m_Meshes.size();
+	for (int i= 0; i < meshCount; ++i)
+	{
+		writeGeometry(pOutStream, repData.m_Meshes.at(i), repData.m_ExportMaterial);
 	}
-	m_pOutStream->writeEndElement(); // Root
+	pOutStream->writeEndElement(); // Root
 
-	m_pOutStream->writeEndElement(); // XMLRepresentation
+	pOutStream->writeEndElement(); // XMLRepresentation
 
-	m_pOutStream->writeEndDocument();
+	pOutStream->writeEndDocument();
 }
 
 QString GLC_WorldTo3dxml::representationFileName(const GLC_3DRep* pRep)
@@ -518,260 +1011,162 @@ QString GLC_WorldTo3dxml::representationFileName(const GLC_3DRep* pRep)
 	return xmlFileName(fileName);
 }
 
-void GLC_WorldTo3dxml::writeGeometry(const GLC_Mesh* pMesh)
+void GLC_WorldTo3dxml::writeGeometry(QXmlStreamWriter* pOutStream, const MeshData& meshData, bool exportMaterial)
 {
-	// Get the list of material id
-	QList<GLC_uint> materialList= pMesh->materialIds();
-	const int materialCount= materialList.size();
-
-	m_pOutStream->writeStartElement("Rep");
-	m_pOutStream->writeAttribute("xsi:type", "PolygonalRepType");
-	m_pOutStream->writeAttribute("id", QString::number(++m_CurrentId));
-	const double masterAccuracy= pMesh->getLodAccuracy(0);
-	m_pOutStream->writeAttribute("accuracy", QString::number(masterAccuracy));
-	m_pOutStream->writeAttribute("solid", "1");
-	const int lodCount= pMesh->lodCount();
+	pOutStream->writeStartElement("Rep");
+	pOutStream->writeAttribute("xsi:type", "PolygonalRepType");
+	pOutStream->writeAttribute("id", QString::number(meshData.m_Id));
+	const int lodCount= meshData.m_Lods.size();
+	const double masterAccuracy= (lodCount > 0) ? meshData.m_Lods.at(0).m_Accuracy : 0.0;
+	pOutStream->writeAttribute("accuracy", QString::number(masterAccuracy));
+	pOutStream->writeAttribute("solid", "1");
 	if (lodCount > 1)
 	{
 		// The mesh contains LOD
 		for (int i= 1; i < lodCount; ++i)
 		{
-			const double lodAccuracy= pMesh->getLodAccuracy(i);
-			m_pOutStream->writeStartElement("PolygonalLOD");
-			m_pOutStream->writeAttribute("accuracy", QString::number(lodAccuracy));
-			m_pOutStream->writeStartElement("Faces");
-			for (int matIndex= 0; matIndex < materialCount; ++matIndex)
+			const LodData& lodData= meshData.m_Lods.at(i);
+			pOutStream->writeStartElement("PolygonalLOD");
+			pOutStream->writeAttribute("accuracy", QString::number(lodData.m_Accuracy));
+			pOutStream->writeStartElement("Faces");
+			const int faceCount= lodData.m_Faces.size();
+			for (int face= 0; face < faceCount; ++face)
 			{
-				const GLC_uint materialId= materialList.at(matIndex);
-				if (pMesh->lodContainsMaterial(i, materialId))
-				{
-					writeGeometryFace(pMesh, i, materialId);
-				}
+				writeGeometryFace(pOutStream, lodData.m_Faces.at(face), exportMaterial);
 			}
-			m_pOutStream->writeEndElement(); // Faces
-			m_pOutStream->writeEndElement(); // PolygonalLOD
+			pOutStream->writeEndElement(); // Faces
+			pOutStream->writeEndElement(); // PolygonalLOD
 		}
 	}
 
 	// Master LOD
-	m_pOutStream->writeStartElement("Faces");
-	for (int matIndex= 0; matIndex < materialCount; ++matIndex)
+	pOutStream->writeStartElement("Faces");
+	if (lodCount > 0)
 	{
-		const GLC_uint materialId= materialList.at(matIndex);
-		if (pMesh->lodContainsMaterial(0, materialId))
+		const LodData& masterLod= meshData.m_Lods.at(0);
+		const int faceCount= masterLod.m_Faces.size();
+		for (int face= 0; face < faceCount; ++face)
 		{
-			writeGeometryFace(pMesh, 0, materialId);
+			writeGeometryFace(pOutStream, masterLod.m_Faces.at(face), exportMaterial);
 		}
 	}
-	m_pOutStream->writeEndElement(); // Faces
-	if (!pMesh->wireDataIsEmpty())
+	pOutStream->writeEndElement(); // Faces
+	if (meshData.m_HasWire)
 	{
-		writeEdges(pMesh);
+		writeEdges(pOutStream, meshData);
 	}
 
 	// Save Bulk data
-	m_pOutStream->writeStartElement("VertexBuffer");
-	{
-		// Get positions
-		GLfloatVector positionVector= pMesh->positionVector();
-		QString positions;
-		const int size= positionVector.size();
-		for (int i= 0; i < size; i+=3)
-		{
-			positions.append(QString::number(positionVector.at(i)));
-			positions.append(' ');
-			positions.append(QString::number(positionVector.at(i + 1)));
-			positions.append(' ');
-			positions.append(QString::number(positionVector.at(i + 2)));
-			positions.append(", ");
-		}
-		positions.remove(positions.size() - 2, 2);
-		m_pOutStream->writeTextElement("Positions", positions);
-	}
+	pOutStream->writeStartElement("VertexBuffer");
+	pOutStream->writeTextElement("Positions", vectorString(meshData.m_Positions, 3));
+	pOutStream->writeTextElement("Normals", vectorString(meshData.m_Normals, 3));
+	if (!meshData.m_Texels.isEmpty())
 	{
-		// Get normals
-		GLfloatVector normalVector= pMesh->normalVector();
-		QString normals;
-		const int size= normalVector.size();
-		for (int i= 0; i < size; i+=3)
-		{
-			normals.append(QString::number(normalVector.at(i)));
-			normals.append(' ');
-			normals.append(QString::number(normalVector.at(i + 1)));
-			normals.append(' ');
-			normals.append(QString::number(normalVector.at(i + 2)));
-			normals.append(", ");
-		}
-		normals.remove(normals.size() - 2, 2);
-		m_pOutStream->writeTextElement("Normals", normals);
+		pOutStream->writeStartElement("TextureCoordinates");
+		pOutStream->writeAttribute("dimension", "2D");
+		pOutStream->writeAttribute("channel", "0");
+		pOutStream->writeCharacters(vectorString(meshData.m_Texels, 2));
+		pOutStream->writeEndElement(); // TexturesCoordinates
 	}
-	{
-		// Get texture coordinates
-		GLfloatVector texelVector= pMesh->texelVector();
-		if (!texelVector.isEmpty())
-		{
-			QString texels;
-			const int size= texelVector.size();
-			for (int i= 0; i < size; i+=2)
-			{
-				texels.append(QString::number(texelVector.at(i)));
-				texels.append(' ');
-				texels.append(QString::number(texelVector.at(i + 1)));
-				texels.append(", ");
-			}
-			texels.remove(texels.size() - 2, 2);
-
-			m_pOutStream->writeStartElement("TextureCoordinates");
-			m_pOutStream->writeAttribute("dimension", "2D");
-			m_pOutStream->writeAttribute("channel", "0");
-			m_pOutStream->writeCharacters(texels);
-			m_pOutStream->writeEndElement(); // TexturesCoordinates
-		}
-	}
-
 
-	m_pOutStream->writeEndElement(); // VertexBuffer
-	m_pOutStream->writeEndElement(); // Rep
+	pOutStream->writeEndElement(); // VertexBuffer
+	pOutStream->writeEndElement(); // Rep
 
 }
-void GLC_WorldTo3dxml::writeGeometryFace(const GLC_Mesh* pMesh, int lod, GLC_uint materialId)
+void GLC_WorldTo3dxml::writeGeometryFace(QXmlStreamWriter* pOutStream, const FaceData& faceData, bool exportMaterial)
 {
-	m_pOutStream->writeStartElement("Face");
-	if (pMesh->containsTriangles(lod, materialId))
+	pOutStream->writeStartElement("Face");
+	if (!faceData.m_Triangles.isEmpty())
 	{
-		QVector<GLuint> triangleIndex= pMesh->getTrianglesIndex(lod, materialId);
-		QString indexString;
-		const int indexSize= triangleIndex.size();
-		for (int index= 0; index < indexSize; ++index)
-		{
-			indexString.append(QString::number(triangleIndex.at(index)));
-			indexString.append(' ');
-		}
-		indexString.remove(indexString.size() - 1, 1);
-		m_pOutStream->writeAttribute("triangles", indexString);
+		QByteArray indexString;
+		appendIndexes(&indexString, faceData.m_Triangles);
+		pOutStream->writeAttribute("triangles", QString::fromLatin1(indexString));
 	}
-	if (pMesh->containsStrips(lod, materialId))
+	if (!faceData.m_Strips.isEmpty())
 	{
-		QList<QVector<GLuint> > stripsIndex= pMesh->getStripsIndex(lod, materialId);
-		QString indexStrips;
-		const int stripCount= stripsIndex.size();
-		for (int stripIndex= 0; stripIndex < stripCount; ++stripIndex)
-		{
-			QVector<GLuint> currentStripIndex= stripsIndex.at(stripIndex);
-			QString currentIndex;
-			const int indexSize= currentStripIndex.size();
-			for (int index= 0; index < indexSize; ++index)
-			{
-				currentIndex.append(QString::number(currentStripIndex.at(index)));
-				currentIndex.append(' ');
-			}
-			currentIndex.remove(currentIndex.size() - 1, 1);
-			indexStrips.append(currentIndex);
-			indexStrips.append(',');
-		}
-		indexStrips.remove(indexStrips.size() - 1, 1);
-		m_pOutStream->writeAttribute("strips", indexStrips);
+		pOutStream->writeAttribute("strips", indexListString(faceData.m_Strips));
 	}
-	if (pMesh->containsFans(lod, materialId))
+	if (!faceData.m_Fans.isEmpty())
 	{
-		QList<QVector<GLuint> > fansIndex= pMesh->getFansIndex(lod, materialId);
-		QString indexFans;
-		const int fanCount= fansIndex.size();
-		for (int fanIndex= 0; fanIndex < fanCount; ++fanIndex)
-		{
-			QVector<GLuint> currentFanIndex= fansIndex.at(fanIndex);
-			QString currentIndex;
-			const int indexSize= currentFanIndex.size();
-			for (int index= 0; index < indexSize; ++index)
-			{
-				currentIndex.append(QString::number(currentFanIndex.at(index)));
-				currentIndex.append(' ');
-			}
-			currentIndex.remove(currentIndex.size() - 1, 1);
-			indexFans.append(currentIndex);
-			indexFans.append(',');
-		}
-		indexFans.remove(indexFans.size() - 1, 1);
-		m_pOutStream->writeAttribute("fans", indexFans);
+		pOutStream->writeAttribute("fans", indexListString(faceData.m_Fans));
 	}
 
-	writeSurfaceAttributes(pMesh->material(materialId));
+	writeSurfaceAttributes(pOutStream, faceData, exportMaterial);
 
-	m_pOutStream->writeEndElement(); // Face
+	pOutStream->writeEndElement(); // Face
 
 }
 
-void GLC_WorldTo3dxml::writeSurfaceAttributes(const GLC_Material* pMaterial)
+void GLC_WorldTo3dxml::writeSurfaceAttributes(QXmlStreamWriter* pOutStream, const FaceData& faceData, bool exportMaterial)
 {
-	QColor diffuseColor= pMaterial->diffuseColor();
-	m_pOutStream->writeStartElement("SurfaceAttributes");
-	if (m_ExportMaterial)
-	{
-		const QString material3dxmlId=(QString::number(m_MaterialIdToMaterialId.value(pMaterial->id())));
-		m_pOutStream->writeStartElement("MaterialApplication");
-			m_pOutStream->writeAttribute("xsi:type", "MaterialApplicationType");
-			m_pOutStream->writeAttribute("mappingChannel", "0");
-			m_pOutStream->writeStartElement("MaterialId");
-				m_pOutStream->writeAttribute("id", "urn:3DXML:CATMaterialRef.3dxml#" + material3dxmlId);
-			m_pOutStream->writeEndElement(); // MaterialId
-		m_pOutStream->writeEndElement(); // MaterialApplication
+	const QColor& diffuseColor= faceData.m_DiffuseColor;
+	pOutStream->writeStartElement("SurfaceAttributes");
+	if (exportMaterial)
+	{
+		const QString material3dxmlId=(QString::number(faceData.m_MaterialId));
+		pOutStream->writeStartElement("MaterialApplication");
+			pOutStream->writeAttribute("xsi:type", "MaterialApplicationType");
+			pOutStream->writeAttribute("mappingChannel", "0");
+			pOutStream->writeStartElement("MaterialId");
+				pOutStream->writeAttribute("id", "urn:3DXML:CATMaterialRef.3dxml#" + material3dxmlId);
+			pOutStream->writeEndElement(); // MaterialId
+		pOutStream->writeEndElement(); // MaterialApplication
 	}
 	else
 	{
-		m_pOutStream->writeStartElement("Color");
-			m_pOutStream->writeAttribute("xsi:type", "RGBAColorType");
-			m_pOutStream->writeAttribute("red", QString::number(diffuseColor.redF()));
-			m_pOutStream->writeAttribute("green", QString::number(diffuseColor.greenF()));
-			m_pOutStream->writeAttribute("blue", QString::number(diffuseColor.blueF()));
-			m_pOutStream->writeAttribute("alpha", QString::number(diffuseColor.alphaF()));
-		m_pOutStream->writeEndElement(); // Color
+		pOutStream->writeStartElement("Color");
+			pOutStream->writeAttribute("xsi:type", "RGBAColorType");
+			pOutStream->writeAttribute("red", QString::number(diffuseColor.redF()));
+			pOutStream->writeAttribute("green", QString::number(diffuseColor.greenF()));
+			pOutStream->writeAttribute("blue", QString::number(diffuseColor.blueF()));
+			pOutStream->writeAttribute("alpha", QString::number(diffuseColor.alphaF()));
+		pOutStream->writeEndElement(); // Color
 	}
-	m_pOutStream->writeEndElement(); // SurfaceAttributes
+	pOutStream->writeEndElement(); // SurfaceAttributes
 }
 
-void GLC_WorldTo3dxml::writeEdges(const GLC_Mesh* pMesh)
+void GLC_WorldTo3dxml::writeEdges(QXmlStreamWriter* pOutStream, const MeshData& meshData)
 {
-	m_pOutStream->writeStartElement("Edges");
-	writeLineAttributes(pMesh->wireColor());
+	pOutStream->writeStartElement("Edges");
+	writeLineAttributes(pOutStream, meshData.m_WireColor);
 
-	GLfloatVector positionVector= pMesh->wirePositionVector();
-	const int polylineCount= pMesh->wirePolylineCount();
+	const GLfloatVector& positionVector= meshData.m_WirePositions;
+	const int polylineCount= meshData.m_WirePolylineOffsets.size();
 	for (int i= 0; i < polylineCount; ++i)
 	{
-		m_pOutStream->writeStartElement("Polyline");
-		QString polylinePosition;
-		const GLuint offset= pMesh->wirePolylineOffset(i);
-		const GLsizei size= pMesh->wirePolylineSize(i);
+		pOutStream->writeStartElement("Polyline");
+		QByteArray polylinePosition;
+		const GLuint offset= meshData.m_WirePolylineOffsets.at(i);
+		const GLsizei size= meshData.m_WirePolylineSizes.at(i);
 		for (GLsizei index= 0; index < size; ++index)
 		{
+			if (index > 0) polylinePosition.append(',');
 			const int startIndex= 3 * (offset + index);
-			polylinePosition.append(QString::number(positionVector.at(startIndex)));
+			appendFloat(&polylinePosition, positionVector.at(startIndex));
 			polylinePosition.append(' ');
-			polylinePosition.append(QString::number(positionVector.at(startIndex + 1)));
+			appendFloat(&polylinePosition, positionVector.at(startIndex + 1));
 			polylinePosition.append(' ');
-			polylinePosition.append(QString::number(positionVector.at(startIndex + 2)));
-			polylinePosition.append(',');
+			appendFloat(&polylinePosition, positionVector.at(startIndex + 2));
 		}
-		polylinePosition.remove(polylinePosition.size() - 1, 1);
-		m_pOutStream->writeAttribute("vertices", polylinePosition);
-		m_pOutStream->writeEndElement(); // Polyline
+		pOutStream->writeAttribute("vertices", QString::fromLatin1(polylinePosition));
+		pOutStream->writeEndElement(); // Polyline
 	}
-	m_pOutStream->writeEndElement(); // Edges
+	pOutStream->writeEndElement(); // Edges
 }
 
-void GLC_WorldTo3dxml::writeLineAttributes(const QColor& color)
+void GLC_WorldTo3dxml::writeLineAttributes(QXmlStreamWriter* pOutStream, const QColor& color)
 {
-	m_pOutStream->writeStartElement("LineAttributes");
-	m_pOutStream->writeAttribute("lineType", "SOLID");
-	m_pOutStream->writeAttribute("thickness", "1");
-		m_pOutStream->writeStartElement("Color");
-			m_pOutStream->writeAttribute("xsi:type", "RGBAColorType");
-			m_pOutStream->writeAttribute("red", QString::number(color.redF()));
-			m_pOutStream->writeAttribute("green", QString::number(color.greenF()));
-			m_pOutStream->writeAttribute("blue", QString::number(color.blueF()));
-			m_pOutStream->writeAttribute("alpha", QString::number(color.alphaF()));
-		m_pOutStream->writeEndElement(); // Color
-	m_pOutStream->writeEndElement(); // LineAttributes
+	pOutStream->writeStartElement("LineAttributes");
+	pOutStream->writeAttribute("lineType", "SOLID");
+	pOutStream->writeAttribute("thickness", "1");
+		pOutStream->writeStartElement("Color");
+			pOutStream->writeAttribute("xsi:type", "RGBAColorType");
+			pOutStream->writeAttribute("red", QString::number(color.redF()));
+			pOutStream->writeAttribute("green", QString::number(color.greenF()));
+			pOutStream->writeAttribute("blue", QString::number(color.blueF()));
+			pOutStream->writeAttribute("alpha", QString::number(color.alphaF()));
+		pOutStream->writeEndElement(); // Color
+	pOutStream->writeEndElement(); // LineAttributes
 }
 
 void GLC_WorldTo3dxml::writeMaterial(const GLC_Material* pMaterial)
@@ -78,6 +78,12 @@ public:
 
 	//! set interrupt flag adress
 	void setInterupt(QReadWriteLock* pReadWriteLock, bool* pInterupt);
+
+	//! Set parallel export usage (the default)
+	/*! Representations are formatted and compressed by a thread pool
+	 *  and written in order by the calling thread*/
+	inline void setParallelExportUsage(bool usage)
+	{m_UseParallelExport= usage;}
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -85,6 +91,11 @@ public:
 //@{
 //////////////////////////////////////////////////////////////////////
 private:
+	struct FaceData;
+	struct LodData;
+	struct MeshData;
+	struct RepData;
+	class RepWritingTask;
 
 	//! Write 3DXML Header
 	void writeHeader();
@@ -119,23 +130,35 @@ private:
 	//! Write the given 3DRep to 3DXML 3DRep
 	void write3DRep(const GLC_3DRep* pRep, const QString& fileName);
 
+	//! Write all the representations using a thread pool
+	void write3DRepsInParallel();
+
+	//! Close the current file of the 3DXML archive
+	void closeCurrentZipFile();
+
+	//! Take the snapshot of the given 3DRep and give ids to its elements
+	void get3DRepData(const GLC_3DRep* pRep, RepData* pRepData);
+
 	//! Return the file name of the given 3DRep
 	QString representationFileName(const GLC_3DRep* pRep);
 
+	//! Write the 3DRep document of the given snapshot
+	static void write3DRepDocument(QXmlStreamWriter* pOutStream, const RepData& repData);
+
 	//! Write the given mesh to 3DXML 3DRep
-	void writeGeometry(const GLC_Mesh* pMesh);
+	static void writeGeometry(QXmlStreamWriter* pOutStream, const MeshData& meshData, bool exportMaterial);
 
-	//! Write the geometry face from the given lod and material
-	void writeGeometryFace(const GLC_Mesh* pMesh, int lod, GLC_uint materialId);
+	//! Write the given geometry face
+	static void writeGeometryFace(QXmlStreamWriter* pOutStream, const FaceData& faceData, bool exportMaterial);
 
 	//! Write surface attributes
-	void writeSurfaceAttributes(const GLC_Material* pMaterial);
+	static void writeSurfaceAttributes(QXmlStreamWriter* pOutStream, const FaceData& faceData, bool exportMaterial);
 
 	//! Write edges
-	void writeEdges(const GLC_Mesh* pMesh);
+	static void writeEdges(QXmlStreamWriter* pOutStream, const MeshData& meshData);
 
 	//! Write lines attributes
-	void writeLineAttributes(const QColor& color);
+	static void writeLineAttributes(QXmlStreamWriter* pOutStream, const QColor& color);
 
 	//! Write Material
 	void writeMaterial(const GLC_Material* pMaterial);
@@ -275,6 +298,9 @@ private:
 	//! Flag to know if export is threaded (the default)
 	bool m_IsThreaded;
 
+	//! Flag to know if representations are written by a thread pool
+	bool m_UseParallelExport;
+
 };
 
 #endif /* GLC_WORLDTO3DXML_H_ */
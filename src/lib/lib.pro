@@ -100,7 +100,9 @@ HEADERS_GLC_IO +=   io/glc_objmtlloader.h \
                     io/glc_fileloader.h \
                     io/glc_worldreaderplugin.h \
                     io/glc_worldreaderhandler.h \
-                    io/glc_worldtoobj.h
+                    io/glc_worldtoobj.h \
+                    io/glc_numberparser.h \
+                    io/glc_asyncfileloader.h
 
 HEADERS_GLC_SCENEGRAPH +=   sceneGraph/glc_3dviewcollection.h \
                             sceneGraph/glc_3dviewinstance.h \
@@ -113,7 +115,15 @@ HEADERS_GLC_SCENEGRAPH +=   sceneGraph/glc_3dviewcollection.h \
                             sceneGraph/glc_spacepartitioning.h \
                             sceneGraph/glc_octree.h \
                             sceneGraph/glc_octreenode.h \
-                            sceneGraph/glc_selectionset.h
+                            sceneGraph/glc_aabbtree.h \
+                            sceneGraph/glc_occlusionculler.h \
+                            sceneGraph/glc_softwareocclusionculler.h \
+                            sceneGraph/glc_bvh.h \
+                            sceneGraph/glc_raypicker.h \
+                            sceneGraph/glc_meshbvh.h \
+                            sceneGraph/glc_clashdetector.h \
+                            sceneGraph/glc_selectionset.h \
+                            sceneGraph/glc_pagingmanager.h
 							
 HEADERS_GLC_GEOMETRY += geometry/glc_geometry.h \
                         geometry/glc_circle.h \
@@ -143,6 +153,7 @@ HEADERS_GLC_SHADING +=  shading/glc_material.h \
                         shading/glc_texture.h \
                         shading/glc_shader.h \
                         shading/glc_selectionmaterial.h \
+                        shading/glc_oitrenderer.h \
                         shading/glc_light.h \
                         shading/glc_renderproperties.h \
                         shading/glc_renderer.h
@@ -161,6 +172,8 @@ HEADERS_GLC_VIEWPORT +=	viewport/glc_camera.h \
                         viewport/glc_settargetmover.h \
                         viewport/glc_turntablemover.h \
                         viewport/glc_frustum.h \
+                        viewport/glc_frustumculler.h \
+                        viewport/glc_pixelreader.h \
                         viewport/glc_flymover.h \
                         viewport/glc_repflymover.h \
                         viewport/glc_userinput.h \
@@ -276,7 +289,9 @@ SOURCES +=	io/glc_objmtlloader.cpp \
                 io/glc_worldto3ds.cpp \
                 io/glc_bsreptoworld.cpp \
                 io/glc_fileloader.cpp \
-                io/glc_worldtoobj.cpp
+                io/glc_worldtoobj.cpp \
+                io/glc_numberparser.cpp \
+                io/glc_asyncfileloader.cpp
 
 SOURCES +=	sceneGraph/glc_3dviewcollection.cpp \
                 sceneGraph/glc_3dviewinstance.cpp \
@@ -288,8 +303,16 @@ SOURCES +=	sceneGraph/glc_3dviewcollection.cpp \
                 sceneGraph/glc_spacepartitioning.cpp \
                 sceneGraph/glc_octree.cpp \
                 sceneGraph/glc_octreenode.cpp \
+                sceneGraph/glc_aabbtree.cpp \
+                sceneGraph/glc_occlusionculler.cpp \
+                sceneGraph/glc_softwareocclusionculler.cpp \
+                sceneGraph/glc_bvh.cpp \
+                sceneGraph/glc_raypicker.cpp \
+                sceneGraph/glc_meshbvh.cpp \
+                sceneGraph/glc_clashdetector.cpp \
                 sceneGraph/glc_selectionset.cpp \
-                sceneGraph/glc_structoccurrence.cpp
+                sceneGraph/glc_structoccurrence.cpp \
+                sceneGraph/glc_pagingmanager.cpp
 
 SOURCES +=	geometry/glc_geometry.cpp \
                 geometry/glc_circle.cpp \
@@ -320,6 +343,7 @@ SOURCES +=	shading/glc_material.cpp \
                 shading/glc_texture.cpp \
                 shading/glc_light.cpp \
                 shading/glc_selectionmaterial.cpp \
+                shading/glc_oitrenderer.cpp \
                 shading/glc_shader.cpp \
                 shading/glc_renderproperties.cpp \
                 shading/glc_renderer.cpp
@@ -338,6 +362,8 @@ SOURCES +=	viewport/glc_camera.cpp \
                 viewport/glc_settargetmover.cpp \
                 viewport/glc_turntablemover.cpp \
                 viewport/glc_frustum.cpp \
+                viewport/glc_frustumculler.cpp \
+                viewport/glc_pixelreader.cpp \
                 viewport/glc_flymover.cpp \
                 viewport/glc_repflymover.cpp \
                 viewport/glc_userinput.cpp \
@@ -423,6 +449,7 @@ HEADERS_INST = GLC_BoundingBox \
                GLC_World \
                GLC_Shader \
                GLC_SelectionMaterial \
+               GLC_OitRenderer \
                GLC_State \
                GLC_Mover \
                GLC_MoverController \
@@ -450,8 +477,18 @@ HEADERS_INST = GLC_BoundingBox \
                GLC_SpacePartitioning \
                GLC_Octree \
                GLC_OctreeNode \
+               GLC_AabbTree \
+               GLC_OcclusionCuller \
+               GLC_SoftwareOcclusionCuller \
+               GLC_Bvh \
+               GLC_RayPicker \
+               GLC_MeshBvh \
+               GLC_ClashDetector \
+               GLC_PagingManager \
                GLC_Plane \
                GLC_Frustum \
+               GLC_FrustumCuller \
+               GLC_PixelReader \
                GLC_GeomTools \
                GLC_Line3d \
                GLC_3DWidget \
@@ -479,6 +516,7 @@ HEADERS_INST = GLC_BoundingBox \
                glcXmlUtil \
                GLC_RenderState \
                GLC_FileLoader \
+               GLC_AsyncFileLoader \
                GLC_WorldReaderPlugin \
                GLC_WorldReaderHandler \
                GLC_PointCloud \
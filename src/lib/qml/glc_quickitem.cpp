@@ -23,6 +23,8 @@
 
 #include <QSGSimpleTextureNode>
 #include <QQuickWindow>
+#include <QRunnable>
+#include <cstring>
 
 #include "../glc_context.h"
 #include "../glc_exception.h"
@@ -33,6 +35,32 @@
 #include "../viewport/glc_viewhandler.h"
 #include "../sceneGraph/glc_octree.h"
 
+namespace
+{
+// Delete a pixel reader and its buffers on the render thread
+class PixelReaderReleaseJob : public QRunnable
+{
+public:
+    explicit PixelReaderReleaseJob(GLC_PixelReader* pPixelReader)
+        : QRunnable()
+        , m_pPixelReader(pPixelReader)
+    {}
+
+    virtual ~PixelReaderReleaseJob()
+    {
+        delete m_pPixelReader;
+    }
+
+    virtual void run()
+    {
+        m_pPixelReader->releaseBuffers();
+    }
+
+private:
+    GLC_PixelReader* m_pPixelReader;
+};
+}
+
 GLC_QuickItem::GLC_QuickItem(GLC_QuickItem *pParent)
     : QQuickItem(pParent)
     , m_Viewhandler(NULL)
@@ -45,6 +73,12 @@ GLC_QuickItem::GLC_QuickItem(GLC_QuickItem *pParent)
     , m_pCamera(new GLC_QuickCamera(this))
     , m_Source()
     , m_pQuickSelection(new GLC_QuickSelection(this))
+    , m_pPixelReader(new GLC_PixelReader)
+    , m_SelectionReadId(-1)
+    , m_DepthReadId(-1)
+    , m_SelectionReadPosition()
+    , m_ScreenShotReadId(-1)
+    , m_ScreenShotReadSize()
 {
     setAcceptedMouseButtons(Qt::LeftButton | Qt::RightButton | Qt::MidButton);
     setFlag(QQuickItem::ItemHasContents);
@@ -63,6 +97,10 @@ GLC_QuickItem::~GLC_QuickItem()
     delete m_pSourceFbo;
     delete m_pTargetFbo;
     delete m_pAuxFbo;
+
+    // Buffers are released on the render thread if the item is still in a window
+    if (NULL != window()) releaseResources();
+    delete m_pPixelReader;
 }
 
 QVariant GLC_QuickItem::viewHandler() const
@@ -222,6 +260,8 @@ QSGNode* GLC_QuickItem::updatePaintNode(QSGNode* pNode, UpdatePaintNodeData* pDa
 
     if ((NULL != m_Viewhandler) && m_Viewhandler->isEnable())
     {
+        collectAsynchronousReads();
+
         bool widthOk= this->width() > 0.0;
         bool heightOk= this->height() > 0.0;
 
@@ -267,6 +307,22 @@ QSGNode* GLC_QuickItem::updatePaintNode(QSGNode* pNode, UpdatePaintNodeData* pDa
     return pTextureNode;
 }
 
+void GLC_QuickItem::releaseResources()
+{
+    // The pixel reader buffers belong to the render thread OpenGL context
+    window()->scheduleRenderJob(new PixelReaderReleaseJob(m_pPixelReader), QQuickWindow::BeforeSynchronizingStage);
+    m_pPixelReader= new GLC_PixelReader;
+    m_SelectionReadId= -1;
+    m_DepthReadId= -1;
+
+    // A pending screen shot is given up
+    if (m_Viewhandler && (-1 != m_ScreenShotReadId))
+    {
+        m_ScreenShotReadId= -1;
+        m_Viewhandler->setAsynchronousScreenShot(QImage());
+    }
+}
+
 void GLC_QuickItem::mousePressEvent(QMouseEvent *e)
 {
     if (NULL != m_Viewhandler)
@@ -413,6 +469,14 @@ void GLC_QuickItem::renderForSelection()
         const int x= m_Viewhandler->pointerPosition().x();
         const int y= m_Viewhandler->pointerPosition().y();
 
+        if (m_Viewhandler->selectionIsAsynchronous() && (m_Viewhandler->selectionModes() & GLC_SelectionEvent::ModeInstance))
+        {
+            readSelection(x, y);
+            m_pAuxFbo->release();
+            popOpenGLMatrix();
+            return;
+        }
+
         GLC_World world= m_Viewhandler->world();
         GLC_SelectionSet selectionSet;
 
@@ -445,7 +509,15 @@ void GLC_QuickItem::renderForSelection()
             }
         }
 
-        m_Viewhandler->updateCurrentSelectionSet(selectionSet, m_UnprojectedPoint);
+        if (m_Viewhandler->selectionIsAsynchronous())
+        {
+            m_Viewhandler->asynchronousSelectionIssued();
+            m_Viewhandler->setAsynchronousSelection(selectionSet, m_UnprojectedPoint);
+        }
+        else
+        {
+            m_Viewhandler->updateCurrentSelectionSet(selectionSet, m_UnprojectedPoint);
+        }
     }
 
     m_pAuxFbo->release();
@@ -475,12 +547,113 @@ void GLC_QuickItem::renderForScreenShot()
         popOpenGLMatrix();
     }
 
-    QImage screenShot= m_pScreenShotFbo->toImage();
+    if (m_Viewhandler->screenShotIsAsynchronous())
+    {
+        readScreenShot(width, height);
+        m_Viewhandler->asynchronousScreenShotIssued();
+    }
+    else
+    {
+        QImage screenShot= m_pScreenShotFbo->toImage();
+        m_Viewhandler->setScreenShotImage(screenShot);
+    }
 
     delete m_pScreenShotFbo;
     m_pScreenShotFbo= NULL;
+}
 
-    m_Viewhandler->setScreenShotImage(screenShot);
+void GLC_QuickItem::readSelection(int x, int y)
+{
+    // A previous selection not yet available is replaced
+    if (-1 != m_SelectionReadId)
+    {
+        m_pPixelReader->discard(m_SelectionReadId);
+        m_pPixelReader->discard(m_DepthReadId);
+    }
+
+    // The aux frame buffer is bound, its pixels are taken on a later frame
+    GLC_Viewport* pView= m_Viewhandler->viewportHandle();
+    const QRect square(pView->selectionSquare(x, y));
+    m_SelectionReadId= m_pPixelReader->read(square.x(), square.y(), square.width(), square.height(), GL_COLOR_ATTACHMENT0);
+    m_DepthReadId= m_pPixelReader->read(x, pView->viewVSize() - y, 1, 1, GL_COLOR_ATTACHMENT0, GL_DEPTH_COMPONENT, GL_FLOAT);
+    m_SelectionReadPosition= QPoint(x, y);
+    m_Viewhandler->asynchronousSelectionIssued();
+    QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+}
+
+void GLC_QuickItem::readScreenShot(int width, int height)
+{
+    if ((NULL == m_pScreenShotFbo) || !m_pScreenShotFbo->isValid())
+    {
+        m_Viewhandler->setAsynchronousScreenShot(QImage());
+        return;
+    }
+
+    // Multisampled pixels can't be read, they are resolved first
+    QOpenGLFramebufferObject* pResolvedFbo= NULL;
+    QOpenGLFramebufferObject* pReadFbo= m_pScreenShotFbo;
+    if (m_pScreenShotFbo->format().samples() > 0)
+    {
+        pResolvedFbo= new QOpenGLFramebufferObject(width, height);
+        QOpenGLFramebufferObject::blitFramebuffer(pResolvedFbo, m_pScreenShotFbo);
+        pReadFbo= pResolvedFbo;
+    }
+
+    if (-1 != m_ScreenShotReadId) m_pPixelReader->discard(m_ScreenShotReadId);
+
+    // The frame buffers can be deleted once the read is issued
+    pReadFbo->bind();
+    m_ScreenShotReadId= m_pPixelReader->read(0, 0, width, height, GL_COLOR_ATTACHMENT0);
+    m_ScreenShotReadSize= QSize(width, height);
+    pReadFbo->release();
+    delete pResolvedFbo;
+
+    QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+}
+
+void GLC_QuickItem::collectAsynchronousReads()
+{
+    if ((-1 == m_SelectionReadId) && (-1 == m_ScreenShotReadId)) return;
+
+    m_pPixelReader->collect();
+    QVector<GLubyte> pixels;
+
+    if ((-1 != m_SelectionReadId) && m_pPixelReader->isFinished(m_SelectionReadId) && m_pPixelReader->isFinished(m_DepthReadId))
+    {
+        m_pPixelReader->takePixels(m_SelectionReadId, &pixels);
+        const GLC_uint instanceId= GLC_Viewport::meaningfullId(pixels);
+
+        GLfloat depth= 1.0f;
+        m_pPixelReader->takePixels(m_DepthReadId, &pixels);
+        if (pixels.size() >= static_cast<int>(sizeof(GLfloat))) memcpy(&depth, pixels.constData(), sizeof(GLfloat));
+        const int x= m_SelectionReadPosition.x();
+        const int y= m_SelectionReadPosition.y();
+        m_UnprojectedPoint= m_Viewhandler->viewportHandle()->unprojectDepth(x, y, depth);
+
+        GLC_SelectionSet selectionSet;
+        if (instanceId) selectionSet.insert(instanceId);
+        m_SelectionReadId= -1;
+        m_DepthReadId= -1;
+        m_Viewhandler->setAsynchronousSelection(selectionSet, m_UnprojectedPoint);
+    }
+
+    if ((-1 != m_ScreenShotReadId) && m_pPixelReader->takePixels(m_ScreenShotReadId, &pixels))
+    {
+        // OpenGL rows are from bottom to top
+        QImage screenShot;
+        if (!pixels.isEmpty())
+        {
+            const QImage image(pixels.constData(), m_ScreenShotReadSize.width(), m_ScreenShotReadSize.height(), QImage::Format_RGBA8888);
+            screenShot= image.mirrored();
+        }
+        m_ScreenShotReadId= -1;
+        m_Viewhandler->setAsynchronousScreenShot(screenShot);
+    }
+
+    if ((-1 != m_SelectionReadId) || (-1 != m_ScreenShotReadId))
+    {
+        QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    }
 }
 
 GLC_uint GLC_QuickItem::selectBody(GLC_uint instanceId, int x, int y)
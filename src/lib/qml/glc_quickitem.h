@@ -37,6 +37,7 @@
 #include "../sceneGraph/glc_world.h"
 #include "../viewport/glc_movercontroller.h"
 #include "../viewport/glc_viewhandler.h"
+#include "../viewport/glc_pixelreader.h"
 #include "../maths/glc_vector3d.h"
 #include "glc_quickcamera.h"
 #include "glc_quickselection.h"
@@ -140,6 +141,7 @@ signals:
 protected:
     virtual void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry);
     virtual QSGNode* updatePaintNode(QSGNode* pNode, UpdatePaintNodeData* pData);
+    virtual void releaseResources();
     virtual void mousePressEvent(QMouseEvent * e);
     virtual void mouseMoveEvent(QMouseEvent * e);
     virtual void mouseReleaseEvent(QMouseEvent * e);
@@ -159,6 +161,9 @@ protected:
     void render(QSGSimpleTextureNode* pTextureNode, UpdatePaintNodeData* pData);
     void renderForSelection();
     void renderForScreenShot();
+    void readSelection(int x, int y);
+    void readScreenShot(int width, int height);
+    void collectAsynchronousReads();
 
     GLC_uint selectBody(GLC_uint instanceId, int x, int y);
     QPair<GLC_uint, GLC_uint> selectPrimitive(GLC_uint instanceId, int x, int y);
@@ -189,6 +194,13 @@ protected:
     QString m_Source;
 
     GLC_QuickSelection* m_pQuickSelection;
+
+    GLC_PixelReader* m_pPixelReader;
+    int m_SelectionReadId;
+    int m_DepthReadId;
+    QPoint m_SelectionReadPosition;
+    int m_ScreenShotReadId;
+    QSize m_ScreenShotReadSize;
 };
 
 #endif // GLC_QUICKITEM_H
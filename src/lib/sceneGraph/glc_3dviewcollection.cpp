@@ -33,8 +33,152 @@
 #include "glc_spacepartitioning.h"
 #include "../glc_context.h"
 #include "../glc_contextmanager.h"
+#include "../glc_renderstatistics.h"
+#include "../geometry/glc_mesh.h"
+#include "../shading/glc_oitrenderer.h"
+#include "glc_occlusionculler.h"
+#include "glc_softwareocclusionculler.h"
+#include "../viewport/glc_frustumculler.h"
 
 #include <QtDebug>
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// LOD value of a render queue item not chosen by prepareFrame()
+const int lodNotPrepared= -2;
+
+// Number of render queue items of a frame preparation chunk
+const int framePreparationChunkSize= 1024;
+
+// Width of the software occlusion depth buffer
+const int softwareDepthBufferWidth= 256;
+
+// Maximum number of occluders rasterized by frame
+const int maximumOccluderCount= 32;
+
+// Minimum ratio between the bounding sphere radius of an occluder and its distance to the eye
+const double minimumOccluderScore= 0.05;
+
+// Maximum number of triangles of the coarsest LOD of an occluder
+const unsigned int maximumOccluderTriangleCount= 4096;
+
+// Order primitive groups by material, then by VBO and then by instance
+template <typename Item>
+bool drawItemLessThan(const Item& item1, const Item& item2)
+{
+	if (item1.m_pMaterial != item2.m_pMaterial) return item1.m_pMaterial < item2.m_pMaterial;
+	if (item1.m_pMesh != item2.m_pMesh) return item1.m_pMesh < item2.m_pMesh;
+	if (item1.m_Lod != item2.m_Lod) return item1.m_Lod < item2.m_Lod;
+	return item1.m_pInstance < item2.m_pInstance;
+}
+
+// Order primitive groups by material, then by VBO and then by primitive group
+template <typename Item>
+bool instancedDrawItemLessThan(const Item& item1, const Item& item2)
+{
+	if (item1.m_pMaterial != item2.m_pMaterial) return item1.m_pMaterial < item2.m_pMaterial;
+	if (item1.m_pMesh != item2.m_pMesh) return item1.m_pMesh < item2.m_pMesh;
+	if (item1.m_Lod != item2.m_Lod) return item1.m_Lod < item2.m_Lod;
+	return item1.m_pGroup < item2.m_pGroup;
+}
+
+// Order occluders by descending score
+template <typename Item>
+bool occluderScoreGreaterThan(const Item& item1, const Item& item2)
+{
+	return item1.m_Score > item2.m_Score;
+}
+
+// Return an unsigned key with the same order than the given float
+inline quint32 depthSortKey(float value)
+{
+	quint32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// Sort items by ascending key with a least significant byte first radix sort
+// Passes where all keys have the same byte are skipped
+template <typename Item>
+void radixSort(QVector<Item>* pItems, QVector<Item>* pBuffer)
+{
+	const int size= pItems->size();
+	if (size < 2) return;
+	pBuffer->resize(size);
+	Item* pSource= pItems->data();
+	Item* pTarget= pBuffer->data();
+	for (int shift= 0; shift < 32; shift+= 8)
+	{
+		int offsets[256];
+		memset(offsets, 0, sizeof(offsets));
+		for (int i= 0; i < size; ++i) ++offsets[(pSource[i].m_Key >> shift) & 0xFF];
+		if (offsets[(pSource[0].m_Key >> shift) & 0xFF] == size) continue;
+
+		int offset= 0;
+		for (int i= 0; i < 256; ++i)
+		{
+			const int count= offsets[i];
+			offsets[i]= offset;
+			offset+= count;
+		}
+		for (int i= 0; i < size; ++i)
+		{
+			pTarget[offsets[(pSource[i].m_Key >> shift) & 0xFF]++]= pSource[i];
+		}
+		std::swap(pSource, pTarget);
+	}
+	if (pSource != pItems->data()) std::copy(pSource, pSource + size, pItems->data());
+}
+
+// Return true if instanced rendering can be used to draw collection members
+inline bool instancingIsUsable()
+{
+	return GLC_State::isInstancingActivated() && GLC_State::instancingSupported() && GLC_State::glslUsed() && !GLC_Shader::hasActiveShader();
+}
+
+// Return true if the given instance can be drawn by the instanced shader
+bool instanceIsInstanciable(GLC_3DViewInstance* pInstance)
+{
+	// The instanced shader transforms normals with the instance matrix
+	const GLC_Matrix4x4& matrix= pInstance->matrix();
+	const double scaleX= matrix.scalingX();
+	return (pInstance->renderPropertiesHandle()->polygonMode() == GL_FILL) && (matrix.type() != GLC_Matrix4x4::Indirect)
+			&& qFuzzyCompare(scaleX, matrix.scalingY()) && qFuzzyCompare(scaleX, matrix.scalingZ());
+}
+}
+
+class GLC_3DViewCollection::FramePreparationTask : public QRunnable
+{
+public:
+	FramePreparationTask(GLC_3DViewCollection* pCollection)
+	: QRunnable()
+	, m_pCollection(pCollection)
+	, m_Done()
+	{
+		setAutoDelete(false);
+	}
+
+	virtual void run()
+	{
+		m_pCollection->prepareChunks();
+		m_Done.release();
+	}
+
+	//! Wait until the task is done
+	inline void waitForDone()
+	{m_Done.acquire();}
+
+private:
+	GLC_3DViewCollection* m_pCollection;
+	QSemaphore m_Done;
+};
 
 //////////////////////////////////////////////////////////////////////
 // Constructor/Destructor
@@ -52,6 +196,22 @@ GLC_3DViewCollection::GLC_3DViewCollection()
 , m_pSpacePartitioning(NULL)
 , m_UseSpacePartitioning(false)
 , m_IsViewable(true)
+, m_RenderQueues()
+, m_SortedDrawItems()
+, m_InstanceMatrices()
+, m_DepthSortItems()
+, m_DepthSortBuffer()
+, m_FramePreparationChunks()
+, m_NextFramePreparationChunk(0)
+, m_IsFramePrepared(false)
+, m_TriangleBudgetItems()
+, m_TriangleBudgetBuffer()
+, m_pOcclusionCuller(NULL)
+, m_OcclusionCandidates()
+, m_OccludedInstancesAreHidden(false)
+, m_pSoftwareOcclusionCuller(NULL)
+, m_OccluderMeshes()
+, m_Occluders()
 {
 }
 
@@ -59,6 +219,8 @@ GLC_3DViewCollection::~GLC_3DViewCollection()
 {
 	// Delete all collection's elements and the collection bounding box
 	clear();
+	delete m_pOcclusionCuller;
+	delete m_pSoftwareOcclusionCuller;
 }
 //////////////////////////////////////////////////////////////////////
 // Set Functions
@@ -104,6 +266,9 @@ bool GLC_3DViewCollection::unBindShader(GLC_uint shaderId)
 			m_ShaderGroup.remove(id);
 		}
 		pShaderNodeHash->clear();
+		invalidateRenderQueueOf(pShaderNodeHash);
+		invalidateRenderQueueOf(&m_MainInstances);
+		invalidateRenderQueueOf(&m_SelectedInstances);
 		delete pShaderNodeHash;
 		result= true;
 	}
@@ -153,10 +318,13 @@ bool GLC_3DViewCollection::add(const GLC_3DViewInstance& node, GLC_uint shaderID
 			if(pInstance->isSelected())
 			{
 				m_SelectedInstances.insert(key, pInstance);
+				addToRenderQueueOf(&m_SelectedInstances, pInstance);
 			}
 			else
 			{
-				m_ShadedPointerViewInstanceHash.value(shaderID)->insert(key, pInstance);
+				PointerViewInstanceHash* pShaderNodeHash= m_ShadedPointerViewInstanceHash.value(shaderID);
+				pShaderNodeHash->insert(key, pInstance);
+				addToRenderQueueOf(pShaderNodeHash, pInstance);
 			}
 			result=true;
 		}
@@ -164,14 +332,21 @@ bool GLC_3DViewCollection::add(const GLC_3DViewInstance& node, GLC_uint shaderID
 	else if (!pInstance->isSelected())
 	{
 		m_MainInstances.insert(key, pInstance);
+		addToRenderQueueOf(&m_MainInstances, pInstance);
 		result=true;
 	}
 	else
 	{
 		m_SelectedInstances.insert(key, pInstance);
+		addToRenderQueueOf(&m_SelectedInstances, pInstance);
 		result=true;
 	}
 
+	if (result && (NULL != m_pSpacePartitioning))
+	{
+		m_pSpacePartitioning->insertInstance(pInstance);
+	}
+
 	return result;
 }
 
@@ -189,6 +364,7 @@ void GLC_3DViewCollection::changeShadingGroup(GLC_uint instanceId, GLC_uint shad
 		if (m_MainInstances.contains(instanceId))
 		{
 			pInstance= m_MainInstances.take(instanceId);
+			removeFromRenderQueueOf(&m_MainInstances, pInstance);
 		}
 		else if (m_SelectedInstances.contains(instanceId))
 		{
@@ -212,6 +388,7 @@ void GLC_3DViewCollection::changeShadingGroup(GLC_uint instanceId, GLC_uint shad
 		else
 		{
 			pInstance= m_ShadedPointerViewInstanceHash.value(instanceShadingGroup)->take(instanceId);
+			removeFromRenderQueueOf(m_ShadedPointerViewInstanceHash.value(instanceShadingGroup), pInstance);
 		}
 
 	}
@@ -222,11 +399,13 @@ void GLC_3DViewCollection::changeShadingGroup(GLC_uint instanceId, GLC_uint shad
 		if (!pInstance->isSelected())
 		{
 			m_ShadedPointerViewInstanceHash.value(shaderId)->insert(instanceId, pInstance);
+			addToRenderQueueOf(m_ShadedPointerViewInstanceHash.value(shaderId), pInstance);
 		}
 	}
 	else if (!pInstance->isSelected())
 	{
 		m_MainInstances.insert(instanceId, pInstance);
+		addToRenderQueueOf(&m_MainInstances, pInstance);
 	}
 }
 
@@ -243,7 +422,22 @@ bool GLC_3DViewCollection::remove(GLC_uint Key)
 			unselect(Key);
 		}
 
-		m_MainInstances.remove(Key);
+		GLC_3DViewInstance* pInstance= &(iNode.value());
+		if (m_MainInstances.remove(Key) > 0)
+		{
+			removeFromRenderQueueOf(&m_MainInstances, pInstance);
+		}
+		if (isInAShadingGroup(Key))
+		{
+			PointerViewInstanceHash* pShaderNodeHash= m_ShadedPointerViewInstanceHash.value(m_ShaderGroup.take(Key));
+			pShaderNodeHash->remove(Key);
+			removeFromRenderQueueOf(pShaderNodeHash, pInstance);
+		}
+
+		if (NULL != m_pSpacePartitioning)
+		{
+			m_pSpacePartitioning->removeInstance(Key);
+		}
 
 		m_3DViewInstanceHash.remove(Key);		// Delete the conteneur
 
@@ -275,12 +469,15 @@ void GLC_3DViewCollection::clear(void)
 
 	m_ShadedPointerViewInstanceHash.clear();
 	m_ShaderGroup.clear();
+	m_RenderQueues.clear();
+	m_OccluderMeshes.clear();
 
 	// Clear main Hash table
     m_3DViewInstanceHash.clear();
 
 	// delete the space partitioning
 	delete m_pSpacePartitioning;
+	m_pSpacePartitioning= NULL;
 }
 
 bool GLC_3DViewCollection::select(GLC_uint key, bool primitive)
@@ -302,11 +499,14 @@ bool GLC_3DViewCollection::select(GLC_uint key, bool primitive)
             if (isInAShadingGroup(key))
             {
                 m_ShadedPointerViewInstanceHash.value(shadingGroup(key))->remove(key);
+                removeFromRenderQueueOf(m_ShadedPointerViewInstanceHash.value(shadingGroup(key)), pSelectedInstance);
             }
             else
             {
                 m_MainInstances.remove(key);
+                removeFromRenderQueueOf(&m_MainInstances, pSelectedInstance);
             }
+            addToRenderQueueOf(&m_SelectedInstances, pSelectedInstance);
             pSelectedInstance->select(primitive);
 
             subject= true;
@@ -319,6 +519,7 @@ bool GLC_3DViewCollection::select(GLC_uint key, bool primitive)
 void GLC_3DViewCollection::selectAll(bool allShowState)
 {
 	unselectAll();
+	m_RenderQueues.clear();
 	ViewInstancesHash::iterator iNode= m_3DViewInstanceHash.begin();
 	while (iNode != m_3DViewInstanceHash.end())
 	{
@@ -356,11 +557,14 @@ bool GLC_3DViewCollection::unselect(GLC_uint key)
 		if (isInAShadingGroup(key))
 		{
 			m_ShadedPointerViewInstanceHash.value(shadingGroup(key))->insert(key, pSelectedNode);
+			addToRenderQueueOf(m_ShadedPointerViewInstanceHash.value(shadingGroup(key)), pSelectedNode);
 		}
 		else
 		{
 			m_MainInstances.insert(key, pSelectedNode);
+			addToRenderQueueOf(&m_MainInstances, pSelectedNode);
 		}
+		removeFromRenderQueueOf(&m_SelectedInstances, pSelectedNode);
 
 		//qDebug("GLC_3DViewCollection::unselectNode : Node succesfuly unselected");
 		return true;
@@ -394,6 +598,7 @@ void GLC_3DViewCollection::unselectAll()
     }
     // Clear selected node hash table
     m_SelectedInstances.clear();
+    m_RenderQueues.clear();
 }
 
 void GLC_3DViewCollection::setPolygonModeForAll(GLenum face, GLenum mode)
@@ -484,6 +689,14 @@ void GLC_3DViewCollection::updateInstanceViewableState(const GLC_Frustum& frustu
     }
 }
 
+void GLC_3DViewCollection::updateInstanceSpacePartitioning(GLC_uint key)
+{
+	if ((NULL != m_pSpacePartitioning) && m_3DViewInstanceHash.contains(key))
+	{
+		m_pSpacePartitioning->updateInstance(&(m_3DViewInstanceHash[key]));
+	}
+}
+
 void GLC_3DViewCollection::updateSpacePartitionning()
 {
     if (NULL != m_pSpacePartitioning)
@@ -492,6 +705,63 @@ void GLC_3DViewCollection::updateSpacePartitionning()
     }
 }
 
+void GLC_3DViewCollection::prepareFrame()
+{
+	m_IsFramePrepared= false;
+	updateRenderQueues();
+	updateInstanceViewableState();
+	const bool isParallel= GLC_State::isParallelFramePreparationActivated();
+	const bool triangleBudgetIsUsed= m_UseLod && (NULL != m_pViewport) && (m_pViewport->triangleBudget() > 0);
+	if (!(isParallel || triangleBudgetIsUsed) || isEmpty() || !m_IsViewable) return;
+
+	// Split the render queues of all groups in chunks
+	QList<PointerViewInstanceHash*> hashList;
+	hashList << &m_MainInstances << &m_SelectedInstances;
+	hashList.append(m_ShadedPointerViewInstanceHash.values());
+	m_FramePreparationChunks.clear();
+	const int hashCount= hashList.size();
+	for (int i= 0; i < hashCount; ++i)
+	{
+		PointerViewInstanceHash* pHash= hashList.at(i);
+		if (pHash->isEmpty()) continue;
+		renderQueue(pHash);
+		RenderQueue& queue= m_RenderQueues[pHash].m_Queue;
+		FramePreparationChunk chunk;
+		chunk.m_pItems= queue.data();
+		chunk.m_Size= queue.size();
+		for (int begin= 0; begin < chunk.m_Size; begin+= framePreparationChunkSize)
+		{
+			chunk.m_Begin= begin;
+			chunk.m_End= qMin(begin + framePreparationChunkSize, chunk.m_Size);
+			m_FramePreparationChunks.append(chunk);
+		}
+	}
+
+	// Chunks are taken by the pool threads and the calling thread until none is left
+	m_NextFramePreparationChunk.fetchAndStoreOrdered(0);
+	QThreadPool* pThreadPool= QThreadPool::globalInstance();
+	const int taskCount= isParallel ? (qMin(m_FramePreparationChunks.size(), pThreadPool->maxThreadCount()) - 1) : 0;
+	QList<FramePreparationTask*> tasks;
+	for (int i= 0; i < taskCount; ++i)
+	{
+		FramePreparationTask* pTask= new FramePreparationTask(this);
+		tasks.append(pTask);
+		pThreadPool->start(pTask);
+	}
+	prepareChunks();
+
+	// Tasks not started yet have nothing left to do
+	for (int i= 0; i < tasks.size(); ++i)
+	{
+		if (!pThreadPool->tryTake(tasks.at(i))) tasks.at(i)->waitForDone();
+	}
+	qDeleteAll(tasks);
+
+	if (triangleBudgetIsUsed) applyTriangleBudget(hashList);
+
+	m_IsFramePrepared= true;
+}
+
 void GLC_3DViewCollection::setVboUsage(bool usage)
 {
 	ViewInstancesHash::iterator iEntry= m_3DViewInstanceHash.begin();
@@ -564,6 +834,44 @@ QList<GLC_3DViewInstance*> GLC_3DViewCollection::viewableInstancesHandle()
 	return instancesList;
 }
 
+QSet<GLC_uint> GLC_3DViewCollection::instancesInsideFrustum(const GLC_Frustum& frustum, bool fullyInside)
+{
+	QSet<GLC_uint> subject;
+	if (m_UseSpacePartitioning && (NULL != m_pSpacePartitioning))
+	{
+		const QList<GLC_3DViewInstance*> instanceList(m_pSpacePartitioning->listOfInstancesInFrustum(frustum, fullyInside));
+		const int size= instanceList.size();
+		for (int i= 0; i < size; ++i)
+		{
+			GLC_3DViewInstance* pInstance= instanceList.at(i);
+			if (pInstance->isVisible() == m_IsInShowSate) subject.insert(pInstance->id());
+		}
+	}
+	else
+	{
+		const QList<GLC_3DViewInstance*> instanceList(viewableInstancesHandle());
+		const int size= instanceList.size();
+		GLC_FrustumCuller cullingTable;
+		cullingTable.reserve(size);
+		for (int i= 0; i < size; ++i)
+		{
+			cullingTable.append(instanceList.at(i)->boundingBox());
+		}
+		QVector<quint8> localisations;
+		cullingTable.localizeBoundingBoxes(frustum, &localisations);
+		for (int i= 0; i < size; ++i)
+		{
+			const GLC_Frustum::Localisation localisation= static_cast<GLC_Frustum::Localisation>(localisations.at(i));
+			if ((localisation == GLC_Frustum::InFrustum) || (!fullyInside && (localisation == GLC_Frustum::IntersectFrustum)))
+			{
+				subject.insert(instanceList.at(i)->id());
+			}
+		}
+	}
+
+	return subject;
+}
+
 GLC_3DViewInstance* GLC_3DViewCollection::instanceHandle(GLC_uint Key)
 {
 	Q_ASSERT(m_3DViewInstanceHash.contains(Key));
@@ -683,6 +991,10 @@ void GLC_3DViewCollection::renderShaderGroup(glc::RenderFlag renderFlag)
 
 void GLC_3DViewCollection::glDraw(GLC_uint groupId, glc::RenderFlag renderFlag)
 {
+	if (groupId == 0) updateRenderQueueOf(&m_MainInstances);
+	else if (groupId == 1) updateRenderQueueOf(&m_SelectedInstances);
+	else updateRenderQueueOf(m_ShadedPointerViewInstanceHash.value(groupId));
+
 	// Set render Mode and OpenGL state
 	if (!GLC_State::isInSelectionMode() && (groupId == 0))
 	{
@@ -704,8 +1016,25 @@ void GLC_3DViewCollection::glDraw(GLC_uint groupId, glc::RenderFlag renderFlag)
 	// Normal GLC_3DViewInstance
 	if ((groupId == 0) && !m_MainInstances.isEmpty())
 	{
+		// Occluded instances are hidden in main group passes, the queries are issued after the opaque pass
+		// The software occlusion culling is done before the opaque pass and takes precedence over queries
+		bool occlusionQueriesAreIssued= false;
+		if (softwareOcclusionCullingIsUsable())
+		{
+			m_OccludedInstancesAreHidden= true;
+			if (renderFlag == glc::ShadingFlag) cullSoftwareOccludedInstances();
+		}
+		else
+		{
+			m_OccludedInstancesAreHidden= occlusionCullingIsUsable();
+			occlusionQueriesAreIssued= m_OccludedInstancesAreHidden && (renderFlag == glc::ShadingFlag);
+			if (occlusionQueriesAreIssued) m_pOcclusionCuller->collectResults(this);
+		}
+
 		glDrawInstancesOf(&m_MainInstances, renderFlag);
 
+		if (occlusionQueriesAreIssued) glIssueOcclusionQueries();
+		m_OccludedInstancesAreHidden= false;
 	}
 	// Selected GLC_3DVIewInstance
 	else if ((groupId == 1) && !m_SelectedInstances.isEmpty())
@@ -737,3 +1066,773 @@ void GLC_3DViewCollection::glDraw(GLC_uint groupId, glc::RenderFlag renderFlag)
 		glEnable(GL_DEPTH_TEST);
 	}
 }
+
+void GLC_3DViewCollection::glDrawInstancesOf(PointerViewInstanceHash* pHash, glc::RenderFlag renderFlag)
+{
+	const bool forceDisplay= GLC_State::isInSelectionMode();
+	if ((renderFlag == glc::TransparentRenderFlag) && !forceDisplay && (pHash != &m_SelectedInstances))
+	{
+		const bool useOit= GLC_State::isOrderIndependentTransparencyActivated();
+		if (useOit && !GLC_Shader::hasActiveShader() && glDrawOitInstancesOf(pHash)) return;
+		if (useOit || GLC_State::isTransparencySortingActivated())
+		{
+			glDrawDepthSortedInstancesOf(pHash);
+			return;
+		}
+	}
+
+	const bool sortableFlag= (renderFlag == glc::ShadingFlag) || (renderFlag == glc::TransparentRenderFlag);
+	const bool sortedDraw= GLC_State::isStateSortingActivated() || instancingIsUsable();
+	if (sortedDraw && !forceDisplay && sortableFlag && (pHash != &m_SelectedInstances))
+	{
+		glDrawStateSortedInstancesOf(pHash, renderFlag);
+		return;
+	}
+
+	glDrawQueueOf(pHash, renderFlag, forceDisplay);
+}
+
+void GLC_3DViewCollection::glDrawQueueOf(PointerViewInstanceHash* pHash, glc::RenderFlag renderFlag, bool forceDisplay)
+{
+	const RenderQueue& queue= renderQueue(pHash);
+
+	// Bodies of an instance are contiguous in the queue
+	GLC_3DViewInstance* pCurInstance= NULL;
+	bool instanceIsDrawn= false;
+	int bodyCount= 0;
+	const int size= queue.size();
+	for (int i= 0; i < size; ++i)
+	{
+		const RenderQueueItem& item= queue.at(i);
+		if (item.m_pInstance != pCurInstance)
+		{
+			if (instanceIsDrawn) pCurInstance->endRender();
+			pCurInstance= item.m_pInstance;
+			instanceIsDrawn= instanceIsDrawable(pCurInstance, renderFlag, forceDisplay);
+			if (instanceIsDrawn)
+			{
+				bodyCount= pCurInstance->numberOfBody();
+				pCurInstance->beginRender(renderFlag);
+			}
+		}
+		if (instanceIsDrawn && (item.m_BodyIndex < bodyCount))
+		{
+			pCurInstance->renderBodyAtLod(item.m_BodyIndex, bodyLodValueOf(item));
+		}
+	}
+	if (instanceIsDrawn) pCurInstance->endRender();
+}
+
+void GLC_3DViewCollection::glDrawDepthSortedInstancesOf(PointerViewInstanceHash* pHash)
+{
+	const RenderQueue& queue= renderQueue(pHash);
+	QElapsedTimer timer;
+	timer.start();
+
+	// View space depth of instance bounding box centres, only the z row of the view matrix is needed
+	const GLC_Matrix4x4 viewMatrix(GLC_ContextManager::instance()->currentContext()->modelViewMatrix());
+	const double* pView= viewMatrix.getData();
+	m_DepthSortItems.clear();
+	GLC_3DViewInstance* pCurInstance= NULL;
+	const int size= queue.size();
+	for (int i= 0; i < size; ++i)
+	{
+		GLC_3DViewInstance* pInstance= queue.at(i).m_pInstance;
+		if (pInstance == pCurInstance) continue;
+		pCurInstance= pInstance;
+		if (instanceIsDrawable(pInstance, glc::TransparentRenderFlag, false))
+		{
+			const GLC_Point3d center(pInstance->boundingBox().center());
+			const double depth= (pView[2] * center.x()) + (pView[6] * center.y()) + (pView[10] * center.z()) + pView[14];
+			DepthSortItem item;
+			item.m_Key= depthSortKey(static_cast<float>(depth));
+			item.m_QueueIndex= i;
+			m_DepthSortItems.append(item);
+		}
+	}
+
+	// The farthest instances have the smallest depth
+	radixSort(&m_DepthSortItems, &m_DepthSortBuffer);
+	GLC_RenderStatistics::addTransparencySort(static_cast<unsigned int>(m_DepthSortItems.size()), timer.nsecsElapsed());
+
+	// Draw instances from back to front, bodies of an instance are contiguous in the queue
+	const int itemCount= m_DepthSortItems.size();
+	for (int i= 0; i < itemCount; ++i)
+	{
+		int index= m_DepthSortItems.at(i).m_QueueIndex;
+		GLC_3DViewInstance* pInstance= queue.at(index).m_pInstance;
+		const int bodyCount= pInstance->numberOfBody();
+		pInstance->beginRender(glc::TransparentRenderFlag);
+		while ((index < size) && (queue.at(index).m_pInstance == pInstance))
+		{
+			const RenderQueueItem& item= queue.at(index);
+			if (item.m_BodyIndex < bodyCount) pInstance->renderBodyAtLod(item.m_BodyIndex, bodyLodValueOf(item));
+			++index;
+		}
+		pInstance->endRender();
+	}
+}
+
+bool GLC_3DViewCollection::occlusionCullingIsUsable()
+{
+	if (!GLC_State::isOcclusionCullingActivated())
+	{
+		if (NULL != m_pOcclusionCuller)
+		{
+			m_pOcclusionCuller->clear(this);
+			delete m_pOcclusionCuller;
+			m_pOcclusionCuller= NULL;
+		}
+		return false;
+	}
+	if (GLC_State::isInSelectionMode() || (NULL == m_pViewport) || GLC_Shader::hasActiveShader() || !GLC_OcclusionCuller::isSupported())
+	{
+		return false;
+	}
+	if (NULL == m_pOcclusionCuller)
+	{
+		m_pOcclusionCuller= new GLC_OcclusionCuller();
+	}
+	return true;
+}
+
+void GLC_3DViewCollection::glIssueOcclusionQueries()
+{
+	const RenderQueue& queue= renderQueue(&m_MainInstances);
+	m_OcclusionCandidates.clear();
+	GLC_3DViewInstance* pCurInstance= NULL;
+	const int size= queue.size();
+	for (int i= 0; i < size; ++i)
+	{
+		GLC_3DViewInstance* pInstance= queue.at(i).m_pInstance;
+		if (pInstance == pCurInstance) continue;
+		pCurInstance= pInstance;
+		if (pInstance->isVisible() != m_IsInShowSate) continue;
+
+		if (pInstance->viewableFlag() == GLC_3DViewInstance::NoViewable)
+		{
+			// Instances entering the frustum are assumed visible
+			pInstance->setOccluded(false);
+		}
+		else
+		{
+			m_OcclusionCandidates.append(pInstance);
+		}
+	}
+
+	// The near plane can cut the bounding box of an instance close to the eye
+	const double margin= 2.0 * m_pViewport->nearClippingPlaneDist();
+	m_pOcclusionCuller->issueQueries(m_OcclusionCandidates, m_pViewport->cameraHandle()->eye(), margin);
+}
+
+bool GLC_3DViewCollection::softwareOcclusionCullingIsUsable()
+{
+	if (!GLC_State::isSoftwareOcclusionCullingActivated())
+	{
+		if (NULL != m_pSoftwareOcclusionCuller)
+		{
+			delete m_pSoftwareOcclusionCuller;
+			m_pSoftwareOcclusionCuller= NULL;
+			m_OccluderMeshes.clear();
+			PointerViewInstanceHash::iterator iEntry= m_MainInstances.begin();
+			while (iEntry != m_MainInstances.constEnd())
+			{
+				iEntry.value()->setOccluded(false);
+				++iEntry;
+			}
+		}
+		return false;
+	}
+	if (GLC_State::isInSelectionMode() || (NULL == m_pViewport) || (m_pViewport->viewHSize() <= 0) || (m_pViewport->viewVSize() <= 0))
+	{
+		return false;
+	}
+
+	// The depth buffer has the aspect ratio of the viewport
+	const int height= qBound(1, (softwareDepthBufferWidth * m_pViewport->viewVSize()) / m_pViewport->viewHSize(), 4 * softwareDepthBufferWidth);
+	if (NULL == m_pSoftwareOcclusionCuller)
+	{
+		m_pSoftwareOcclusionCuller= new GLC_SoftwareOcclusionCuller(softwareDepthBufferWidth, height);
+	}
+	else if (m_pSoftwareOcclusionCuller->height() != height)
+	{
+		m_pSoftwareOcclusionCuller->setResolution(softwareDepthBufferWidth, height);
+	}
+	return true;
+}
+
+void GLC_3DViewCollection::cullSoftwareOccludedInstances()
+{
+	GLC_Context* pContext= GLC_ContextManager::instance()->currentContext();
+	m_pSoftwareOcclusionCuller->beginFrame(pContext->projectionMatrix() * pContext->modelViewMatrix());
+
+	// Opaque meshes instances which look large from the eye are occluders
+	const RenderQueue& queue= renderQueue(&m_MainInstances);
+	const GLC_Point3d eye(m_pViewport->cameraHandle()->eye());
+	const double nearDistance= m_pViewport->nearClippingPlaneDist();
+	m_Occluders.clear();
+	const int size= queue.size();
+	int index= 0;
+	while (index < size)
+	{
+		const int firstIndex= index;
+		GLC_3DViewInstance* pInstance= queue.at(index).m_pInstance;
+		bool isOccluder= (pInstance->viewableFlag() != GLC_3DViewInstance::NoViewable) && (pInstance->isVisible() == m_IsInShowSate)
+				&& (pInstance->renderPropertiesHandle()->renderingMode() == glc::NormalRenderMode)
+				&& (pInstance->renderPropertiesHandle()->polygonMode() == GL_FILL);
+		while ((index < size) && (queue.at(index).m_pInstance == pInstance))
+		{
+			GLC_Mesh* pMesh= queue.at(index).m_pMesh;
+			isOccluder= isOccluder && (NULL != pMesh) && !pMesh->hasTransparentMaterials();
+			++index;
+		}
+		if (!isOccluder) continue;
+
+		const GLC_BoundingBox boundingBox(pInstance->boundingBox());
+		const double distance= qMax(nearDistance, (boundingBox.center() - eye).length());
+		const double score= boundingBox.boundingSphereRadius() / distance;
+		if (score >= minimumOccluderScore)
+		{
+			Occluder occluder;
+			occluder.m_Score= score;
+			occluder.m_QueueIndex= firstIndex;
+			m_Occluders.append(occluder);
+		}
+	}
+
+	// Rasterize the largest occluders
+	const int occluderCount= qMin(m_Occluders.size(), maximumOccluderCount);
+	std::partial_sort(m_Occluders.begin(), m_Occluders.begin() + occluderCount, m_Occluders.end(), occluderScoreGreaterThan<Occluder>);
+	for (int i= 0; i < occluderCount; ++i)
+	{
+		index= m_Occluders.at(i).m_QueueIndex;
+		GLC_3DViewInstance* pInstance= queue.at(index).m_pInstance;
+		while ((index < size) && (queue.at(index).m_pInstance == pInstance))
+		{
+			const OccluderMesh& occluderMesh= occluderMeshOf(queue.at(index));
+			if (!occluderMesh.m_Indexes.isEmpty())
+			{
+				m_pSoftwareOcclusionCuller->addOccluder(occluderMesh.m_Positions.constData(), occluderMesh.m_Positions.size() / 3
+						, occluderMesh.m_Indexes.constData(), occluderMesh.m_Indexes.size(), pInstance->matrix());
+			}
+			++index;
+		}
+	}
+	m_pSoftwareOcclusionCuller->buildDepthPyramid();
+
+	// Test the bounding box of viewable instances
+	unsigned int occludedInstanceCount= 0;
+	GLC_3DViewInstance* pCurInstance= NULL;
+	for (int i= 0; i < size; ++i)
+	{
+		GLC_3DViewInstance* pInstance= queue.at(i).m_pInstance;
+		if (pInstance == pCurInstance) continue;
+		pCurInstance= pInstance;
+
+		bool isOccluded= false;
+		if ((pInstance->viewableFlag() != GLC_3DViewInstance::NoViewable) && (pInstance->isVisible() == m_IsInShowSate))
+		{
+			isOccluded= m_pSoftwareOcclusionCuller->isOccluded(pInstance->boundingBox());
+			if (isOccluded) ++occludedInstanceCount;
+		}
+		pInstance->setOccluded(isOccluded);
+	}
+	GLC_RenderStatistics::addOccludedInstances(occludedInstanceCount);
+}
+
+const GLC_3DViewCollection::OccluderMesh& GLC_3DViewCollection::occluderMeshOf(const RenderQueueItem& item)
+{
+	GLC_Mesh* pMesh= item.m_pMesh;
+	QHash<GLC_uint, OccluderMesh>::iterator iMesh= m_OccluderMeshes.find(pMesh->id());
+	if (iMesh != m_OccluderMeshes.end()) return iMesh.value();
+
+	OccluderMesh& occluderMesh= m_OccluderMeshes[pMesh->id()];
+	occluderMesh.m_BodiesRevision= item.m_pInstance->bodiesRevision();
+	const int lod= pMesh->lodCount() - 1;
+	if ((lod >= 0) && (pMesh->faceCount(lod) <= maximumOccluderTriangleCount))
+	{
+		const QList<GLC_uint> materialIds(pMesh->materialIds());
+		const int materialCount= materialIds.size();
+		for (int i= 0; i < materialCount; ++i)
+		{
+			const GLC_uint materialId= materialIds.at(i);
+			if (pMesh->lodContainsMaterial(lod, materialId))
+			{
+				occluderMesh.m_Indexes+= pMesh->getEquivalentTrianglesStripsFansIndex(lod, materialId).toVector();
+			}
+		}
+		if (!occluderMesh.m_Indexes.isEmpty()) occluderMesh.m_Positions= pMesh->positionVector();
+	}
+	return occluderMesh;
+}
+
+void GLC_3DViewCollection::pruneOccluderMeshes(const RenderQueue& queue)
+{
+	QHash<GLC_uint, int> bodiesRevisionOfMesh;
+	const int size= queue.size();
+	for (int i= 0; i < size; ++i)
+	{
+		const RenderQueueItem& item= queue.at(i);
+		if (NULL != item.m_pMesh) bodiesRevisionOfMesh.insert(item.m_pMesh->id(), item.m_pInstance->bodiesRevision());
+	}
+
+	// Meshes transformed in place keep their id
+	QHash<GLC_uint, OccluderMesh>::iterator iMesh= m_OccluderMeshes.begin();
+	while (iMesh != m_OccluderMeshes.end())
+	{
+		QHash<GLC_uint, int>::const_iterator iRevision= bodiesRevisionOfMesh.constFind(iMesh.key());
+		if ((iRevision == bodiesRevisionOfMesh.constEnd()) || (iRevision.value() != iMesh.value().m_BodiesRevision))
+		{
+			iMesh= m_OccluderMeshes.erase(iMesh);
+		}
+		else
+		{
+			++iMesh;
+		}
+	}
+}
+
+bool GLC_3DViewCollection::glDrawOitInstancesOf(PointerViewInstanceHash* pHash)
+{
+	GLC_OitRenderer* pOitRenderer= GLC_ContextManager::instance()->currentContext()->oitRenderer();
+	if (!pOitRenderer->begin()) return false;
+
+	try
+	{
+		glDrawQueueOf(pHash, glc::TransparentRenderFlag, false);
+	}
+	catch (...)
+	{
+		pOitRenderer->end();
+		throw;
+	}
+	pOitRenderer->end();
+
+	return true;
+}
+
+void GLC_3DViewCollection::glDrawStateSortedInstancesOf(PointerViewInstanceHash* pHash, glc::RenderFlag renderFlag)
+{
+	const RenderQueue& queue= renderQueue(pHash);
+	const bool isTransparent= (renderFlag == glc::TransparentRenderFlag);
+	const bool useInstancing= instancingIsUsable();
+	m_SortedDrawItems.clear();
+
+	// Gather primitive groups of sortable meshes, draw the other bodies at once
+	GLC_3DViewInstance* pCurInstance= NULL;
+	bool instanceIsDrawn= false;
+	bool instanceIsSortable= false;
+	bool instanceIsRendering= false;
+	bool instanceHasSortedBody= false;
+	int bodyCount= 0;
+	unsigned int sortedBodyCount= 0;
+	unsigned int sortedInstanceCount= 0;
+	const int size= queue.size();
+	for (int i= 0; i < size; ++i)
+	{
+		const RenderQueueItem& item= queue.at(i);
+		if (item.m_pInstance != pCurInstance)
+		{
+			if (instanceIsRendering) pCurInstance->endRender();
+			instanceIsRendering= false;
+			instanceHasSortedBody= false;
+			pCurInstance= item.m_pInstance;
+			instanceIsDrawn= instanceIsDrawable(pCurInstance, renderFlag, false);
+			if (instanceIsDrawn)
+			{
+				bodyCount= pCurInstance->numberOfBody();
+				const GLC_RenderProperties* pRenderProperties= pCurInstance->renderPropertiesHandle();
+				instanceIsSortable= (pRenderProperties->renderingMode() == glc::NormalRenderMode) && !pRenderProperties->isSelected()
+						&& (!useInstancing || instanceIsInstanciable(pCurInstance));
+			}
+		}
+		if (!instanceIsDrawn || (item.m_BodyIndex >= bodyCount)) continue;
+
+		GLC_Mesh* pMesh= item.m_pMesh;
+		const bool bodyIsSortable= instanceIsSortable && (NULL != pMesh) && (pCurInstance->geomAt(item.m_BodyIndex) == pMesh)
+				&& !pMesh->typeIsWire() && !pMesh->ColorPearVertexIsAcivated() && pMesh->hasMaterial();
+		if (bodyIsSortable)
+		{
+			const int lodValue= bodyLodValueOf(item);
+			if (lodValue < 0) continue;
+			pMesh->setCurrentLod(lodValue);
+			const int lod= pMesh->currentLodIndex();
+			const GLC_Mesh::LodPrimitiveGroups* pGroups= pMesh->lodPrimitiveGroups(lod);
+			if (NULL == pGroups) continue;
+
+			GLC_Mesh::LodPrimitiveGroups::const_iterator iGroup= pGroups->constBegin();
+			while (pGroups->constEnd() != iGroup)
+			{
+				GLC_Material* pMaterial= pMesh->material(iGroup.key());
+				if (pMaterial->isTransparent() == isTransparent)
+				{
+					SortedDrawItem drawItem;
+					drawItem.m_pMaterial= pMaterial;
+					drawItem.m_pMesh= pMesh;
+					drawItem.m_Lod= lod;
+					drawItem.m_pInstance= pCurInstance;
+					drawItem.m_pGroup= iGroup.value();
+					m_SortedDrawItems.append(drawItem);
+				}
+				++iGroup;
+			}
+			++sortedBodyCount;
+			if (!instanceHasSortedBody)
+			{
+				instanceHasSortedBody= true;
+				++sortedInstanceCount;
+			}
+			GLC_RenderStatistics::addBodies(1);
+			GLC_RenderStatistics::addTriangles(pMesh->faceCount(lod));
+		}
+		else
+		{
+			if (!instanceIsRendering)
+			{
+				pCurInstance->beginRender(renderFlag);
+				instanceIsRendering= true;
+			}
+			pCurInstance->renderBodyAtLod(item.m_BodyIndex, bodyLodValueOf(item));
+		}
+	}
+	if (instanceIsRendering) pCurInstance->endRender();
+
+	if (m_SortedDrawItems.isEmpty()) return;
+
+	GLC_Context* pContext= GLC_ContextManager::instance()->currentContext();
+	if (useInstancing && pContext->useInstancedShader())
+	{
+		glDrawInstancedItems(pContext);
+		pContext->unuseInstancedShader();
+		return;
+	}
+
+	std::sort(m_SortedDrawItems.begin(), m_SortedDrawItems.end(), drawItemLessThan<SortedDrawItem>);
+
+	// Draw primitive groups, state changes are done only when needed
+	pContext->glcEnableLighting(true);
+	GLC_Material* pCurrentMaterial= NULL;
+	GLC_Mesh* pCurrentMesh= NULL;
+	int currentLod= -1;
+	pCurInstance= NULL;
+	unsigned int materialChangeCount= 0;
+	unsigned int meshChangeCount= 0;
+	unsigned int instanceChangeCount= 0;
+	const int itemCount= m_SortedDrawItems.size();
+	for (int i= 0; i < itemCount; ++i)
+	{
+		const SortedDrawItem& drawItem= m_SortedDrawItems.at(i);
+		if (drawItem.m_pMaterial != pCurrentMaterial)
+		{
+			pCurrentMaterial= drawItem.m_pMaterial;
+			pCurrentMaterial->glExecute();
+			++materialChangeCount;
+		}
+		if ((drawItem.m_pMesh != pCurrentMesh) || (drawItem.m_Lod != currentLod))
+		{
+			if (NULL != pCurrentMesh) pCurrentMesh->endPrimitiveGroupsRendering();
+			pCurrentMesh= drawItem.m_pMesh;
+			currentLod= drawItem.m_Lod;
+			pCurrentMesh->beginPrimitiveGroupsRendering(currentLod);
+			++meshChangeCount;
+		}
+		if (drawItem.m_pInstance != pCurInstance)
+		{
+			if (NULL != pCurInstance) pCurInstance->endRender();
+			pCurInstance= drawItem.m_pInstance;
+			pCurInstance->beginRender(renderFlag);
+			++instanceChangeCount;
+		}
+		pCurrentMesh->drawPrimitiveGroup(drawItem.m_pGroup);
+	}
+	pCurInstance->endRender();
+	pCurrentMesh->endPrimitiveGroupsRendering();
+
+	// Instance by instance, each group executes its material and each body binds its VBO
+	const unsigned int unsortedChangeCount= static_cast<unsigned int>(itemCount) + sortedBodyCount + sortedInstanceCount;
+	const unsigned int sortedChangeCount= materialChangeCount + meshChangeCount + instanceChangeCount;
+	if (unsortedChangeCount > sortedChangeCount)
+	{
+		GLC_RenderStatistics::addSavedStateChanges(unsortedChangeCount - sortedChangeCount);
+	}
+}
+
+void GLC_3DViewCollection::glDrawInstancedItems(GLC_Context* pContext)
+{
+	std::sort(m_SortedDrawItems.begin(), m_SortedDrawItems.end(), instancedDrawItemLessThan<SortedDrawItem>);
+
+	// Upload instance matrices in draw order, the instances of a primitive group are contiguous
+	const int itemCount= m_SortedDrawItems.size();
+	m_InstanceMatrices.resize(itemCount * 16);
+	GLfloat* pMatrices= m_InstanceMatrices.data();
+	for (int i= 0; i < itemCount; ++i)
+	{
+		const double* pData= m_SortedDrawItems.at(i).m_pInstance->matrix().getData();
+		for (int j= 0; j < 16; ++j)
+		{
+			pMatrices[j]= static_cast<GLfloat>(pData[j]);
+		}
+		pMatrices+= 16;
+	}
+	pContext->glcSetInstanceMatrices(m_InstanceMatrices);
+
+	// Draw each primitive group once for all its instances
+	pContext->glcEnableLighting(true);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	GLC_Material* pCurrentMaterial= NULL;
+	GLC_Mesh* pCurrentMesh= NULL;
+	int currentLod= -1;
+	unsigned int drawCount= 0;
+	int first= 0;
+	while (first < itemCount)
+	{
+		const SortedDrawItem& drawItem= m_SortedDrawItems.at(first);
+		int last= first + 1;
+		while ((last < itemCount) && (m_SortedDrawItems.at(last).m_pGroup == drawItem.m_pGroup)) ++last;
+
+		if (drawItem.m_pMaterial != pCurrentMaterial)
+		{
+			pCurrentMaterial= drawItem.m_pMaterial;
+			pCurrentMaterial->glExecute();
+		}
+		if ((drawItem.m_pMesh != pCurrentMesh) || (drawItem.m_Lod != currentLod))
+		{
+			if (NULL != pCurrentMesh) pCurrentMesh->endPrimitiveGroupsRendering();
+			pCurrentMesh= drawItem.m_pMesh;
+			currentLod= drawItem.m_Lod;
+			pCurrentMesh->beginPrimitiveGroupsRendering(currentLod);
+		}
+		pContext->glcUseInstanceMatrixPointer(first);
+		pCurrentMesh->drawPrimitiveGroupInstanced(drawItem.m_pGroup, last - first);
+		++drawCount;
+		first= last;
+	}
+	pContext->glcDisableInstanceMatrixClientState();
+	pCurrentMesh->endPrimitiveGroupsRendering();
+
+	GLC_RenderStatistics::addSavedDrawCalls(static_cast<unsigned int>(itemCount) - drawCount);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Render queue Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_3DViewCollection::appendToRenderQueue(GroupRenderQueue* pGroupQueue, GLC_3DViewInstance* pInstance)
+{
+	// The revision is read first, so that bodies changed meanwhile are seen by the next update
+	RenderQueueInstance queueInstance;
+	queueInstance.m_pInstance= pInstance;
+	queueInstance.m_BodiesRevision= pInstance->bodiesRevision();
+	pGroupQueue->m_Instances.append(queueInstance);
+
+	const int bodyCount= pInstance->numberOfBody();
+	for (int i= 0; i < bodyCount; ++i)
+	{
+		RenderQueueItem item;
+		item.m_pInstance= pInstance;
+		item.m_pGeometry= pInstance->geomAt(i);
+		item.m_pMesh= dynamic_cast<GLC_Mesh*>(item.m_pGeometry);
+		item.m_BodyIndex= i;
+		item.m_PreparedLod= lodNotPrepared;
+		pGroupQueue->m_Queue.append(item);
+	}
+}
+
+void GLC_3DViewCollection::addToRenderQueueOf(const PointerViewInstanceHash* pHash, GLC_3DViewInstance* pInstance)
+{
+	QHash<const PointerViewInstanceHash*, GroupRenderQueue>::iterator iQueue= m_RenderQueues.find(pHash);
+	if (m_RenderQueues.end() != iQueue)
+	{
+		appendToRenderQueue(&(iQueue.value()), pInstance);
+	}
+}
+
+void GLC_3DViewCollection::removeFromRenderQueueOf(const PointerViewInstanceHash* pHash, GLC_3DViewInstance* pInstance)
+{
+	QHash<const PointerViewInstanceHash*, GroupRenderQueue>::iterator iQueue= m_RenderQueues.find(pHash);
+	if (m_RenderQueues.end() == iQueue) return;
+
+	// Bodies of an instance are contiguous in the queue
+	RenderQueue& queue= iQueue.value().m_Queue;
+	const int size= queue.size();
+	int begin= 0;
+	while ((begin < size) && (queue.at(begin).m_pInstance != pInstance)) ++begin;
+	int end= begin;
+	while ((end < size) && (queue.at(end).m_pInstance == pInstance)) ++end;
+	if (end > begin) queue.remove(begin, end - begin);
+
+	// The order of the instances doesn't matter
+	QVector<RenderQueueInstance>& instances= iQueue.value().m_Instances;
+	const int instanceCount= instances.size();
+	for (int i= 0; i < instanceCount; ++i)
+	{
+		if (instances.at(i).m_pInstance == pInstance)
+		{
+			instances[i]= instances.last();
+			instances.removeLast();
+			break;
+		}
+	}
+}
+
+void GLC_3DViewCollection::updateRenderQueueOf(const PointerViewInstanceHash* pHash)
+{
+	QHash<const PointerViewInstanceHash*, GroupRenderQueue>::iterator iQueue= m_RenderQueues.find(pHash);
+	if (m_RenderQueues.end() == iQueue) return;
+
+	const QVector<RenderQueueInstance>& instances= iQueue.value().m_Instances;
+	const int instanceCount= instances.size();
+	for (int i= 0; i < instanceCount; ++i)
+	{
+		const RenderQueueInstance& queueInstance= instances.at(i);
+		if (queueInstance.m_pInstance->bodiesRevision() != queueInstance.m_BodiesRevision)
+		{
+			// The queue may point to deleted geometries
+			m_RenderQueues.erase(iQueue);
+			return;
+		}
+	}
+}
+
+void GLC_3DViewCollection::updateRenderQueues()
+{
+	const QList<const PointerViewInstanceHash*> hashList(m_RenderQueues.keys());
+	const int hashCount= hashList.size();
+	for (int i= 0; i < hashCount; ++i)
+	{
+		updateRenderQueueOf(hashList.at(i));
+	}
+}
+
+int GLC_3DViewCollection::bodyLodValueOf(const RenderQueueItem& item)
+{
+	if (m_IsFramePrepared && (lodNotPrepared != item.m_PreparedLod))
+	{
+		return item.m_PreparedLod;
+	}
+	else
+	{
+		return item.m_pInstance->bodyLodValue(item.m_BodyIndex, m_UseLod, m_pViewport);
+	}
+}
+
+void GLC_3DViewCollection::prepareChunk(const FramePreparationChunk& chunk)
+{
+	RenderQueueItem* pItems= chunk.m_pItems;
+	int i= chunk.m_Begin;
+	// Skip the bodies of the instance handled by the previous chunk
+	while ((i > 0) && (i < chunk.m_End) && (pItems[i].m_pInstance == pItems[i - 1].m_pInstance)) ++i;
+
+	// Bodies of the last instance are handled even after the end of the chunk
+	GLC_3DViewInstance* pCurInstance= NULL;
+	bool instanceIsViewable= false;
+	int bodyCount= 0;
+	while ((i < chunk.m_Size) && ((i < chunk.m_End) || (pItems[i].m_pInstance == pCurInstance)))
+	{
+		RenderQueueItem& item= pItems[i];
+		if (item.m_pInstance != pCurInstance)
+		{
+			pCurInstance= item.m_pInstance;
+			instanceIsViewable= (pCurInstance->viewableFlag() != GLC_3DViewInstance::NoViewable) && (pCurInstance->isVisible() == m_IsInShowSate);
+			bodyCount= pCurInstance->numberOfBody();
+		}
+		// Bounding boxes computed on demand can be shared by several instances, their LOD is chosen while drawing
+		if (instanceIsViewable && (item.m_BodyIndex < bodyCount) && pCurInstance->geomAt(item.m_BodyIndex)->boundingBoxIsValid())
+		{
+			item.m_PreparedLod= pCurInstance->bodyLodValue(item.m_BodyIndex, m_UseLod, m_pViewport);
+		}
+		else
+		{
+			item.m_PreparedLod= lodNotPrepared;
+		}
+		++i;
+	}
+}
+
+void GLC_3DViewCollection::applyTriangleBudget(const QList<PointerViewInstanceHash*>& hashList)
+{
+	// Count the triangles of the prepared LOD and gather the bodies which can be degraded
+	const GLC_Point3d eye(m_pViewport->cameraHandle()->eye());
+	unsigned int triangleCount= 0;
+	m_TriangleBudgetItems.clear();
+	const int hashCount= hashList.size();
+	for (int i= 0; i < hashCount; ++i)
+	{
+		PointerViewInstanceHash* pHash= hashList.at(i);
+		if (pHash->isEmpty()) continue;
+		RenderQueue& queue= m_RenderQueues[pHash].m_Queue;
+		RenderQueueItem* pItems= queue.data();
+		const int size= queue.size();
+		GLC_3DViewInstance* pCurInstance= NULL;
+		quint32 key= 0;
+		for (int index= 0; index < size; ++index)
+		{
+			RenderQueueItem& item= pItems[index];
+			if ((NULL == item.m_pMesh) || (item.m_PreparedLod < 0)) continue;
+			const int lod= item.m_pMesh->lodIndexOf(item.m_PreparedLod);
+			triangleCount+= item.m_pMesh->faceCount(lod);
+			if (lod >= (item.m_pMesh->lodCount() - 1)) continue;
+
+			if (item.m_pInstance != pCurInstance)
+			{
+				pCurInstance= item.m_pInstance;
+				// Farthest first
+				key= ~depthSortKey(static_cast<float>((pCurInstance->boundingBox().center() - eye).length()));
+			}
+			TriangleBudgetItem budgetItem;
+			budgetItem.m_Key= key;
+			budgetItem.m_pItem= &item;
+			m_TriangleBudgetItems.append(budgetItem);
+		}
+	}
+
+	const unsigned int triangleBudget= m_pViewport->triangleBudget();
+	if (triangleCount <= triangleBudget) return;
+
+	radixSort(&m_TriangleBudgetItems, &m_TriangleBudgetBuffer);
+	const int itemCount= m_TriangleBudgetItems.size();
+	for (int i= 0; (i < itemCount) && (triangleCount > triangleBudget); ++i)
+	{
+		RenderQueueItem* pItem= m_TriangleBudgetItems.at(i).m_pItem;
+		GLC_Mesh* pMesh= pItem->m_pMesh;
+		const int coarsestLod= pMesh->lodCount() - 1;
+		const unsigned int preparedTriangleCount= pMesh->faceCount(pMesh->lodIndexOf(pItem->m_PreparedLod));
+		const unsigned int coarsestTriangleCount= pMesh->faceCount(coarsestLod);
+		if (coarsestTriangleCount < preparedTriangleCount)
+		{
+			triangleCount-= preparedTriangleCount - coarsestTriangleCount;
+			pItem->m_PreparedLod= pMesh->lodValueOf(coarsestLod);
+		}
+	}
+}
+
+void GLC_3DViewCollection::prepareChunks()
+{
+	const int chunkCount= m_FramePreparationChunks.size();
+	int index= m_NextFramePreparationChunk.fetchAndAddRelaxed(1);
+	while (index < chunkCount)
+	{
+		prepareChunk(m_FramePreparationChunks.at(index));
+		index= m_NextFramePreparationChunk.fetchAndAddRelaxed(1);
+	}
+}
+
+const GLC_3DViewCollection::RenderQueue& GLC_3DViewCollection::renderQueue(const PointerViewInstanceHash* pHash)
+{
+	QHash<const PointerViewInstanceHash*, GroupRenderQueue>::iterator iQueue= m_RenderQueues.find(pHash);
+	if (m_RenderQueues.end() == iQueue)
+	{
+		iQueue= m_RenderQueues.insert(pHash, GroupRenderQueue());
+		GroupRenderQueue& groupQueue= iQueue.value();
+		groupQueue.m_Queue.reserve(pHash->size());
+		groupQueue.m_Instances.reserve(pHash->size());
+		PointerViewInstanceHash::const_iterator iEntry= pHash->constBegin();
+		while (pHash->constEnd() != iEntry)
+		{
+			appendToRenderQueue(&groupQueue, iEntry.value());
+			++iEntry;
+		}
+		if ((pHash == &m_MainInstances) && !m_OccluderMeshes.isEmpty()) pruneOccluderMeshes(groupQueue.m_Queue);
+	}
+	return iQueue.value().m_Queue;
+}
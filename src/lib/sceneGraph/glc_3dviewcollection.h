@@ -27,6 +27,9 @@
 
 
 #include <QHash>
+#include <QVector>
+#include <QAtomicInt>
+#include <QSet>
 #include "glc_3dviewinstance.h"
 #include "../glc_global.h"
 #include "../viewport/glc_frustum.h"
@@ -34,7 +37,12 @@
 #include "../glc_config.h"
 
 class GLC_SpacePartitioning;
+class GLC_Context;
 class GLC_Material;
+class GLC_Mesh;
+class GLC_OcclusionCuller;
+class GLC_SoftwareOcclusionCuller;
+class GLC_PrimitiveGroup;
 class GLC_Shader;
 class GLC_Viewport;
 
@@ -57,6 +65,15 @@ typedef QHash<GLC_uint, GLC_uint> ShaderIdToInstancesId;
 /*! An GLC_3DViewCollection contains  :
  * 		- A hash table containing GLC_3DViewInstance Class
  * 		- A hash table use to associate shader with GLC_3DViewInstance
+ * 		- A render queue of instance's bodies for each group, rebuilt
+ * 		  when the content of the group change
+ *
+ * If GLC_State::isStateSortingActivated(), meshes of the main and shading groups
+ * are drawn by primitive groups sorted by material and VBO to avoid redundant
+ * state changes.
+ *
+ * If GLC_State::isSoftwareOcclusionCullingActivated(), the largest opaque instances
+ * of the main group are rasterized on the CPU and instances hidden by them are not drawn.
  */
 //////////////////////////////////////////////////////////////////////
 
@@ -103,6 +120,11 @@ public:
 	//! Return all viewable GLC_3DViewInstance from the collection
 	QList<GLC_3DViewInstance*> viewableInstancesHandle();
 
+	//! Return the id of the viewable instances inside or intersecting the given frustum
+	/*! If fullyInside is true, only instances with a bounding box inside the frustum are returned.
+	 *  Nothing is rendered, the space partitioning is used if it is in use*/
+	QSet<GLC_uint> instancesInsideFrustum(const GLC_Frustum& frustum, bool fullyInside= false);
+
 	//! Return a GLC_3DViewInstance from collection
 	/*! If the element is not found in collection a empty node is return*/
 	GLC_3DViewInstance* instanceHandle(GLC_uint Key);
@@ -259,6 +281,21 @@ public:
     //! Update space partitionning
     void updateSpacePartitionning();
 
+	//! Update the space partitioning of the instance of the given key after a change of its matrix
+	void updateInstanceSpacePartitioning(GLC_uint key);
+
+	//! Prepare the next frame of this collection
+	/*! Update the instance viewable state, and if parallel frame preparation is activated
+	 *  choose the LOD of all viewable bodies with several threads.
+	 *  If the attached viewport has a triangle budget, the LOD are also chosen and the farthest
+	 *  bodies use their coarsest LOD until the budget is reached.
+	 *  The chosen LOD are used until endFrame() is called*/
+	void prepareFrame();
+
+	//! Discard the LOD chosen by prepareFrame()
+	inline void endFrame()
+	{m_IsFramePrepared= false;}
+
 	//! Set the attached viewport of this collection
 	inline void setAttachedViewport(GLC_Viewport* pViewport)
 	{m_pViewport= pViewport;}
@@ -270,6 +307,15 @@ public:
 	//! Set VBO usage
 	void setVboUsage(bool usage);
 
+	//! Invalidate the render queue of all groups
+	/*! A render queue is invalidated automatically when the bodies of the 3D rep of one of its
+	 *  instances are added, removed or transformed, see GLC_3DRep::bodiesRevision()*/
+	inline void invalidateRenderQueue()
+	{
+		m_RenderQueues.clear();
+		m_OccluderMeshes.clear();
+	}
+
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -299,7 +345,171 @@ private:
 	void glDraw(GLC_uint groupID, glc::RenderFlag renderFlag);
 
 	//! Draw instances of a PointerViewInstanceHash
-	inline void glDrawInstancesOf(PointerViewInstanceHash*, glc::RenderFlag);
+	void glDrawInstancesOf(PointerViewInstanceHash*, glc::RenderFlag);
+
+	//! Draw bodies of the render queue of a PointerViewInstanceHash in queue order
+	void glDrawQueueOf(PointerViewInstanceHash*, glc::RenderFlag, bool forceDisplay);
+
+	//! Draw transparent instances of a PointerViewInstanceHash from back to front
+	void glDrawDepthSortedInstancesOf(PointerViewInstanceHash*);
+
+	//! Draw transparent instances of a PointerViewInstanceHash with order independent transparency
+	/*! Return false if order independent transparency can't be used*/
+	bool glDrawOitInstancesOf(PointerViewInstanceHash*);
+
+	//! Draw instances of a PointerViewInstanceHash sorted by material and VBO
+	void glDrawStateSortedInstancesOf(PointerViewInstanceHash*, glc::RenderFlag);
+
+	//! Draw the gathered primitive groups with one instanced draw for each primitive group
+	/*! The instanced shader must be used*/
+	void glDrawInstancedItems(GLC_Context* pContext);
+
+	//! Return true if occluded instances can be culled, create or delete the occlusion culler if needed
+	bool occlusionCullingIsUsable();
+
+	//! Issue the occlusion queries of the viewable instances of the main group
+	void glIssueOcclusionQueries();
+
+	//! Return true if the software occlusion culling can be used, create or delete the culler if needed
+	bool softwareOcclusionCullingIsUsable();
+
+	//! Rasterize the occluders of the main group and set the occluded state of its viewable instances
+	void cullSoftwareOccludedInstances();
+
+	//! Return true if the given instance have to be drawn with the given render flag
+	inline bool instanceIsDrawable(GLC_3DViewInstance* pInstance, glc::RenderFlag renderFlag, bool forceDisplay) const;
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Render queue Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+private:
+	//! A body of an instance to draw
+	/*! The matrix is read from the instance, the LOD is chosen by prepareFrame(),
+	 *  materials belong to the primitive groups of the body and render flags to the
+	 *  drawing pass, so only the body and its prepared LOD are kept*/
+	struct RenderQueueItem
+	{
+		GLC_3DViewInstance* m_pInstance;
+		GLC_Geometry* m_pGeometry;
+		GLC_Mesh* m_pMesh;
+		int m_BodyIndex;
+		int m_PreparedLod;
+	};
+
+	//! A primitive group to draw with state sorting
+	struct SortedDrawItem
+	{
+		GLC_Material* m_pMaterial;
+		GLC_Mesh* m_pMesh;
+		int m_Lod;
+		GLC_3DViewInstance* m_pInstance;
+		GLC_PrimitiveGroup* m_pGroup;
+	};
+
+	//! A transparent instance to sort by depth
+	struct DepthSortItem
+	{
+		quint32 m_Key;
+		int m_QueueIndex;
+	};
+
+	//! Contiguous list of bodies to draw
+	typedef QVector<RenderQueueItem> RenderQueue;
+
+	//! An instance of a render queue and the revision of its bodies when its items were built
+	struct RenderQueueInstance
+	{
+		GLC_3DViewInstance* m_pInstance;
+		int m_BodiesRevision;
+	};
+
+	//! The render queue of a group and the instances it was built from
+	/*! Instances without body have no item but are kept to know when they are loaded*/
+	struct GroupRenderQueue
+	{
+		RenderQueue m_Queue;
+		QVector<RenderQueueInstance> m_Instances;
+	};
+
+	//! The triangles of the coarsest LOD of a mesh, used as occluder
+	struct OccluderMesh
+	{
+		GLfloatVector m_Positions;
+		QVector<GLuint> m_Indexes;
+		int m_BodiesRevision;
+	};
+
+	//! An instance which can hide other instances
+	struct Occluder
+	{
+		double m_Score;
+		int m_QueueIndex;
+	};
+
+	//! Return the occluder mesh of the given mesh, build it if needed
+	/*! The occluder mesh is empty if the mesh is too complex to be an occluder*/
+	const OccluderMesh& occluderMeshOf(const RenderQueueItem& item);
+
+	//! Remove the occluder meshes which are not in the given queue or whose bodies changed
+	void pruneOccluderMeshes(const RenderQueue& queue);
+
+	//! Return the render queue of the given group, build it if needed
+	const RenderQueue& renderQueue(const PointerViewInstanceHash* pHash);
+
+	//! Invalidate the render queue of the given group
+	inline void invalidateRenderQueueOf(const PointerViewInstanceHash* pHash)
+	{m_RenderQueues.remove(pHash);}
+
+	//! Append the bodies of the given instance to the given render queue
+	static void appendToRenderQueue(GroupRenderQueue* pGroupQueue, GLC_3DViewInstance* pInstance);
+
+	//! Add the given instance to the render queue of the given group if it is built
+	void addToRenderQueueOf(const PointerViewInstanceHash* pHash, GLC_3DViewInstance* pInstance);
+
+	//! Remove the given instance from the render queue of the given group if it is built
+	void removeFromRenderQueueOf(const PointerViewInstanceHash* pHash, GLC_3DViewInstance* pInstance);
+
+	//! Invalidate the render queue of the given group if bodies of its instances changed since it was built
+	/*! Must not be called while a reference on a render queue is kept*/
+	void updateRenderQueueOf(const PointerViewInstanceHash* pHash);
+
+	//! Invalidate the render queues of all groups whose instances bodies changed since they were built
+	/*! Must not be called while a reference on a render queue is kept*/
+	void updateRenderQueues();
+
+	//! Return the LOD value of the given render queue item, chosen by prepareFrame() if possible
+	int bodyLodValueOf(const RenderQueueItem& item);
+
+	//! A range of a render queue whose LOD are chosen by one thread
+	struct FramePreparationChunk
+	{
+		RenderQueueItem* m_pItems;
+		int m_Size;
+		int m_Begin;
+		int m_End;
+	};
+
+	//! Choose the LOD of the bodies of the given chunk
+	/*! Instances whose first body is in the chunk are handled by this chunk*/
+	void prepareChunk(const FramePreparationChunk& chunk);
+
+	//! Prepare chunks until all chunks are taken
+	void prepareChunks();
+
+	//! A prepared body to degrade to hold the triangle budget
+	struct TriangleBudgetItem
+	{
+		quint32 m_Key;
+		RenderQueueItem* m_pItem;
+	};
+
+	//! Use the coarsest LOD of the farthest prepared bodies of the given groups until the triangle budget is reached
+	void applyTriangleBudget(const QList<PointerViewInstanceHash*>& hashList);
+
+	class FramePreparationTask;
 
 //@}
 
@@ -340,70 +550,73 @@ private:
 	//! Viewable state
 	bool m_IsViewable;
 
+	//! Render queue of each group
+	QHash<const PointerViewInstanceHash*, GroupRenderQueue> m_RenderQueues;
+
+	//! Primitive groups to draw with state sorting, kept to avoid allocations
+	QVector<SortedDrawItem> m_SortedDrawItems;
+
+	//! Per instance model matrices of the instanced draws, kept to avoid allocations
+	QVector<GLfloat> m_InstanceMatrices;
+
+	//! Transparent instances sorted by depth and the sort buffer, kept to avoid allocations
+	QVector<DepthSortItem> m_DepthSortItems;
+	QVector<DepthSortItem> m_DepthSortBuffer;
+
+	//! Ranges of render queues to prepare, kept to avoid allocations
+	QVector<FramePreparationChunk> m_FramePreparationChunks;
+
+	//! Index of the next chunk to prepare
+	QAtomicInt m_NextFramePreparationChunk;
+
+	//! Flag to know if the LOD chosen by prepareFrame() are valid
+	bool m_IsFramePrepared;
+
+	//! Prepared bodies sorted from the farthest and the sort buffer, kept to avoid allocations
+	QVector<TriangleBudgetItem> m_TriangleBudgetItems;
+	QVector<TriangleBudgetItem> m_TriangleBudgetBuffer;
+
+	//! The occlusion culler of the main group, NULL if occlusion culling is not used
+	GLC_OcclusionCuller* m_pOcclusionCuller;
+
+	//! Instances tested by occlusion queries, kept to avoid allocations
+	QVector<GLC_3DViewInstance*> m_OcclusionCandidates;
+
+	//! Flag to know if occluded instances are not drawn
+	bool m_OccludedInstancesAreHidden;
+
+	//! The software occlusion culler of the main group, NULL if software occlusion culling is not used
+	GLC_SoftwareOcclusionCuller* m_pSoftwareOcclusionCuller;
+
+	//! Occluder meshes by mesh id
+	QHash<GLC_uint, OccluderMesh> m_OccluderMeshes;
+
+	//! Occluders of the frame, kept to avoid allocations
+	QVector<Occluder> m_Occluders;
+
 private:
     Q_DISABLE_COPY(GLC_3DViewCollection)
 };
 
-// Draw instances of a PointerViewInstanceHash
-void GLC_3DViewCollection::glDrawInstancesOf(PointerViewInstanceHash* pHash, glc::RenderFlag renderFlag)
+// Return true if the given instance have to be drawn with the given render flag
+bool GLC_3DViewCollection::instanceIsDrawable(GLC_3DViewInstance* pInstance, glc::RenderFlag renderFlag, bool forceDisplay) const
 {
-	bool forceDisplay= false;
-	if (GLC_State::isInSelectionMode())
+	if ((pInstance->viewableFlag() == GLC_3DViewInstance::NoViewable) || (pInstance->isVisible() != m_IsInShowSate)
+			|| (m_OccludedInstancesAreHidden && pInstance->isOccluded()))
 	{
-		forceDisplay= true;
+		return false;
 	}
-
-	PointerViewInstanceHash::iterator iEntry= pHash->begin();
-	// The current instance
-	GLC_3DViewInstance* pCurInstance;
-	if (forceDisplay)
+	else if (forceDisplay)
+	{
+		return true;
+	}
+	else if (renderFlag == glc::TransparentRenderFlag)
 	{
-		while (iEntry != pHash->constEnd())
-		{
-			pCurInstance= iEntry.value();
-			if ((pCurInstance->viewableFlag() != GLC_3DViewInstance::NoViewable) && (pCurInstance->isVisible() == m_IsInShowSate))
-			{
-				pCurInstance->render(renderFlag, m_UseLod, m_pViewport);
-			}
-			++iEntry;
-		}
+		return pInstance->hasTransparentMaterials();
 	}
 	else
 	{
-		if (!(renderFlag == glc::TransparentRenderFlag))
-		{
-			while (iEntry != pHash->constEnd())
-			{
-				pCurInstance= iEntry.value();
-				if ((pCurInstance->viewableFlag() != GLC_3DViewInstance::NoViewable) && (pCurInstance->isVisible() == m_IsInShowSate))
-				{
-					if (!pCurInstance->isTransparent() || pCurInstance->renderPropertiesHandle()->isSelected() || (renderFlag == glc::WireRenderFlag))
-					{
-						pCurInstance->render(renderFlag, m_UseLod, m_pViewport);
-					}
-				}
-
-				++iEntry;
-			}
-
-		}
-		else
-		{
-			while (iEntry != pHash->constEnd())
-			{
-				pCurInstance= iEntry.value();
-				if ((pCurInstance->viewableFlag() != GLC_3DViewInstance::NoViewable) && (pCurInstance->isVisible() == m_IsInShowSate))
-				{
-					if (pCurInstance->hasTransparentMaterials())
-					{
-						pCurInstance->render(renderFlag, m_UseLod, m_pViewport);
-					}
-				}
-
-				++iEntry;
-			}
-	   }
-
+		return !pInstance->isTransparent() || pInstance->renderPropertiesHandle()->isSelected() || (renderFlag == glc::WireRenderFlag);
 	}
 }
 
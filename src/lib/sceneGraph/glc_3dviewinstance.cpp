@@ -25,6 +25,7 @@
 #include "glc_3dviewinstance.h"
 #include "../shading/glc_selectionmaterial.h"
 #include "../viewport/glc_viewport.h"
+#include "../geometry/glc_mesh.h"
 #include <QMutexLocker>
 #include "../glc_state.h"
 
@@ -50,6 +51,8 @@ GLC_3DViewInstance::GLC_3DViewInstance()
 , m_DefaultLOD(m_GlobalDefaultLOD)
 , m_ViewableFlag(GLC_3DViewInstance::FullViewable)
 , m_ViewableGeomFlag()
+, m_IsOccluded(false)
+, m_BodyLodIndexes()
 {
 	// Encode Color Id
 	glc::encodeRgbId(m_Uid, m_colorId);
@@ -67,6 +70,8 @@ GLC_3DViewInstance::GLC_3DViewInstance(GLC_Geometry* pGeom)
 , m_DefaultLOD(m_GlobalDefaultLOD)
 , m_ViewableFlag(GLC_3DViewInstance::FullViewable)
 , m_ViewableGeomFlag()
+, m_IsOccluded(false)
+, m_BodyLodIndexes()
 {
 	// Encode Color Id
 	glc::encodeRgbId(m_Uid, m_colorId);
@@ -85,6 +90,8 @@ GLC_3DViewInstance::GLC_3DViewInstance(GLC_Geometry* pGeom, GLC_uint id)
 , m_DefaultLOD(m_GlobalDefaultLOD)
 , m_ViewableFlag(GLC_3DViewInstance::FullViewable)
 , m_ViewableGeomFlag()
+, m_IsOccluded(false)
+, m_BodyLodIndexes()
 {
 	// Encode Color Id
 	glc::encodeRgbId(m_Uid, m_colorId);
@@ -103,6 +110,8 @@ GLC_3DViewInstance::GLC_3DViewInstance(const GLC_3DRep& rep)
 , m_DefaultLOD(m_GlobalDefaultLOD)
 , m_ViewableFlag(GLC_3DViewInstance::FullViewable)
 , m_ViewableGeomFlag()
+, m_IsOccluded(false)
+, m_BodyLodIndexes()
 {
 	// Encode Color Id
 	glc::encodeRgbId(m_Uid, m_colorId);
@@ -120,6 +129,8 @@ GLC_3DViewInstance::GLC_3DViewInstance(const GLC_3DRep& rep, GLC_uint id)
 , m_DefaultLOD(m_GlobalDefaultLOD)
 , m_ViewableFlag(GLC_3DViewInstance::FullViewable)
 , m_ViewableGeomFlag()
+, m_IsOccluded(false)
+, m_BodyLodIndexes()
 {
 	// Encode Color Id
 	glc::encodeRgbId(m_Uid, m_colorId);
@@ -138,6 +149,8 @@ GLC_3DViewInstance::GLC_3DViewInstance(const GLC_3DViewInstance& inputNode)
 , m_DefaultLOD(inputNode.m_DefaultLOD)
 , m_ViewableFlag(inputNode.m_ViewableFlag)
 , m_ViewableGeomFlag(inputNode.m_ViewableGeomFlag)
+, m_IsOccluded(false)
+, m_BodyLodIndexes()
 {
 	// Encode Color Id
 	glc::encodeRgbId(m_Uid, m_colorId);
@@ -172,6 +185,8 @@ GLC_3DViewInstance& GLC_3DViewInstance::operator=(const GLC_3DViewInstance& inpu
 		m_DefaultLOD= inputNode.m_DefaultLOD;
 		m_ViewableFlag= inputNode.m_ViewableFlag;
 		m_ViewableGeomFlag= inputNode.m_ViewableGeomFlag;
+		m_IsOccluded= false;
+		m_BodyLodIndexes.clear();
 
 		//qDebug() << "GLC_3DViewInstance::operator= :ID = " << m_Uid;
 		//qDebug() << "Number of instance" << (*m_pNumberOfInstance);
@@ -318,8 +333,19 @@ void GLC_3DViewInstance::render(glc::RenderFlag renderFlag, bool useLod, GLC_Vie
 {
 	//qDebug() << "GLC_3DViewInstance::render render properties= " << m_RenderProperties.renderingMode();
 	if (m_3DRep.isEmpty()) return;
+
+	beginRender(renderFlag);
 	const int bodyCount= m_3DRep.numberOfBody();
+	for (int i= 0; i < bodyCount; ++i)
+	{
+		renderBody(i, useLod, pView);
+	}
+	endRender();
+}
 
+void GLC_3DViewInstance::beginRender(glc::RenderFlag renderFlag)
+{
+	const int bodyCount= m_3DRep.numberOfBody();
 	if (bodyCount != m_ViewableGeomFlag.size())
 	{
 		m_ViewableGeomFlag.fill(true, bodyCount);
@@ -328,8 +354,7 @@ void GLC_3DViewInstance::render(glc::RenderFlag renderFlag, bool useLod, GLC_Vie
 	m_RenderProperties.setRenderingFlag(renderFlag);
 
 	// Save current OpenGL Matrix
-    GLC_Context* pContext= GLC_ContextManager::instance()->currentContext();
-    pContext->glcPushMatrix();
+	GLC_ContextManager::instance()->currentContext()->glcPushMatrix();
 	OpenglVisProperties();
 
 	// Change front face orientation if this instance absolute matrix is indirect
@@ -341,56 +366,63 @@ void GLC_3DViewInstance::render(glc::RenderFlag renderFlag, bool useLod, GLC_Vie
 	{
 		glColor3ubv(m_colorId); // D'ont use Alpha component
 	}
+}
+
+void GLC_3DViewInstance::renderBody(int index, bool useLod, GLC_Viewport* pView)
+{
+	renderBodyAtLod(index, bodyLodValue(index, useLod, pView));
+}
 
+void GLC_3DViewInstance::renderBodyAtLod(int index, int lodValue)
+{
+	if (lodValue >= 0)
+	{
+		GLC_Geometry* pGeom= m_3DRep.geomAt(index);
+		pGeom->setCurrentLod(lodValue);
+		m_RenderProperties.setCurrentBodyIndex(index);
+		pGeom->render(m_RenderProperties);
+	}
+}
+
+int GLC_3DViewInstance::bodyLodValue(int index, bool useLod, GLC_Viewport* pView)
+{
+	if (m_3DRep.numberOfBody() != m_ViewableGeomFlag.size())
+	{
+		m_ViewableGeomFlag.fill(true, m_3DRep.numberOfBody());
+	}
+	if (!m_ViewableGeomFlag.at(index)) return -1;
+
+	const GLC_BoundingBox& boundingBox= m_3DRep.geomAt(index)->boundingBox();
 	if (useLod && (NULL != pView))
 	{
-		for (int i= 0; i < bodyCount; ++i)
-		{
-			if (m_ViewableGeomFlag.at(i))
-			{
-				const int lodValue= choseLod(m_3DRep.geomAt(i)->boundingBox(), pView, useLod);
-				if (lodValue <= 100)
-				{
-					m_3DRep.geomAt(i)->setCurrentLod(lodValue);
-					m_RenderProperties.setCurrentBodyIndex(i);
-					m_3DRep.geomAt(i)->render(m_RenderProperties);
-				}
-			}
-		}
+		const int lodValue= choseLod(boundingBox, pView, useLod);
+		if (lodValue > 100) return -1;
+		else if (GLC_State::isScreenSpaceErrorLodActivated()) return screenSpaceErrorLodValue(index, boundingBox, pView, lodValue);
+		else return lodValue;
 	}
 	else
 	{
-		for (int i= 0; i < bodyCount; ++i)
+		int lodValue= 0;
+		if (GLC_State::isPixelCullingActivated() && (NULL != pView))
 		{
-			if (m_ViewableGeomFlag.at(i))
-			{
-				int lodValue= 0;
-				if (GLC_State::isPixelCullingActivated() && (NULL != pView))
-				{
-					lodValue= choseLod(m_3DRep.geomAt(i)->boundingBox(), pView, useLod);
-				}
-
-				if (lodValue <= 100)
-				{
-					m_3DRep.geomAt(i)->setCurrentLod(m_DefaultLOD);
-					m_RenderProperties.setCurrentBodyIndex(i);
-					m_3DRep.geomAt(i)->render(m_RenderProperties);
-				}
-			}
+			lodValue= choseLod(boundingBox, pView, useLod);
 		}
+		return (lodValue <= 100) ? m_DefaultLOD : -1;
 	}
+}
+
+void GLC_3DViewInstance::endRender()
+{
 	// Restore OpenGL Matrix
-    pContext->glcPopMatrix();
+	GLC_ContextManager::instance()->currentContext()->glcPopMatrix();
 
 	// Restore front face orientation if this instance absolute matrix is indirect
 	if (m_AbsoluteMatrix.type() == GLC_Matrix4x4::Indirect)
 	{
 		glFrontFace(GL_CCW);
 	}
-
 }
 
-// Display the instance in Body selection mode
 void GLC_3DViewInstance::renderForBodySelection()
 {
 	Q_ASSERT(GLC_State::isInSelectionMode());
@@ -538,4 +570,42 @@ int GLC_3DViewInstance::choseLod(const GLC_BoundingBox& boundingBox, GLC_Viewpor
 	return static_cast<int>(ratio);
 }
 
+int GLC_3DViewInstance::screenSpaceErrorLodValue(int index, const GLC_BoundingBox& boundingBox, GLC_Viewport* pView, int lodValue)
+{
+	GLC_Mesh* pMesh= dynamic_cast<GLC_Mesh*>(m_3DRep.geomAt(index));
+	if ((NULL == pMesh) || (pMesh->lodCount() < 2)) return lodValue;
+
+	// Number of pixels of a geometry unit at the nearest point of the bounding sphere
+	const double scale= m_AbsoluteMatrix.scalingX();
+	double distance= 0.0;
+	if (pView->useOrtho())
+	{
+		distance= pView->cameraHandle()->distEyeTarget();
+	}
+	else
+	{
+		const GLC_Vector3d center(m_AbsoluteMatrix * boundingBox.center());
+		distance= (center - pView->cameraHandle()->eye()).length() - (boundingBox.boundingSphereRadius() * scale);
+	}
+	distance= qMax(distance, pView->nearClippingPlaneDist());
+	const double unitToPixel= scale * static_cast<double>(pView->viewVSize()) / (distance * pView->viewTangent());
+
+	const double maximumAccuracy= pView->screenSpaceError() / unitToPixel;
+	int lod= pMesh->coarsestLod(maximumAccuracy);
+
+	// A coarser LOD is used only if its error is clearly below the maximum error to avoid LOD popping
+	if (m_BodyLodIndexes.size() != m_3DRep.numberOfBody())
+	{
+		m_BodyLodIndexes.fill(-1, m_3DRep.numberOfBody());
+	}
+	const int previousLod= m_BodyLodIndexes.at(index);
+	if ((previousLod >= 0) && (lod > previousLod))
+	{
+		lod= qMax(previousLod, pMesh->coarsestLod(maximumAccuracy * pView->lodHysteresis()));
+	}
+	m_BodyLodIndexes[index]= lod;
+
+	return pMesh->lodValueOf(lod);
+}
+
 
@@ -169,6 +169,10 @@ public:
 	inline bool isGeomViewable(int index) const
 	{return m_ViewableGeomFlag.at(index);}
 
+	//! Return true if the instance was hidden by other instances in the last occlusion test
+	inline bool isOccluded() const
+	{return m_IsOccluded;}
+
 	//! Get number of faces
 	inline unsigned int numberOfFaces() const
 	{return m_3DRep.faceCount();}
@@ -197,6 +201,10 @@ public:
 	inline int numberOfBody() const
 	{return m_3DRep.numberOfBody();}
 
+	//! Return the revision of the bodies of the 3DRep
+	inline int bodiesRevision() const
+	{return m_3DRep.bodiesRevision();}
+
 	//! Return the global default LOD value
 	inline static int globalDefaultLod()
 	{
@@ -278,6 +286,10 @@ public:
 	inline void setGeomViewable(int index, bool flag)
 	{m_ViewableGeomFlag[index]= flag;}
 
+	//! Set the occluded flag
+	inline void setOccluded(bool flag)
+	{m_IsOccluded= flag;}
+
 
 	//! Set the global default LOD value
 	static void setGlobalDefaultLod(int);
@@ -299,6 +311,26 @@ public:
 	//! Display the instance
 	void render(glc::RenderFlag renderFlag= glc::ShadingFlag, bool useLod= false, GLC_Viewport* pView= NULL);
 
+	//! Prepare the rendering of the bodies of the instance
+	/*! Set the instance matrix and OpenGL properties, must be followed by endRender()*/
+	void beginRender(glc::RenderFlag renderFlag);
+
+	//! Display the body at the given index of the instance
+	/*! Must be called between beginRender() and endRender()*/
+	void renderBody(int index, bool useLod= false, GLC_Viewport* pView= NULL);
+
+	//! Display the body at the given index of the instance with the given LOD value
+	/*! Nothing is displayed if the LOD value is negative
+	 *  Must be called between beginRender() and endRender()*/
+	void renderBodyAtLod(int index, int lodValue);
+
+	//! Restore the OpenGL state changed by beginRender()
+	void endRender();
+
+	//! Return the LOD value used to display the body at the given index
+	/*! Return -1 if the body is not viewable or culled*/
+	int bodyLodValue(int index, bool useLod= false, GLC_Viewport* pView= NULL);
+
 	//! Display the instance in Body selection mode
 	void renderForBodySelection();
 
@@ -332,6 +364,10 @@ private:
 	//! Compute LOD
 	int choseLod(const GLC_BoundingBox&, GLC_Viewport*, bool);
 
+	//! Return the LOD value of the body at the given index from the screen space error of its LOD
+	/*! The given LOD value is returned if the body is not a mesh with several LOD*/
+	int screenSpaceErrorLodValue(int index, const GLC_BoundingBox&, GLC_Viewport*, int lodValue);
+
 //////////////////////////////////////////////////////////////////////
 // Private members
 //////////////////////////////////////////////////////////////////////
@@ -367,6 +403,12 @@ private:
 	//! vector of Flag to know if geometies of this instance are viewable
 	QVector<bool> m_ViewableGeomFlag;
 
+	//! Flag to know if the instance is hidden by other instances
+	bool m_IsOccluded;
+
+	//! LOD index of each body chosen from the screen space error, -1 if not chosen yet
+	QVector<int> m_BodyLodIndexes;
+
 	//! A Mutex
 	static QMutex m_Mutex;
 
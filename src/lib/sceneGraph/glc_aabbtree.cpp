@@ -0,0 +1,535 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_aabbtree.cpp implementation for the GLC_AabbTree class.
+
+#include "glc_aabbtree.h"
+#include "glc_3dviewcollection.h"
+
+#include <QtGlobal>
+
+namespace
+{
+// Return the surface area of the given bounding box
+inline double surfaceArea(const GLC_BoundingBox& bBox)
+{
+	const double x= bBox.xLength();
+	const double y= bBox.yLength();
+	const double z= bBox.zLength();
+	return 2.0 * ((x * y) + (y * z) + (z * x));
+}
+
+// Return the union of the two given bounding boxes
+inline GLC_BoundingBox unitedBox(const GLC_BoundingBox& box1, const GLC_BoundingBox& box2)
+{
+	GLC_BoundingBox subject(box1);
+	subject.combine(box2);
+	return subject;
+}
+
+// Return true if the first given bounding box contains the second one
+inline bool contains(const GLC_BoundingBox& box1, const GLC_BoundingBox& box2)
+{
+	const GLC_Point3d& lower1= box1.lowerCorner();
+	const GLC_Point3d& upper1= box1.upperCorner();
+	const GLC_Point3d& lower2= box2.lowerCorner();
+	const GLC_Point3d& upper2= box2.upperCorner();
+	return (lower1.x() <= lower2.x()) && (lower1.y() <= lower2.y()) && (lower1.z() <= lower2.z())
+		&& (upper2.x() <= upper1.x()) && (upper2.y() <= upper1.y()) && (upper2.z() <= upper1.z());
+}
+
+// Visitor collecting instances
+class InstanceCollector
+{
+public:
+	InstanceCollector(QList<GLC_3DViewInstance*>* pList, bool fullyInside= false)
+	: m_pList(pList)
+	, m_FullyInside(fullyInside)
+	{}
+
+	inline bool operator()(GLC_3DViewInstance* pInstance)
+	{
+		m_pList->append(pInstance);
+		return true;
+	}
+
+	inline bool operator()(GLC_3DViewInstance* pInstance, GLC_Frustum::Localisation localisation)
+	{
+		if (!m_FullyInside || (localisation == GLC_Frustum::InFrustum)) m_pList->append(pInstance);
+		return true;
+	}
+
+private:
+	QList<GLC_3DViewInstance*>* m_pList;
+	bool m_FullyInside;
+};
+
+// Visitor updating the viewable state of instances
+class ViewableUpdater
+{
+public:
+	ViewableUpdater(const GLC_Frustum& frustum)
+	: m_Frustum(frustum)
+	{}
+
+	bool operator()(GLC_3DViewInstance* pInstance, GLC_Frustum::Localisation localisation)
+	{
+		if (localisation == GLC_Frustum::OutFrustum)
+		{
+			pInstance->setViewable(GLC_3DViewInstance::NoViewable);
+		}
+		else if (localisation == GLC_Frustum::InFrustum)
+		{
+			pInstance->setViewable(GLC_3DViewInstance::FullViewable);
+		}
+		else
+		{
+			pInstance->setViewable(GLC_3DViewInstance::PartialViewable);
+			//Update the geometries viewable property of the instance
+			const GLC_Matrix4x4 instanceMat= pInstance->matrix();
+			const double scaling= instanceMat.scalingX();
+			const int size= pInstance->numberOfBody();
+			for (int i= 0; i < size; ++i)
+			{
+				const GLC_BoundingBox geomBox= pInstance->geomAt(i)->boundingBox();
+				const GLC_Point3d center(instanceMat * geomBox.center());
+				const double radius= geomBox.boundingSphereRadius() * scaling;
+				pInstance->setGeomViewable(i, m_Frustum.localizeSphere(center, radius) != GLC_Frustum::OutFrustum);
+			}
+		}
+		return true;
+	}
+
+private:
+	const GLC_Frustum& m_Frustum;
+};
+
+// The default margin ratio of leaf boxes
+const double defaultMarginRatio= 0.1;
+}
+
+GLC_AabbTree::GLC_AabbTree(GLC_3DViewCollection* pCollection)
+: GLC_SpacePartitioning(pCollection)
+, m_Nodes()
+, m_Root(-1)
+, m_FreeNode(-1)
+, m_LeafIndexHash()
+, m_MarginRatio(defaultMarginRatio)
+, m_IsSynchronized(false)
+{
+
+}
+
+GLC_AabbTree::GLC_AabbTree(const GLC_AabbTree& aabbTree)
+: GLC_SpacePartitioning(aabbTree)
+, m_Nodes()
+, m_Root(-1)
+, m_FreeNode(-1)
+, m_LeafIndexHash()
+, m_MarginRatio(aabbTree.m_MarginRatio)
+, m_IsSynchronized(false)
+{
+
+}
+
+GLC_AabbTree::~GLC_AabbTree()
+{
+
+}
+
+GLC_SpacePartitioning* GLC_AabbTree::clone()
+{
+	GLC_SpacePartitioning* pSubject= new GLC_AabbTree(*this);
+
+	return pSubject;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Get Functions
+//////////////////////////////////////////////////////////////////////
+
+QList<GLC_3DViewInstance*> GLC_AabbTree::listOfIntersectedInstances(const GLC_BoundingBox& bBox)
+{
+	if (!m_IsSynchronized)
+	{
+		updateSpacePartitioning();
+	}
+	QList<GLC_3DViewInstance*> subject;
+	InstanceCollector collector(&subject);
+	visitIntersectedInstances(bBox, collector);
+
+	return subject;
+}
+
+QList<GLC_3DViewInstance*> GLC_AabbTree::listOfInstancesInFrustum(const GLC_Frustum& frustum, bool fullyInside)
+{
+	if (!m_IsSynchronized)
+	{
+		updateSpacePartitioning();
+	}
+	QList<GLC_3DViewInstance*> subject;
+	InstanceCollector collector(&subject, fullyInside);
+	visitInstancesInFrustum(frustum, collector);
+
+	return subject;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_AabbTree::updateViewableInstances(const GLC_Frustum& frustum)
+{
+	if (!m_IsSynchronized)
+	{
+		updateSpacePartitioning();
+	}
+	ViewableUpdater updater(frustum);
+	visitInstancesInFrustum(frustum, updater, true);
+}
+
+void GLC_AabbTree::updateSpacePartitioning()
+{
+	m_IsSynchronized= true;
+
+	// Remove the instances which are no longer in the collection
+	QList<GLC_uint> removedIds;
+	QHash<GLC_uint, int>::const_iterator iLeaf= m_LeafIndexHash.constBegin();
+	while (m_LeafIndexHash.constEnd() != iLeaf)
+	{
+		if (!m_pCollection->contains(iLeaf.key())) removedIds.append(iLeaf.key());
+		++iLeaf;
+	}
+	const int removedCount= removedIds.size();
+	for (int i= 0; i < removedCount; ++i)
+	{
+		removeInstance(removedIds.at(i));
+	}
+
+	// Insert new instances and move the others
+	const QList<GLC_3DViewInstance*> instanceList(m_pCollection->instancesHandle());
+	const int size= instanceList.size();
+	for (int i= 0; i < size; ++i)
+	{
+		updateInstance(instanceList.at(i));
+	}
+}
+
+void GLC_AabbTree::clear()
+{
+	m_Nodes.clear();
+	m_Root= -1;
+	m_FreeNode= -1;
+	m_LeafIndexHash.clear();
+	m_IsSynchronized= false;
+}
+
+void GLC_AabbTree::insertInstance(GLC_3DViewInstance* pInstance)
+{
+	Q_ASSERT(NULL != pInstance);
+	// Instances not yet in the tree are inserted on synchronization
+	if (!m_IsSynchronized) return;
+
+	if (m_LeafIndexHash.contains(pInstance->id()))
+	{
+		updateInstance(pInstance);
+	}
+	else
+	{
+		const GLC_BoundingBox instanceBox= pInstance->boundingBox();
+		if (!instanceBox.isEmpty())
+		{
+			const int leaf= allocateNode();
+			m_Nodes[leaf].m_Box= enlargedBox(instanceBox);
+			m_Nodes[leaf].m_pInstance= pInstance;
+			insertLeaf(leaf);
+			m_LeafIndexHash.insert(pInstance->id(), leaf);
+		}
+	}
+}
+
+void GLC_AabbTree::removeInstance(GLC_uint id)
+{
+	QHash<GLC_uint, int>::iterator iLeaf= m_LeafIndexHash.find(id);
+	if (m_LeafIndexHash.end() != iLeaf)
+	{
+		const int leaf= iLeaf.value();
+		m_LeafIndexHash.erase(iLeaf);
+		removeLeaf(leaf);
+		freeNode(leaf);
+	}
+}
+
+void GLC_AabbTree::updateInstance(GLC_3DViewInstance* pInstance)
+{
+	Q_ASSERT(NULL != pInstance);
+	if (!m_IsSynchronized) return;
+
+	QHash<GLC_uint, int>::const_iterator iLeaf= m_LeafIndexHash.constFind(pInstance->id());
+	if (m_LeafIndexHash.constEnd() == iLeaf)
+	{
+		insertInstance(pInstance);
+	}
+	else
+	{
+		const GLC_BoundingBox instanceBox= pInstance->boundingBox();
+		if (instanceBox.isEmpty())
+		{
+			removeInstance(pInstance->id());
+		}
+		else
+		{
+			const int leaf= iLeaf.value();
+			// The instance may have been copied in the collection
+			m_Nodes[leaf].m_pInstance= pInstance;
+			if (!contains(m_Nodes.at(leaf).m_Box, instanceBox))
+			{
+				removeLeaf(leaf);
+				m_Nodes[leaf].m_Box= enlargedBox(instanceBox);
+				insertLeaf(leaf);
+			}
+		}
+	}
+}
+
+void GLC_AabbTree::setMarginRatio(double ratio)
+{
+	Q_ASSERT(ratio >= 0.0);
+	m_MarginRatio= ratio;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+int GLC_AabbTree::allocateNode()
+{
+	int index;
+	if (-1 == m_FreeNode)
+	{
+		index= m_Nodes.size();
+		m_Nodes.append(Node());
+	}
+	else
+	{
+		index= m_FreeNode;
+		m_FreeNode= m_Nodes.at(index).m_Parent;
+	}
+	Node& node= m_Nodes[index];
+	node.m_Box= GLC_BoundingBox();
+	node.m_pInstance= NULL;
+	node.m_Parent= -1;
+	node.m_Child1= -1;
+	node.m_Child2= -1;
+	node.m_Height= 0;
+
+	return index;
+}
+
+void GLC_AabbTree::freeNode(int index)
+{
+	Node& node= m_Nodes[index];
+	node.m_pInstance= NULL;
+	node.m_Parent= m_FreeNode;
+	node.m_Height= -1;
+	m_FreeNode= index;
+}
+
+void GLC_AabbTree::insertLeaf(int leaf)
+{
+	if (-1 == m_Root)
+	{
+		m_Root= leaf;
+		m_Nodes[leaf].m_Parent= -1;
+		return;
+	}
+
+	// Find the best sibling with the surface area heuristic
+	const GLC_BoundingBox leafBox= m_Nodes.at(leaf).m_Box;
+	int index= m_Root;
+	while (!m_Nodes.at(index).isLeaf())
+	{
+		const Node& node= m_Nodes.at(index);
+		const double area= surfaceArea(node.m_Box);
+		const double combinedArea= surfaceArea(unitedBox(node.m_Box, leafBox));
+
+		// Cost of creating a new parent for this node and the leaf
+		const double cost= 2.0 * combinedArea;
+		// Minimum cost of pushing the leaf further down the tree
+		const double inheritanceCost= 2.0 * (combinedArea - area);
+
+		double childCost[2];
+		const int children[2]= {node.m_Child1, node.m_Child2};
+		for (int i= 0; i < 2; ++i)
+		{
+			const Node& child= m_Nodes.at(children[i]);
+			const double childArea= surfaceArea(unitedBox(child.m_Box, leafBox));
+			if (child.isLeaf()) childCost[i]= childArea + inheritanceCost;
+			else childCost[i]= (childArea - surfaceArea(child.m_Box)) + inheritanceCost;
+		}
+
+		if ((cost < childCost[0]) && (cost < childCost[1])) break;
+
+		index= (childCost[0] < childCost[1]) ? children[0] : children[1];
+	}
+	const int sibling= index;
+
+	// Create a new parent
+	const int oldParent= m_Nodes.at(sibling).m_Parent;
+	const int newParent= allocateNode();
+	Node* pNodes= m_Nodes.data();
+	pNodes[newParent].m_Parent= oldParent;
+	pNodes[newParent].m_Box= unitedBox(leafBox, pNodes[sibling].m_Box);
+	pNodes[newParent].m_Height= pNodes[sibling].m_Height + 1;
+	pNodes[newParent].m_Child1= sibling;
+	pNodes[newParent].m_Child2= leaf;
+	pNodes[sibling].m_Parent= newParent;
+	pNodes[leaf].m_Parent= newParent;
+
+	if (-1 != oldParent)
+	{
+		if (pNodes[oldParent].m_Child1 == sibling) pNodes[oldParent].m_Child1= newParent;
+		else pNodes[oldParent].m_Child2= newParent;
+	}
+	else
+	{
+		m_Root= newParent;
+	}
+
+	refit(oldParent);
+}
+
+void GLC_AabbTree::removeLeaf(int leaf)
+{
+	if (leaf == m_Root)
+	{
+		m_Root= -1;
+		return;
+	}
+
+	Node* pNodes= m_Nodes.data();
+	const int parent= pNodes[leaf].m_Parent;
+	const int grandParent= pNodes[parent].m_Parent;
+	const int sibling= (pNodes[parent].m_Child1 == leaf) ? pNodes[parent].m_Child2 : pNodes[parent].m_Child1;
+
+	// Replace the parent by the sibling
+	pNodes[sibling].m_Parent= grandParent;
+	if (-1 != grandParent)
+	{
+		if (pNodes[grandParent].m_Child1 == parent) pNodes[grandParent].m_Child1= sibling;
+		else pNodes[grandParent].m_Child2= sibling;
+	}
+	else
+	{
+		m_Root= sibling;
+	}
+	pNodes[leaf].m_Parent= -1;
+	freeNode(parent);
+
+	refit(grandParent);
+}
+
+void GLC_AabbTree::refit(int index)
+{
+	while (-1 != index)
+	{
+		index= balance(index);
+
+		Node* pNodes= m_Nodes.data();
+		Node& node= pNodes[index];
+		const Node& child1= pNodes[node.m_Child1];
+		const Node& child2= pNodes[node.m_Child2];
+		node.m_Height= 1 + qMax(child1.m_Height, child2.m_Height);
+		node.m_Box= unitedBox(child1.m_Box, child2.m_Box);
+
+		index= node.m_Parent;
+	}
+}
+
+int GLC_AabbTree::balance(int indexA)
+{
+	Node* pNodes= m_Nodes.data();
+	Node& nodeA= pNodes[indexA];
+	if (nodeA.isLeaf() || (nodeA.m_Height < 2)) return indexA;
+
+	const int indexB= nodeA.m_Child1;
+	const int indexC= nodeA.m_Child2;
+	Node& nodeB= pNodes[indexB];
+	Node& nodeC= pNodes[indexC];
+
+	const int heightDifference= nodeC.m_Height - nodeB.m_Height;
+
+	if ((heightDifference > -2) && (heightDifference < 2)) return indexA;
+
+	// The higher child becomes the parent of A
+	const bool rotateC= heightDifference > 1;
+	const int indexUp= rotateC ? indexC : indexB;
+	const int indexOther= rotateC ? indexB : indexC;
+	Node& nodeUp= pNodes[indexUp];
+	Node& nodeOther= pNodes[indexOther];
+
+	const int indexF= nodeUp.m_Child1;
+	const int indexG= nodeUp.m_Child2;
+	Node& nodeF= pNodes[indexF];
+	Node& nodeG= pNodes[indexG];
+
+	// Swap A and the higher child
+	nodeUp.m_Child1= indexA;
+	nodeUp.m_Parent= nodeA.m_Parent;
+	nodeA.m_Parent= indexUp;
+
+	if (-1 != nodeUp.m_Parent)
+	{
+		Node& parent= pNodes[nodeUp.m_Parent];
+		if (parent.m_Child1 == indexA) parent.m_Child1= indexUp;
+		else parent.m_Child2= indexUp;
+	}
+	else
+	{
+		m_Root= indexUp;
+	}
+
+	// The higher grandchild stays under the rotated node, the other one goes under A
+	const bool keepF= nodeF.m_Height > nodeG.m_Height;
+	const int indexKept= keepF ? indexF : indexG;
+	const int indexMoved= keepF ? indexG : indexF;
+	Node& nodeKept= pNodes[indexKept];
+	Node& nodeMoved= pNodes[indexMoved];
+
+	nodeUp.m_Child2= indexKept;
+	if (rotateC) nodeA.m_Child2= indexMoved;
+	else nodeA.m_Child1= indexMoved;
+	nodeMoved.m_Parent= indexA;
+
+	nodeA.m_Box= unitedBox(nodeOther.m_Box, nodeMoved.m_Box);
+	nodeA.m_Height= 1 + qMax(nodeOther.m_Height, nodeMoved.m_Height);
+	nodeUp.m_Box= unitedBox(nodeA.m_Box, nodeKept.m_Box);
+	nodeUp.m_Height= 1 + qMax(nodeA.m_Height, nodeKept.m_Height);
+
+	return indexUp;
+}
+
+GLC_BoundingBox GLC_AabbTree::enlargedBox(const GLC_BoundingBox& bBox) const
+{
+	const double margin= bBox.boundingSphereRadius() * m_MarginRatio;
+	const GLC_Vector3d marginVector(margin, margin, margin);
+	return GLC_BoundingBox(bBox.lowerCorner() - marginVector, bBox.upperCorner() + marginVector);
+}
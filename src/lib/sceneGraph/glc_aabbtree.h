@@ -0,0 +1,279 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_aabbtree.h interface for the GLC_AabbTree class.
+
+#ifndef GLC_AABBTREE_H_
+#define GLC_AABBTREE_H_
+
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QVarLengthArray>
+
+#include "glc_spacepartitioning.h"
+#include "glc_3dviewinstance.h"
+#include "../glc_config.h"
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_AabbTree
+/*! \brief GLC_AabbTree : represent space partioning implementation with a dynamic AABB tree */
+
+/*! Each instance with a non empty bounding box is stored in a single leaf whose box is the
+ *  instance bounding box enlarged by a margin. Nodes are stored in a contiguous array and
+ *  the tree is kept balanced by rotations, so inserting, removing or moving an instance costs O(log n).
+ *  A moved instance is only reinserted when its bounding box leaves its enlarged box.
+ *
+ *  The visit functions call the given visitor for each instance found without allocating memory,
+ *  the visitor returns false to stop the visit.*/
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_AabbTree : public GLC_SpacePartitioning
+{
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Create an empty AABB tree of the given 3D view collection
+	GLC_AabbTree(GLC_3DViewCollection*);
+
+	//! Create an empty AABB tree with the margin of the given AABB tree
+	GLC_AabbTree(const GLC_AabbTree&);
+
+	//! Destructor
+	virtual ~GLC_AabbTree();
+
+	virtual GLC_SpacePartitioning* clone();
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return the list off instances inside or intersect the given bounding box
+	virtual QList<GLC_3DViewInstance*> listOfIntersectedInstances(const GLC_BoundingBox& bBox);
+
+	//! Return the list of instances inside or intersecting the given frustum
+	/*! Subtrees out of the frustum are skipped with their instances*/
+	virtual QList<GLC_3DViewInstance*> listOfInstancesInFrustum(const GLC_Frustum& frustum, bool fullyInside);
+
+	//! Call the given visitor for each instance whose bounding box intersect the given bounding box
+	/*! The visitor is called with a GLC_3DViewInstance pointer and returns false to stop the visit*/
+	template <class Visitor>
+	void visitIntersectedInstances(const GLC_BoundingBox& bBox, Visitor& visitor) const;
+
+	//! Call the given visitor for each instance inside or intersecting the given frustum
+	/*! The visitor is called with a GLC_3DViewInstance pointer and its GLC_Frustum::Localisation
+	 *  and returns false to stop the visit. If visitOutside is true, instances out of the frustum are also visited*/
+	template <class Visitor>
+	void visitInstancesInFrustum(const GLC_Frustum& frustum, Visitor& visitor, bool visitOutside= false) const;
+
+	//! Return the number of instances of this AABB tree
+	inline int instanceCount() const
+	{return m_LeafIndexHash.size();}
+
+	//! Return the height of this AABB tree
+	inline int height() const
+	{return (-1 == m_Root) ? 0 : m_Nodes.at(m_Root).m_Height;}
+
+	//! Return the margin added to the instance bounding boxes as a ratio of their bounding sphere radius
+	inline double marginRatio() const
+	{return m_MarginRatio;}
+
+//@}
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+
+	//! Update the viewable 3d view instance of this AABB tree from the given frustum
+	virtual void updateViewableInstances(const GLC_Frustum&);
+
+	//! Synchronize this AABB tree with its collection
+	/*! Only added, removed and moved instances are updated*/
+	virtual void updateSpacePartitioning();
+
+	//! Clear the space partionning
+	virtual void clear();
+
+	//! Insert the given instance in this AABB tree
+	virtual void insertInstance(GLC_3DViewInstance* pInstance);
+
+	//! Remove the instance of the given id from this AABB tree
+	virtual void removeInstance(GLC_uint id);
+
+	//! Update the leaf of the given instance after a change of its bounding box
+	virtual void updateInstance(GLC_3DViewInstance* pInstance);
+
+	//! Set the margin added to the instance bounding boxes as a ratio of their bounding sphere radius
+	/*! The margin is used by instances inserted or moved later*/
+	void setMarginRatio(double ratio);
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Private services function
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Return the index of a new node
+	int allocateNode();
+
+	//! Release the node of the given index
+	void freeNode(int index);
+
+	//! Insert the given leaf in the tree
+	void insertLeaf(int leaf);
+
+	//! Remove the given leaf from the tree without releasing it
+	void removeLeaf(int leaf);
+
+	//! Update boxes and heights from the given node to the root, balancing the tree
+	void refit(int index);
+
+	//! Balance the subtree of the given node and return the index of its new root
+	int balance(int index);
+
+	//! Return the given bounding box enlarged by the margin
+	GLC_BoundingBox enlargedBox(const GLC_BoundingBox& bBox) const;
+
+	//! Return true if the two given bounding box overlap
+	static inline bool overlap(const GLC_BoundingBox& box1, const GLC_BoundingBox& box2)
+	{
+		const GLC_Point3d& lower1= box1.lowerCorner();
+		const GLC_Point3d& upper1= box1.upperCorner();
+		const GLC_Point3d& lower2= box2.lowerCorner();
+		const GLC_Point3d& upper2= box2.upperCorner();
+		return (lower1.x() <= upper2.x()) && (lower2.x() <= upper1.x())
+			&& (lower1.y() <= upper2.y()) && (lower2.y() <= upper1.y())
+			&& (lower1.z() <= upper2.z()) && (lower2.z() <= upper1.z());
+	}
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Node of the tree
+	struct Node
+	{
+		//! Enlarged instance box for a leaf, union of the children boxes otherwise
+		GLC_BoundingBox m_Box;
+
+		//! The instance of a leaf
+		GLC_3DViewInstance* m_pInstance;
+
+		//! Index of the parent node or of the next free node
+		int m_Parent;
+
+		//! Index of the children, -1 for a leaf
+		int m_Child1;
+		int m_Child2;
+
+		//! Height of the node, 0 for a leaf and -1 for a free node
+		int m_Height;
+
+		inline bool isLeaf() const
+		{return -1 == m_Child1;}
+	};
+
+	//! The nodes of the tree
+	QVector<Node> m_Nodes;
+
+	//! Index of the root node
+	int m_Root;
+
+	//! Index of the first free node
+	int m_FreeNode;
+
+	//! Hash table of instance id to leaf index
+	QHash<GLC_uint, int> m_LeafIndexHash;
+
+	//! Margin ratio of the leaf boxes
+	double m_MarginRatio;
+
+	//! True if the tree has been synchronized with its collection
+	bool m_IsSynchronized;
+};
+
+template <class Visitor>
+void GLC_AabbTree::visitIntersectedInstances(const GLC_BoundingBox& bBox, Visitor& visitor) const
+{
+	if ((-1 == m_Root) || bBox.isEmpty()) return;
+
+	QVarLengthArray<int, 256> stack;
+	stack.append(m_Root);
+	while (!stack.isEmpty())
+	{
+		const Node& node= m_Nodes.at(stack.last());
+		stack.removeLast();
+		if (overlap(node.m_Box, bBox))
+		{
+			if (node.isLeaf())
+			{
+				if (overlap(node.m_pInstance->boundingBox(), bBox) && !visitor(node.m_pInstance)) return;
+			}
+			else
+			{
+				stack.append(node.m_Child1);
+				stack.append(node.m_Child2);
+			}
+		}
+	}
+}
+
+template <class Visitor>
+void GLC_AabbTree::visitInstancesInFrustum(const GLC_Frustum& frustum, Visitor& visitor, bool visitOutside) const
+{
+	if (-1 == m_Root) return;
+
+	// Each entry is a node index with the localisation of its parent when known
+	QVarLengthArray<QPair<int, GLC_Frustum::Localisation>, 256> stack;
+	stack.append(qMakePair(m_Root, GLC_Frustum::IntersectFrustum));
+	while (!stack.isEmpty())
+	{
+		const QPair<int, GLC_Frustum::Localisation> entry= stack.last();
+		stack.removeLast();
+		const Node& node= m_Nodes.at(entry.first);
+		GLC_Frustum::Localisation localisation= entry.second;
+		if (localisation == GLC_Frustum::IntersectFrustum)
+		{
+			if (node.isLeaf()) localisation= frustum.localizeBoundingBox(node.m_pInstance->boundingBox());
+			else localisation= frustum.localizeBoundingBox(node.m_Box);
+		}
+
+		if ((localisation != GLC_Frustum::OutFrustum) || visitOutside)
+		{
+			if (node.isLeaf())
+			{
+				if (!visitor(node.m_pInstance, localisation)) return;
+			}
+			else
+			{
+				stack.append(qMakePair(node.m_Child1, localisation));
+				stack.append(qMakePair(node.m_Child2, localisation));
+			}
+		}
+	}
+}
+
+#endif /* GLC_AABBTREE_H_ */
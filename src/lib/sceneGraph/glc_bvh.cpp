@@ -0,0 +1,293 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_bvh.cpp implementation of the GLC_Bvh class.
+
+#include "glc_bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+// Number of bins of the surface area heuristic
+const int binCount= 16;
+
+// Maximum number of primitives of a leaf
+const int maximumLeafSize= 4;
+
+// Cost of a node traversal relative to a primitive intersection
+const float traversalCost= 1.0f;
+
+// A bin of primitive box centers
+struct Bin
+{
+	float m_Min[3];
+	float m_Max[3];
+	int m_Count;
+};
+
+inline void initBounds(float* pMin, float* pMax)
+{
+	for (int i= 0; i < 3; ++i)
+	{
+		pMin[i]= FLT_MAX;
+		pMax[i]= -FLT_MAX;
+	}
+}
+
+inline void growBounds(float* pMin, float* pMax, const float* pBoxMin, const float* pBoxMax)
+{
+	for (int i= 0; i < 3; ++i)
+	{
+		pMin[i]= qMin(pMin[i], pBoxMin[i]);
+		pMax[i]= qMax(pMax[i], pBoxMax[i]);
+	}
+}
+
+// Return half the area of the given bounds
+inline float halfArea(const float* pMin, const float* pMax)
+{
+	const float x= pMax[0] - pMin[0];
+	const float y= pMax[1] - pMin[1];
+	const float z= pMax[2] - pMin[2];
+	return (x * y) + (y * z) + (z * x);
+}
+
+// Return the bin of the given center
+inline int binOf(float center, float minimum, float scale)
+{
+	return qBound(0, static_cast<int>((center - minimum) * scale), binCount - 1);
+}
+
+// Return true if the center of the given primitive is in the bins before the split
+struct IsBeforeSplit
+{
+	const float* m_pCenters;
+	int m_Axis;
+	float m_Minimum;
+	float m_Scale;
+	int m_SplitBin;
+	inline bool operator()(int index) const
+	{return binOf(m_pCenters[(3 * index) + m_Axis], m_Minimum, m_Scale) < m_SplitBin;}
+};
+
+// Order primitives by center along an axis
+struct CenterLessThan
+{
+	const float* m_pCenters;
+	int m_Axis;
+	inline bool operator()(int index1, int index2) const
+	{return m_pCenters[(3 * index1) + m_Axis] < m_pCenters[(3 * index2) + m_Axis];}
+};
+}
+
+GLC_Bvh::GLC_Bvh()
+: m_Nodes()
+, m_PrimitiveIndexes()
+{
+
+}
+
+GLC_Bvh::~GLC_Bvh()
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_Bvh::build(const QVector<float>& boxes)
+{
+	clear();
+	const int boxCount= boxes.size() / 6;
+	const float* pBoxes= boxes.constData();
+	QVector<float> centers(3 * boxCount);
+	float* pCenters= centers.data();
+	m_PrimitiveIndexes.reserve(boxCount);
+	for (int i= 0; i < boxCount; ++i)
+	{
+		const float* pBox= pBoxes + (6 * i);
+		if ((pBox[0] > pBox[3]) || (pBox[1] > pBox[4]) || (pBox[2] > pBox[5])) continue;
+		m_PrimitiveIndexes.append(i);
+		for (int axis= 0; axis < 3; ++axis)
+		{
+			pCenters[(3 * i) + axis]= 0.5f * (pBox[axis] + pBox[axis + 3]);
+		}
+	}
+	if (m_PrimitiveIndexes.isEmpty()) return;
+
+	m_Nodes.reserve(2 * ((m_PrimitiveIndexes.size() / 2) + 1));
+	buildNode(pBoxes, pCenters, 0, m_PrimitiveIndexes.size(), 0);
+	m_Nodes.squeeze();
+}
+
+void GLC_Bvh::clear()
+{
+	m_Nodes.clear();
+	m_PrimitiveIndexes.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+int GLC_Bvh::buildNode(const float* pBoxes, const float* pCenters, int begin, int end, int depth)
+{
+	const int nodeIndex= m_Nodes.size();
+	m_Nodes.append(Node());
+	int* pIndexes= m_PrimitiveIndexes.data();
+
+	// Bounds of the boxes and of their centers
+	Node node;
+	float centerMin[3];
+	float centerMax[3];
+	initBounds(node.m_Min, node.m_Max);
+	initBounds(centerMin, centerMax);
+	for (int i= begin; i < end; ++i)
+	{
+		const float* pBox= pBoxes + (6 * pIndexes[i]);
+		const float* pCenter= pCenters + (3 * pIndexes[i]);
+		growBounds(node.m_Min, node.m_Max, pBox, pBox + 3);
+		growBounds(centerMin, centerMax, pCenter, pCenter);
+	}
+	node.m_Index= begin;
+	node.m_Count= end - begin;
+
+	const int count= end - begin;
+	if ((count <= 1) || (depth >= m_MaximumDepth))
+	{
+		m_Nodes[nodeIndex]= node;
+		return nodeIndex;
+	}
+
+	// Find the cheapest split between bins
+	const float nodeArea= halfArea(node.m_Min, node.m_Max);
+	const float inverseArea= (nodeArea > 0.0f) ? (1.0f / nodeArea) : 0.0f;
+	float bestCost= FLT_MAX;
+	int bestAxis= -1;
+	int bestBin= 0;
+
+	// Bin the primitives on the 3 axis in one pass
+	float scales[3];
+	Bin bins[3][binCount];
+	for (int axis= 0; axis < 3; ++axis)
+	{
+		const float extent= centerMax[axis] - centerMin[axis];
+		scales[axis]= (extent > 0.0f) ? (static_cast<float>(binCount) / extent) : 0.0f;
+		for (int bin= 0; bin < binCount; ++bin)
+		{
+			initBounds(bins[axis][bin].m_Min, bins[axis][bin].m_Max);
+			bins[axis][bin].m_Count= 0;
+		}
+	}
+	for (int i= begin; i < end; ++i)
+	{
+		const float* pBox= pBoxes + (6 * pIndexes[i]);
+		const float* pCenter= pCenters + (3 * pIndexes[i]);
+		for (int axis= 0; axis < 3; ++axis)
+		{
+			Bin& bin= bins[axis][binOf(pCenter[axis], centerMin[axis], scales[axis])];
+			growBounds(bin.m_Min, bin.m_Max, pBox, pBox + 3);
+			++bin.m_Count;
+		}
+	}
+
+	for (int axis= 0; axis < 3; ++axis)
+	{
+		if (0.0f == scales[axis]) continue;
+		const Bin* pBins= bins[axis];
+
+		// Area and count of the primitives after each split
+		float rightAreas[binCount];
+		int rightCounts[binCount];
+		float boundsMin[3];
+		float boundsMax[3];
+		initBounds(boundsMin, boundsMax);
+		int boundsCount= 0;
+		for (int bin= binCount - 1; bin > 0; --bin)
+		{
+			if (pBins[bin].m_Count > 0) growBounds(boundsMin, boundsMax, pBins[bin].m_Min, pBins[bin].m_Max);
+			boundsCount+= pBins[bin].m_Count;
+			rightAreas[bin]= (boundsCount > 0) ? halfArea(boundsMin, boundsMax) : 0.0f;
+			rightCounts[bin]= boundsCount;
+		}
+
+		initBounds(boundsMin, boundsMax);
+		boundsCount= 0;
+		for (int bin= 0; bin < (binCount - 1); ++bin)
+		{
+			if (pBins[bin].m_Count > 0) growBounds(boundsMin, boundsMax, pBins[bin].m_Min, pBins[bin].m_Max);
+			boundsCount+= pBins[bin].m_Count;
+			if ((0 == boundsCount) || (0 == rightCounts[bin + 1])) continue;
+
+			const float cost= traversalCost + (((halfArea(boundsMin, boundsMax) * boundsCount) + (rightAreas[bin + 1] * rightCounts[bin + 1])) * inverseArea);
+			if (cost < bestCost)
+			{
+				bestCost= cost;
+				bestAxis= axis;
+				bestBin= bin + 1;
+			}
+		}
+	}
+
+	// A small leaf is kept if no split is cheaper
+	if ((count <= maximumLeafSize) && ((bestAxis < 0) || (bestCost >= static_cast<float>(count))))
+	{
+		m_Nodes[nodeIndex]= node;
+		return nodeIndex;
+	}
+
+	int middle;
+	if (bestAxis >= 0)
+	{
+		IsBeforeSplit isBeforeSplit;
+		isBeforeSplit.m_pCenters= pCenters;
+		isBeforeSplit.m_Axis= bestAxis;
+		isBeforeSplit.m_Minimum= centerMin[bestAxis];
+		isBeforeSplit.m_Scale= scales[bestAxis];
+		isBeforeSplit.m_SplitBin= bestBin;
+		middle= static_cast<int>(std::partition(pIndexes + begin, pIndexes + end, isBeforeSplit) - pIndexes);
+	}
+	else
+	{
+		// All centers are equal, split in the middle
+		middle= begin + (count / 2);
+	}
+	if ((middle == begin) || (middle == end))
+	{
+		CenterLessThan centerLessThan;
+		centerLessThan.m_pCenters= pCenters;
+		centerLessThan.m_Axis= (bestAxis >= 0) ? bestAxis : 0;
+		middle= begin + (count / 2);
+		std::nth_element(pIndexes + begin, pIndexes + middle, pIndexes + end, centerLessThan);
+	}
+
+	const int leftIndex= buildNode(pBoxes, pCenters, begin, middle, depth + 1);
+	Q_ASSERT(leftIndex == (nodeIndex + 1));
+	Q_UNUSED(leftIndex);
+	node.m_Index= buildNode(pBoxes, pCenters, middle, end, depth + 1);
+	node.m_Count= 0;
+	m_Nodes[nodeIndex]= node;
+
+	return nodeIndex;
+}
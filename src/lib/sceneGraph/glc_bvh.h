@@ -0,0 +1,313 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_bvh.h interface for the GLC_Bvh class.
+
+#ifndef GLC_BVH_H_
+#define GLC_BVH_H_
+
+#include <QVector>
+
+#include "../glc_config.h"
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_Bvh
+/*! \brief GLC_Bvh : Bounding volume hierarchy of axis aligned boxes */
+
+/*! The hierarchy is built with the surface area heuristic evaluated on bins
+ *  of primitive box centers. Nodes are stored in depth first order, the left child
+ *  of an inner node follows it.
+ *  Ray intersection visits the nearest child first and uses a functor to intersect
+ *  the primitives of leaves. Overlap visits the pairs of leaves of two hierarchies
+ *  whose boxes are closer than a margin.*/
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_Bvh
+{
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Construct an empty hierarchy
+	GLC_Bvh();
+
+	//! Destructor
+	~GLC_Bvh();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return true if the hierarchy is empty
+	inline bool isEmpty() const
+	{return m_Nodes.isEmpty();}
+
+	//! Return the number of nodes
+	inline int nodeCount() const
+	{return m_Nodes.size();}
+
+	//! Return the number of primitives
+	inline int primitiveCount() const
+	{return m_PrimitiveIndexes.size();}
+
+	//! Return the intersection of the given ray with the primitives of this hierarchy
+	/*! The ray is origin + t * direction with t in [0, *pDistance].
+	 *  The intersector is called with the index of a primitive and pDistance, it must
+	 *  return true and update *pDistance if the primitive is hit nearer.
+	 *  Return true if a primitive is hit*/
+	template <typename Intersector>
+	bool intersect(const float* pOrigin, const float* pDirection, float* pDistance, Intersector& intersector) const;
+
+	//! Visit the pairs of primitives of this hierarchy and of the given one whose boxes are closer than *pMargin
+	/*! The given matrix moves the other hierarchy in this hierarchy coordinates, it is 12 floats :
+	 *  the 3 rows of a 3x4 row major matrix.
+	 *  The visitor is called with the index of a primitive of this hierarchy, the index of a primitive
+	 *  of the other hierarchy and pMargin, it may decrease *pMargin and returns false to stop the visit*/
+	template <typename PairVisitor>
+	void visitOverlaps(const GLC_Bvh& other, const float* pMatrix, float* pMargin, PairVisitor& visitor) const;
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Build the hierarchy of the given boxes
+	/*! Each box is 6 floats : minimum x, y, z and maximum x, y, z.
+	 *  Empty boxes, whose minimum is greater than maximum, are ignored*/
+	void build(const QVector<float>& boxes);
+
+	//! Clear the hierarchy
+	void clear();
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Private services function
+//////////////////////////////////////////////////////////////////////
+private:
+	//! A node of the hierarchy
+	struct Node
+	{
+		float m_Min[3];
+		float m_Max[3];
+		//! First primitive of a leaf or right child of an inner node
+		int m_Index;
+		//! Number of primitives of a leaf, 0 for an inner node
+		int m_Count;
+	};
+
+	//! Build the node of the primitives in the given range, return its index
+	int buildNode(const float* pBoxes, const float* pCenters, int begin, int end, int depth);
+
+	//! Return true if the given ray hits the given node before the given distance
+	static inline bool nodeIsHit(const Node& node, const float* pOrigin, const float* pInverseDirection, float maximumDistance, float* pEntryDistance);
+
+	//! Return true if the given node is closer than the given margin of the other node moved with the given matrices
+	static inline bool nodesOverlap(const Node& node, const Node& otherNode, const float* pMatrix, const float* pAbsoluteMatrix, float margin);
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! The nodes, the first one is the root
+	QVector<Node> m_Nodes;
+
+	//! Primitive indexes ordered by leaf
+	QVector<int> m_PrimitiveIndexes;
+
+	//! Maximum depth of the hierarchy, also the size of the traversal stack
+	static const int m_MaximumDepth= 64;
+};
+
+bool GLC_Bvh::nodeIsHit(const Node& node, const float* pOrigin, const float* pInverseDirection, float maximumDistance, float* pEntryDistance)
+{
+	float entry= 0.0f;
+	float exit= maximumDistance;
+	for (int i= 0; i < 3; ++i)
+	{
+		float t0= (node.m_Min[i] - pOrigin[i]) * pInverseDirection[i];
+		float t1= (node.m_Max[i] - pOrigin[i]) * pInverseDirection[i];
+		if (t0 > t1) qSwap(t0, t1);
+		entry= (t0 > entry) ? t0 : entry;
+		exit= (t1 < exit) ? t1 : exit;
+	}
+	*pEntryDistance= entry;
+	return entry <= exit;
+}
+
+bool GLC_Bvh::nodesOverlap(const Node& node, const Node& otherNode, const float* pMatrix, const float* pAbsoluteMatrix, float margin)
+{
+	// The other node is moved as a center and half extents, the result contains the moved box
+	const float center[3]= {0.5f * (otherNode.m_Min[0] + otherNode.m_Max[0]), 0.5f * (otherNode.m_Min[1] + otherNode.m_Max[1]), 0.5f * (otherNode.m_Min[2] + otherNode.m_Max[2])};
+	const float extent[3]= {0.5f * (otherNode.m_Max[0] - otherNode.m_Min[0]), 0.5f * (otherNode.m_Max[1] - otherNode.m_Min[1]), 0.5f * (otherNode.m_Max[2] - otherNode.m_Min[2])};
+	for (int i= 0; i < 3; ++i)
+	{
+		const float* pRow= pMatrix + (4 * i);
+		const float* pAbsoluteRow= pAbsoluteMatrix + (3 * i);
+		const float movedCenter= (pRow[0] * center[0]) + (pRow[1] * center[1]) + (pRow[2] * center[2]) + pRow[3];
+		const float movedExtent= (pAbsoluteRow[0] * extent[0]) + (pAbsoluteRow[1] * extent[1]) + (pAbsoluteRow[2] * extent[2]) + margin;
+		if (((movedCenter + movedExtent) < node.m_Min[i]) || ((movedCenter - movedExtent) > node.m_Max[i])) return false;
+	}
+	return true;
+}
+
+template <typename Intersector>
+bool GLC_Bvh::intersect(const float* pOrigin, const float* pDirection, float* pDistance, Intersector& intersector) const
+{
+	if (m_Nodes.isEmpty()) return false;
+
+	const float inverseDirection[3]= {1.0f / pDirection[0], 1.0f / pDirection[1], 1.0f / pDirection[2]};
+	const Node* pNodes= m_Nodes.constData();
+	const int* pPrimitiveIndexes= m_PrimitiveIndexes.constData();
+
+	float entryDistance;
+	if (!nodeIsHit(pNodes[0], pOrigin, inverseDirection, *pDistance, &entryDistance)) return false;
+
+	// Nodes to visit with their entry distance
+	int stack[m_MaximumDepth + 1];
+	float stackDistances[m_MaximumDepth + 1];
+	int stackSize= 0;
+	int nodeIndex= 0;
+	bool isHit= false;
+	for (;;)
+	{
+		const Node& node= pNodes[nodeIndex];
+		bool nodeIsFound= false;
+		if (node.m_Count > 0)
+		{
+			for (int i= 0; i < node.m_Count; ++i)
+			{
+				if (intersector(pPrimitiveIndexes[node.m_Index + i], pDistance)) isHit= true;
+			}
+		}
+		else
+		{
+			float leftDistance;
+			float rightDistance;
+			const int left= nodeIndex + 1;
+			const int right= node.m_Index;
+			const bool leftIsHit= nodeIsHit(pNodes[left], pOrigin, inverseDirection, *pDistance, &leftDistance);
+			const bool rightIsHit= nodeIsHit(pNodes[right], pOrigin, inverseDirection, *pDistance, &rightDistance);
+			if (leftIsHit && rightIsHit)
+			{
+				// Visit the nearest child first
+				const bool leftIsNearest= leftDistance <= rightDistance;
+				stack[stackSize]= leftIsNearest ? right : left;
+				stackDistances[stackSize]= leftIsNearest ? rightDistance : leftDistance;
+				++stackSize;
+				nodeIndex= leftIsNearest ? left : right;
+				nodeIsFound= true;
+			}
+			else if (leftIsHit || rightIsHit)
+			{
+				nodeIndex= leftIsHit ? left : right;
+				nodeIsFound= true;
+			}
+		}
+
+		// Skip the nodes entered after the nearest hit
+		while (!nodeIsFound && (stackSize > 0))
+		{
+			--stackSize;
+			if (stackDistances[stackSize] <= *pDistance)
+			{
+				nodeIndex= stack[stackSize];
+				nodeIsFound= true;
+			}
+		}
+		if (!nodeIsFound) break;
+	}
+
+	return isHit;
+}
+
+template <typename PairVisitor>
+void GLC_Bvh::visitOverlaps(const GLC_Bvh& other, const float* pMatrix, float* pMargin, PairVisitor& visitor) const
+{
+	if (m_Nodes.isEmpty() || other.m_Nodes.isEmpty()) return;
+
+	float absoluteMatrix[9];
+	for (int i= 0; i < 3; ++i)
+	{
+		for (int j= 0; j < 3; ++j) absoluteMatrix[(3 * i) + j]= qAbs(pMatrix[(4 * i) + j]);
+	}
+
+	const Node* pNodes= m_Nodes.constData();
+	const Node* pOtherNodes= other.m_Nodes.constData();
+	const int* pPrimitiveIndexes= m_PrimitiveIndexes.constData();
+	const int* pOtherPrimitiveIndexes= other.m_PrimitiveIndexes.constData();
+
+	// Pairs of nodes to visit, one of the nodes is split at each step
+	int stack[2 * (m_MaximumDepth + 1)];
+	int otherStack[2 * (m_MaximumDepth + 1)];
+	int stackSize= 1;
+	stack[0]= 0;
+	otherStack[0]= 0;
+	while (stackSize > 0)
+	{
+		--stackSize;
+		const int nodeIndex= stack[stackSize];
+		const int otherNodeIndex= otherStack[stackSize];
+		const Node& node= pNodes[nodeIndex];
+		const Node& otherNode= pOtherNodes[otherNodeIndex];
+		if (!nodesOverlap(node, otherNode, pMatrix, absoluteMatrix, *pMargin)) continue;
+
+		const bool isLeaf= node.m_Count > 0;
+		const bool otherIsLeaf= otherNode.m_Count > 0;
+		if (isLeaf && otherIsLeaf)
+		{
+			for (int i= 0; i < node.m_Count; ++i)
+			{
+				for (int j= 0; j < otherNode.m_Count; ++j)
+				{
+					if (!visitor(pPrimitiveIndexes[node.m_Index + i], pOtherPrimitiveIndexes[otherNode.m_Index + j], pMargin)) return;
+				}
+			}
+		}
+		else
+		{
+			// Split the largest node
+			const float size= (node.m_Max[0] - node.m_Min[0]) + (node.m_Max[1] - node.m_Min[1]) + (node.m_Max[2] - node.m_Min[2]);
+			const float otherSize= (otherNode.m_Max[0] - otherNode.m_Min[0]) + (otherNode.m_Max[1] - otherNode.m_Min[1]) + (otherNode.m_Max[2] - otherNode.m_Min[2]);
+			if (otherIsLeaf || (!isLeaf && (size >= otherSize)))
+			{
+				stack[stackSize]= nodeIndex + 1;
+				otherStack[stackSize]= otherNodeIndex;
+				stack[stackSize + 1]= node.m_Index;
+				otherStack[stackSize + 1]= otherNodeIndex;
+			}
+			else
+			{
+				stack[stackSize]= nodeIndex;
+				otherStack[stackSize]= otherNodeIndex + 1;
+				stack[stackSize + 1]= nodeIndex;
+				otherStack[stackSize + 1]= otherNode.m_Index;
+			}
+			stackSize+= 2;
+		}
+	}
+}
+
+#endif /* GLC_BVH_H_ */
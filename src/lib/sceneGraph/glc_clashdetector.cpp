@@ -0,0 +1,650 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_clashdetector.cpp implementation of the GLC_ClashDetector class.
+
+#include "glc_clashdetector.h"
+#include "glc_3dviewcollection.h"
+#include "glc_3dviewinstance.h"
+#include "../geometry/glc_mesh.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+// Number of candidate pairs taken at once by a thread
+const int pairChunkSize= 16;
+
+// Default contact tolerance
+const double defaultContactTolerance= 1e-5;
+
+inline void subtract(const float* p1, const float* p2, float* pResult)
+{
+	pResult[0]= p1[0] - p2[0];
+	pResult[1]= p1[1] - p2[1];
+	pResult[2]= p1[2] - p2[2];
+}
+
+inline float dot(const float* v1, const float* v2)
+{
+	return (v1[0] * v2[0]) + (v1[1] * v2[1]) + (v1[2] * v2[2]);
+}
+
+inline void cross(const float* v1, const float* v2, float* pResult)
+{
+	pResult[0]= (v1[1] * v2[2]) - (v1[2] * v2[1]);
+	pResult[1]= (v1[2] * v2[0]) - (v1[0] * v2[2]);
+	pResult[2]= (v1[0] * v2[1]) - (v1[1] * v2[0]);
+}
+
+// Set pResult to p + (v * s)
+inline void moveAlong(const float* p, const float* v, float s, float* pResult)
+{
+	pResult[0]= p[0] + (v[0] * s);
+	pResult[1]= p[1] + (v[1] * s);
+	pResult[2]= p[2] + (v[2] * s);
+}
+
+inline void copyPoint(const float* p, float* pResult)
+{
+	pResult[0]= p[0];
+	pResult[1]= p[1];
+	pResult[2]= p[2];
+}
+
+inline float squaredDistance(const float* p1, const float* p2)
+{
+	float v[3];
+	subtract(p1, p2, v);
+	return dot(v, v);
+}
+
+inline float clamp01(float value)
+{
+	return qBound(0.0f, value, 1.0f);
+}
+
+// Return the squared distance between two segments and set their closest points
+float segmentSquaredDistance(const float* p1, const float* q1, const float* p2, const float* q2, float* pPoint1, float* pPoint2)
+{
+	float d1[3], d2[3], r[3];
+	subtract(q1, p1, d1);
+	subtract(q2, p2, d2);
+	subtract(p1, p2, r);
+	const float a= dot(d1, d1);
+	const float e= dot(d2, d2);
+	const float f= dot(d2, r);
+	float s= 0.0f;
+	float t= 0.0f;
+	if ((a > FLT_MIN) || (e > FLT_MIN))
+	{
+		if (a <= FLT_MIN)
+		{
+			t= clamp01(f / e);
+		}
+		else
+		{
+			const float c= dot(d1, r);
+			if (e <= FLT_MIN)
+			{
+				s= clamp01(-c / a);
+			}
+			else
+			{
+				const float b= dot(d1, d2);
+				const float denominator= (a * e) - (b * b);
+				// Parallel segments have a denominator of 0, any s is then valid
+				if (denominator > 0.0f) s= clamp01(((b * f) - (c * e)) / denominator);
+				t= ((b * s) + f) / e;
+				if (t < 0.0f)
+				{
+					t= 0.0f;
+					s= clamp01(-c / a);
+				}
+				else if (t > 1.0f)
+				{
+					t= 1.0f;
+					s= clamp01((b - c) / a);
+				}
+			}
+		}
+	}
+	moveAlong(p1, d1, s, pPoint1);
+	moveAlong(p2, d2, t, pPoint2);
+
+	return squaredDistance(pPoint1, pPoint2);
+}
+
+// Set the point of the given triangle closest to the given point
+void closestPointOnTriangle(const float* p, const float* pTriangle, float* pResult)
+{
+	const float* a= pTriangle;
+	const float* b= pTriangle + 3;
+	const float* c= pTriangle + 6;
+	float ab[3], ac[3], ap[3], bp[3], cp[3];
+	subtract(b, a, ab);
+	subtract(c, a, ac);
+
+	// Vertex regions
+	subtract(p, a, ap);
+	const float d1= dot(ab, ap);
+	const float d2= dot(ac, ap);
+	if ((d1 <= 0.0f) && (d2 <= 0.0f))
+	{
+		copyPoint(a, pResult);
+		return;
+	}
+	subtract(p, b, bp);
+	const float d3= dot(ab, bp);
+	const float d4= dot(ac, bp);
+	if ((d3 >= 0.0f) && (d4 <= d3))
+	{
+		copyPoint(b, pResult);
+		return;
+	}
+	subtract(p, c, cp);
+	const float d5= dot(ab, cp);
+	const float d6= dot(ac, cp);
+	if ((d6 >= 0.0f) && (d5 <= d6))
+	{
+		copyPoint(c, pResult);
+		return;
+	}
+
+	// Edge regions
+	const float vc= (d1 * d4) - (d3 * d2);
+	if ((vc <= 0.0f) && (d1 >= 0.0f) && (d3 <= 0.0f))
+	{
+		moveAlong(a, ab, d1 / (d1 - d3), pResult);
+		return;
+	}
+	const float vb= (d5 * d2) - (d1 * d6);
+	if ((vb <= 0.0f) && (d2 >= 0.0f) && (d6 <= 0.0f))
+	{
+		moveAlong(a, ac, d2 / (d2 - d6), pResult);
+		return;
+	}
+	const float va= (d3 * d6) - (d5 * d4);
+	if ((va <= 0.0f) && ((d4 - d3) >= 0.0f) && ((d5 - d6) >= 0.0f))
+	{
+		float bc[3];
+		subtract(c, b, bc);
+		moveAlong(b, bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)), pResult);
+		return;
+	}
+
+	// Face region
+	const float denominator= va + vb + vc;
+	if (denominator <= 0.0f)
+	{
+		// Degenerated triangle
+		copyPoint(a, pResult);
+		return;
+	}
+	const float v= vb / denominator;
+	const float w= vc / denominator;
+	pResult[0]= a[0] + (ab[0] * v) + (ac[0] * w);
+	pResult[1]= a[1] + (ab[1] * v) + (ac[1] * w);
+	pResult[2]= a[2] + (ab[2] * v) + (ac[2] * w);
+}
+
+// Return the squared distance between two triangles and set their closest points
+/*! The triangles must not cross each other*/
+float triangleSquaredDistance(const float* pTriangle1, const float* pTriangle2, float* pPoint1, float* pPoint2)
+{
+	float minimum= FLT_MAX;
+	float point1[3], point2[3];
+
+	// Edge to edge
+	for (int i= 0; i < 3; ++i)
+	{
+		const float* p1= pTriangle1 + (3 * i);
+		const float* q1= pTriangle1 + (3 * ((i + 1) % 3));
+		for (int j= 0; j < 3; ++j)
+		{
+			const float* p2= pTriangle2 + (3 * j);
+			const float* q2= pTriangle2 + (3 * ((j + 1) % 3));
+			const float distance= segmentSquaredDistance(p1, q1, p2, q2, point1, point2);
+			if (distance < minimum)
+			{
+				minimum= distance;
+				copyPoint(point1, pPoint1);
+				copyPoint(point2, pPoint2);
+			}
+		}
+	}
+
+	// Vertex to face
+	for (int i= 0; i < 3; ++i)
+	{
+		const float* p1= pTriangle1 + (3 * i);
+		closestPointOnTriangle(p1, pTriangle2, point2);
+		float distance= squaredDistance(p1, point2);
+		if (distance < minimum)
+		{
+			minimum= distance;
+			copyPoint(p1, pPoint1);
+			copyPoint(point2, pPoint2);
+		}
+
+		const float* p2= pTriangle2 + (3 * i);
+		closestPointOnTriangle(p2, pTriangle1, point1);
+		distance= squaredDistance(p2, point1);
+		if (distance < minimum)
+		{
+			minimum= distance;
+			copyPoint(point1, pPoint1);
+			copyPoint(p2, pPoint2);
+		}
+	}
+
+	return minimum;
+}
+
+// Return true if an edge of the first triangle crosses the second triangle deeper than the given tolerance
+bool edgeCrossesTriangle(const float* pTriangle1, const float* pTriangle2, float tolerance, float* pPoint)
+{
+	const float* a= pTriangle2;
+	const float* b= pTriangle2 + 3;
+	const float* c= pTriangle2 + 6;
+	float ab[3], ac[3], normal[3];
+	subtract(b, a, ab);
+	subtract(c, a, ac);
+	cross(ab, ac, normal);
+	const float length= std::sqrt(dot(normal, normal));
+	if (length <= FLT_MIN) return false;
+	normal[0]/= length;
+	normal[1]/= length;
+	normal[2]/= length;
+
+	float distances[3];
+	for (int i= 0; i < 3; ++i)
+	{
+		float v[3];
+		subtract(pTriangle1 + (3 * i), a, v);
+		distances[i]= dot(normal, v);
+	}
+
+	for (int i= 0; i < 3; ++i)
+	{
+		const int j= (i + 1) % 3;
+		const bool isCrossing= ((distances[i] > tolerance) && (distances[j] < -tolerance)) || ((distances[i] < -tolerance) && (distances[j] > tolerance));
+		if (!isCrossing) continue;
+
+		// Intersection of the edge with the plane of the triangle
+		const float* p= pTriangle1 + (3 * i);
+		const float* q= pTriangle1 + (3 * j);
+		float pq[3];
+		subtract(q, p, pq);
+		float point[3];
+		moveAlong(p, pq, distances[i] / (distances[i] - distances[j]), point);
+
+		// The point must be on the inner side of the 3 edges
+		bool isInside= true;
+		for (int k= 0; isInside && (k < 3); ++k)
+		{
+			const float* v1= pTriangle2 + (3 * k);
+			const float* v2= pTriangle2 + (3 * ((k + 1) % 3));
+			float edge[3], toPoint[3], side[3];
+			subtract(v2, v1, edge);
+			subtract(point, v1, toPoint);
+			cross(edge, toPoint, side);
+			isInside= dot(side, normal) >= 0.0f;
+		}
+		if (isInside)
+		{
+			copyPoint(point, pPoint);
+			return true;
+		}
+	}
+	return false;
+}
+}
+
+struct GLC_ClashDetector::InstancePairVisitor
+{
+	QVector<CandidatePair>* m_pPairs;
+
+	// Each pair is visited in both orders and each instance with itself
+	inline bool operator()(int index, int otherIndex, float*)
+	{
+		if (index < otherIndex)
+		{
+			CandidatePair pair;
+			pair.m_First= index;
+			pair.m_Second= otherIndex;
+			m_pPairs->append(pair);
+		}
+		return true;
+	}
+};
+
+struct GLC_ClashDetector::TrianglePairVisitor
+{
+	//! Triangles of the first mesh
+	const float* m_pTriangles;
+	//! Triangles of the second mesh
+	const float* m_pOtherTriangles;
+	//! Move the second mesh in the first mesh coordinates
+	const float* m_pMatrix;
+	float m_Tolerance;
+	bool m_IsCrossing;
+	float m_Distance;
+	float m_Point[3];
+
+	bool operator()(int index, int otherIndex, float* pMargin)
+	{
+		const float* pTriangle= m_pTriangles + (9 * index);
+		const float* pOtherTriangle= m_pOtherTriangles + (9 * otherIndex);
+		float otherTriangle[9];
+		for (int i= 0; i < 3; ++i)
+		{
+			const float* p= pOtherTriangle + (3 * i);
+			for (int j= 0; j < 3; ++j)
+			{
+				const float* pRow= m_pMatrix + (4 * j);
+				otherTriangle[(3 * i) + j]= (pRow[0] * p[0]) + (pRow[1] * p[1]) + (pRow[2] * p[2]) + pRow[3];
+			}
+		}
+
+		if (edgeCrossesTriangle(pTriangle, otherTriangle, m_Tolerance, m_Point) || edgeCrossesTriangle(otherTriangle, pTriangle, m_Tolerance, m_Point))
+		{
+			m_IsCrossing= true;
+			m_Distance= 0.0f;
+			return false;
+		}
+
+		float point1[3], point2[3];
+		const float distance= std::sqrt(triangleSquaredDistance(pTriangle, otherTriangle, point1, point2));
+		if (distance < m_Distance)
+		{
+			m_Distance= distance;
+			m_Point[0]= 0.5f * (point1[0] + point2[0]);
+			m_Point[1]= 0.5f * (point1[1] + point2[1]);
+			m_Point[2]= 0.5f * (point1[2] + point2[2]);
+			// Only closer triangles are still of interest
+			if (distance < *pMargin) *pMargin= distance;
+		}
+		return true;
+	}
+};
+
+class GLC_ClashDetector::DetectionTask : public QRunnable
+{
+public:
+	DetectionTask(GLC_ClashDetector* pDetector)
+	: QRunnable()
+	, m_pDetector(pDetector)
+	, m_Done()
+	{
+		setAutoDelete(false);
+	}
+
+	virtual void run()
+	{
+		m_pDetector->detectPairs();
+		m_Done.release();
+	}
+
+	//! Wait until the task is done
+	inline void waitForDone()
+	{m_Done.acquire();}
+
+private:
+	GLC_ClashDetector* m_pDetector;
+	QSemaphore m_Done;
+};
+
+GLC_ClashDetector::GLC_ClashDetector(GLC_3DViewCollection* pCollection)
+: m_pCollection(pCollection)
+, m_Clearance(0.0)
+, m_ContactTolerance(defaultContactTolerance)
+, m_MeshHierarchies()
+, m_Instances()
+, m_CandidatePairs()
+, m_Interferences()
+, m_IsInterfering()
+, m_NextPair()
+{
+
+}
+
+GLC_ClashDetector::~GLC_ClashDetector()
+{
+	clearMeshHierarchies();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+QList<GLC_ClashDetector::Interference> GLC_ClashDetector::detect()
+{
+	const double threshold= qMax(m_Clearance, m_ContactTolerance);
+
+	// Broad phase on the bounding boxes of the visible instances
+	m_Instances.clear();
+	QVector<float> boxes;
+	const bool showState= m_pCollection->showState();
+	const QList<GLC_3DViewInstance*> instances(m_pCollection->instancesHandle());
+	const int instanceCount= instances.size();
+	m_Instances.reserve(instanceCount);
+	boxes.reserve(6 * instanceCount);
+	for (int i= 0; i < instanceCount; ++i)
+	{
+		GLC_3DViewInstance* pInstance= instances.at(i);
+		if (pInstance->isVisible() != showState) continue;
+		const GLC_BoundingBox boundingBox(pInstance->boundingBox());
+		if (boundingBox.isEmpty()) continue;
+
+		ClashInstance clashInstance;
+		clashInstance.m_pInstance= pInstance;
+		m_Instances.append(clashInstance);
+
+		// Enlarge the box to cover float rounding
+		const GLC_Point3d& lower= boundingBox.lowerCorner();
+		const GLC_Point3d& upper= boundingBox.upperCorner();
+		const double margin= 1e-5 * (upper - lower).length();
+		boxes << static_cast<float>(lower.x() - margin) << static_cast<float>(lower.y() - margin) << static_cast<float>(lower.z() - margin)
+				<< static_cast<float>(upper.x() + margin) << static_cast<float>(upper.y() + margin) << static_cast<float>(upper.z() + margin);
+	}
+	GLC_Bvh instanceBvh;
+	instanceBvh.build(boxes);
+
+	// Meshes of removed instances may have been deleted
+	GLC_MeshBvh::pruneHierarchies(&m_MeshHierarchies, instances);
+
+	m_CandidatePairs.clear();
+	InstancePairVisitor pairVisitor;
+	pairVisitor.m_pPairs= &m_CandidatePairs;
+	const float identity[12]= {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+	float margin= static_cast<float>(threshold);
+	instanceBvh.visitOverlaps(instanceBvh, identity, &margin, pairVisitor);
+
+	// Mesh hierarchies are built in this thread, they may need the OpenGL context
+	const int pairCount= m_CandidatePairs.size();
+	QVector<bool> isUsed(m_Instances.size(), false);
+	for (int i= 0; i < pairCount; ++i)
+	{
+		isUsed[m_CandidatePairs.at(i).m_First]= true;
+		isUsed[m_CandidatePairs.at(i).m_Second]= true;
+	}
+	for (int i= 0; i < m_Instances.size(); ++i)
+	{
+		if (!isUsed.at(i)) continue;
+		ClashInstance& clashInstance= m_Instances[i];
+		GLC_3DViewInstance* pInstance= clashInstance.m_pInstance;
+		clashInstance.m_Matrix= pInstance->matrix();
+		clashInstance.m_InverseMatrix= clashInstance.m_Matrix.inverted();
+		const int bodyCount= pInstance->numberOfBody();
+		for (int body= 0; body < bodyCount; ++body)
+		{
+			GLC_Mesh* pMesh= dynamic_cast<GLC_Mesh*>(pInstance->geomAt(body));
+			if (NULL != pMesh) clashInstance.m_Meshes.append(meshHierarchy(pMesh));
+		}
+	}
+
+	// Narrow phase, pairs are taken by the pool threads and the calling thread until none is left
+	m_Interferences.resize(pairCount);
+	m_IsInterfering.fill(false, pairCount);
+	m_NextPair.fetchAndStoreOrdered(0);
+	QThreadPool* pThreadPool= QThreadPool::globalInstance();
+	const int chunkCount= (pairCount + pairChunkSize - 1) / pairChunkSize;
+	const int taskCount= qMax(0, qMin(chunkCount, pThreadPool->maxThreadCount()) - 1);
+	QList<DetectionTask*> tasks;
+	for (int i= 0; i < taskCount; ++i)
+	{
+		DetectionTask* pTask= new DetectionTask(this);
+		tasks.append(pTask);
+		pThreadPool->start(pTask);
+	}
+	detectPairs();
+
+	// Tasks not started yet have nothing left to do
+	for (int i= 0; i < tasks.size(); ++i)
+	{
+		if (!pThreadPool->tryTake(tasks.at(i))) tasks.at(i)->waitForDone();
+	}
+	qDeleteAll(tasks);
+
+	QList<Interference> subject;
+	for (int i= 0; i < pairCount; ++i)
+	{
+		if (m_IsInterfering.at(i)) subject.append(m_Interferences.at(i));
+	}
+	m_Instances.clear();
+	m_CandidatePairs.clear();
+	m_Interferences.clear();
+	m_IsInterfering.clear();
+
+	return subject;
+}
+
+void GLC_ClashDetector::setClearance(double clearance)
+{
+	Q_ASSERT(clearance >= 0.0);
+	m_Clearance= clearance;
+}
+
+void GLC_ClashDetector::setContactTolerance(double tolerance)
+{
+	Q_ASSERT(tolerance >= 0.0);
+	m_ContactTolerance= tolerance;
+}
+
+void GLC_ClashDetector::clearMeshHierarchies()
+{
+	qDeleteAll(m_MeshHierarchies);
+	m_MeshHierarchies.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_ClashDetector::detectPairs()
+{
+	const int pairCount= m_CandidatePairs.size();
+	int begin= m_NextPair.fetchAndAddOrdered(pairChunkSize);
+	while (begin < pairCount)
+	{
+		const int end= qMin(begin + pairChunkSize, pairCount);
+		for (int i= begin; i < end; ++i)
+		{
+			detectPair(i);
+		}
+		begin= m_NextPair.fetchAndAddOrdered(pairChunkSize);
+	}
+}
+
+void GLC_ClashDetector::detectPair(int pairIndex)
+{
+	const CandidatePair& pair= m_CandidatePairs.at(pairIndex);
+	const ClashInstance& first= m_Instances.at(pair.m_First);
+	const ClashInstance& second= m_Instances.at(pair.m_Second);
+
+	// The second instance is moved in the first instance coordinates
+	const GLC_Matrix4x4 relativeMatrix(first.m_InverseMatrix * second.m_Matrix);
+	const double* pData= relativeMatrix.getData();
+	float matrix[12];
+	for (int row= 0; row < 3; ++row)
+	{
+		for (int column= 0; column < 4; ++column)
+		{
+			matrix[(4 * row) + column]= static_cast<float>(pData[(4 * column) + row]);
+		}
+	}
+	const double scaling= first.m_Matrix.scalingX();
+	const double threshold= qMax(m_Clearance, m_ContactTolerance);
+
+	TrianglePairVisitor visitor;
+	visitor.m_pMatrix= matrix;
+	visitor.m_Tolerance= static_cast<float>(m_ContactTolerance / scaling);
+	visitor.m_IsCrossing= false;
+	visitor.m_Distance= FLT_MAX;
+	visitor.m_Point[0]= 0.0f;
+	visitor.m_Point[1]= 0.0f;
+	visitor.m_Point[2]= 0.0f;
+	const int meshCount= first.m_Meshes.size();
+	const int otherMeshCount= second.m_Meshes.size();
+	for (int i= 0; !visitor.m_IsCrossing && (i < meshCount); ++i)
+	{
+		const GLC_MeshBvh* pMesh= first.m_Meshes.at(i);
+		for (int j= 0; !visitor.m_IsCrossing && (j < otherMeshCount); ++j)
+		{
+			const GLC_MeshBvh* pOtherMesh= second.m_Meshes.at(j);
+			visitor.m_pTriangles= pMesh->triangles();
+			visitor.m_pOtherTriangles= pOtherMesh->triangles();
+			float margin= qMin(static_cast<float>(threshold / scaling), visitor.m_Distance);
+			pMesh->bvh().visitOverlaps(pOtherMesh->bvh(), matrix, &margin, visitor);
+		}
+	}
+
+	const double distance= visitor.m_IsCrossing ? 0.0 : (static_cast<double>(visitor.m_Distance) * scaling);
+	if (!visitor.m_IsCrossing && (distance > threshold)) return;
+
+	Interference& interference= m_Interferences[pairIndex];
+	interference.m_FirstInstanceId= first.m_pInstance->id();
+	interference.m_SecondInstanceId= second.m_pInstance->id();
+	if (visitor.m_IsCrossing) interference.m_Type= Penetration;
+	else if (distance <= m_ContactTolerance) interference.m_Type= Contact;
+	else interference.m_Type= Clearance;
+	interference.m_Distance= distance;
+	interference.m_Point= first.m_Matrix * GLC_Point3d(visitor.m_Point[0], visitor.m_Point[1], visitor.m_Point[2]);
+	m_IsInterfering[pairIndex]= true;
+}
+
+const GLC_MeshBvh* GLC_ClashDetector::meshHierarchy(GLC_Mesh* pMesh)
+{
+	GLC_MeshBvh* pHierarchy= m_MeshHierarchies.value(pMesh->id(), NULL);
+	if (NULL == pHierarchy)
+	{
+		pHierarchy= new GLC_MeshBvh(pMesh);
+		m_MeshHierarchies.insert(pMesh->id(), pHierarchy);
+	}
+
+	return pHierarchy;
+}
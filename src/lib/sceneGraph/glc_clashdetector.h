@@ -0,0 +1,214 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_clashdetector.h interface for the GLC_ClashDetector class.
+
+#ifndef GLC_CLASHDETECTOR_H_
+#define GLC_CLASHDETECTOR_H_
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+#include "glc_meshbvh.h"
+#include "../maths/glc_matrix4x4.h"
+#include "../maths/glc_vector3d.h"
+#include "../glc_global.h"
+
+#include "../glc_config.h"
+
+class GLC_3DViewCollection;
+class GLC_3DViewInstance;
+class GLC_Mesh;
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_ClashDetector
+/*! \brief GLC_ClashDetector : Detect the interferences between the instances of a collection */
+
+/*! The broad phase finds the pairs of visible instances whose bounding boxes are closer than
+ *  the clearance with a hierarchy of the instance bounding boxes.
+ *  The narrow phase tests the triangles of the master LOD of the meshes of each pair, with
+ *  the hierarchy of each mesh moved by the instance matrices. Pairs are spread over the
+ *  threads of the global thread pool.
+ *
+ *  An interference is a penetration if the meshes cross each other deeper than the contact tolerance,
+ *  a contact if they are closer than the contact tolerance and a clearance if they are closer than the clearance.
+ *  A mesh fully inside another one without crossing its triangles is not detected.
+ *  Distances are measured in the coordinates of the first instance and scaled by its x scaling,
+ *  so instances are expected to have uniform scaling.
+ *
+ *  With GLC_World, instance ids are the ids of the occurrences.*/
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_ClashDetector
+{
+public:
+	//! Type of interference
+	enum InterferenceType
+	{
+		Penetration= 0,
+		Contact= 1,
+		Clearance= 2
+	};
+
+	//! An interference between two instances
+	struct Interference
+	{
+		//! Id of the first instance
+		GLC_uint m_FirstInstanceId;
+		//! Id of the second instance
+		GLC_uint m_SecondInstanceId;
+		//! Type of the interference
+		InterferenceType m_Type;
+		//! Minimum distance between the meshes, 0 for a penetration
+		double m_Distance;
+		//! Point of the interference in world coordinates
+		GLC_Point3d m_Point;
+	};
+
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Construct a clash detector of the instances of the given collection
+	explicit GLC_ClashDetector(GLC_3DViewCollection* pCollection);
+
+	//! Destructor
+	~GLC_ClashDetector();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return the collection of this clash detector
+	inline GLC_3DViewCollection* collectionHandle() const
+	{return m_pCollection;}
+
+	//! Return the clearance, interferences are reported below this distance
+	inline double clearance() const
+	{return m_Clearance;}
+
+	//! Return the contact tolerance
+	inline double contactTolerance() const
+	{return m_ContactTolerance;}
+
+	//! Return the number of mesh hierarchies built
+	inline int meshHierarchyCount() const
+	{return m_MeshHierarchies.size();}
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return the interferences between the visible instances of the collection
+	/*! Must be called with the OpenGL context current if meshes data are only in their VBO*/
+	QList<Interference> detect();
+
+	//! Set the clearance
+	void setClearance(double clearance);
+
+	//! Set the contact tolerance
+	void setContactTolerance(double tolerance);
+
+	//! Clear the hierarchies of meshes
+	/*! Must be called if the geometry of meshes is changed*/
+	void clearMeshHierarchies();
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Private services function
+//////////////////////////////////////////////////////////////////////
+private:
+	//! An instance tested by the narrow phase
+	struct ClashInstance
+	{
+		GLC_3DViewInstance* m_pInstance;
+		GLC_Matrix4x4 m_Matrix;
+		GLC_Matrix4x4 m_InverseMatrix;
+		//! The hierarchies of the meshes of the instance
+		QVector<const GLC_MeshBvh*> m_Meshes;
+	};
+
+	//! A pair of instances whose bounding boxes are close
+	struct CandidatePair
+	{
+		int m_First;
+		int m_Second;
+	};
+
+	//! Collect the pairs of instances of the broad phase
+	struct InstancePairVisitor;
+
+	//! Test the pairs of triangles of two meshes
+	struct TrianglePairVisitor;
+
+	//! Task detecting interferences in the thread pool
+	class DetectionTask;
+
+	//! Detect the interferences of the candidate pairs until none is left
+	void detectPairs();
+
+	//! Detect the interference of the given candidate pair
+	void detectPair(int pairIndex);
+
+	//! Return the hierarchy of the given mesh, build it if needed
+	const GLC_MeshBvh* meshHierarchy(GLC_Mesh* pMesh);
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! The tested collection
+	GLC_3DViewCollection* m_pCollection;
+
+	//! The clearance
+	double m_Clearance;
+
+	//! The contact tolerance
+	double m_ContactTolerance;
+
+	//! Mesh hierarchies by mesh id
+	QHash<GLC_uint, GLC_MeshBvh*> m_MeshHierarchies;
+
+	//! Instances of the current detection
+	QVector<ClashInstance> m_Instances;
+
+	//! Candidate pairs of the current detection
+	QVector<CandidatePair> m_CandidatePairs;
+
+	//! Interference of each candidate pair
+	QVector<Interference> m_Interferences;
+
+	//! True if the candidate pair of the same index interferes
+	QVector<bool> m_IsInterfering;
+
+	//! Index of the next candidate pair to detect
+	QAtomicInt m_NextPair;
+};
+
+#endif /* GLC_CLASHDETECTOR_H_ */
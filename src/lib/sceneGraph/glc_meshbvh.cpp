@@ -0,0 +1,170 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_meshbvh.cpp implementation of the GLC_MeshBvh class.
+
+#include "glc_meshbvh.h"
+#include "../geometry/glc_mesh.h"
+#include "../geometry/glc_primitivegroup.h"
+#include "glc_3dviewinstance.h"
+
+#include <QSet>
+
+GLC_MeshBvh::GLC_MeshBvh(GLC_Mesh* pMesh)
+: m_Bvh()
+, m_Triangles()
+, m_PrimitiveIds()
+{
+	// Triangles, strips and fans of the master LOD with their primitive id
+	const GLC_Mesh::LodPrimitiveGroups* pGroups= pMesh->lodPrimitiveGroups(0);
+	if (NULL == pGroups) return;
+	const GLfloatVector positions(pMesh->positionVector());
+	GLC_Mesh::LodPrimitiveGroups::const_iterator iGroup= pGroups->constBegin();
+	while (iGroup != pGroups->constEnd())
+	{
+		const GLC_uint materialId= iGroup.key();
+		const GLC_PrimitiveGroup* pGroup= iGroup.value();
+		if (pMesh->containsTriangles(0, materialId))
+		{
+			const QVector<GLuint> trianglesIndex(pMesh->getTrianglesIndex(0, materialId));
+			if (pGroup->containsTrianglesGroupId())
+			{
+				const IndexSizes& sizes= pGroup->trianglesIndexSizes();
+				int offset= 0;
+				for (int i= 0; i < sizes.size(); ++i)
+				{
+					appendTriangles(positions, trianglesIndex.mid(offset, sizes.at(i)), pGroup->triangleGroupId(i));
+					offset+= sizes.at(i);
+				}
+			}
+			else
+			{
+				appendTriangles(positions, trianglesIndex, 0);
+			}
+		}
+		if (pMesh->containsStrips(0, materialId))
+		{
+			const QList<QVector<GLuint> > stripsIndex(pMesh->getStripsIndex(0, materialId));
+			for (int i= 0; i < stripsIndex.size(); ++i)
+			{
+				const QVector<GLuint>& strip= stripsIndex.at(i);
+				QVector<GLuint> trianglesIndex;
+				for (int j= 2; j < strip.size(); ++j)
+				{
+					trianglesIndex << strip.at(j - 2) << strip.at(j - 1) << strip.at(j);
+				}
+				appendTriangles(positions, trianglesIndex, pGroup->containsStripGroupId() ? pGroup->stripGroupId(i) : 0);
+			}
+		}
+		if (pMesh->containsFans(0, materialId))
+		{
+			const QList<QVector<GLuint> > fansIndex(pMesh->getFansIndex(0, materialId));
+			for (int i= 0; i < fansIndex.size(); ++i)
+			{
+				const QVector<GLuint>& fan= fansIndex.at(i);
+				QVector<GLuint> trianglesIndex;
+				for (int j= 2; j < fan.size(); ++j)
+				{
+					trianglesIndex << fan.first() << fan.at(j - 1) << fan.at(j);
+				}
+				appendTriangles(positions, trianglesIndex, pGroup->containsFanGroupId() ? pGroup->fanGroupId(i) : 0);
+			}
+		}
+		++iGroup;
+	}
+
+	// Bounding box of each triangle
+	const int triangleCount= m_PrimitiveIds.size();
+	const float* pTriangles= m_Triangles.constData();
+	QVector<float> boxes(6 * triangleCount);
+	float* pBoxes= boxes.data();
+	for (int i= 0; i < triangleCount; ++i)
+	{
+		const float* pTriangle= pTriangles + (9 * i);
+		float* pBox= pBoxes + (6 * i);
+		for (int axis= 0; axis < 3; ++axis)
+		{
+			pBox[axis]= qMin(pTriangle[axis], qMin(pTriangle[axis + 3], pTriangle[axis + 6]));
+			pBox[axis + 3]= qMax(pTriangle[axis], qMax(pTriangle[axis + 3], pTriangle[axis + 6]));
+		}
+	}
+	m_Bvh.build(boxes);
+}
+
+GLC_MeshBvh::~GLC_MeshBvh()
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_MeshBvh::pruneHierarchies(QHash<GLC_uint, GLC_MeshBvh*>* pHierarchies, const QList<GLC_3DViewInstance*>& instances)
+{
+	if (pHierarchies->isEmpty()) return;
+
+	QSet<GLC_uint> usedIds;
+	const int instanceCount= instances.size();
+	for (int i= 0; i < instanceCount; ++i)
+	{
+		GLC_3DViewInstance* pInstance= instances.at(i);
+		const int bodyCount= pInstance->numberOfBody();
+		for (int body= 0; body < bodyCount; ++body)
+		{
+			usedIds.insert(pInstance->geomAt(body)->id());
+		}
+	}
+
+	QHash<GLC_uint, GLC_MeshBvh*>::iterator iHierarchy= pHierarchies->begin();
+	while (iHierarchy != pHierarchies->end())
+	{
+		if (usedIds.contains(iHierarchy.key()))
+		{
+			++iHierarchy;
+		}
+		else
+		{
+			delete iHierarchy.value();
+			iHierarchy= pHierarchies->erase(iHierarchy);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_MeshBvh::appendTriangles(const GLfloatVector& positions, const QVector<GLuint>& index, GLC_uint primitiveId)
+{
+	const int vertexCount= positions.size() / 3;
+	const int size= index.size() - (index.size() % 3);
+	for (int i= 0; i < size; i+= 3)
+	{
+		if ((index.at(i) >= static_cast<GLuint>(vertexCount)) || (index.at(i + 1) >= static_cast<GLuint>(vertexCount)) || (index.at(i + 2) >= static_cast<GLuint>(vertexCount))) continue;
+		for (int j= 0; j < 3; ++j)
+		{
+			const GLfloat* pPosition= positions.constData() + (3 * index.at(i + j));
+			m_Triangles << pPosition[0] << pPosition[1] << pPosition[2];
+		}
+		m_PrimitiveIds.append(primitiveId);
+	}
+}
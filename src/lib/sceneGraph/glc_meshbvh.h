@@ -0,0 +1,117 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_meshbvh.h interface for the GLC_MeshBvh class.
+
+#ifndef GLC_MESHBVH_H_
+#define GLC_MESHBVH_H_
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+#include "glc_bvh.h"
+#include "../glc_global.h"
+
+#include "../glc_config.h"
+
+class GLC_Mesh;
+class GLC_3DViewInstance;
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_MeshBvh
+/*! \brief GLC_MeshBvh : The triangles of a mesh and their bounding volume hierarchy */
+
+/*! The triangles, strips and fans of the master LOD of the mesh are copied in mesh
+ *  coordinates with the id of their triangle group, strip or fan.
+ *  If the mesh data are only in its VBO, they are read back from the VBO, so
+ *  the hierarchy must then be built with the OpenGL context current.*/
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_MeshBvh
+{
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Build the hierarchy of the triangles of the given mesh
+	explicit GLC_MeshBvh(GLC_Mesh* pMesh);
+
+	//! Destructor
+	~GLC_MeshBvh();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return the hierarchy of the triangles
+	inline const GLC_Bvh& bvh() const
+	{return m_Bvh;}
+
+	//! Return the number of triangles
+	inline int triangleCount() const
+	{return m_PrimitiveIds.size();}
+
+	//! Return the triangles, 9 floats by triangle
+	inline const float* triangles() const
+	{return m_Triangles.constData();}
+
+	//! Return the primitive id of the given triangle, 0 if the mesh has no primitive id
+	inline GLC_uint primitiveId(int triangle) const
+	{return m_PrimitiveIds.at(triangle);}
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Delete the given hierarchies by mesh id whose mesh isn't used by the given instances
+	/*! Meshes of removed instances may have been deleted, their hierarchies are useless*/
+	static void pruneHierarchies(QHash<GLC_uint, GLC_MeshBvh*>* pHierarchies, const QList<GLC_3DViewInstance*>& instances);
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Private services function
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Append the triangles of the given index
+	void appendTriangles(const GLfloatVector& positions, const QVector<GLuint>& index, GLC_uint primitiveId);
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! The hierarchy of the triangles
+	GLC_Bvh m_Bvh;
+
+	//! 9 floats by triangle
+	QVector<float> m_Triangles;
+
+	//! Primitive id of each triangle
+	QVector<GLC_uint> m_PrimitiveIds;
+};
+
+#endif /* GLC_MESHBVH_H_ */
@@ -0,0 +1,260 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_occlusionculler.cpp implementation of the GLC_OcclusionCuller class.
+
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+
+#include "glc_occlusionculler.h"
+#include "glc_3dviewcollection.h"
+#include "glc_3dviewinstance.h"
+#include "../glc_context.h"
+#include "../glc_contextmanager.h"
+#include "../glc_renderstatistics.h"
+
+namespace
+{
+// Number of frames a visible instance is assumed to stay visible
+const int visibleInstanceQueryInterval= 8;
+
+// Relative enlargement of the bounding boxes drawn in queries, to not be hidden by the instance itself
+const double boxEnlargement= 1.0e-3;
+
+// Triangles of a box whose corner index is made of x, y and z bits
+const GLubyte boxIndices[36]= {0, 2, 6, 0, 6, 4,
+							   1, 3, 7, 1, 7, 5,
+							   0, 1, 5, 0, 5, 4,
+							   2, 3, 7, 2, 7, 6,
+							   0, 1, 3, 0, 3, 2,
+							   4, 5, 7, 4, 7, 6};
+
+// Return the query target of the current context
+inline GLenum queryTarget()
+{
+	const QSurfaceFormat format= QOpenGLContext::currentContext()->format();
+	return (format.version() >= qMakePair(3, 3)) ? GL_ANY_SAMPLES_PASSED : GL_SAMPLES_PASSED;
+}
+
+inline bool boxContains(const GLC_BoundingBox& box, const GLC_Point3d& point, double margin)
+{
+	const GLC_Point3d& lower= box.lowerCorner();
+	const GLC_Point3d& upper= box.upperCorner();
+	return (point.x() >= (lower.x() - margin)) && (point.x() <= (upper.x() + margin))
+			&& (point.y() >= (lower.y() - margin)) && (point.y() <= (upper.y() + margin))
+			&& (point.z() >= (lower.z() - margin)) && (point.z() <= (upper.z() + margin));
+}
+}
+
+GLC_OcclusionCuller::GLC_OcclusionCuller()
+: m_InstanceQueries()
+, m_FrameIndex(0)
+{
+	for (int i= 0; i < 24; ++i) m_BoxVertices[i]= 0.0f;
+}
+
+GLC_OcclusionCuller::~GLC_OcclusionCuller()
+{
+	if (NULL != QOpenGLContext::currentContext())
+	{
+		QOpenGLExtraFunctions* pFunctions= QOpenGLContext::currentContext()->extraFunctions();
+		QHash<GLC_uint, InstanceQuery>::iterator iQuery= m_InstanceQueries.begin();
+		while (m_InstanceQueries.constEnd() != iQuery)
+		{
+			pFunctions->glDeleteQueries(1, &(iQuery.value().m_QueryId));
+			++iQuery;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Get Functions
+//////////////////////////////////////////////////////////////////////
+
+bool GLC_OcclusionCuller::isSupported()
+{
+	// Bounding boxes are drawn with the fixed pipeline vertex array
+	const QOpenGLContext* pContext= QOpenGLContext::currentContext();
+	const QSurfaceFormat format= pContext->format();
+	return !pContext->isOpenGLES() && (format.profile() != QSurfaceFormat::CoreProfile)
+			&& (format.version() >= qMakePair(1, 5));
+}
+
+int GLC_OcclusionCuller::visibleQueryInterval()
+{
+	return visibleInstanceQueryInterval;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_OcclusionCuller::collectResults(GLC_3DViewCollection* pCollection)
+{
+	++m_FrameIndex;
+	QOpenGLExtraFunctions* pFunctions= QOpenGLContext::currentContext()->extraFunctions();
+
+	unsigned int occludedInstanceCount= 0;
+	QHash<GLC_uint, InstanceQuery>::iterator iQuery= m_InstanceQueries.begin();
+	while (m_InstanceQueries.constEnd() != iQuery)
+	{
+		InstanceQuery& query= iQuery.value();
+		if (!pCollection->contains(iQuery.key()))
+		{
+			pFunctions->glDeleteQueries(1, &(query.m_QueryId));
+			iQuery= m_InstanceQueries.erase(iQuery);
+			continue;
+		}
+
+		GLC_3DViewInstance* pInstance= pCollection->instanceHandle(iQuery.key());
+		if (query.m_IsPending)
+		{
+			// Never wait for a result, the previous visibility is kept until it is available
+			GLuint isAvailable= 0;
+			pFunctions->glGetQueryObjectuiv(query.m_QueryId, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+			if (isAvailable)
+			{
+				GLuint sampleCount= 0;
+				pFunctions->glGetQueryObjectuiv(query.m_QueryId, GL_QUERY_RESULT, &sampleCount);
+				pInstance->setOccluded(0 == sampleCount);
+				query.m_IsPending= false;
+			}
+		}
+		if (pInstance->isOccluded() && (pInstance->viewableFlag() != GLC_3DViewInstance::NoViewable))
+		{
+			++occludedInstanceCount;
+		}
+		++iQuery;
+	}
+	GLC_RenderStatistics::addOccludedInstances(occludedInstanceCount);
+}
+
+void GLC_OcclusionCuller::clear(GLC_3DViewCollection* pCollection)
+{
+	QOpenGLExtraFunctions* pFunctions= QOpenGLContext::currentContext()->extraFunctions();
+	QHash<GLC_uint, InstanceQuery>::iterator iQuery= m_InstanceQueries.begin();
+	while (m_InstanceQueries.constEnd() != iQuery)
+	{
+		pFunctions->glDeleteQueries(1, &(iQuery.value().m_QueryId));
+		if (pCollection->contains(iQuery.key()))
+		{
+			pCollection->instanceHandle(iQuery.key())->setOccluded(false);
+		}
+		++iQuery;
+	}
+	m_InstanceQueries.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+// OpenGL Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_OcclusionCuller::issueQueries(const QVector<GLC_3DViewInstance*>& instances, const GLC_Point3d& eye, double margin)
+{
+	QOpenGLExtraFunctions* pFunctions= QOpenGLContext::currentContext()->extraFunctions();
+	GLC_Context* pContext= GLC_ContextManager::instance()->currentContext();
+	const GLenum target= queryTarget();
+
+	// Bounding boxes only write in queries
+	GLboolean colorMask[4];
+	glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+	GLboolean depthMask;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+	GLint depthFunc;
+	glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+	const GLboolean cullFace= glIsEnabled(GL_CULL_FACE);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_LEQUAL);
+	glEnable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	pFunctions->glBindBuffer(GL_ARRAY_BUFFER, 0);
+	pFunctions->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	pContext->glcUseVertexPointer(m_BoxVertices);
+
+	unsigned int queryCount= 0;
+	const int size= instances.size();
+	for (int i= 0; i < size; ++i)
+	{
+		GLC_3DViewInstance* pInstance= instances.at(i);
+		const GLC_uint id= pInstance->id();
+		QHash<GLC_uint, InstanceQuery>::iterator iQuery= m_InstanceQueries.find(id);
+		if (m_InstanceQueries.end() == iQuery)
+		{
+			InstanceQuery query;
+			pFunctions->glGenQueries(1, &(query.m_QueryId));
+			query.m_IsPending= false;
+			query.m_NextQueryFrame= m_FrameIndex;
+			iQuery= m_InstanceQueries.insert(id, query);
+		}
+		InstanceQuery& query= iQuery.value();
+		if (query.m_IsPending) continue;
+
+		const GLC_BoundingBox boundingBox(pInstance->boundingBox());
+		if (boundingBox.isEmpty()) continue;
+		// The bounding box of an instance around the eye can't be seen
+		if (boxContains(boundingBox, eye, margin))
+		{
+			pInstance->setOccluded(false);
+			continue;
+		}
+		if (!pInstance->isOccluded() && (m_FrameIndex < query.m_NextQueryFrame)) continue;
+
+		pFunctions->glBeginQuery(target, query.m_QueryId);
+		drawBoundingBox(boundingBox);
+		pFunctions->glEndQuery(target);
+		query.m_IsPending= true;
+		// Spread the queries of visible instances over the frames
+		query.m_NextQueryFrame= m_FrameIndex + visibleInstanceQueryInterval + static_cast<int>(id % visibleInstanceQueryInterval);
+		++queryCount;
+	}
+
+	pContext->glcDisableVertexClientState();
+	glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
+	glDepthMask(depthMask);
+	glDepthFunc(depthFunc);
+	if (cullFace) glEnable(GL_CULL_FACE);
+
+	GLC_RenderStatistics::addOcclusionQueries(queryCount);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_OcclusionCuller::drawBoundingBox(const GLC_BoundingBox& boundingBox)
+{
+	const GLC_Point3d& lower= boundingBox.lowerCorner();
+	const GLC_Point3d& upper= boundingBox.upperCorner();
+	const double dx= (upper.x() - lower.x()) * boxEnlargement;
+	const double dy= (upper.y() - lower.y()) * boxEnlargement;
+	const double dz= (upper.z() - lower.z()) * boxEnlargement;
+	const GLfloat x[2]= {static_cast<GLfloat>(lower.x() - dx), static_cast<GLfloat>(upper.x() + dx)};
+	const GLfloat y[2]= {static_cast<GLfloat>(lower.y() - dy), static_cast<GLfloat>(upper.y() + dy)};
+	const GLfloat z[2]= {static_cast<GLfloat>(lower.z() - dz), static_cast<GLfloat>(upper.z() + dz)};
+	for (int i= 0; i < 8; ++i)
+	{
+		m_BoxVertices[(3 * i)]= x[i & 1];
+		m_BoxVertices[(3 * i) + 1]= y[(i >> 1) & 1];
+		m_BoxVertices[(3 * i) + 2]= z[(i >> 2) & 1];
+	}
+	glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, boxIndices);
+}
@@ -0,0 +1,133 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_occlusionculler.h interface for the GLC_OcclusionCuller class.
+
+#ifndef GLC_OCCLUSIONCULLER_H_
+#define GLC_OCCLUSIONCULLER_H_
+
+#include <QHash>
+#include <QVector>
+#include <QtOpenGL>
+
+#include "../glc_global.h"
+#include "../glc_boundingbox.h"
+#include "../glc_config.h"
+
+class GLC_3DViewCollection;
+class GLC_3DViewInstance;
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_OcclusionCuller
+/*! \brief GLC_OcclusionCuller : Hide instances occluded by other instances with occlusion queries */
+
+/*! The bounding box of an instance is drawn in an occlusion query after the opaque
+ *  instances are drawn. The result is read at the next frame only if it is available,
+ *  so rendering never waits for the GPU, and the instance occluded flag is updated.
+ *  As in coherent hierarchical culling, occluded instances are tested every frame and
+ *  visible instances are assumed to stay visible for several frames.*/
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_OcclusionCuller
+{
+	//! The occlusion query of an instance
+	struct InstanceQuery
+	{
+		GLuint m_QueryId;
+		bool m_IsPending;
+		int m_NextQueryFrame;
+	};
+
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Default constructor
+	GLC_OcclusionCuller();
+
+	//! Destructor
+	/*! Queries are deleted if an OpenGL context is current*/
+	~GLC_OcclusionCuller();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return true if occlusion queries are supported by the current OpenGL context
+	static bool isSupported();
+
+	//! Return the number of frames a visible instance is assumed to stay visible
+	static int visibleQueryInterval();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Update the occluded flag of the instances of the given collection from the available query results
+	/*! Must be called at the beginning of a frame, queries of removed instances are deleted*/
+	void collectResults(GLC_3DViewCollection* pCollection);
+
+	//! Delete all queries and clear the occluded flag of the instances of the given collection
+	void clear(GLC_3DViewCollection* pCollection);
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name OpenGL Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Issue the occlusion queries of the given instances
+	/*! Must be called after opaque instances are drawn.
+	 *  Instances whose bounding box contains the eye, enlarged by the given margin, are visible*/
+	void issueQueries(const QVector<GLC_3DViewInstance*>& instances, const GLC_Point3d& eye, double margin);
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Private services function
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Draw the given bounding box with the current vertex pointer
+	void drawBoundingBox(const GLC_BoundingBox& boundingBox);
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Occlusion query of each instance id
+	QHash<GLC_uint, InstanceQuery> m_InstanceQueries;
+
+	//! Index of the current frame
+	int m_FrameIndex;
+
+	//! The corners of the bounding box drawn in a query
+	GLfloat m_BoxVertices[24];
+
+private:
+	Q_DISABLE_COPY(GLC_OcclusionCuller)
+};
+
+#endif /* GLC_OCCLUSIONCULLER_H_ */
@@ -28,6 +28,20 @@
 
 int GLC_Octree::m_DefaultOctreeDepth= 3;
 
+namespace
+{
+	// Return true if the inner bounding box is inside or on the border of the outer one
+	bool boxContainsBox(const GLC_BoundingBox& outer, const GLC_BoundingBox& inner)
+	{
+		const GLC_Point3d& outerLower= outer.lowerCorner();
+		const GLC_Point3d& outerUpper= outer.upperCorner();
+		const GLC_Point3d& innerLower= inner.lowerCorner();
+		const GLC_Point3d& innerUpper= inner.upperCorner();
+		return (innerLower.x() >= outerLower.x()) && (innerLower.y() >= outerLower.y()) && (innerLower.z() >= outerLower.z())
+				&& (innerUpper.x() <= outerUpper.x()) && (innerUpper.y() <= outerUpper.y()) && (innerUpper.z() <= outerUpper.z());
+	}
+}
+
 GLC_Octree::GLC_Octree(GLC_3DViewCollection* pCollection)
 : GLC_SpacePartitioning(pCollection)
 , m_pRootNode(NULL)
@@ -70,6 +84,18 @@ QList<GLC_3DViewInstance*> GLC_Octree::listOfIntersectedInstances(const GLC_Boun
 	return m_pRootNode->setOfIntersectedInstances(bBox).toList();
 }
 
+QList<GLC_3DViewInstance*> GLC_Octree::listOfInstancesInFrustum(const GLC_Frustum& frustum, bool fullyInside)
+{
+	if (NULL == m_pRootNode)
+	{
+		updateSpacePartitioning();
+	}
+	QSet<GLC_3DViewInstance*> instanceSet;
+	m_pRootNode->instancesInFrustum(frustum, fullyInside, &instanceSet);
+
+	return instanceSet.toList();
+}
+
 void GLC_Octree::updateViewableInstances(const GLC_Frustum& frustum)
 {
 	if (NULL == m_pRootNode)
@@ -99,6 +125,22 @@ void GLC_Octree::clear()
 	m_pRootNode= NULL;
 }
 
+void GLC_Octree::updateInstance(GLC_3DViewInstance* pInstance)
+{
+	if (NULL == m_pRootNode) return;
+
+	m_pRootNode->removeInstance(pInstance);
+	const GLC_BoundingBox instanceBox(pInstance->boundingBox());
+	if (instanceBox.isEmpty() || boxContainsBox(m_pRootNode->boundingBox(), instanceBox))
+	{
+		m_pRootNode->addInstance(pInstance, m_OctreeDepth);
+	}
+	else
+	{
+		clear();
+	}
+}
+
 void GLC_Octree::setDepth(int depth)
 {
 	m_OctreeDepth= depth;
@@ -66,6 +66,10 @@ public:
 	//! Return the list off instances inside or intersect the given bounding box
 	virtual QList<GLC_3DViewInstance*> listOfIntersectedInstances(const GLC_BoundingBox& bBox);
 
+	//! Return the list of instances inside or intersecting the given frustum
+	/*! Octree nodes out of the frustum are skipped with their instances*/
+	virtual QList<GLC_3DViewInstance*> listOfInstancesInFrustum(const GLC_Frustum& frustum, bool fullyInside);
+
 //@}
 //////////////////////////////////////////////////////////////////////
 /*! \name Set Functions*/
@@ -82,6 +86,10 @@ public:
 	//! Clear the space partionning
 	virtual void clear();
 
+	//! Move the given instance whose bounding box has changed to the matching octree nodes
+	/*! If the instance leaves the octree root box, the octree is rebuilt at its next use*/
+	virtual void updateInstance(GLC_3DViewInstance* pInstance);
+
 	//! Set this octree depth
 	/*! If space partitionning is already done, update it*/
 	void setDepth(int);
@@ -31,6 +31,10 @@ GLC_OctreeNode::GLC_OctreeNode(const GLC_BoundingBox& boundingBox, GLC_OctreeNod
 , m_Children()
 , m_3DViewInstanceSet()
 , m_Empty(true)
+, m_CulledInstances()
+, m_CullingTable()
+, m_Localisations()
+, m_CullingTableIsValid(false)
 {
 
 
@@ -42,6 +46,10 @@ GLC_OctreeNode::GLC_OctreeNode(const GLC_OctreeNode& octreeNode, GLC_OctreeNode*
 , m_Children()
 , m_3DViewInstanceSet(octreeNode.m_3DViewInstanceSet)
 , m_Empty(octreeNode.m_Empty)
+, m_CulledInstances()
+, m_CullingTable()
+, m_Localisations()
+, m_CullingTableIsValid(false)
 {
 	if (!octreeNode.m_Children.isEmpty())
 	{
@@ -90,6 +98,30 @@ QSet<GLC_3DViewInstance*> GLC_OctreeNode::setOfIntersectedInstances(const GLC_Bo
 
 	return instanceSet;
 }
+
+void GLC_OctreeNode::instancesInFrustum(const GLC_Frustum& frustum, bool fullyInside, QSet<GLC_3DViewInstance*>* pInstanceSet)
+{
+	if (frustum.localizeBoundingBox(m_BoundingBox) == GLC_Frustum::OutFrustum) return;
+
+	// Localize all instances of this node at once
+	if (!m_CullingTableIsValid) updateCullingTable();
+	m_CullingTable.localizeBoundingBoxes(frustum, &m_Localisations);
+	const int instanceCount= m_CulledInstances.size();
+	for (int i= 0; i < instanceCount; ++i)
+	{
+		const GLC_Frustum::Localisation localisation= static_cast<GLC_Frustum::Localisation>(m_Localisations.at(i));
+		if ((localisation == GLC_Frustum::InFrustum) || (!fullyInside && (localisation == GLC_Frustum::IntersectFrustum)))
+		{
+			pInstanceSet->insert(m_CulledInstances.at(i));
+		}
+	}
+
+	const int childCount= m_Children.size();
+	for (int i= 0; i < childCount; ++i)
+	{
+		m_Children.at(i)->instancesInFrustum(frustum, fullyInside, pInstanceSet);
+	}
+}
 //////////////////////////////////////////////////////////////////////
 // Set Functions
 //////////////////////////////////////////////////////////////////////
@@ -185,6 +217,7 @@ void GLC_OctreeNode::addInstance(GLC_3DViewInstance* pInstance, int depth)
 		if (0 == depth)
 		{
 			m_3DViewInstanceSet.insert(pInstance);
+			m_CullingTableIsValid= false;
 		}
 		else
 		{
@@ -205,6 +238,7 @@ void GLC_OctreeNode::addInstance(GLC_3DViewInstance* pInstance, int depth)
 			if (allIntersect)
 			{
 				m_3DViewInstanceSet.insert(pInstance);
+				m_CullingTableIsValid= false;
 			}
 			else
 			{
@@ -221,6 +255,18 @@ void GLC_OctreeNode::addInstance(GLC_3DViewInstance* pInstance, int depth)
 	}
 }
 
+void GLC_OctreeNode::removeInstance(GLC_3DViewInstance* pInstance)
+{
+	if (m_3DViewInstanceSet.remove(pInstance))
+	{
+		m_CullingTableIsValid= false;
+	}
+	const int childCount= m_Children.size();
+	for (int i= 0; i < childCount; ++i)
+	{
+		m_Children.at(i)->removeInstance(pInstance);
+	}
+}
 
 void GLC_OctreeNode::updateViewableInstances(const GLC_Frustum& frustum, QSet<GLC_3DViewInstance*>* pInstanceSet)
 {
@@ -245,15 +291,18 @@ void GLC_OctreeNode::updateViewableInstances(const GLC_Frustum& frustum, QSet<GL
 	}
 	else // The current node intersect the frustum
 	{
-		QSet<GLC_3DViewInstance*>::iterator iInstance= m_3DViewInstanceSet.begin();
-		while (m_3DViewInstanceSet.constEnd() != iInstance)
+		// Localize all instances of this node at once
+		if (!m_CullingTableIsValid) updateCullingTable();
+		m_CullingTable.localizeBoundingBoxes(frustum, &m_Localisations);
+
+		const int instanceCount= m_CulledInstances.size();
+		for (int instanceIndex= 0; instanceIndex < instanceCount; ++instanceIndex)
 		{
+			GLC_3DViewInstance* pCurrentInstance= m_CulledInstances.at(instanceIndex);
 			// Test if the instances is in the viewable set
-			if (!pInstanceSet->contains(*iInstance))
+			if (!pInstanceSet->contains(pCurrentInstance))
 			{
-				GLC_3DViewInstance* pCurrentInstance= (*iInstance);
-				// Test the localisation of the current instance
-				GLC_Frustum::Localisation instanceLocalisation= frustum.localizeBoundingBox(pCurrentInstance->boundingBox());
+				const GLC_Frustum::Localisation instanceLocalisation= static_cast<GLC_Frustum::Localisation>(m_Localisations.at(instanceIndex));
 
 				if (instanceLocalisation == GLC_Frustum::OutFrustum)
 				{
@@ -283,8 +332,6 @@ void GLC_OctreeNode::updateViewableInstances(const GLC_Frustum& frustum, QSet<GL
 					}
 				}
 			}
-
-			++iInstance;
 		}
 		const int size= m_Children.size();
 		for (int i= 0; i < size; ++i)
@@ -324,7 +371,9 @@ void GLC_OctreeNode::removeEmptyChildren()
 		if (1 == m_3DViewInstanceSet.size())
 		{
 			m_pParent->m_3DViewInstanceSet.insert(*(m_3DViewInstanceSet.begin()));
+			m_pParent->m_CullingTableIsValid= false;
 			m_3DViewInstanceSet.clear();
+			m_CullingTableIsValid= false;
 		}
 		m_Empty= m_3DViewInstanceSet.isEmpty();
 	}
@@ -373,3 +422,18 @@ void GLC_OctreeNode::disableViewFlag(QSet<GLC_3DViewInstance*>* pInstanceSet)
 	}
 }
 
+void GLC_OctreeNode::updateCullingTable()
+{
+	m_CulledInstances.clear();
+	m_CullingTable.clear();
+	m_CulledInstances.reserve(m_3DViewInstanceSet.size());
+	m_CullingTable.reserve(m_3DViewInstanceSet.size());
+	QSet<GLC_3DViewInstance*>::iterator iInstance= m_3DViewInstanceSet.begin();
+	while (m_3DViewInstanceSet.constEnd() != iInstance)
+	{
+		m_CulledInstances.append(*iInstance);
+		m_CullingTable.append((*iInstance)->boundingBox());
+		++iInstance;
+	}
+	m_CullingTableIsValid= true;
+}
@@ -29,8 +29,10 @@
 #include "../glc_boundingbox.h"
 #include "../glc_config.h"
 #include "../viewport/glc_frustum.h"
+#include "../viewport/glc_frustumculler.h"
 #include <QList>
 #include <QSet>
+#include <QVector>
 
 class GLC_LIB_EXPORT GLC_OctreeNode;
 
@@ -99,6 +101,10 @@ public:
 	//! Return the list off instances inside or intersect the given bounding box
 	QSet<GLC_3DViewInstance*> setOfIntersectedInstances(const GLC_BoundingBox& bBox);
 
+	//! Insert in the given set the instances of this octree node branch inside or intersecting the given frustum
+	/*! If fullyInside is true, only instances with a bounding box inside the frustum are inserted*/
+	void instancesInFrustum(const GLC_Frustum& frustum, bool fullyInside, QSet<GLC_3DViewInstance*>* pInstanceSet);
+
 
 //@}
 
@@ -114,6 +120,10 @@ public:
 	//! Add 3d view instance in this octree node branch
 	void addInstance(GLC_3DViewInstance*, int);
 
+	//! Remove the given 3d view instance from this octree node branch
+	/*! Culling tables of the nodes which contained the instance are invalidated*/
+	void removeInstance(GLC_3DViewInstance*);
+
 	//! Update 3d view instances visibility of this octree node branch from the given frustum
 	/*! Viewable 3d view instance are inserted the the given set if exist also the set is created*/
 	void updateViewableInstances(const GLC_Frustum&, QSet<GLC_3DViewInstance*>* pInstanceSet= NULL);
@@ -135,6 +145,9 @@ private:
 	//! Disable the node and sub node view flag
 	void disableViewFlag(QSet<GLC_3DViewInstance*>*);
 
+	//! Fill the culling table with the bounding boxes of this node 3d view instances
+	void updateCullingTable();
+
 //////////////////////////////////////////////////////////////////////
 // Private members
 //////////////////////////////////////////////////////////////////////
@@ -154,6 +167,19 @@ private:
 	//! Flag to know if the node is empty
 	bool m_Empty;
 
+	//! This node 3d view instances in the order of the culling table
+	QVector<GLC_3DViewInstance*> m_CulledInstances;
+
+	//! Bounding boxes of this node 3d view instances
+	/*! Filled at the first viewable update after the node instances changed*/
+	GLC_FrustumCuller m_CullingTable;
+
+	//! Localisations of the culling table bounding boxes, kept to avoid allocations
+	QVector<quint8> m_Localisations;
+
+	//! Flag to know if the culling table is up to date
+	bool m_CullingTableIsValid;
+
 	//! Flag to know if intersection is calculated with bounding sphere
 	static bool m_useBoundingSphere;
 
@@ -0,0 +1,470 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+
+//! \file glc_pagingmanager.cpp implementation of the GLC_PagingManager class.
+
+#include "glc_pagingmanager.h"
+
+#include "../geometry/glc_3drep.h"
+#include "../io/glc_3dxmltoworld.h"
+#include "../viewport/glc_viewport.h"
+#include "../viewport/glc_frustum.h"
+#include "../glc_cachemanager.h"
+#include "../glc_exception.h"
+#include "../glc_errorlog.h"
+#include "../glc_state.h"
+#include "../glc_global.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <algorithm>
+#include <limits>
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_PagingManager::LoadingTask
+/*! \brief LoadingTask : Load a representation on a worker thread */
+//////////////////////////////////////////////////////////////////////
+class GLC_PagingManager::LoadingTask : public QRunnable
+{
+public:
+	LoadingTask(GLC_PagingManager* pManager, int generation, int index, const QString& fileName)
+		: QRunnable()
+		, m_pManager(pManager)
+		, m_Generation(generation)
+		, m_Index(index)
+		, m_FileName(fileName)
+	{}
+
+	virtual void run()
+	{
+		GLC_3DRep* pRep= NULL;
+		try
+		{
+			GLC_3dxmlToWorld loader;
+			pRep= new GLC_3DRep(loader.create3DrepFrom3dxmlRep(m_FileName));
+		}
+		catch (GLC_Exception& e)
+		{
+			QStringList stringList("GLC_PagingManager::LoadingTask");
+			stringList.append(m_FileName);
+			stringList.append(e.what());
+			GLC_ErrorLog::addError(stringList);
+		}
+		m_pManager->representationLoaded(m_Generation, m_Index, pRep);
+	}
+
+private:
+	GLC_PagingManager* m_pManager;
+	int m_Generation;
+	int m_Index;
+	QString m_FileName;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Constructor destructor
+//////////////////////////////////////////////////////////////////////
+GLC_PagingManager::GLC_PagingManager(qint64 memoryBudget, QObject* pParent)
+: QObject(pParent)
+, m_World()
+, m_RepEntries()
+, m_MemoryBudget(memoryBudget)
+, m_ResidentSize(0)
+, m_MaximumPendingLoadCount(qMax(1, QThread::idealThreadCount()))
+, m_PendingLoadCount(0)
+, m_PendingSize(0)
+, m_PageInCount(0)
+, m_PageOutCount(0)
+, m_Frame(0)
+, m_Generation(0)
+, m_Mutex()
+, m_LoadedRepresentations()
+, m_ThreadPool()
+{
+	m_ThreadPool.setMaxThreadCount(m_MaximumPendingLoadCount);
+}
+
+GLC_PagingManager::~GLC_PagingManager()
+{
+	m_ThreadPool.waitForDone();
+
+	const int count= m_LoadedRepresentations.count();
+	for (int i= 0; i < count; ++i)
+	{
+		delete m_LoadedRepresentations.at(i).m_pRep;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Get Functions
+//////////////////////////////////////////////////////////////////////
+
+int GLC_PagingManager::residentCount() const
+{
+	int count= 0;
+	const int size= m_RepEntries.size();
+	for (int i= 0; i < size; ++i)
+	{
+		if (m_RepEntries.at(i).m_IsResident) ++count;
+	}
+	return count;
+}
+
+qint64 GLC_PagingManager::representationSize(const GLC_3DRep& rep)
+{
+	// Position, normal and texture coordinate by vertex, 3 indexes by face
+	const qint64 vertexSize= 8 * sizeof(GLfloat);
+	const qint64 faceSize= 3 * sizeof(GLuint);
+	return (static_cast<qint64>(rep.vertexCount()) * vertexSize) + (static_cast<qint64>(rep.faceCount()) * faceSize);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_PagingManager::setWorld(const GLC_World& world)
+{
+	// Pending loading of the previous world are discarded
+	++m_Generation;
+	m_PendingLoadCount= 0;
+	m_PendingSize= 0;
+	m_ResidentSize= 0;
+	m_RepEntries.clear();
+	m_World= world;
+
+	const QList<GLC_StructReference*> referenceList(m_World.references());
+	const int referenceCount= referenceList.count();
+	for (int i= 0; i < referenceCount; ++i)
+	{
+		GLC_StructReference* pReference= referenceList.at(i);
+		if (!pReference->hasRepresentation() || pReference->representationFileName().isEmpty()) continue;
+		GLC_3DRep* p3DRep= dynamic_cast<GLC_3DRep*>(pReference->representationHandle());
+		if (NULL == p3DRep) continue;
+
+		RepEntry entry;
+		entry.m_pReference= pReference;
+		entry.m_FileName= pReference->representationFileName();
+		entry.m_Size= 0;
+		entry.m_Priority= -1.0;
+		entry.m_LastVisibleFrame= 0;
+		entry.m_IsResident= p3DRep->isLoaded();
+		entry.m_IsPending= false;
+		entry.m_IsPinned= false;
+		if (entry.m_IsResident)
+		{
+			entry.m_Size= representationSize(*p3DRep);
+			entry.m_BoundingBox= p3DRep->boundingBox();
+			m_ResidentSize+= entry.m_Size;
+		}
+		else
+		{
+			entry.m_BoundingBox= cachedBoundingBox(entry.m_FileName);
+		}
+		m_RepEntries.append(entry);
+	}
+}
+
+void GLC_PagingManager::clear()
+{
+	setWorld(GLC_World());
+}
+
+void GLC_PagingManager::setMaximumPendingLoadCount(int count)
+{
+	m_MaximumPendingLoadCount= qMax(1, count);
+	m_ThreadPool.setMaxThreadCount(m_MaximumPendingLoadCount);
+}
+
+bool GLC_PagingManager::update(const GLC_Viewport& viewport)
+{
+	bool worldIsModified= integrateRepresentations();
+
+	updatePriorities(viewport);
+
+	// Resident representations sorted by eviction order :
+	// not visible from the least recently visible, then visible from the smallest
+	QList<QPair<double, int> > evictionList;
+	// Visible representations to load sorted from the biggest
+	QList<QPair<double, int> > loadingList;
+	const int size= m_RepEntries.size();
+	for (int i= 0; i < size; ++i)
+	{
+		const RepEntry& entry= m_RepEntries.at(i);
+		const bool isVisible= (entry.m_LastVisibleFrame == m_Frame);
+		if (entry.m_IsResident)
+		{
+			if (entry.m_IsPinned) continue;
+			const double key= isVisible ? entry.m_Priority : -1.0 - static_cast<double>(m_Frame - entry.m_LastVisibleFrame);
+			evictionList.append(qMakePair(key, i));
+		}
+		else if (isVisible && !entry.m_IsPending)
+		{
+			loadingList.append(qMakePair(-entry.m_Priority, i));
+		}
+	}
+	std::sort(evictionList.begin(), evictionList.end());
+	std::sort(loadingList.begin(), loadingList.end());
+
+	int evictionCursor= 0;
+	const quint64 pageOutCount= m_PageOutCount;
+
+	// Budget decrease or representations of unknown size loaded
+	makeRoom(0, std::numeric_limits<double>::max(), evictionList, &evictionCursor);
+
+	const int loadingCount= loadingList.size();
+	for (int i= 0; (i < loadingCount) && (m_PendingLoadCount < m_MaximumPendingLoadCount); ++i)
+	{
+		const int index= loadingList.at(i).second;
+		const RepEntry& entry= m_RepEntries.at(index);
+		if (!makeRoom(entry.m_Size, entry.m_Priority, evictionList, &evictionCursor)) break;
+		startLoading(index);
+	}
+
+	worldIsModified= worldIsModified || (pageOutCount != m_PageOutCount);
+	return worldIsModified;
+}
+
+void GLC_PagingManager::resetStatistics()
+{
+	m_PageInCount= 0;
+	m_PageOutCount= 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private slots
+//////////////////////////////////////////////////////////////////////
+
+bool GLC_PagingManager::integrateRepresentations()
+{
+	QList<LoadedRep> loadedRepresentations;
+	{
+		QMutexLocker locker(&m_Mutex);
+		loadedRepresentations.swap(m_LoadedRepresentations);
+	}
+
+	bool worldIsModified= false;
+	const int count= loadedRepresentations.count();
+	for (int i= 0; i < count; ++i)
+	{
+		const LoadedRep& loadedRep= loadedRepresentations.at(i);
+		GLC_3DRep* pRep= loadedRep.m_pRep;
+		if (loadedRep.m_Generation == m_Generation)
+		{
+			RepEntry& entry= m_RepEntries[loadedRep.m_Index];
+			entry.m_IsPending= false;
+			--m_PendingLoadCount;
+			m_PendingSize-= entry.m_Size;
+
+			if ((NULL != pRep) && !pRep->isEmpty() && !entry.m_IsResident)
+			{
+				entry.m_Size= representationSize(*pRep);
+				entry.m_BoundingBox= pRep->boundingBox();
+				if (entry.m_pReference->loadRepresentation(pRep))
+				{
+					++m_PageInCount;
+					worldIsModified= true;
+				}
+				if (entry.m_pReference->representationIsLoaded())
+				{
+					entry.m_IsResident= true;
+					m_ResidentSize+= entry.m_Size;
+				}
+			}
+		}
+		delete pRep;
+	}
+
+	if (worldIsModified) emit representationsLoaded();
+
+	return worldIsModified;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_PagingManager::updatePriorities(const GLC_Viewport& viewport)
+{
+	++m_Frame;
+
+	const GLC_Frustum& frustum= viewport.frustum();
+	const GLC_Point3d eye(viewport.cameraHandle()->eye());
+	const double viewTangent= viewport.viewTangent();
+	GLC_3DViewCollection* pCollection= m_World.collection();
+
+	const int size= m_RepEntries.size();
+	for (int i= 0; i < size; ++i)
+	{
+		RepEntry& entry= m_RepEntries[i];
+		GLC_StructReference* pReference= entry.m_pReference;
+
+		// Representation loaded or unloaded by the application
+		if (!entry.m_IsPending && (entry.m_IsResident != pReference->representationIsLoaded()))
+		{
+			entry.m_IsResident= !entry.m_IsResident;
+			if (entry.m_IsResident)
+			{
+				const GLC_3DRep* p3DRep= dynamic_cast<GLC_3DRep*>(pReference->representationHandle());
+				entry.m_Size= representationSize(*p3DRep);
+				entry.m_BoundingBox= p3DRep->boundingBox();
+				m_ResidentSize+= entry.m_Size;
+			}
+			else
+			{
+				m_ResidentSize-= entry.m_Size;
+			}
+		}
+
+		double priority= -1.0;
+		bool isPinned= false;
+		const QList<GLC_StructOccurrence*> occurrenceList(pReference->listOfStructOccurrence());
+		const int occurrenceCount= occurrenceList.count();
+		for (int iOcc= 0; iOcc < occurrenceCount; ++iOcc)
+		{
+			GLC_StructOccurrence* pOccurrence= occurrenceList.at(iOcc);
+			if (!pOccurrence->isVisible()) continue;
+			isPinned= isPinned || m_World.isSelected(pOccurrence);
+
+			GLC_BoundingBox boundingBox;
+			if (pOccurrence->has3DViewInstance())
+			{
+				GLC_3DViewInstance* pInstance= pCollection->instanceHandle(pOccurrence->id());
+				if (!pInstance->isVisible() || (pInstance->viewableFlag() == GLC_3DViewInstance::NoViewable)) continue;
+				boundingBox= pInstance->boundingBox();
+			}
+			else if (!entry.m_BoundingBox.isEmpty())
+			{
+				boundingBox= entry.m_BoundingBox;
+				boundingBox.transform(pOccurrence->absoluteMatrix());
+			}
+			else
+			{
+				// Unknown extent, load it after representations of known extent
+				priority= qMax(priority, 0.0);
+				continue;
+			}
+
+			if (frustum.localizeBoundingBox(boundingBox) == GLC_Frustum::OutFrustum) continue;
+
+			// Screen coverage as used by GLC_3DViewInstance LOD selection
+			const double radius= boundingBox.boundingSphereRadius();
+			const double distance= qMax((boundingBox.center() - eye).length(), radius);
+			const double cameraCover= distance * viewTangent;
+			if (cameraCover > 0.0)
+			{
+				priority= qMax(priority, (radius * 2.0) / cameraCover);
+			}
+			else
+			{
+				priority= qMax(priority, 0.0);
+			}
+		}
+
+		entry.m_Priority= priority;
+		entry.m_IsPinned= isPinned;
+		if (priority >= 0.0) entry.m_LastVisibleFrame= m_Frame;
+	}
+}
+
+bool GLC_PagingManager::makeRoom(qint64 size, double priority, const QList<QPair<double, int> >& evictionList, int* pCursor)
+{
+	const int count= evictionList.size();
+	while ((m_ResidentSize + m_PendingSize + size) > m_MemoryBudget)
+	{
+		if ((*pCursor >= count) || (evictionList.at(*pCursor).first >= priority)) return false;
+
+		RepEntry* pEntry= &(m_RepEntries[evictionList.at(*pCursor).second]);
+		++(*pCursor);
+		if (pEntry->m_IsResident) unloadRepresentation(pEntry);
+	}
+	return true;
+}
+
+void GLC_PagingManager::unloadRepresentation(RepEntry* pEntry)
+{
+	GLC_StructReference* pReference= pEntry->m_pReference;
+
+	// Unload through occurrences to keep their rendering properties
+	const QList<GLC_StructOccurrence*> occurrenceList(pReference->listOfStructOccurrence());
+	const int occurrenceCount= occurrenceList.count();
+	for (int i= 0; i < occurrenceCount; ++i)
+	{
+		GLC_StructOccurrence* pOccurrence= occurrenceList.at(i);
+		if (pOccurrence->has3DViewInstance()) pOccurrence->unloadRepresentation();
+	}
+	if (pReference->representationIsLoaded()) pReference->unloadRepresentation();
+
+	if (!pReference->representationIsLoaded())
+	{
+		pEntry->m_IsResident= false;
+		m_ResidentSize-= pEntry->m_Size;
+		++m_PageOutCount;
+	}
+}
+
+void GLC_PagingManager::startLoading(int index)
+{
+	RepEntry& entry= m_RepEntries[index];
+	entry.m_IsPending= true;
+	++m_PendingLoadCount;
+	m_PendingSize+= entry.m_Size;
+
+	m_ThreadPool.start(new LoadingTask(this, m_Generation, index, entry.m_FileName));
+}
+
+GLC_BoundingBox GLC_PagingManager::cachedBoundingBox(const QString& fileName)
+{
+	GLC_BoundingBox boundingBox;
+	if (GLC_State::cacheIsUsed() && (glc::isArchiveString(fileName) || glc::isFileString(fileName)))
+	{
+		// The time stamp is not checked, the bounding box is only used to sort loading
+		const QString context(QFileInfo(glc::archiveFileName(fileName)).baseName());
+		const QString repFileName(QFileInfo(glc::archiveEntryFileName(fileName)).fileName());
+		GLC_CacheManager& cacheManager= GLC_State::currentCacheManager();
+		if (cacheManager.isCashed(context, repFileName))
+		{
+			boundingBox= cacheManager.binary3DRep(context, repFileName).boundingBox();
+		}
+	}
+	return boundingBox;
+}
+
+void GLC_PagingManager::representationLoaded(int generation, int index, GLC_3DRep* pRep)
+{
+	LoadedRep loadedRep;
+	loadedRep.m_Generation= generation;
+	loadedRep.m_Index= index;
+	loadedRep.m_pRep= pRep;
+
+	bool postIntegration;
+	{
+		QMutexLocker locker(&m_Mutex);
+		postIntegration= m_LoadedRepresentations.isEmpty();
+		m_LoadedRepresentations.append(loadedRep);
+	}
+	// Representations loaded meanwhile are integrated by the same call
+	if (postIntegration)
+	{
+		QMetaObject::invokeMethod(this, "integrateRepresentations", Qt::QueuedConnection);
+	}
+}
@@ -0,0 +1,285 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+
+//! \file glc_pagingmanager.h interface for the GLC_PagingManager class.
+
+#ifndef GLC_PAGINGMANAGER_H_
+#define GLC_PAGINGMANAGER_H_
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QThreadPool>
+
+#include "glc_world.h"
+#include "../glc_boundingbox.h"
+
+#include "../glc_config.h"
+
+class GLC_Viewport;
+class GLC_3DRep;
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_PagingManager
+/*! \brief GLC_PagingManager : Keep the representations of a world in a memory budget*/
+
+/*! GLC_PagingManager manages the representations of a world which have a
+ *  file name (3DXML loaded with the "structure only" option for example).
+ *
+ *  Each call to update() gives a priority to the representations :
+ *  	- A representation is visible if one of its occurrences is visible and
+ *  	  in the frustum of the viewport
+ *  	- Visible representations are sorted by screen coverage
+ *
+ *  Visible representations which are not loaded are loaded on worker threads
+ *  with GLC_3dxmlToWorld::create3DrepFrom3dxmlRep() which use the binary rep
+ *  cache if available. They are added to the world by the next update() or
+ *  as soon as possible in the thread of the manager.
+ *
+ *  When the memory budget is reached, the least recently visible representations
+ *  are unloaded first, then the visible representations with the smallest
+ *  screen coverage. Representations of selected occurrences are never unloaded.
+ *
+ *  The structure of the world must not be modified while it is managed.
+ */
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_PagingManager : public QObject
+{
+	Q_OBJECT
+
+	class LoadingTask;
+
+	//! A managed representation
+	struct RepEntry
+	{
+		//! The reference of the representation
+		GLC_StructReference* m_pReference;
+
+		//! The file name of the representation
+		QString m_FileName;
+
+		//! The bounding box of the representation in reference coordinate
+		GLC_BoundingBox m_BoundingBox;
+
+		//! The size in bytes of the representation, 0 if unknown
+		qint64 m_Size;
+
+		//! The screen coverage of the representation at the last update
+		double m_Priority;
+
+		//! The last update where the representation was visible
+		quint64 m_LastVisibleFrame;
+
+		//! True if the representation is loaded
+		bool m_IsResident;
+
+		//! True if the representation is being loaded
+		bool m_IsPending;
+
+		//! True if an occurrence of the representation is selected
+		bool m_IsPinned;
+	};
+
+	//! A representation loaded by a worker thread
+	struct LoadedRep
+	{
+		//! The generation of the managed world when the loading started
+		int m_Generation;
+
+		//! The index of the representation entry
+		int m_Index;
+
+		//! The loaded representation, NULL on error
+		GLC_3DRep* m_pRep;
+	};
+
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Construct a paging manager with the given memory budget in bytes
+	explicit GLC_PagingManager(qint64 memoryBudget= 512 * 1024 * 1024, QObject* pParent= NULL);
+
+	//! Wait for pending loading and destroy the paging manager
+	virtual ~GLC_PagingManager();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return the managed world
+	inline GLC_World world() const
+	{return m_World;}
+
+	//! Return the memory budget in bytes
+	inline qint64 memoryBudget() const
+	{return m_MemoryBudget;}
+
+	//! Return the maximum number of representations loading at the same time
+	inline int maximumPendingLoadCount() const
+	{return m_MaximumPendingLoadCount;}
+
+	//! Return the estimated size in bytes of loaded representations
+	inline qint64 residentSize() const
+	{return m_ResidentSize;}
+
+	//! Return the number of managed representations
+	inline int representationCount() const
+	{return m_RepEntries.size();}
+
+	//! Return the number of loaded managed representations
+	int residentCount() const;
+
+	//! Return the number of representations being loaded
+	inline int pendingLoadCount() const
+	{return m_PendingLoadCount;}
+
+	//! Return the number of representations loaded since the last statistics reset
+	inline quint64 pageInCount() const
+	{return m_PageInCount;}
+
+	//! Return the number of representations unloaded since the last statistics reset
+	inline quint64 pageOutCount() const
+	{return m_PageOutCount;}
+
+	//! Return the estimated size in bytes of the given loaded representation
+	static qint64 representationSize(const GLC_3DRep& rep);
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Manage the representations of the given world
+	/*! Loaded representations of the world are counted in the resident size*/
+	void setWorld(const GLC_World& world);
+
+	//! Stop managing the world, loaded representations stay loaded
+	void clear();
+
+	//! Set the memory budget in bytes
+	/*! The budget is applied by the next update()*/
+	inline void setMemoryBudget(qint64 budget)
+	{m_MemoryBudget= budget;}
+
+	//! Set the maximum number of representations loading at the same time
+	void setMaximumPendingLoadCount(int count);
+
+	//! Update priorities for the given viewport, unload and load representations
+	/*! Return true if the world has been modified*/
+	bool update(const GLC_Viewport& viewport);
+
+	//! Reset page in and page out counters
+	void resetStatistics();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Qt Signals
+//////////////////////////////////////////////////////////////////////
+signals:
+	//! Representations have been loaded and added to the world
+	void representationsLoaded();
+
+//////////////////////////////////////////////////////////////////////
+// Private slots
+//////////////////////////////////////////////////////////////////////
+private slots:
+	//! Add loaded representations to the world
+	bool integrateRepresentations();
+
+//////////////////////////////////////////////////////////////////////
+// Private services functions
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Compute the priority and visibility of all representations
+	void updatePriorities(const GLC_Viewport& viewport);
+
+	//! Unload representations of the eviction list until the given size fits in the budget
+	/*! Only representations with an eviction key lower than the given priority are unloaded.
+	 *  Return true if the size fits in the budget*/
+	bool makeRoom(qint64 size, double priority, const QList<QPair<double, int> >& evictionList, int* pCursor);
+
+	//! Unload the representation of the given entry
+	void unloadRepresentation(RepEntry* pEntry);
+
+	//! Start the loading of the given entry
+	void startLoading(int index);
+
+	//! Return the bounding box of the given representation from the binary rep cache
+	static GLC_BoundingBox cachedBoundingBox(const QString& fileName);
+
+	//! Called by loading tasks from worker threads
+	void representationLoaded(int generation, int index, GLC_3DRep* pRep);
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! The managed world
+	GLC_World m_World;
+
+	//! The managed representations
+	QVector<RepEntry> m_RepEntries;
+
+	//! The memory budget in bytes
+	qint64 m_MemoryBudget;
+
+	//! The estimated size of loaded representations
+	qint64 m_ResidentSize;
+
+	//! The maximum number of representations loading at the same time
+	int m_MaximumPendingLoadCount;
+
+	//! The number of representations being loaded
+	int m_PendingLoadCount;
+
+	//! The known size of representations being loaded
+	qint64 m_PendingSize;
+
+	//! Page in and page out counters
+	quint64 m_PageInCount;
+	quint64 m_PageOutCount;
+
+	//! The current update number
+	quint64 m_Frame;
+
+	//! Incremented each time the world changes, discard obsolete loading
+	int m_Generation;
+
+	//! Protect the list of loaded representations
+	QMutex m_Mutex;
+
+	//! Representations loaded by worker threads and not yet added to the world
+	QList<LoadedRep> m_LoadedRepresentations;
+
+	//! The pool of loading threads
+	QThreadPool m_ThreadPool;
+};
+
+#endif /* GLC_PAGINGMANAGER_H_ */
@@ -0,0 +1,213 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_raypicker.cpp implementation of the GLC_RayPicker class.
+
+#include "glc_raypicker.h"
+#include "glc_3dviewcollection.h"
+#include "glc_3dviewinstance.h"
+#include "../geometry/glc_mesh.h"
+
+#include <cfloat>
+
+struct GLC_RayPicker::TriangleIntersector
+{
+	const float* m_pTriangles;
+	const float* m_pOrigin;
+	const float* m_pDirection;
+	int m_HitTriangle;
+
+	// Moller Trumbore ray triangle intersection
+	inline bool operator()(int index, float* pDistance)
+	{
+		const float* p0= m_pTriangles + (9 * index);
+		const float* p1= p0 + 3;
+		const float* p2= p0 + 6;
+		const float edge1[3]= {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+		const float edge2[3]= {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+		const float* d= m_pDirection;
+		const float p[3]= {(d[1] * edge2[2]) - (d[2] * edge2[1]), (d[2] * edge2[0]) - (d[0] * edge2[2]), (d[0] * edge2[1]) - (d[1] * edge2[0])};
+		const float determinant= (edge1[0] * p[0]) + (edge1[1] * p[1]) + (edge1[2] * p[2]);
+		if (0.0f == determinant) return false;
+		const float inverseDeterminant= 1.0f / determinant;
+
+		const float s[3]= {m_pOrigin[0] - p0[0], m_pOrigin[1] - p0[1], m_pOrigin[2] - p0[2]};
+		const float u= ((s[0] * p[0]) + (s[1] * p[1]) + (s[2] * p[2])) * inverseDeterminant;
+		if ((u < 0.0f) || (u > 1.0f)) return false;
+
+		const float q[3]= {(s[1] * edge1[2]) - (s[2] * edge1[1]), (s[2] * edge1[0]) - (s[0] * edge1[2]), (s[0] * edge1[1]) - (s[1] * edge1[0])};
+		const float v= ((d[0] * q[0]) + (d[1] * q[1]) + (d[2] * q[2])) * inverseDeterminant;
+		if ((v < 0.0f) || ((u + v) > 1.0f)) return false;
+
+		const float distance= ((edge2[0] * q[0]) + (edge2[1] * q[1]) + (edge2[2] * q[2])) * inverseDeterminant;
+		if ((distance < 0.0f) || (distance >= *pDistance)) return false;
+
+		*pDistance= distance;
+		m_HitTriangle= index;
+		return true;
+	}
+};
+
+struct GLC_RayPicker::InstanceIntersector
+{
+	GLC_RayPicker* m_pPicker;
+	GLC_Point3d m_Origin;
+	GLC_Vector3d m_Direction;
+	int m_HitInstance;
+	int m_HitBody;
+	GLC_uint m_HitPrimitiveId;
+
+	// The ray is transformed in instance coordinates, distances are unchanged
+	bool operator()(int index, float* pDistance)
+	{
+		const PickableInstance& pickableInstance= m_pPicker->m_Instances.at(index);
+		GLC_3DViewInstance* pInstance= pickableInstance.m_pInstance;
+		const GLC_Point3d localOrigin(pickableInstance.m_InverseMatrix * m_Origin);
+		const GLC_Vector3d localDirection((pickableInstance.m_InverseMatrix * (m_Origin + m_Direction)) - localOrigin);
+		const float origin[3]= {static_cast<float>(localOrigin.x()), static_cast<float>(localOrigin.y()), static_cast<float>(localOrigin.z())};
+		const float direction[3]= {static_cast<float>(localDirection.x()), static_cast<float>(localDirection.y()), static_cast<float>(localDirection.z())};
+
+		bool isHit= false;
+		const int bodyCount= pInstance->numberOfBody();
+		for (int body= 0; body < bodyCount; ++body)
+		{
+			GLC_Mesh* pMesh= dynamic_cast<GLC_Mesh*>(pInstance->geomAt(body));
+			if (NULL == pMesh) continue;
+			const GLC_MeshBvh* pHierarchy= m_pPicker->meshHierarchy(pMesh);
+			TriangleIntersector intersector;
+			intersector.m_pTriangles= pHierarchy->triangles();
+			intersector.m_pOrigin= origin;
+			intersector.m_pDirection= direction;
+			intersector.m_HitTriangle= -1;
+			if (pHierarchy->bvh().intersect(origin, direction, pDistance, intersector))
+			{
+				m_HitInstance= index;
+				m_HitBody= body;
+				m_HitPrimitiveId= pHierarchy->primitiveId(intersector.m_HitTriangle);
+				isHit= true;
+			}
+		}
+		return isHit;
+	}
+};
+
+GLC_RayPicker::GLC_RayPicker(GLC_3DViewCollection* pCollection)
+: m_pCollection(pCollection)
+, m_Instances()
+, m_InstanceBvh()
+, m_IsUpToDate(false)
+, m_MeshHierarchies()
+{
+
+}
+
+GLC_RayPicker::~GLC_RayPicker()
+{
+	clearMeshHierarchies();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+bool GLC_RayPicker::pick(const GLC_Line3d& ray, GLC_uint* pInstanceId, int* pBodyIndex, GLC_uint* pPrimitiveId, GLC_Point3d* pPoint)
+{
+	if (!m_IsUpToDate) update();
+
+	const GLC_Point3d rayOrigin(ray.startingPoint());
+	const GLC_Vector3d rayDirection(ray.direction().normalize());
+	const float origin[3]= {static_cast<float>(rayOrigin.x()), static_cast<float>(rayOrigin.y()), static_cast<float>(rayOrigin.z())};
+	const float direction[3]= {static_cast<float>(rayDirection.x()), static_cast<float>(rayDirection.y()), static_cast<float>(rayDirection.z())};
+
+	InstanceIntersector intersector;
+	intersector.m_pPicker= this;
+	intersector.m_Origin= rayOrigin;
+	intersector.m_Direction= rayDirection;
+	intersector.m_HitInstance= -1;
+	intersector.m_HitBody= -1;
+	intersector.m_HitPrimitiveId= 0;
+	float distance= FLT_MAX;
+	if (!m_InstanceBvh.intersect(origin, direction, &distance, intersector)) return false;
+
+	if (NULL != pInstanceId) *pInstanceId= m_Instances.at(intersector.m_HitInstance).m_pInstance->id();
+	if (NULL != pBodyIndex) *pBodyIndex= intersector.m_HitBody;
+	if (NULL != pPrimitiveId) *pPrimitiveId= intersector.m_HitPrimitiveId;
+	if (NULL != pPoint) *pPoint= rayOrigin + (rayDirection * static_cast<double>(distance));
+
+	return true;
+}
+
+void GLC_RayPicker::update()
+{
+	m_Instances.clear();
+	QVector<float> boxes;
+	const bool showState= m_pCollection->showState();
+	const QList<GLC_3DViewInstance*> instances(m_pCollection->instancesHandle());
+	const int instanceCount= instances.size();
+	m_Instances.reserve(instanceCount);
+	boxes.reserve(6 * instanceCount);
+	for (int i= 0; i < instanceCount; ++i)
+	{
+		GLC_3DViewInstance* pInstance= instances.at(i);
+		if (pInstance->isVisible() != showState) continue;
+		const GLC_BoundingBox boundingBox(pInstance->boundingBox());
+		if (boundingBox.isEmpty()) continue;
+
+		PickableInstance pickableInstance;
+		pickableInstance.m_pInstance= pInstance;
+		pickableInstance.m_InverseMatrix= pInstance->matrix().inverted();
+		m_Instances.append(pickableInstance);
+
+		// Enlarge the box to cover float rounding
+		const GLC_Point3d& lower= boundingBox.lowerCorner();
+		const GLC_Point3d& upper= boundingBox.upperCorner();
+		const double margin= 1e-5 * (upper - lower).length();
+		boxes << static_cast<float>(lower.x() - margin) << static_cast<float>(lower.y() - margin) << static_cast<float>(lower.z() - margin)
+				<< static_cast<float>(upper.x() + margin) << static_cast<float>(upper.y() + margin) << static_cast<float>(upper.z() + margin);
+	}
+	m_InstanceBvh.build(boxes);
+	m_IsUpToDate= true;
+
+	// Meshes of removed instances may have been deleted
+	GLC_MeshBvh::pruneHierarchies(&m_MeshHierarchies, instances);
+}
+
+void GLC_RayPicker::clearMeshHierarchies()
+{
+	qDeleteAll(m_MeshHierarchies);
+	m_MeshHierarchies.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+const GLC_MeshBvh* GLC_RayPicker::meshHierarchy(GLC_Mesh* pMesh)
+{
+	GLC_MeshBvh* pHierarchy= m_MeshHierarchies.value(pMesh->id(), NULL);
+	if (NULL == pHierarchy)
+	{
+		pHierarchy= new GLC_MeshBvh(pMesh);
+		m_MeshHierarchies.insert(pMesh->id(), pHierarchy);
+	}
+
+	return pHierarchy;
+}
@@ -0,0 +1,145 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_raypicker.h interface for the GLC_RayPicker class.
+
+#ifndef GLC_RAYPICKER_H_
+#define GLC_RAYPICKER_H_
+
+#include <QHash>
+#include <QVector>
+
+#include "glc_meshbvh.h"
+#include "../maths/glc_line3d.h"
+#include "../maths/glc_matrix4x4.h"
+#include "../glc_global.h"
+
+#include "../glc_config.h"
+
+class GLC_3DViewCollection;
+class GLC_3DViewInstance;
+class GLC_Mesh;
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_RayPicker
+/*! \brief GLC_RayPicker : Pick the instances of a collection with a ray on the CPU */
+
+/*! A hierarchy of the bounding boxes of the collection instances is built by update().
+ *  The hierarchy of the triangles of the master LOD of each mesh is built the first time
+ *  the ray reaches the mesh and is kept until the mesh leaves the collection or
+ *  clearMeshHierarchies() is called.
+ *  Apart from the first pick of a mesh whose data are only in its VBO, picking doesn't
+ *  use OpenGL.*/
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_RayPicker
+{
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Construct a picker of the instances of the given collection
+	explicit GLC_RayPicker(GLC_3DViewCollection* pCollection);
+
+	//! Destructor
+	~GLC_RayPicker();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return the collection of this picker
+	inline GLC_3DViewCollection* collectionHandle() const
+	{return m_pCollection;}
+
+	//! Return the number of mesh hierarchies built
+	inline int meshHierarchyCount() const
+	{return m_MeshHierarchies.size();}
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return true if the given ray hits a mesh of a visible instance
+	/*! The instance id, the body index, the primitive id and the point of the nearest hit
+	 *  are set if the given pointers are not NULL. The primitive id is 0 if the mesh has no
+	 *  primitive id.
+	 *  Must be called with the OpenGL context current if a reached mesh has no hierarchy yet
+	 *  and its data are only in its VBO*/
+	bool pick(const GLC_Line3d& ray, GLC_uint* pInstanceId, int* pBodyIndex= NULL, GLC_uint* pPrimitiveId= NULL, GLC_Point3d* pPoint= NULL);
+
+	//! Update the hierarchy of the collection instances
+	/*! Must be called if instances are added, removed, moved, shown or hidden.
+	 *  Hierarchies of meshes no longer used by the collection are deleted*/
+	void update();
+
+	//! Clear the hierarchies of meshes
+	/*! Must be called if the geometry of meshes is changed*/
+	void clearMeshHierarchies();
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Private services function
+//////////////////////////////////////////////////////////////////////
+private:
+	//! An instance of the hierarchy and its inverted matrix
+	struct PickableInstance
+	{
+		GLC_3DViewInstance* m_pInstance;
+		GLC_Matrix4x4 m_InverseMatrix;
+	};
+
+	//! Intersect the triangles of a mesh with the ray in mesh coordinates
+	struct TriangleIntersector;
+
+	//! Intersect the meshes of an instance with the ray
+	struct InstanceIntersector;
+
+	//! Return the hierarchy of the given mesh, build it if needed
+	const GLC_MeshBvh* meshHierarchy(GLC_Mesh* pMesh);
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! The picked collection
+	GLC_3DViewCollection* m_pCollection;
+
+	//! Instances of the hierarchy
+	QVector<PickableInstance> m_Instances;
+
+	//! The hierarchy of instances bounding boxes
+	GLC_Bvh m_InstanceBvh;
+
+	//! Flag to know if the instances hierarchy is built
+	bool m_IsUpToDate;
+
+	//! Mesh hierarchies by mesh id
+	QHash<GLC_uint, GLC_MeshBvh*> m_MeshHierarchies;
+};
+
+#endif /* GLC_RAYPICKER_H_ */
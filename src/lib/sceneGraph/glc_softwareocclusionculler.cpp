@@ -0,0 +1,325 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_softwareocclusionculler.cpp implementation of the GLC_SoftwareOcclusionCuller class.
+
+#include "glc_softwareocclusionculler.h"
+
+#include <QtGlobal>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define GLC_SOFTWAREOCCLUSIONCULLER_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+// Screen depth of a vertex which can't be projected
+const float invalidDepth= -1.0f;
+
+// Project the given position with the given column major matrix in screen space
+// Return false if the position is not in front of the near plane
+inline bool projectToScreen(const double* m, double x, double y, double z, int width, int height, float* pResult)
+{
+	const double w= (m[3] * x) + (m[7] * y) + (m[11] * z) + m[15];
+	if (w <= 0.0) return false;
+	const double inverseW= 1.0 / w;
+	const double depth= ((m[2] * x) + (m[6] * y) + (m[10] * z) + m[14]) * inverseW * 0.5 + 0.5;
+	if (depth < 0.0) return false;
+	pResult[0]= static_cast<float>((((m[0] * x) + (m[4] * y) + (m[8] * z) + m[12]) * inverseW * 0.5 + 0.5) * width);
+	pResult[1]= static_cast<float>((((m[1] * x) + (m[5] * y) + (m[9] * z) + m[13]) * inverseW * 0.5 + 0.5) * height);
+	pResult[2]= static_cast<float>(depth);
+	return true;
+}
+}
+
+GLC_SoftwareOcclusionCuller::GLC_SoftwareOcclusionCuller(int width, int height)
+: m_Width(0)
+, m_Height(0)
+, m_Stride(0)
+, m_ViewProjectionMatrix()
+, m_DepthLevels()
+, m_LevelWidths()
+, m_LevelHeights()
+, m_ScreenVertices()
+, m_PyramidIsValid(false)
+, m_RasterizedTriangleCount(0)
+{
+	setResolution(width, height);
+}
+
+GLC_SoftwareOcclusionCuller::~GLC_SoftwareOcclusionCuller()
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////
+// Get Functions
+//////////////////////////////////////////////////////////////////////
+
+float GLC_SoftwareOcclusionCuller::depthAt(int x, int y, int level) const
+{
+	Q_ASSERT((level >= 0) && (level < levelCount()));
+	Q_ASSERT((x >= 0) && (x < m_LevelWidths.at(level)) && (y >= 0) && (y < m_LevelHeights.at(level)));
+	const int stride= (0 == level) ? m_Stride : m_LevelWidths.at(level);
+	return m_DepthLevels.at(level).at((y * stride) + x);
+}
+
+bool GLC_SoftwareOcclusionCuller::isOccluded(const GLC_BoundingBox& boundingBox) const
+{
+	if (!m_PyramidIsValid || boundingBox.isEmpty()) return false;
+
+	// Screen rectangle and nearest depth of the bounding box
+	const double* pMatrix= m_ViewProjectionMatrix.getData();
+	const GLC_Point3d& lower= boundingBox.lowerCorner();
+	const GLC_Point3d& upper= boundingBox.upperCorner();
+	float minX= static_cast<float>(m_Width);
+	float minY= static_cast<float>(m_Height);
+	float maxX= 0.0f;
+	float maxY= 0.0f;
+	float minDepth= 1.0f;
+	for (int i= 0; i < 8; ++i)
+	{
+		float corner[3];
+		const double x= (i & 1) ? upper.x() : lower.x();
+		const double y= (i & 2) ? upper.y() : lower.y();
+		const double z= (i & 4) ? upper.z() : lower.z();
+		if (!projectToScreen(pMatrix, x, y, z, m_Width, m_Height, corner)) return false;
+		minX= qMin(minX, corner[0]);
+		maxX= qMax(maxX, corner[0]);
+		minY= qMin(minY, corner[1]);
+		maxY= qMax(maxY, corner[1]);
+		minDepth= qMin(minDepth, corner[2]);
+	}
+	if ((maxX < 0.0f) || (maxY < 0.0f) || (minX >= m_Width) || (minY >= m_Height)) return false;
+
+	// The rectangle is enlarged by one pixel because occluders are sampled at pixel centers
+	const int x0= qMax(0, static_cast<int>(floor(minX)) - 1);
+	const int x1= qMin(m_Width - 1, static_cast<int>(floor(maxX)) + 1);
+	const int y0= qMax(0, static_cast<int>(floor(minY)) - 1);
+	const int y1= qMin(m_Height - 1, static_cast<int>(floor(maxY)) + 1);
+
+	// Use the level where the rectangle covers a few texels
+	int level= 0;
+	int size= qMax(x1 - x0, y1 - y0) + 1;
+	while ((size > 4) && ((level + 1) < levelCount()))
+	{
+		size= (size + 1) / 2;
+		++level;
+	}
+	const float* pDepths= m_DepthLevels.at(level).constData();
+	const int stride= (0 == level) ? m_Stride : m_LevelWidths.at(level);
+	for (int y= (y0 >> level); y <= (y1 >> level); ++y)
+	{
+		for (int x= (x0 >> level); x <= (x1 >> level); ++x)
+		{
+			if (pDepths[(y * stride) + x] >= minDepth) return false;
+		}
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_SoftwareOcclusionCuller::setResolution(int width, int height)
+{
+	Q_ASSERT((width > 0) && (height > 0));
+	m_Width= width;
+	m_Height= height;
+	m_Stride= (width + 3) & ~3;
+
+	m_LevelWidths.clear();
+	m_LevelHeights.clear();
+	m_DepthLevels.clear();
+	m_LevelWidths.append(width);
+	m_LevelHeights.append(height);
+	m_DepthLevels.append(QVector<float>(m_Stride * height, 1.0f));
+	while ((width > 1) || (height > 1))
+	{
+		width= (width + 1) / 2;
+		height= (height + 1) / 2;
+		m_LevelWidths.append(width);
+		m_LevelHeights.append(height);
+		m_DepthLevels.append(QVector<float>(width * height, 1.0f));
+	}
+	m_PyramidIsValid= false;
+}
+
+void GLC_SoftwareOcclusionCuller::beginFrame(const GLC_Matrix4x4& viewProjectionMatrix)
+{
+	m_ViewProjectionMatrix= viewProjectionMatrix;
+	m_DepthLevels[0].fill(1.0f);
+	m_PyramidIsValid= false;
+	m_RasterizedTriangleCount= 0;
+}
+
+void GLC_SoftwareOcclusionCuller::addOccluder(const float* pPositions, int vertexCount, const unsigned int* pIndexes, int indexCount, const GLC_Matrix4x4& matrix)
+{
+	const GLC_Matrix4x4 transformation(m_ViewProjectionMatrix * matrix);
+	const double* pMatrix= transformation.getData();
+
+	m_ScreenVertices.resize(vertexCount * 3);
+	float* pScreenVertices= m_ScreenVertices.data();
+	for (int i= 0; i < vertexCount; ++i)
+	{
+		const float* pPosition= pPositions + (3 * i);
+		if (!projectToScreen(pMatrix, pPosition[0], pPosition[1], pPosition[2], m_Width, m_Height, pScreenVertices + (3 * i)))
+		{
+			pScreenVertices[(3 * i) + 2]= invalidDepth;
+		}
+	}
+
+	for (int i= 0; (i + 2) < indexCount; i+= 3)
+	{
+		const unsigned int index0= pIndexes[i];
+		const unsigned int index1= pIndexes[i + 1];
+		const unsigned int index2= pIndexes[i + 2];
+		const unsigned int count= static_cast<unsigned int>(vertexCount);
+		if ((index0 >= count) || (index1 >= count) || (index2 >= count)) continue;
+
+		const float* pVertex0= pScreenVertices + (3 * index0);
+		const float* pVertex1= pScreenVertices + (3 * index1);
+		const float* pVertex2= pScreenVertices + (3 * index2);
+		// Triangles crossing the near plane are ignored
+		if ((pVertex0[2] < 0.0f) || (pVertex1[2] < 0.0f) || (pVertex2[2] < 0.0f)) continue;
+
+		// The farthest depth of the triangle keeps the occlusion conservative
+		const float depth= qMax(pVertex0[2], qMax(pVertex1[2], pVertex2[2]));
+		rasterizeTriangle(pVertex0, pVertex1, pVertex2, depth);
+	}
+	m_PyramidIsValid= false;
+}
+
+void GLC_SoftwareOcclusionCuller::buildDepthPyramid()
+{
+	const int count= levelCount();
+	for (int level= 1; level < count; ++level)
+	{
+		const int sourceWidth= m_LevelWidths.at(level - 1);
+		const int sourceHeight= m_LevelHeights.at(level - 1);
+		const int sourceStride= (1 == level) ? m_Stride : sourceWidth;
+		const float* pSource= m_DepthLevels.at(level - 1).constData();
+
+		const int width= m_LevelWidths.at(level);
+		const int height= m_LevelHeights.at(level);
+		float* pTarget= m_DepthLevels[level].data();
+		for (int y= 0; y < height; ++y)
+		{
+			const float* pRow0= pSource + ((2 * y) * sourceStride);
+			const float* pRow1= pSource + (qMin((2 * y) + 1, sourceHeight - 1) * sourceStride);
+			for (int x= 0; x < width; ++x)
+			{
+				const int x0= 2 * x;
+				const int x1= qMin(x0 + 1, sourceWidth - 1);
+				pTarget[(y * width) + x]= qMax(qMax(pRow0[x0], pRow0[x1]), qMax(pRow1[x0], pRow1[x1]));
+			}
+		}
+	}
+	m_PyramidIsValid= true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_SoftwareOcclusionCuller::rasterizeTriangle(const float* pVertex0, const float* pVertex1, const float* pVertex2, float depth)
+{
+	float doubledArea= ((pVertex1[0] - pVertex0[0]) * (pVertex2[1] - pVertex0[1])) - ((pVertex2[0] - pVertex0[0]) * (pVertex1[1] - pVertex0[1]));
+	if (0.0f == doubledArea) return;
+	if (doubledArea < 0.0f) std::swap(pVertex1, pVertex2);
+
+	// Pixels whose center is inside the bounding rectangle of the triangle
+	const float minX= qMin(pVertex0[0], qMin(pVertex1[0], pVertex2[0]));
+	const float maxX= qMax(pVertex0[0], qMax(pVertex1[0], pVertex2[0]));
+	const float minY= qMin(pVertex0[1], qMin(pVertex1[1], pVertex2[1]));
+	const float maxY= qMax(pVertex0[1], qMax(pVertex1[1], pVertex2[1]));
+	const int x0= qMax(0, static_cast<int>(ceil(minX - 0.5f)));
+	const int x1= qMin(m_Width - 1, static_cast<int>(floor(maxX - 0.5f)));
+	const int y0= qMax(0, static_cast<int>(ceil(minY - 0.5f)));
+	const int y1= qMin(m_Height - 1, static_cast<int>(floor(maxY - 0.5f)));
+	if ((x0 > x1) || (y0 > y1)) return;
+	++m_RasterizedTriangleCount;
+
+	// Edge functions a * x + b * y + c, positive inside the triangle
+	// Pixels on a shared edge are written by both triangles so meshes have no cracks
+	const float* pVertices[3]= {pVertex0, pVertex1, pVertex2};
+	float a[3];
+	float b[3];
+	float c[3];
+	for (int i= 0; i < 3; ++i)
+	{
+		const float* pFrom= pVertices[(i + 1) % 3];
+		const float* pTo= pVertices[(i + 2) % 3];
+		a[i]= pFrom[1] - pTo[1];
+		b[i]= pTo[0] - pFrom[0];
+		c[i]= (pFrom[0] * pTo[1]) - (pTo[0] * pFrom[1]);
+	}
+
+	float* pDepths= m_DepthLevels[0].data();
+	for (int y= y0; y <= y1; ++y)
+	{
+		const float centerY= static_cast<float>(y) + 0.5f;
+		const float rowEdge0= (b[0] * centerY) + c[0];
+		const float rowEdge1= (b[1] * centerY) + c[1];
+		const float rowEdge2= (b[2] * centerY) + c[2];
+		float* pRow= pDepths + (y * m_Stride);
+#ifdef GLC_SOFTWAREOCCLUSIONCULLER_SSE
+		// 4 pixels at a time from an aligned pixel, lanes outside [x0, x1] are masked
+		const __m128 zero= _mm_setzero_ps();
+		const __m128 triangleDepth= _mm_set1_ps(depth);
+		const __m128 first= _mm_set1_ps(static_cast<float>(x0));
+		const __m128 last= _mm_set1_ps(static_cast<float>(x1));
+		const __m128 a0= _mm_set1_ps(a[0]);
+		const __m128 a1= _mm_set1_ps(a[1]);
+		const __m128 a2= _mm_set1_ps(a[2]);
+		const __m128 edge0= _mm_set1_ps(rowEdge0);
+		const __m128 edge1= _mm_set1_ps(rowEdge1);
+		const __m128 edge2= _mm_set1_ps(rowEdge2);
+		for (int x= (x0 & ~3); x <= x1; x+= 4)
+		{
+			const __m128 pixelX= _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+			const __m128 centerX= _mm_add_ps(pixelX, _mm_set1_ps(0.5f));
+			__m128 mask= _mm_and_ps(_mm_cmpge_ps(pixelX, first), _mm_cmple_ps(pixelX, last));
+			mask= _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, centerX), edge0), zero));
+			mask= _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, centerX), edge1), zero));
+			mask= _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, centerX), edge2), zero));
+			if (0 == _mm_movemask_ps(mask)) continue;
+			const __m128 previousDepth= _mm_loadu_ps(pRow + x);
+			const __m128 newDepth= _mm_min_ps(previousDepth, triangleDepth);
+			_mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(mask, newDepth), _mm_andnot_ps(mask, previousDepth)));
+		}
+#else
+		for (int x= x0; x <= x1; ++x)
+		{
+			const float centerX= static_cast<float>(x) + 0.5f;
+			if ((((a[0] * centerX) + rowEdge0) >= 0.0f) && (((a[1] * centerX) + rowEdge1) >= 0.0f) && (((a[2] * centerX) + rowEdge2) >= 0.0f))
+			{
+				pRow[x]= qMin(pRow[x], depth);
+			}
+		}
+#endif
+	}
+}
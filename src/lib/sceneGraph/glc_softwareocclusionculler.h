@@ -0,0 +1,151 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_softwareocclusionculler.h interface for the GLC_SoftwareOcclusionCuller class.
+
+#ifndef GLC_SOFTWAREOCCLUSIONCULLER_H_
+#define GLC_SOFTWAREOCCLUSIONCULLER_H_
+
+#include <QVector>
+
+#include "../maths/glc_matrix4x4.h"
+#include "../glc_boundingbox.h"
+#include "../glc_config.h"
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_SoftwareOcclusionCuller
+/*! \brief GLC_SoftwareOcclusionCuller : Test bounding boxes against occluders rasterized on the CPU */
+
+/*! Occluder triangles are rasterized in a low resolution depth buffer, sampled at pixel centers,
+ *  with the farthest depth of each triangle so occluders never hide more than they do on screen.
+ *  A hierarchical depth pyramid, which keeps the farthest depth of each 2x2 block, is then built
+ *  and a bounding box is occluded if its nearest depth is behind all the pyramid texels covered
+ *  by its screen rectangle enlarged by one pixel.
+ *  This class doesn't use OpenGL, so it can be checked without a context: after beginFrame()
+ *  with a view projection matrix, addOccluder() with a quad facing the camera and
+ *  buildDepthPyramid(), depthAt() returns the quad depth inside its screen rectangle and 1
+ *  outside, and isOccluded() is true for a box behind the quad and false for a box beside it.*/
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_SoftwareOcclusionCuller
+{
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Construct a culler with a depth buffer of the given size
+	GLC_SoftwareOcclusionCuller(int width= 256, int height= 128);
+
+	//! Destructor
+	~GLC_SoftwareOcclusionCuller();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return the depth buffer width
+	inline int width() const
+	{return m_Width;}
+
+	//! Return the depth buffer height
+	inline int height() const
+	{return m_Height;}
+
+	//! Return the number of levels of the depth pyramid
+	inline int levelCount() const
+	{return m_LevelWidths.size();}
+
+	//! Return the depth of the pixel at the given position of the given pyramid level
+	/*! The depth is in the range [0, 1], 1 is the far plane*/
+	float depthAt(int x, int y, int level= 0) const;
+
+	//! Return the number of occluder triangles rasterized since the last beginFrame()
+	inline int rasterizedTriangleCount() const
+	{return m_RasterizedTriangleCount;}
+
+	//! Return true if the given bounding box is hidden by the occluders
+	/*! The depth pyramid must be built. A bounding box crossing the near plane is never occluded*/
+	bool isOccluded(const GLC_BoundingBox& boundingBox) const;
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Set the size of the depth buffer
+	void setResolution(int width, int height);
+
+	//! Clear the depth buffer and set the view projection matrix of the frame
+	void beginFrame(const GLC_Matrix4x4& viewProjectionMatrix);
+
+	//! Rasterize the given indexed triangles transformed by the given matrix
+	/*! Positions are x, y, z triplets and each 3 indexes make a triangle.
+	 *  Triangles crossing the near plane are ignored*/
+	void addOccluder(const float* pPositions, int vertexCount, const unsigned int* pIndexes, int indexCount, const GLC_Matrix4x4& matrix);
+
+	//! Build the depth pyramid from the rasterized occluders
+	void buildDepthPyramid();
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Private services function
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Rasterize the given screen space triangle with the given depth
+	void rasterizeTriangle(const float* pVertex0, const float* pVertex1, const float* pVertex2, float depth);
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Depth buffer size
+	int m_Width;
+	int m_Height;
+
+	//! Row stride of the first level, a multiple of 4 pixels
+	int m_Stride;
+
+	//! The view projection matrix of the frame
+	GLC_Matrix4x4 m_ViewProjectionMatrix;
+
+	//! Depth pyramid levels, the first one is the depth buffer
+	QVector<QVector<float> > m_DepthLevels;
+
+	//! Size of each level
+	QVector<int> m_LevelWidths;
+	QVector<int> m_LevelHeights;
+
+	//! Screen space vertices of the current occluder, kept to avoid allocations
+	QVector<float> m_ScreenVertices;
+
+	//! Flag to know if the pyramid is up to date
+	bool m_PyramidIsValid;
+
+	//! Number of rasterized triangles
+	int m_RasterizedTriangleCount;
+};
+
+#endif /* GLC_SOFTWAREOCCLUSIONCULLER_H_ */
@@ -23,6 +23,7 @@
 
 #include "glc_spacepartitioning.h"
 #include "glc_3dviewcollection.h"
+#include "../viewport/glc_frustumculler.h"
 
 #include <QtGlobal>
 
@@ -45,6 +46,32 @@ GLC_SpacePartitioning::~GLC_SpacePartitioning()
 
 }
 
+QList<GLC_3DViewInstance*> GLC_SpacePartitioning::listOfInstancesInFrustum(const GLC_Frustum& frustum, bool fullyInside)
+{
+	const QList<GLC_3DViewInstance*> instanceList(m_pCollection->instancesHandle());
+	const int size= instanceList.size();
+	GLC_FrustumCuller cullingTable;
+	cullingTable.reserve(size);
+	for (int i= 0; i < size; ++i)
+	{
+		cullingTable.append(instanceList.at(i)->boundingBox());
+	}
+	QVector<quint8> localisations;
+	cullingTable.localizeBoundingBoxes(frustum, &localisations);
+
+	QList<GLC_3DViewInstance*> subject;
+	for (int i= 0; i < size; ++i)
+	{
+		const GLC_Frustum::Localisation localisation= static_cast<GLC_Frustum::Localisation>(localisations.at(i));
+		if ((localisation == GLC_Frustum::InFrustum) || (!fullyInside && (localisation == GLC_Frustum::IntersectFrustum)))
+		{
+			subject.append(instanceList.at(i));
+		}
+	}
+
+	return subject;
+}
+
 void GLC_SpacePartitioning::set3DViewCollection(GLC_3DViewCollection *pCollection)
 {
     Q_ASSERT(NULL != pCollection);
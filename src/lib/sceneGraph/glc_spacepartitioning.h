@@ -66,6 +66,10 @@ public:
 	//! Return the list off instances inside or intersect the given bounding box
 	virtual QList<GLC_3DViewInstance*> listOfIntersectedInstances(const GLC_BoundingBox&)= 0;
 
+	//! Return the list of instances inside or intersecting the given frustum
+	/*! If fullyInside is true, only instances with a bounding box inside the frustum are returned.
+	 *  The default implementation localizes the bounding boxes of all instances of the collection*/
+	virtual QList<GLC_3DViewInstance*> listOfInstancesInFrustum(const GLC_Frustum& frustum, bool fullyInside);
 
 //@}
 //////////////////////////////////////////////////////////////////////
@@ -83,6 +87,18 @@ public:
 	//! Clear the space partionning
 	virtual void clear()= 0;
 
+	//! Insert the given instance added to the collection
+	/*! The default implementation does nothing, the instance is taken into account by updateSpacePartitioning()*/
+	virtual void insertInstance(GLC_3DViewInstance*) {}
+
+	//! Remove the instance of the given id removed from the collection
+	/*! The default implementation does nothing*/
+	virtual void removeInstance(GLC_uint) {}
+
+	//! Update the given instance whose bounding box has changed
+	/*! The default implementation does nothing*/
+	virtual void updateInstance(GLC_3DViewInstance*) {}
+
     //! Set the collection to use
     void set3DViewCollection(GLC_3DViewCollection* pCollection);
 
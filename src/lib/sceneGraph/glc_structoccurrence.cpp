@@ -596,6 +596,7 @@ GLC_StructOccurrence* GLC_StructOccurrence::updateAbsoluteMatrix()
 	if ((NULL != m_pWorldHandle) && m_pWorldHandle->collection()->contains(m_Uid))
 	{
 		m_pWorldHandle->collection()->instanceHandle(m_Uid)->setMatrix(m_AbsoluteMatrix);
+		m_pWorldHandle->collection()->updateInstanceSpacePartitioning(m_Uid);
 	}
 	return this;
 }
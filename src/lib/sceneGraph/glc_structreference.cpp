@@ -207,18 +207,20 @@ bool GLC_StructReference::loadRepresentation()
 	Q_ASSERT(NULL != m_pRepresentation);
 	if (m_pRepresentation->load())
 	{
-		QSet<GLC_StructOccurrence*> structOccurrenceSet= this->setOfStructOccurrence();
-		QSet<GLC_StructOccurrence*>::iterator iOcc= structOccurrenceSet.begin();
-		while (structOccurrenceSet.constEnd() != iOcc)
-		{
-			GLC_StructOccurrence* pOccurrence= *iOcc;
-			Q_ASSERT(!pOccurrence->has3DViewInstance());
-			if (pOccurrence->useAutomatic3DViewInstanceCreation())
-			{
-				pOccurrence->create3DViewInstance();
-			}
-			++iOcc;
-		}
+		create3DViewInstances();
+		return true;
+	}
+	else return false;
+}
+
+bool GLC_StructReference::loadRepresentation(GLC_3DRep* pLoadedRep)
+{
+	Q_ASSERT(NULL != m_pRepresentation);
+	GLC_3DRep* p3DRep= dynamic_cast<GLC_3DRep*>(m_pRepresentation);
+	if ((NULL != p3DRep) && !p3DRep->isLoaded() && !pLoadedRep->isEmpty())
+	{
+		p3DRep->take(pLoadedRep);
+		create3DViewInstances();
 		return true;
 	}
 	else return false;
@@ -270,3 +272,22 @@ QList<GLC_StructOccurrence*> GLC_StructReference::addChild(GLC_StructOccurrence*
 	return subject;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_StructReference::create3DViewInstances()
+{
+	QSet<GLC_StructOccurrence*> structOccurrenceSet= this->setOfStructOccurrence();
+	QSet<GLC_StructOccurrence*>::iterator iOcc= structOccurrenceSet.begin();
+	while (structOccurrenceSet.constEnd() != iOcc)
+	{
+		GLC_StructOccurrence* pOccurrence= *iOcc;
+		Q_ASSERT(!pOccurrence->has3DViewInstance());
+		if (pOccurrence->useAutomatic3DViewInstanceCreation())
+		{
+			pOccurrence->create3DViewInstance();
+		}
+		++iOcc;
+	}
+}
@@ -206,6 +206,10 @@ public:
 	/*! The representation must exists*/
 	bool loadRepresentation();
 
+	//! Load the representation by taking the geometries of the given loaded representation
+	/*! The representation must exists, return false if it is already loaded*/
+	bool loadRepresentation(GLC_3DRep* pLoadedRep);
+
 	//! Unload the representation
 	/*! The representation must exists*/
 	bool unloadRepresentation();
@@ -217,6 +221,13 @@ public:
 
 //@}
 
+//////////////////////////////////////////////////////////////////////
+// Private services functions
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Create the 3D view instance of the occurrences of this reference
+	void create3DViewInstances();
+
 //////////////////////////////////////////////////////////////////////
 // Private members
 //////////////////////////////////////////////////////////////////////
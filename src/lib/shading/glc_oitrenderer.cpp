@@ -0,0 +1,226 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+
+//! \file glc_oitrenderer.cpp implementation of the GLC_OitRenderer class.
+
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+
+#include "glc_oitrenderer.h"
+#include "glc_shader.h"
+#include "../glc_state.h"
+#include "../glc_exception.h"
+#include "../glc_errorlog.h"
+
+GLC_OitRenderer::GLC_OitRenderer()
+: m_pFramebuffer(NULL)
+, m_pAccumulationShader(NULL)
+, m_pCompositeShader(NULL)
+, m_IsValid(true)
+, m_IsActive(false)
+, m_PreviousFramebuffer(0)
+{
+	for (int i= 0; i < 4; ++i) m_Viewport[i]= 0;
+}
+
+GLC_OitRenderer::~GLC_OitRenderer()
+{
+	delete m_pFramebuffer;
+	delete m_pAccumulationShader;
+	delete m_pCompositeShader;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Get Functions
+//////////////////////////////////////////////////////////////////////
+
+bool GLC_OitRenderer::isSupported()
+{
+	// Float color attachments and multiple render targets are needed
+	const QOpenGLContext* pContext= QOpenGLContext::currentContext();
+	const QSurfaceFormat format= pContext->format();
+	return !pContext->isOpenGLES() && (format.profile() != QSurfaceFormat::CoreProfile)
+			&& (format.version() >= qMakePair(3, 0)) && GLC_State::glslUsed()
+			&& GLC_State::frameBufferSupported() && GLC_State::frameBufferBlitSupported();
+}
+
+//////////////////////////////////////////////////////////////////////
+// OpenGL Functions
+//////////////////////////////////////////////////////////////////////
+
+bool GLC_OitRenderer::begin()
+{
+	Q_ASSERT(!m_IsActive);
+	if (!m_IsValid) return false;
+	if ((NULL == m_pAccumulationShader) && !(isSupported() && initShaders()))
+	{
+		m_IsValid= false;
+		return false;
+	}
+
+	QOpenGLExtraFunctions* pGlFunctions= QOpenGLContext::currentContext()->extraFunctions();
+	glGetIntegerv(GL_VIEWPORT, m_Viewport);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_PreviousFramebuffer);
+	const QSize size(m_Viewport[0] + m_Viewport[2], m_Viewport[1] + m_Viewport[3]);
+	if (size.isEmpty()) return false;
+	updateFramebuffer(size);
+
+	// Copy the depth of opaque geometries
+	const GLint x1= m_Viewport[0] + m_Viewport[2];
+	const GLint y1= m_Viewport[1] + m_Viewport[3];
+	pGlFunctions->glBindFramebuffer(GL_READ_FRAMEBUFFER, m_PreviousFramebuffer);
+	pGlFunctions->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_pFramebuffer->handle());
+	pGlFunctions->glBlitFramebuffer(m_Viewport[0], m_Viewport[1], x1, y1, m_Viewport[0], m_Viewport[1], x1, y1, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	if (glGetError() != GL_NO_ERROR)
+	{
+		// Depth formats of the frame buffers don't match
+		pGlFunctions->glBindFramebuffer(GL_FRAMEBUFFER, m_PreviousFramebuffer);
+		GLC_ErrorLog::addError(QString("GLC_OitRenderer::begin Unable to copy the depth buffer"));
+		m_IsValid= false;
+		return false;
+	}
+	pGlFunctions->glBindFramebuffer(GL_FRAMEBUFFER, m_pFramebuffer->handle());
+
+	const GLenum drawBuffers[2]= {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+	pGlFunctions->glDrawBuffers(2, drawBuffers);
+	const GLfloat accumulationClear[4]= {0.0f, 0.0f, 0.0f, 1.0f};
+	const GLfloat weightClear[4]= {0.0f, 0.0f, 0.0f, 0.0f};
+	pGlFunctions->glClearBufferfv(GL_COLOR, 0, accumulationClear);
+	pGlFunctions->glClearBufferfv(GL_COLOR, 1, weightClear);
+
+	// Color and weight are summed, revealage is the product of (1 - alpha)
+	glEnable(GL_BLEND);
+	pGlFunctions->glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+
+	m_pAccumulationShader->use();
+	m_IsActive= true;
+
+	return true;
+}
+
+void GLC_OitRenderer::end()
+{
+	Q_ASSERT(m_IsActive);
+	m_pAccumulationShader->unuse();
+	m_IsActive= false;
+
+	QOpenGLExtraFunctions* pGlFunctions= QOpenGLContext::currentContext()->extraFunctions();
+	pGlFunctions->glBindFramebuffer(GL_FRAMEBUFFER, m_PreviousFramebuffer);
+
+	// Composite over the previous frame buffer
+	const QVector<GLuint> textures= m_pFramebuffer->textures();
+	pGlFunctions->glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, textures.at(1));
+	pGlFunctions->glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, textures.at(0));
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+
+	m_pCompositeShader->use();
+	QGLShaderProgram* pProgram= m_pCompositeShader->programShaderHandle();
+	pProgram->setUniformValue("accumulation_tex", GLint(0));
+	pProgram->setUniformValue("weight_tex", GLint(1));
+	pProgram->setUniformValue("framebuffer_size", QSizeF(m_pFramebuffer->size()));
+
+	const GLfloat quad[8]= {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+	pProgram->enableAttributeArray("a_position");
+	pProgram->setAttributeArray("a_position", quad, 2);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	pProgram->disableAttributeArray("a_position");
+	m_pCompositeShader->unuse();
+
+	// Restore OpenGL state
+	pGlFunctions->glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	pGlFunctions->glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void GLC_OitRenderer::clear()
+{
+	Q_ASSERT(!m_IsActive);
+	delete m_pFramebuffer;
+	m_pFramebuffer= NULL;
+	delete m_pAccumulationShader;
+	m_pAccumulationShader= NULL;
+	delete m_pCompositeShader;
+	m_pCompositeShader= NULL;
+	m_IsValid= true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+bool GLC_OitRenderer::initShaders()
+{
+	QFile accumulationVertex(":/GLC_lib_Shaders/oit_accum_vert");
+	QFile accumulationFragment(":/GLC_lib_Shaders/oit_accum_frag");
+	QFile compositeVertex(":/GLC_lib_Shaders/oit_composite_vert");
+	QFile compositeFragment(":/GLC_lib_Shaders/oit_composite_frag");
+	Q_ASSERT(accumulationVertex.exists() && accumulationFragment.exists());
+	Q_ASSERT(compositeVertex.exists() && compositeFragment.exists());
+
+	m_pAccumulationShader= new GLC_Shader(accumulationVertex, accumulationFragment);
+	m_pCompositeShader= new GLC_Shader(compositeVertex, compositeFragment);
+	try
+	{
+		m_pAccumulationShader->createAndCompileProgrammShader();
+		m_pCompositeShader->createAndCompileProgrammShader();
+	}
+	catch (GLC_Exception& e)
+	{
+		GLC_ErrorLog::addError(e.what());
+		delete m_pAccumulationShader;
+		m_pAccumulationShader= NULL;
+		delete m_pCompositeShader;
+		m_pCompositeShader= NULL;
+		return false;
+	}
+	return true;
+}
+
+void GLC_OitRenderer::updateFramebuffer(const QSize& size)
+{
+	if ((NULL != m_pFramebuffer) && (m_pFramebuffer->size() == size)) return;
+
+	delete m_pFramebuffer;
+	m_pFramebuffer= new QOpenGLFramebufferObject(size, QOpenGLFramebufferObject::CombinedDepthStencil, GL_TEXTURE_2D, GL_RGBA16F);
+	m_pFramebuffer->addColorAttachment(size, GL_R16F);
+
+	// Composition fetch one texel by fragment
+	const QVector<GLuint> textures= m_pFramebuffer->textures();
+	for (int i= 0; i < textures.size(); ++i)
+	{
+		glBindTexture(GL_TEXTURE_2D, textures.at(i));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,128 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+
+//! \file glc_oitrenderer.h interface for the GLC_OitRenderer class.
+
+#ifndef GLC_OITRENDERER_H_
+#define GLC_OITRENDERER_H_
+
+#include <QtOpenGL>
+#include <QSize>
+
+#include "../glc_config.h"
+
+class GLC_Shader;
+class QOpenGLFramebufferObject;
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_OitRenderer
+/*! \brief GLC_OitRenderer : Weighted blended order independent transparency*/
+
+/*! Transparent fragments drawn between begin() and end() are accumulated
+ *  in an offscreen frame buffer with a depth dependent weight, then composited
+ *  over the frame buffer bound before begin(). No sort of transparent geometries is needed.\n
+ *  The depth buffer of the bound frame buffer is copied so opaque geometries hide transparent ones.
+ */
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_OitRenderer
+{
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	GLC_OitRenderer();
+	virtual ~GLC_OitRenderer();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return true if order independent transparency is supported by the current context
+	static bool isSupported();
+
+	//! Return true if the renderer is between begin() and end()
+	inline bool isActive() const
+	{return m_IsActive;}
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name OpenGL Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Begin the accumulation of transparent fragments
+	/*! Return false if order independent transparency can't be used,
+	 *  in this case the OpenGL state is unchanged*/
+	bool begin();
+
+	//! End the accumulation and composite transparent fragments
+	void end();
+
+	//! Release OpenGL resources, the context must be current
+	void clear();
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Build shaders, return false on failure
+	bool initShaders();
+
+	//! Create the frame buffer of the given size if needed
+	void updateFramebuffer(const QSize& size);
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! The accumulation frame buffer
+	QOpenGLFramebufferObject* m_pFramebuffer;
+
+	//! Shader used to accumulate transparent fragments
+	GLC_Shader* m_pAccumulationShader;
+
+	//! Shader used to composite accumulated fragments
+	GLC_Shader* m_pCompositeShader;
+
+	//! False if order independent transparency can't be used
+	bool m_IsValid;
+
+	//! True between begin() and end()
+	bool m_IsActive;
+
+	//! The frame buffer bound before begin()
+	GLint m_PreviousFramebuffer;
+
+	//! The viewport at begin()
+	GLint m_Viewport[4];
+
+private:
+	Q_DISABLE_COPY(GLC_OitRenderer)
+};
+
+#endif /* GLC_OITRENDERER_H_ */
@@ -47,6 +47,7 @@ GLC_Shader::GLC_Shader()
 , m_TextcoordAttributeId(-1)
 , m_ColorAttributeId(-1)
 , m_NormalAttributeId(-1)
+, m_InstanceMatrixAttributeId(-1)
 , m_ModelViewLocationId(-1)
 , m_MvpLocationId(-1)
 , m_InvModelViewLocationId(-1)
@@ -78,6 +79,7 @@ GLC_Shader::GLC_Shader(QFile& vertexShaderFile, QFile& fragmentShaderFile)
 , m_TextcoordAttributeId(-1)
 , m_ColorAttributeId(-1)
 , m_NormalAttributeId(-1)
+, m_InstanceMatrixAttributeId(-1)
 , m_ModelViewLocationId(-1)
 , m_MvpLocationId(-1)
 , m_InvModelViewLocationId(-1)
@@ -109,6 +111,7 @@ GLC_Shader::GLC_Shader(const GLC_Shader& shader)
 , m_TextcoordAttributeId(-1)
 , m_ColorAttributeId(-1)
 , m_NormalAttributeId(-1)
+, m_InstanceMatrixAttributeId(-1)
 , m_ModelViewLocationId(-1)
 , m_MvpLocationId(-1)
 , m_InvModelViewLocationId(-1)
@@ -266,6 +269,8 @@ void GLC_Shader::createAndCompileProgrammShader()
 		//qDebug() << "m_ColorAttributeId " << m_ColorAttributeId;
 		m_NormalAttributeId= m_ProgramShader.attributeLocation("a_normal");
 		//qDebug() << "m_NormalAttributeId " << m_NormalAttributeId;
+		m_InstanceMatrixAttributeId= m_ProgramShader.attributeLocation("a_instance_matrix");
+		//qDebug() << "m_InstanceMatrixAttributeId " << m_InstanceMatrixAttributeId;
 
 		m_ModelViewLocationId= m_ProgramShader.uniformLocation("modelview_matrix");
 		//qDebug() << "m_ModelViewLocationId " << m_ModelViewLocationId;
@@ -106,6 +106,11 @@ public:
 	inline int normalAttributeId() const
 	{return m_NormalAttributeId;}
 
+	//! Return the per instance model matrix attribute id
+	/*! Return -1 if the shader is not an instanced shader*/
+	inline int instanceMatrixAttributeId() const
+	{return m_InstanceMatrixAttributeId;}
+
 	//! Return the number of shader
 	static int shaderCount();
 
@@ -285,6 +290,9 @@ private:
 	//! The Normal attribute id
 	int m_NormalAttributeId;
 
+	//! The per instance model matrix attribute id
+	int m_InstanceMatrixAttributeId;
+
 	//! The modelView location matrix id
 	int m_ModelViewLocationId;
 
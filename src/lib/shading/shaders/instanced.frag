@@ -0,0 +1,19 @@
+#version 120
+
+uniform bool    useTexture;
+uniform sampler2D tex;
+
+// varying variables output by the vertex shader
+varying vec2    v_textcoord;
+varying vec4    v_front_color;
+varying vec4    v_back_color;
+
+void main()
+{
+    vec4 color= gl_FrontFacing ? v_front_color : v_back_color;
+    if (useTexture)
+    {
+        color*= texture2D(tex, v_textcoord);
+    }
+    gl_FragColor= color;
+}
@@ -0,0 +1,117 @@
+#version 120
+
+// Instanced version of the fixed pipeline used to draw occurrences of the same mesh
+// The view matrix, the lights and the material come from the OpenGL state
+
+const float     c_zero= 0.0;
+const float     c_one= 1.0;
+
+uniform bool    enable_lighting;
+uniform bool    light_model_two_sided;
+uniform bool    light_enable_state[8];
+
+// vertex attributes
+attribute vec4  a_position;
+attribute vec3  a_normal;
+attribute vec2  a_textcoord0;
+
+// Per instance attribute : the absolute matrix of the occurrence
+attribute mat4  a_instance_matrix;
+
+// varying variables output by the vertex shader
+varying vec2    v_textcoord;
+varying vec4    v_front_color;
+varying vec4    v_back_color;
+
+vec4 lighting_equation(int i, vec4 p_eye, vec3 n, gl_MaterialParameters material)
+{
+    vec4    computed_color= vec4(c_zero, c_zero, c_zero, c_zero);
+    vec3    VPpli;
+    float   att_factor= c_one;
+
+    if (gl_LightSource[i].position.w != c_zero)
+    {
+        // this is a point or a spot light
+        VPpli= gl_LightSource[i].position.xyz - p_eye.xyz;
+        float dist= length(VPpli);
+        att_factor= c_one / (gl_LightSource[i].constantAttenuation + (gl_LightSource[i].linearAttenuation * dist)
+                             + (gl_LightSource[i].quadraticAttenuation * dist * dist));
+        VPpli= normalize(VPpli);
+
+        if (gl_LightSource[i].spotCutoff < 180.0)
+        {
+            float spot_factor= dot(-VPpli, normalize(gl_LightSource[i].spotDirection));
+            if (spot_factor >= gl_LightSource[i].spotCosCutoff)
+            {
+                spot_factor= pow(spot_factor, gl_LightSource[i].spotExponent);
+            }
+            else
+            {
+                spot_factor= c_zero;
+            }
+            att_factor*= spot_factor;
+        }
+    }
+    else
+    {
+        // this is a directional light
+        VPpli= normalize(gl_LightSource[i].position.xyz);
+    }
+
+    if (att_factor > c_zero)
+    {
+        computed_color+= gl_LightSource[i].ambient * material.ambient;
+        float ndotl= max(c_zero, dot(n, VPpli));
+        computed_color+= ndotl * gl_LightSource[i].diffuse * material.diffuse;
+        float ndoth= dot(n, normalize(VPpli + vec3(c_zero, c_zero, c_one)));
+        if ((ndotl > c_zero) && (ndoth > c_zero))
+        {
+            computed_color+= pow(ndoth, material.shininess) * gl_LightSource[i].specular * material.specular;
+        }
+        computed_color*= att_factor;
+    }
+
+    return computed_color;
+}
+
+vec4 do_lighting(vec4 p_eye, vec3 n, gl_MaterialParameters material)
+{
+    vec4 vtx_color= material.emission + (material.ambient * gl_LightModel.ambient);
+    for (int i= 0; i < 8; ++i)
+    {
+        if (light_enable_state[i])
+        {
+            vtx_color+= lighting_equation(i, p_eye, n, material);
+        }
+    }
+    vtx_color.a= material.diffuse.a;
+
+    return vtx_color;
+}
+
+void main()
+{
+    // The instance matrices have an uniform scaling, normals are transformed as positions
+    mat4 modelview= gl_ModelViewMatrix * a_instance_matrix;
+    vec4 p_eye= modelview * a_position;
+
+    if (enable_lighting)
+    {
+        vec3 n= normalize(mat3(modelview[0].xyz, modelview[1].xyz, modelview[2].xyz) * a_normal);
+        v_front_color= do_lighting(p_eye, n, gl_FrontMaterial);
+        v_back_color= v_front_color;
+        if (light_model_two_sided)
+        {
+            v_back_color= do_lighting(p_eye, -n, gl_BackMaterial);
+        }
+    }
+    else
+    {
+        v_front_color= gl_FrontMaterial.diffuse;
+        v_back_color= gl_BackMaterial.diffuse;
+    }
+
+    v_textcoord= a_textcoord0;
+
+    gl_Position= gl_ProjectionMatrix * p_eye;
+}
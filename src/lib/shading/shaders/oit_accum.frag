@@ -0,0 +1,29 @@
+#version 120
+
+// Weighted blended order independent transparency accumulation
+// gl_FragData[0] : premultiplied weighted color and revealage
+// gl_FragData[1] : sum of weights
+
+uniform bool    useTexture;
+uniform sampler2D tex;
+
+// varying variables output by the vertex shader
+varying vec2    v_textcoord;
+varying vec4    v_front_color;
+varying vec4    v_back_color;
+
+void main()
+{
+    vec4 color= gl_FrontFacing ? v_front_color : v_back_color;
+    if (useTexture)
+    {
+        color*= texture2D(tex, v_textcoord);
+    }
+
+    // Depth based weight, closer fragments have a greater weight
+    float depth= 1.0 - (gl_FragCoord.z * 0.9);
+    float weight= clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(depth, 3.0), 1e-2, 3e3);
+
+    gl_FragData[0]= vec4(color.rgb * color.a * weight, color.a);
+    gl_FragData[1]= vec4(color.a * weight, 0.0, 0.0, 0.0);
+}
@@ -0,0 +1,118 @@
+#version 120
+
+// Fixed pipeline transformation and lighting of transparent geometries
+// The matrices, the lights and the material come from the OpenGL state
+
+const float     c_zero= 0.0;
+const float     c_one= 1.0;
+
+uniform bool    enable_lighting;
+uniform bool    light_model_two_sided;
+uniform bool    light_enable_state[8];
+uniform bool    enable_color_material;
+
+// varying variables output by the vertex shader
+varying vec2    v_textcoord;
+varying vec4    v_front_color;
+varying vec4    v_back_color;
+
+vec4 lighting_equation(int i, vec4 p_eye, vec3 n, gl_MaterialParameters material)
+{
+    vec4    computed_color= vec4(c_zero, c_zero, c_zero, c_zero);
+    vec3    VPpli;
+    float   att_factor= c_one;
+
+    if (gl_LightSource[i].position.w != c_zero)
+    {
+        // this is a point or a spot light
+        VPpli= gl_LightSource[i].position.xyz - p_eye.xyz;
+        float dist= length(VPpli);
+        att_factor= c_one / (gl_LightSource[i].constantAttenuation + (gl_LightSource[i].linearAttenuation * dist)
+                             + (gl_LightSource[i].quadraticAttenuation * dist * dist));
+        VPpli= normalize(VPpli);
+
+        if (gl_LightSource[i].spotCutoff < 180.0)
+        {
+            float spot_factor= dot(-VPpli, normalize(gl_LightSource[i].spotDirection));
+            if (spot_factor >= gl_LightSource[i].spotCosCutoff)
+            {
+                spot_factor= pow(spot_factor, gl_LightSource[i].spotExponent);
+            }
+            else
+            {
+                spot_factor= c_zero;
+            }
+            att_factor*= spot_factor;
+        }
+    }
+    else
+    {
+        // this is a directional light
+        VPpli= normalize(gl_LightSource[i].position.xyz);
+    }
+
+    if (att_factor > c_zero)
+    {
+        computed_color+= gl_LightSource[i].ambient * material.ambient;
+        float ndotl= max(c_zero, dot(n, VPpli));
+        computed_color+= ndotl * gl_LightSource[i].diffuse * material.diffuse;
+        float ndoth= dot(n, normalize(VPpli + vec3(c_zero, c_zero, c_one)));
+        if ((ndotl > c_zero) && (ndoth > c_zero))
+        {
+            computed_color+= pow(ndoth, material.shininess) * gl_LightSource[i].specular * material.specular;
+        }
+        computed_color*= att_factor;
+    }
+
+    return computed_color;
+}
+
+vec4 do_lighting(vec4 p_eye, vec3 n, gl_MaterialParameters material)
+{
+    vec4 vtx_color= material.emission + (material.ambient * gl_LightModel.ambient);
+    for (int i= 0; i < 8; ++i)
+    {
+        if (light_enable_state[i])
+        {
+            vtx_color+= lighting_equation(i, p_eye, n, material);
+        }
+    }
+    vtx_color.a= material.diffuse.a;
+
+    return vtx_color;
+}
+
+void main()
+{
+    vec4 p_eye= gl_ModelViewMatrix * gl_Vertex;
+
+    gl_MaterialParameters front_material= gl_FrontMaterial;
+    gl_MaterialParameters back_material= gl_BackMaterial;
+    if (enable_color_material)
+    {
+        front_material.ambient= gl_Color;
+        front_material.diffuse= gl_Color;
+        back_material.ambient= gl_Color;
+        back_material.diffuse= gl_Color;
+    }
+
+    if (enable_lighting)
+    {
+        vec3 n= normalize(gl_NormalMatrix * gl_Normal);
+        v_front_color= do_lighting(p_eye, n, front_material);
+        v_back_color= v_front_color;
+        if (light_model_two_sided)
+        {
+            v_back_color= do_lighting(p_eye, -n, back_material);
+        }
+    }
+    else
+    {
+        v_front_color= gl_Color;
+        v_back_color= gl_Color;
+    }
+
+    v_textcoord= gl_MultiTexCoord0.xy;
+
+    gl_Position= gl_ProjectionMatrix * p_eye;
+}
@@ -0,0 +1,22 @@
+#version 120
+
+// Weighted blended order independent transparency composition
+
+uniform sampler2D   accumulation_tex;
+uniform sampler2D   weight_tex;
+uniform vec2        framebuffer_size;
+
+void main()
+{
+    vec2 textcoord= gl_FragCoord.xy / framebuffer_size;
+    vec4 accumulation= texture2D(accumulation_tex, textcoord);
+    float revealage= accumulation.a;
+    if (revealage == 1.0)
+    {
+        discard;
+    }
+    float weight= texture2D(weight_tex, textcoord).r;
+
+    // Blended with glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA)
+    gl_FragColor= vec4(accumulation.rgb / max(weight, 1e-5), revealage);
+}
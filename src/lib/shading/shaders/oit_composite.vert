@@ -0,0 +1,9 @@
+#version 120
+
+// Full screen quad in normalized device coordinates
+attribute vec2  a_position;
+
+void main()
+{
+    gl_Position= vec4(a_position, 0.0, 1.0);
+}
@@ -0,0 +1,297 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_frustumculler.cpp Implementation of the GLC_FrustumCuller class.
+
+#include "glc_frustumculler.h"
+
+#include <cmath>
+
+#if defined(__AVX__)
+#define GLC_FRUSTUMCULLER_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define GLC_FRUSTUMCULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+// The arrays are padded to a multiple of the widest batch
+const int paddingSize= 8;
+
+// Half extent of empty bounding boxes, its projected radius is always negative
+const float emptyExtent= -1.0e30f;
+
+// Frustum planes coefficients as float
+struct CullingPlane
+{
+	float m_A;
+	float m_B;
+	float m_C;
+	float m_D;
+	float m_AbsA;
+	float m_AbsB;
+	float m_AbsC;
+};
+
+inline CullingPlane cullingPlane(const GLC_Plane& plane)
+{
+	CullingPlane result;
+	result.m_A= static_cast<float>(plane.coefA());
+	result.m_B= static_cast<float>(plane.coefB());
+	result.m_C= static_cast<float>(plane.coefC());
+	result.m_D= static_cast<float>(plane.coefD());
+	result.m_AbsA= fabs(result.m_A);
+	result.m_AbsB= fabs(result.m_B);
+	result.m_AbsC= fabs(result.m_C);
+	return result;
+}
+
+// Write the localisations of a batch from its out and intersect bit masks
+inline void writeLocalisations(int outMask, int intersectMask, int count, quint8* pResult)
+{
+	const int mask= outMask | intersectMask;
+	for (int i= 0; i < count; ++i)
+	{
+		pResult[i]= static_cast<quint8>((((outMask >> i) & 1) << 1) | ((mask >> i) & 1));
+	}
+}
+
+}
+
+GLC_FrustumCuller::GLC_FrustumCuller()
+: m_Size(0)
+, m_CenterX()
+, m_CenterY()
+, m_CenterZ()
+, m_ExtentX()
+, m_ExtentY()
+, m_ExtentZ()
+{
+
+}
+
+GLC_FrustumCuller::~GLC_FrustumCuller()
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////
+// Get Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_FrustumCuller::localizeBoundingBoxes(const GLC_Frustum& frustum, QVector<quint8>* pLocalisations) const
+{
+	pLocalisations->resize(m_Size);
+	if (0 == m_Size) return;
+
+	CullingPlane planes[6];
+	planes[0]= cullingPlane(frustum.leftClippingPlane());
+	planes[1]= cullingPlane(frustum.rightClippingPlane());
+	planes[2]= cullingPlane(frustum.topClippingPlane());
+	planes[3]= cullingPlane(frustum.bottomClippingPlane());
+	planes[4]= cullingPlane(frustum.nearClippingPlane());
+	planes[5]= cullingPlane(frustum.farClippingPlane());
+
+	const float* pCenterX= m_CenterX.constData();
+	const float* pCenterY= m_CenterY.constData();
+	const float* pCenterZ= m_CenterZ.constData();
+	const float* pExtentX= m_ExtentX.constData();
+	const float* pExtentY= m_ExtentY.constData();
+	const float* pExtentZ= m_ExtentZ.constData();
+	quint8* pResult= pLocalisations->data();
+
+	// A box is out if it is under a plane by more than its projected radius
+	// and intersect if it is not over all planes by more than its projected radius
+#if defined(GLC_FRUSTUMCULLER_AVX)
+	const __m256 zero= _mm256_setzero_ps();
+	for (int i= 0; i < m_Size; i+= 8)
+	{
+		const __m256 centerX= _mm256_loadu_ps(pCenterX + i);
+		const __m256 centerY= _mm256_loadu_ps(pCenterY + i);
+		const __m256 centerZ= _mm256_loadu_ps(pCenterZ + i);
+		const __m256 extentX= _mm256_loadu_ps(pExtentX + i);
+		const __m256 extentY= _mm256_loadu_ps(pExtentY + i);
+		const __m256 extentZ= _mm256_loadu_ps(pExtentZ + i);
+		__m256 outMask= zero;
+		__m256 intersectMask= zero;
+		for (int j= 0; j < 6; ++j)
+		{
+			const CullingPlane& plane= planes[j];
+			__m256 distance= _mm256_mul_ps(_mm256_set1_ps(plane.m_A), centerX);
+			distance= _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.m_B), centerY));
+			distance= _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.m_C), centerZ));
+			distance= _mm256_add_ps(distance, _mm256_set1_ps(plane.m_D));
+			__m256 radius= _mm256_mul_ps(_mm256_set1_ps(plane.m_AbsA), extentX);
+			radius= _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(plane.m_AbsB), extentY));
+			radius= _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(plane.m_AbsC), extentZ));
+			outMask= _mm256_or_ps(outMask, _mm256_cmp_ps(distance, _mm256_sub_ps(zero, radius), _CMP_LT_OQ));
+			intersectMask= _mm256_or_ps(intersectMask, _mm256_cmp_ps(distance, radius, _CMP_LE_OQ));
+		}
+		const int count= qMin(8, m_Size - i);
+		writeLocalisations(_mm256_movemask_ps(outMask), _mm256_movemask_ps(intersectMask), count, pResult + i);
+	}
+#elif defined(GLC_FRUSTUMCULLER_SSE)
+	const __m128 zero= _mm_setzero_ps();
+	for (int i= 0; i < m_Size; i+= 4)
+	{
+		const __m128 centerX= _mm_loadu_ps(pCenterX + i);
+		const __m128 centerY= _mm_loadu_ps(pCenterY + i);
+		const __m128 centerZ= _mm_loadu_ps(pCenterZ + i);
+		const __m128 extentX= _mm_loadu_ps(pExtentX + i);
+		const __m128 extentY= _mm_loadu_ps(pExtentY + i);
+		const __m128 extentZ= _mm_loadu_ps(pExtentZ + i);
+		__m128 outMask= zero;
+		__m128 intersectMask= zero;
+		for (int j= 0; j < 6; ++j)
+		{
+			const CullingPlane& plane= planes[j];
+			__m128 distance= _mm_mul_ps(_mm_set1_ps(plane.m_A), centerX);
+			distance= _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.m_B), centerY));
+			distance= _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.m_C), centerZ));
+			distance= _mm_add_ps(distance, _mm_set1_ps(plane.m_D));
+			__m128 radius= _mm_mul_ps(_mm_set1_ps(plane.m_AbsA), extentX);
+			radius= _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(plane.m_AbsB), extentY));
+			radius= _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(plane.m_AbsC), extentZ));
+			outMask= _mm_or_ps(outMask, _mm_cmplt_ps(distance, _mm_sub_ps(zero, radius)));
+			intersectMask= _mm_or_ps(intersectMask, _mm_cmple_ps(distance, radius));
+		}
+		const int count= qMin(4, m_Size - i);
+		writeLocalisations(_mm_movemask_ps(outMask), _mm_movemask_ps(intersectMask), count, pResult + i);
+	}
+#else
+	for (int i= 0; i < m_Size; ++i)
+	{
+		int outMask= 0;
+		int intersectMask= 0;
+		for (int j= 0; j < 6; ++j)
+		{
+			const CullingPlane& plane= planes[j];
+			const float distance= (plane.m_A * pCenterX[i]) + (plane.m_B * pCenterY[i]) + (plane.m_C * pCenterZ[i]) + plane.m_D;
+			const float radius= (plane.m_AbsA * pExtentX[i]) + (plane.m_AbsB * pExtentY[i]) + (plane.m_AbsC * pExtentZ[i]);
+			outMask|= (distance < -radius);
+			intersectMask|= (distance <= radius);
+		}
+		writeLocalisations(outMask, intersectMask, 1, pResult + i);
+	}
+#endif
+}
+
+int GLC_FrustumCuller::batchSize()
+{
+#if defined(GLC_FRUSTUMCULLER_AVX)
+	return 8;
+#elif defined(GLC_FRUSTUMCULLER_SSE)
+	return 4;
+#else
+	return 1;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_FrustumCuller::clear()
+{
+	m_Size= 0;
+	m_CenterX.clear();
+	m_CenterY.clear();
+	m_CenterZ.clear();
+	m_ExtentX.clear();
+	m_ExtentY.clear();
+	m_ExtentZ.clear();
+}
+
+void GLC_FrustumCuller::reserve(int size)
+{
+	const int paddedSize= ((size + paddingSize - 1) / paddingSize) * paddingSize;
+	m_CenterX.reserve(paddedSize);
+	m_CenterY.reserve(paddedSize);
+	m_CenterZ.reserve(paddedSize);
+	m_ExtentX.reserve(paddedSize);
+	m_ExtentY.reserve(paddedSize);
+	m_ExtentZ.reserve(paddedSize);
+}
+
+int GLC_FrustumCuller::append(const GLC_BoundingBox& boundingBox)
+{
+	const int index= m_Size;
+	resize(m_Size + 1);
+	setBoundingBox(index, boundingBox);
+
+	return index;
+}
+
+void GLC_FrustumCuller::setBoundingBox(int index, const GLC_BoundingBox& boundingBox)
+{
+	Q_ASSERT((index >= 0) && (index < m_Size));
+	if (boundingBox.isEmpty())
+	{
+		m_CenterX[index]= 0.0f;
+		m_CenterY[index]= 0.0f;
+		m_CenterZ[index]= 0.0f;
+		m_ExtentX[index]= emptyExtent;
+		m_ExtentY[index]= emptyExtent;
+		m_ExtentZ[index]= emptyExtent;
+	}
+	else
+	{
+		const GLC_Point3d& lower= boundingBox.lowerCorner();
+		const GLC_Point3d& upper= boundingBox.upperCorner();
+		m_CenterX[index]= static_cast<float>((lower.x() + upper.x()) * 0.5);
+		m_CenterY[index]= static_cast<float>((lower.y() + upper.y()) * 0.5);
+		m_CenterZ[index]= static_cast<float>((lower.z() + upper.z()) * 0.5);
+		m_ExtentX[index]= static_cast<float>((upper.x() - lower.x()) * 0.5);
+		m_ExtentY[index]= static_cast<float>((upper.y() - lower.y()) * 0.5);
+		m_ExtentZ[index]= static_cast<float>((upper.z() - lower.z()) * 0.5);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_FrustumCuller::resize(int size)
+{
+	const int paddedSize= ((size + paddingSize - 1) / paddingSize) * paddingSize;
+	if (paddedSize != m_CenterX.size())
+	{
+		const int previousSize= m_CenterX.size();
+		m_CenterX.resize(paddedSize);
+		m_CenterY.resize(paddedSize);
+		m_CenterZ.resize(paddedSize);
+		m_ExtentX.resize(paddedSize);
+		m_ExtentY.resize(paddedSize);
+		m_ExtentZ.resize(paddedSize);
+		for (int i= previousSize; i < paddedSize; ++i)
+		{
+			m_CenterX[i]= 0.0f;
+			m_CenterY[i]= 0.0f;
+			m_CenterZ[i]= 0.0f;
+			m_ExtentX[i]= emptyExtent;
+			m_ExtentY[i]= emptyExtent;
+			m_ExtentZ[i]= emptyExtent;
+		}
+	}
+	m_Size= size;
+}
@@ -0,0 +1,125 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_frustumculler.h Interface for the GLC_FrustumCuller class.
+
+#ifndef GLC_FRUSTUMCULLER_H_
+#define GLC_FRUSTUMCULLER_H_
+
+#include <QVector>
+
+#include "glc_frustum.h"
+#include "../glc_boundingbox.h"
+#include "../glc_config.h"
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_FrustumCuller
+/*! \brief GLC_FrustumCuller : Localize a table of bounding boxes in a frustum */
+
+/*! The bounding boxes are stored in single precision structure of arrays
+ *  (centres and half extents) and localized several at a time with SSE or AVX
+ *  when available, with a scalar fallback.
+ *  A box is tested against the 6 planes of the frustum with its projected radius,
+ *  which is never greater than the bounding sphere radius used by GLC_Frustum::localizeBoundingBox*/
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_FrustumCuller
+{
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Default constructor
+	GLC_FrustumCuller();
+
+	//! Destructor
+	~GLC_FrustumCuller();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return the number of bounding boxes of this culler
+	inline int size() const
+	{return m_Size;}
+
+	//! Return true if this culler is empty
+	inline bool isEmpty() const
+	{return 0 == m_Size;}
+
+	//! Localize all bounding boxes of this culler in the given frustum
+	/*! The given vector is resized to size() and its value at index i
+	 *  is the GLC_Frustum::Localisation of the bounding box at index i*/
+	void localizeBoundingBoxes(const GLC_Frustum& frustum, QVector<quint8>* pLocalisations) const;
+
+	//! Return the number of bounding boxes localized together
+	static int batchSize();
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Remove all bounding boxes
+	void clear();
+
+	//! Reserve space for the given number of bounding boxes
+	void reserve(int size);
+
+	//! Append the given bounding box and return its index
+	/*! An empty bounding box is always localized out of the frustum*/
+	int append(const GLC_BoundingBox& boundingBox);
+
+	//! Set the bounding box at the given index
+	void setBoundingBox(int index, const GLC_BoundingBox& boundingBox);
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Private services function
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Resize the arrays, the padding of the last batch is filled with empty boxes
+	void resize(int size);
+
+//////////////////////////////////////////////////////////////////////
+// Private Member
+//////////////////////////////////////////////////////////////////////
+private:
+	//! The number of bounding boxes
+	int m_Size;
+
+	//! Bounding boxes centres
+	QVector<float> m_CenterX;
+	QVector<float> m_CenterY;
+	QVector<float> m_CenterZ;
+
+	//! Bounding boxes half extents, negative for empty boxes
+	QVector<float> m_ExtentX;
+	QVector<float> m_ExtentY;
+	QVector<float> m_ExtentZ;
+};
+
+#endif /* GLC_FRUSTUMCULLER_H_ */
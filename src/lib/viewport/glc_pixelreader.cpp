@@ -0,0 +1,252 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_pixelreader.cpp implementation of the GLC_PixelReader class.
+
+#include <QOpenGLContext>
+#include <cstring>
+
+#include "glc_pixelreader.h"
+
+namespace
+{
+// Timeout of a wait for a fence in nanoseconds
+const GLuint64 fenceTimeout= 1000000000;
+
+// Return the size in bytes of a pixel of the given format and type
+int pixelSize(GLenum format, GLenum type)
+{
+	int componentCount= 1;
+	if (GL_RGBA == format) componentCount= 4;
+	else if (GL_RGB == format) componentCount= 3;
+
+	int componentSize= 4;
+	if (GL_UNSIGNED_BYTE == type) componentSize= 1;
+	else if ((GL_UNSIGNED_SHORT == type) || (GL_HALF_FLOAT == type)) componentSize= 2;
+
+	return componentCount * componentSize;
+}
+
+// Return the size in bytes of the given pixel rectangle with a pack alignment of 4
+inline int rectangleSize(int width, int height, GLenum format, GLenum type)
+{
+	const int rowSize= ((width * pixelSize(format, type)) + 3) & ~3;
+	return rowSize * height;
+}
+}
+
+GLC_PixelReader::GLC_PixelReader(int bufferCount)
+: m_BufferCount(qMax(1, bufferCount))
+, m_Buffers()
+, m_NextBufferIndex(0)
+, m_NextReadId(0)
+, m_PendingReadCount(0)
+, m_DiscardedReads()
+, m_FinishedReads()
+{
+
+}
+
+GLC_PixelReader::~GLC_PixelReader()
+{
+	releaseBuffers();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Get Functions
+//////////////////////////////////////////////////////////////////////
+
+bool GLC_PixelReader::isAsynchronousReadSupported()
+{
+	// Pixel buffer objects are mapped with glMapBufferRange and fenced with glFenceSync
+	QOpenGLContext* pContext= QOpenGLContext::currentContext();
+	const QSurfaceFormat format= pContext->format();
+	if (pContext->isOpenGLES())
+	{
+		return format.version() >= qMakePair(3, 0);
+	}
+	else
+	{
+		return (format.version() >= qMakePair(3, 2))
+				|| ((format.version() >= qMakePair(3, 0)) && pContext->hasExtension("GL_ARB_sync"));
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set Functions
+//////////////////////////////////////////////////////////////////////
+
+bool GLC_PixelReader::takePixels(int readId, QVector<GLubyte>* pPixels)
+{
+	if (!m_FinishedReads.contains(readId)) return false;
+
+	*pPixels= m_FinishedReads.take(readId);
+
+	return true;
+}
+
+void GLC_PixelReader::discard(int readId)
+{
+	if (m_FinishedReads.remove(readId) == 0)
+	{
+		m_DiscardedReads.insert(readId);
+	}
+}
+
+void GLC_PixelReader::clear()
+{
+	m_FinishedReads.clear();
+	const int size= m_Buffers.size();
+	for (int i= 0; i < size; ++i)
+	{
+		if (NULL != m_Buffers.at(i).m_Fence) m_DiscardedReads.insert(m_Buffers.at(i).m_ReadId);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// OpenGL Functions
+//////////////////////////////////////////////////////////////////////
+
+int GLC_PixelReader::read(int x, int y, int width, int height, GLenum buffer, GLenum format, GLenum type)
+{
+	Q_ASSERT((width > 0) && (height > 0));
+	QOpenGLExtraFunctions* pFunctions= QOpenGLContext::currentContext()->extraFunctions();
+	const int readId= m_NextReadId++;
+	const int size= rectangleSize(width, height, format, type);
+
+	pFunctions->glReadBuffer(buffer);
+	if (!isAsynchronousReadSupported())
+	{
+		QVector<GLubyte>& pixels= m_FinishedReads[readId];
+		pixels.resize(size);
+		pFunctions->glReadPixels(x, y, width, height, format, type, pixels.data());
+		return readId;
+	}
+
+	if (m_Buffers.isEmpty())
+	{
+		const PixelBuffer emptyBuffer= {0, 0, 0, NULL, -1};
+		m_Buffers.fill(emptyBuffer, m_BufferCount);
+	}
+
+	// The oldest read is finished before its buffer is reused
+	PixelBuffer& pixelBuffer= m_Buffers[m_NextBufferIndex];
+	m_NextBufferIndex= (m_NextBufferIndex + 1) % m_Buffers.size();
+	if (NULL != pixelBuffer.m_Fence)
+	{
+		collectBuffer(pFunctions, &pixelBuffer, true);
+	}
+
+	if (0 == pixelBuffer.m_BufferId)
+	{
+		pFunctions->glGenBuffers(1, &(pixelBuffer.m_BufferId));
+	}
+	pFunctions->glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer.m_BufferId);
+	if (pixelBuffer.m_Capacity < size)
+	{
+		pFunctions->glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		pixelBuffer.m_Capacity= size;
+	}
+	pFunctions->glReadPixels(x, y, width, height, format, type, NULL);
+	pFunctions->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	pixelBuffer.m_Fence= pFunctions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	pixelBuffer.m_Size= size;
+	pixelBuffer.m_ReadId= readId;
+	++m_PendingReadCount;
+
+	return readId;
+}
+
+void GLC_PixelReader::collect(bool wait)
+{
+	if (0 == m_PendingReadCount) return;
+
+	QOpenGLExtraFunctions* pFunctions= QOpenGLContext::currentContext()->extraFunctions();
+	const int size= m_Buffers.size();
+	for (int i= 0; i < size; ++i)
+	{
+		PixelBuffer& pixelBuffer= m_Buffers[i];
+		if (NULL != pixelBuffer.m_Fence)
+		{
+			collectBuffer(pFunctions, &pixelBuffer, wait);
+		}
+	}
+}
+
+void GLC_PixelReader::releaseBuffers()
+{
+	if (m_Buffers.isEmpty()) return;
+
+	if (NULL != QOpenGLContext::currentContext())
+	{
+		QOpenGLExtraFunctions* pFunctions= QOpenGLContext::currentContext()->extraFunctions();
+		const int size= m_Buffers.size();
+		for (int i= 0; i < size; ++i)
+		{
+			const PixelBuffer& pixelBuffer= m_Buffers.at(i);
+			if (NULL != pixelBuffer.m_Fence) pFunctions->glDeleteSync(pixelBuffer.m_Fence);
+			if (0 != pixelBuffer.m_BufferId) pFunctions->glDeleteBuffers(1, &(pixelBuffer.m_BufferId));
+		}
+	}
+	m_Buffers.clear();
+	m_NextBufferIndex= 0;
+	m_PendingReadCount= 0;
+	m_DiscardedReads.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Private services Functions
+//////////////////////////////////////////////////////////////////////
+
+void GLC_PixelReader::collectBuffer(QOpenGLExtraFunctions* pFunctions, PixelBuffer* pBuffer, bool wait)
+{
+	Q_ASSERT(NULL != pBuffer->m_Fence);
+
+	// Commands are flushed to be sure that the fence is signaled one day
+	GLenum status= pFunctions->glClientWaitSync(pBuffer->m_Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (wait && (GL_TIMEOUT_EXPIRED == status))
+	{
+		status= pFunctions->glClientWaitSync(pBuffer->m_Fence, GL_SYNC_FLUSH_COMMANDS_BIT, fenceTimeout);
+	}
+	if (GL_TIMEOUT_EXPIRED == status) return;
+
+	pFunctions->glDeleteSync(pBuffer->m_Fence);
+	pBuffer->m_Fence= NULL;
+	--m_PendingReadCount;
+
+	// A failed wait or map gives an empty read
+	const bool isKept= !m_DiscardedReads.remove(pBuffer->m_ReadId);
+	QVector<GLubyte> pixels;
+	if (isKept && (GL_WAIT_FAILED != status))
+	{
+		pFunctions->glBindBuffer(GL_PIXEL_PACK_BUFFER, pBuffer->m_BufferId);
+		const void* pData= pFunctions->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pBuffer->m_Size, GL_MAP_READ_BIT);
+		if (NULL != pData)
+		{
+			pixels.resize(pBuffer->m_Size);
+			memcpy(pixels.data(), pData, pBuffer->m_Size);
+			pFunctions->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		pFunctions->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	if (isKept) m_FinishedReads.insert(pBuffer->m_ReadId, pixels);
+}
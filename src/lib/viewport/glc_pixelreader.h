@@ -0,0 +1,166 @@
+/****************************************************************************
+
+ This file is part of the GLC-lib library.
+ Copyright (C) 2005-2008 Laurent Ribon (laumaya@users.sourceforge.net)
+ http://glc-lib.sourceforge.net
+
+ GLC-lib is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ GLC-lib is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with GLC-lib; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*****************************************************************************/
+//! \file glc_pixelreader.h interface for the GLC_PixelReader class.
+
+#ifndef GLC_PIXELREADER_H_
+#define GLC_PIXELREADER_H_
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QtOpenGL>
+#include <QOpenGLExtraFunctions>
+
+#include "../glc_config.h"
+
+//////////////////////////////////////////////////////////////////////
+//! \class GLC_PixelReader
+/*! \brief GLC_PixelReader : Read pixels of the bound frame buffer without waiting for the GPU */
+
+/*! A read copies the pixels in one of a ring of pixel buffer objects and a fence
+ *  is inserted after the copy. The buffer is mapped only once its fence is signaled,
+ *  usually at a later frame, so the read doesn't flush the pipeline.
+ *  When the ring is full, the oldest read is waited for before its buffer is reused.
+ *  If pixel buffer objects and fences are not supported by the current context, as on
+ *  old software renderers, pixels are read synchronously and the read is finished at once.*/
+//////////////////////////////////////////////////////////////////////
+class GLC_LIB_EXPORT GLC_PixelReader
+{
+	//! A pixel buffer object of the ring
+	struct PixelBuffer
+	{
+		GLuint m_BufferId;
+		int m_Capacity;
+		int m_Size;
+		GLsync m_Fence;
+		int m_ReadId;
+	};
+
+//////////////////////////////////////////////////////////////////////
+/*! @name Constructor / Destructor */
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Construct a pixel reader with the given number of pixel buffer objects
+	GLC_PixelReader(int bufferCount= 3);
+
+	//! Destructor
+	/*! Buffers and fences are deleted if an OpenGL context is current,
+	 *  otherwise releaseBuffers() must have been called in the right context*/
+	~GLC_PixelReader();
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Get Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Return true if pixels can be read asynchronously in the current OpenGL context
+	static bool isAsynchronousReadSupported();
+
+	//! Return the number of pixel buffer objects of this reader
+	inline int bufferCount() const
+	{return m_BufferCount;}
+
+	//! Return true if a read is not finished
+	inline bool hasPendingRead() const
+	{return m_PendingReadCount > 0;}
+
+	//! Return true if the given read is finished and its pixels are not taken
+	inline bool isFinished(int readId) const
+	{return m_FinishedReads.contains(readId);}
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name Set Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Take the pixels of the given finished read, return false if it is not finished
+	/*! Rows are from bottom to top, as read by glReadPixels with the default pack alignment*/
+	bool takePixels(int readId, QVector<GLubyte>* pPixels);
+
+	//! Forget the pixels of the given read, now or when it is finished
+	void discard(int readId);
+
+	//! Forget all reads
+	void clear();
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+/*! \name OpenGL Functions*/
+//@{
+//////////////////////////////////////////////////////////////////////
+public:
+	//! Read the given rectangle of the given buffer of the bound frame buffer and return the read id
+	/*! Format and type are those of glReadPixels, as GL_RGBA and GL_UNSIGNED_BYTE
+	 *  or GL_DEPTH_COMPONENT and GL_FLOAT*/
+	int read(int x, int y, int width, int height, GLenum buffer, GLenum format= GL_RGBA, GLenum type= GL_UNSIGNED_BYTE);
+
+	//! Finish the reads whose fence is signaled, or all pending reads if wait is true
+	void collect(bool wait= false);
+
+	//! Delete the pixel buffer objects and fences of the current OpenGL context
+	/*! Pending reads are forgotten, buffers are created again by the next asynchronous read*/
+	void releaseBuffers();
+
+//@}
+
+//////////////////////////////////////////////////////////////////////
+// Private services function
+//////////////////////////////////////////////////////////////////////
+private:
+	//! Finish the read of the given buffer if its fence is signaled or if wait is true
+	void collectBuffer(QOpenGLExtraFunctions* pFunctions, PixelBuffer* pBuffer, bool wait);
+
+//////////////////////////////////////////////////////////////////////
+// Private members
+//////////////////////////////////////////////////////////////////////
+private:
+	//! The number of pixel buffer objects
+	int m_BufferCount;
+
+	//! The ring of pixel buffer objects, created at the first asynchronous read
+	QVector<PixelBuffer> m_Buffers;
+
+	//! Index of the next buffer of the ring
+	int m_NextBufferIndex;
+
+	//! Id of the next read
+	int m_NextReadId;
+
+	//! The number of reads not finished
+	int m_PendingReadCount;
+
+	//! Reads whose pixels are forgotten when they are finished
+	QSet<int> m_DiscardedReads;
+
+	//! Pixels of the finished reads
+	QHash<int, QVector<GLubyte> > m_FinishedReads;
+
+private:
+	Q_DISABLE_COPY(GLC_PixelReader)
+};
+
+#endif /* GLC_PIXELREADER_H_ */
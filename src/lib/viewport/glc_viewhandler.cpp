@@ -54,8 +54,10 @@ GLC_ViewHandler::GLC_ViewHandler(QObject *pParent)
     , m_UnprojectedPoint()
     , m_3DWidgetManager(m_pViewport)
     , m_isRendering()
+    , m_AsynchronousSelection(false)
 
     , m_ScreenShotMode(false)
+    , m_AsynchronousScreenShot(false)
     , m_ScreenshotSettings()
     , m_ScreenShotImage()
 
@@ -178,6 +180,29 @@ QPair<GLC_SelectionSet, GLC_Point3d> GLC_ViewHandler::selectAndUnproject(int x,
     return subject;
 }
 
+void GLC_ViewHandler::requestSelection(int x, int y, GLC_SelectionEvent::Modes modes)
+{
+    m_RenderingMode= GLC_ViewHandler::selectRenderMode;
+    m_AsynchronousSelection= true;
+    m_PointerPosition.setX(x);
+    m_PointerPosition.setY(y);
+    m_SelectionModes= modes;
+    updateGL();
+}
+
+void GLC_ViewHandler::asynchronousSelectionIssued()
+{
+    m_RenderingMode= GLC_ViewHandler::normalRenderMode;
+    m_AsynchronousSelection= false;
+}
+
+void GLC_ViewHandler::setAsynchronousSelection(const GLC_SelectionSet& selectionSet, const GLC_Point3d& point)
+{
+    m_CurrentSelectionSet= selectionSet;
+    m_UnprojectedPoint= point;
+    emit asynchronousSelectionAvailable();
+}
+
 void GLC_ViewHandler::unsetSelection()
 {
     m_RenderingMode= GLC_ViewHandler::normalRenderMode;
@@ -204,6 +229,26 @@ QImage GLC_ViewHandler::takeScreenshot(const GLC_ScreenShotSettings &screenShotS
     return m_ScreenShotImage;
 }
 
+void GLC_ViewHandler::requestScreenshot(const GLC_ScreenShotSettings &screenShotSettings)
+{
+    m_ScreenshotSettings= screenShotSettings;
+    m_ScreenShotMode= true;
+    m_AsynchronousScreenShot= true;
+    updateGL();
+}
+
+void GLC_ViewHandler::asynchronousScreenShotIssued()
+{
+    m_ScreenShotMode= false;
+    m_AsynchronousScreenShot= false;
+}
+
+void GLC_ViewHandler::setAsynchronousScreenShot(const QImage &image)
+{
+    m_ScreenShotImage= image;
+    emit asynchronousScreenShotAvailable();
+}
+
 void GLC_ViewHandler::setSize(int width, int height)
 {
     m_pViewport->setWinGLSize(width, height);
@@ -296,7 +341,7 @@ void GLC_ViewHandler::render()
 
         // Calculate camera depth of view
         m_pViewport->setDistMinAndMax(m_World.boundingBox());
-        m_World.collection()->updateInstanceViewableState();
+        m_World.collection()->prepareFrame();
 
         renderBackGround();
 
@@ -316,6 +361,7 @@ void GLC_ViewHandler::render()
         m_World.render(0, m_RenderFlag);
         m_World.render(0, glc::TransparentRenderFlag);
         m_World.render(1, m_RenderFlag);
+        m_World.collection()->endFrame();
 
         if (!GLC_State::isInSelectionMode())
         {
@@ -64,6 +64,8 @@ signals :
     void invalidateSelectionBuffer();
     void acceptHoverEvent(bool track);
     void selectionChanged();
+    void asynchronousSelectionAvailable();
+    void asynchronousScreenShotAvailable();
 
     // Error signals
     void frameBufferCreationFailed();
@@ -102,6 +104,18 @@ public:
     inline QPoint pointerPosition() const
     {return m_PointerPosition;}
 
+    inline const GLC_SelectionSet& currentSelectionSet() const
+    {return m_CurrentSelectionSet;}
+
+    inline GLC_Point3d unprojectedPoint() const
+    {return m_UnprojectedPoint;}
+
+    inline bool selectionIsAsynchronous() const
+    {return m_AsynchronousSelection;}
+
+    inline bool screenShotIsAsynchronous() const
+    {return m_AsynchronousScreenShot;}
+
     inline GLC_InputEventInterpreter* eventInterpreter() const
     {return m_pInputEventInterpreter;}
 
@@ -152,12 +166,33 @@ public:
 
     virtual QPair<GLC_SelectionSet, GLC_Point3d> selectAndUnproject(int x, int y, GLC_SelectionEvent::Modes modes);
 
+    //! Select and unproject without waiting for the rendering
+    /*! asynchronousSelectionAvailable() is emitted when the selection set and the point are available,
+     *  usually a few frames later. Only instance selection doesn't wait for the GPU*/
+    virtual void requestSelection(int x, int y, GLC_SelectionEvent::Modes modes);
+
+    //! Called by the view when the pixels of the requested selection are being read
+    void asynchronousSelectionIssued();
+
+    //! Called by the view when the requested selection is available
+    void setAsynchronousSelection(const GLC_SelectionSet& selectionSet, const GLC_Point3d& point);
+
     virtual void unsetSelection();
 
     virtual void selectionUpdated(const GLC_SelectionEvent &selectionEvent);
 
     virtual QImage takeScreenshot(const GLC_ScreenShotSettings& screenShotSettings);
 
+    //! Take a screenshot without waiting for the rendering
+    /*! asynchronousScreenShotAvailable() is emitted when screenShotImage() is available*/
+    virtual void requestScreenshot(const GLC_ScreenShotSettings& screenShotSettings);
+
+    //! Called by the view when the pixels of the requested screenshot are being read
+    void asynchronousScreenShotIssued();
+
+    //! Called by the view when the requested screenshot is available
+    void setAsynchronousScreenShot(const QImage& image);
+
     virtual void setSize(int width, int height);
 
     virtual void setMouseTracking(bool track);
@@ -233,8 +268,10 @@ protected:
     GLC_Point3d m_UnprojectedPoint;
     GLC_3DWidgetManager m_3DWidgetManager;
     bool m_isRendering;
+    bool m_AsynchronousSelection;
 
     bool m_ScreenShotMode;
+    bool m_AsynchronousScreenShot;
     GLC_ScreenShotSettings m_ScreenshotSettings;
     QImage m_ScreenShotImage;
 
@@ -37,7 +37,92 @@
 
 #include <QtDebug>
 
+#include <algorithm>
+
 using namespace glc;
+
+namespace
+{
+// Return the orientation of the triangle (p0, p1, p2)
+inline double orientation(const QPointF& p0, const QPointF& p1, const QPointF& p2)
+{
+	return ((p1.x() - p0.x()) * (p2.y() - p0.y())) - ((p1.y() - p0.y()) * (p2.x() - p0.x()));
+}
+
+// Return true if an edge of the first polygon crosses an edge of the second polygon
+bool polygonEdgesCross(const QPolygonF& polygon1, const QPolygonF& polygon2)
+{
+	const int size1= polygon1.size();
+	const int size2= polygon2.size();
+	for (int i= 0; i < size1; ++i)
+	{
+		const QPointF& p0= polygon1.at(i);
+		const QPointF& p1= polygon1.at((i + 1) % size1);
+		for (int j= 0; j < size2; ++j)
+		{
+			const QPointF& q0= polygon2.at(j);
+			const QPointF& q1= polygon2.at((j + 1) % size2);
+			if (((orientation(p0, p1, q0) * orientation(p0, p1, q1)) < 0.0) && ((orientation(q0, q1, p0) * orientation(q0, q1, p1)) < 0.0))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Lexicographic order of points
+inline bool pointLessThan(const QPointF& p0, const QPointF& p1)
+{
+	return (p0.x() < p1.x()) || ((p0.x() == p1.x()) && (p0.y() < p1.y()));
+}
+
+// Return the convex hull of the given points
+QPolygonF convexHull(QVector<QPointF> points)
+{
+	std::sort(points.begin(), points.end(), pointLessThan);
+
+	// Andrew's monotone chain
+	const int size= points.size();
+	QVector<QPointF> hull(2 * size);
+	int count= 0;
+	for (int i= 0; i < size; ++i)
+	{
+		while ((count >= 2) && (orientation(hull.at(count - 2), hull.at(count - 1), points.at(i)) <= 0.0)) --count;
+		hull[count++]= points.at(i);
+	}
+	const int lowerCount= count + 1;
+	for (int i= size - 2; i >= 0; --i)
+	{
+		while ((count >= lowerCount) && (orientation(hull.at(count - 2), hull.at(count - 1), points.at(i)) <= 0.0)) --count;
+		hull[count++]= points.at(i);
+	}
+	hull.resize(qMax(1, count - 1));
+
+	return QPolygonF(hull);
+}
+
+// Project the corners of the given bounding box in window coordinates
+// Return false if a corner is behind the eye
+bool projectCorners(const double* pMatrix, const GLC_BoundingBox& boundingBox, int width, int height, QVector<QPointF>* pCorners)
+{
+	const GLC_Point3d& lower= boundingBox.lowerCorner();
+	const GLC_Point3d& upper= boundingBox.upperCorner();
+	pCorners->resize(8);
+	for (int i= 0; i < 8; ++i)
+	{
+		const double x= (i & 1) ? upper.x() : lower.x();
+		const double y= (i & 2) ? upper.y() : lower.y();
+		const double z= (i & 4) ? upper.z() : lower.z();
+		const double w= (pMatrix[3] * x) + (pMatrix[7] * y) + (pMatrix[11] * z) + pMatrix[15];
+		if (w <= glc::EPSILON) return false;
+		const double clipX= (pMatrix[0] * x) + (pMatrix[4] * y) + (pMatrix[8] * z) + pMatrix[12];
+		const double clipY= (pMatrix[1] * x) + (pMatrix[5] * y) + (pMatrix[9] * z) + pMatrix[13];
+		(*pCorners)[i]= QPointF(((clipX / w) + 1.0) * 0.5 * width, (1.0 - (clipY / w)) * 0.5 * height);
+	}
+	return true;
+}
+}
 //////////////////////////////////////////////////////////////////////
 // Constructor Destructor
 //////////////////////////////////////////////////////////////////////
@@ -65,7 +150,11 @@ GLC_Viewport::GLC_Viewport()
     , m_MinimumStaticPixelSize(10)
     , m_MinimumStaticRatioSize(0.0)
     , m_MinimumDynamicRatioSize(0.0)
+    , m_ScreenSpaceError(1.0)
+    , m_LodHysteresis(0.7)
+    , m_TriangleBudget(0)
     , m_TextRenderingCollection()
+    , m_SelectionBuffer()
 {
 
 }
@@ -154,6 +243,68 @@ GLC_Vector3d GLC_Viewport::mapNormalyzePosMouse(double Posx, double Posy) const
 	return mapPosMouse(screenX, screenY);
 }
 
+GLC_Line3d GLC_Viewport::pickingRay(int x, int y) const
+{
+	// Unproject the pixel center on the near and far planes
+	const GLC_Matrix4x4 inverseMatrix(compositionMatrix().inverted());
+	const double normalizedX= ((2.0 * (static_cast<double>(x) + 0.5)) / static_cast<double>(m_Width)) - 1.0;
+	const double normalizedY= 1.0 - ((2.0 * (static_cast<double>(y) + 0.5)) / static_cast<double>(m_Height));
+	const GLC_Point3d nearPoint(inverseMatrix * GLC_Point3d(normalizedX, normalizedY, -1.0));
+	const GLC_Point3d farPoint(inverseMatrix * GLC_Point3d(normalizedX, normalizedY, 1.0));
+
+	return GLC_Line3d(nearPoint, (farPoint - nearPoint).normalize());
+}
+
+QRect GLC_Viewport::selectionSquare(int x, int y) const
+{
+	GLsizei width= m_SelectionSquareSize;
+	GLsizei height= width;
+	GLint newX= x - width / 2;
+    GLint newY= (m_Height - y) - height / 2;
+	if (newX < 0) newX= 0;
+	if (newY < 0) newY= 0;
+
+	return QRect(newX, newY, width, height);
+}
+
+GLC_uint GLC_Viewport::meaningfullId(const QVector<GLubyte>& colorId)
+{
+	const int squareSize= colorId.size() / 4; // 4 -> R G B A
+	QHash<GLC_uint, int> idHash;
+	QList<int> idWeight;
+
+	// Find the most meaningful color
+	GLC_uint returnId= 0;
+	// There is nothing at the center
+	int maxWeight= 0;
+	int currentIndex= 0;
+	for (int i= 0; i < squareSize; ++i)
+	{
+		GLC_uint id= glc::decodeRgbId(&colorId.at(i * 4));
+		if (idHash.contains(id))
+		{
+			const int currentWeight= ++(idWeight[idHash.value(id)]);
+			if (maxWeight < currentWeight)
+			{
+				returnId= id;
+				maxWeight= currentWeight;
+			}
+		}
+		else if (id != 0)
+		{
+			idHash.insert(id, currentIndex++);
+			idWeight.append(1);
+			if (maxWeight < 1)
+			{
+				returnId= id;
+				maxWeight= 1;
+			}
+		}
+	}
+
+	return returnId;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Public OpenGL Functions
 //////////////////////////////////////////////////////////////////////
@@ -309,6 +460,33 @@ GLC_Frustum GLC_Viewport::selectionFrustum(int x, int y) const
 	return selectionFrustum;
 }
 
+GLC_Frustum GLC_Viewport::selectionFrustum(int x1, int y1, int x2, int y2) const
+{
+	// Normalized device coordinates of the rectangle, at least one pixel wide
+	const int xMin= qMin(x1, x2);
+	const int xMax= qMax(qMax(x1, x2), xMin + 1);
+	const int yMin= qMin(y1, y2);
+	const int yMax= qMax(qMax(y1, y2), yMin + 1);
+	const double left= ((2.0 * static_cast<double>(xMin)) / static_cast<double>(m_Width)) - 1.0;
+	const double right= ((2.0 * static_cast<double>(xMax)) / static_cast<double>(m_Width)) - 1.0;
+	const double top= 1.0 - ((2.0 * static_cast<double>(yMin)) / static_cast<double>(m_Height));
+	const double bottom= 1.0 - ((2.0 * static_cast<double>(yMax)) / static_cast<double>(m_Height));
+
+	// Map the rectangle on the whole clipping volume
+	double pickMatrix[16]= {0.0};
+	pickMatrix[0]= 2.0 / (right - left);
+	pickMatrix[5]= 2.0 / (top - bottom);
+	pickMatrix[10]= 1.0;
+	pickMatrix[12]= -(right + left) / (right - left);
+	pickMatrix[13]= -(top + bottom) / (top - bottom);
+	pickMatrix[15]= 1.0;
+
+	GLC_Frustum selectionFrustum;
+	selectionFrustum.update(GLC_Matrix4x4(pickMatrix) * compositionMatrix());
+
+	return selectionFrustum;
+}
+
 GLC_Point3d GLC_Viewport::unproject(int x, int y, GLenum buffer, bool onGeometry) const
 {
     GLC_Point3d subject;
@@ -319,6 +497,13 @@ GLC_Point3d GLC_Viewport::unproject(int x, int y, GLenum buffer, bool onGeometry
     glReadBuffer(buffer);
     glReadPixels(x, m_Height - y , 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &Depth);
 
+    return unprojectDepth(x, y, Depth, onGeometry);
+}
+
+GLC_Point3d GLC_Viewport::unprojectDepth(int x, int y, GLfloat Depth, bool onGeometry) const
+{
+    GLC_Point3d subject;
+
     // if on geometry mode and the point is not on geometry return null point
     if (!qFuzzyCompare(Depth, 1.0f) || !onGeometry)
     {
@@ -555,14 +740,9 @@ GLC_uint GLC_Viewport::renderAndSelect(int x, int y, GLenum buffer)
 
 GLC_uint GLC_Viewport::selectOnPreviousRender(int x, int y, GLenum buffer)
 {
-	GLsizei width= m_SelectionSquareSize;
-	GLsizei height= width;
-	GLint newX= x - width / 2;
-    GLint newY= (m_Height - y) - height / 2;
-	if (newX < 0) newX= 0;
-	if (newY < 0) newY= 0;
+	const QRect square(selectionSquare(x, y));
 
-    return meaningfullIdInsideSquare(newX, newY, width, height, buffer);
+    return meaningfullIdInsideSquare(square.x(), square.y(), square.width(), square.height(), buffer);
 }
 GLC_uint GLC_Viewport::selectBody(GLC_3DViewInstance* pInstance, int x, int y, GLenum buffer)
 {
@@ -671,63 +851,84 @@ QSet<GLC_uint> GLC_Viewport::selectInsideSquare(int x1, int y1, int x2, int y2,
     return listOfIdInsideSquare(newX, newY, width, height, buffer);
 }
 
-GLC_uint GLC_Viewport::meaningfullIdInsideSquare(GLint x, GLint y, GLsizei width, GLsizei height, GLenum buffer)
+QSet<GLC_uint> GLC_Viewport::selectInsideSquare(GLC_3DViewCollection* pCollection, int x1, int y1, int x2, int y2, bool fullyInside) const
 {
-	const int squareSize= width * height;
-	const GLsizei arraySize= squareSize * 4; // 4 -> R G B A
-	QVector<GLubyte> colorId(arraySize);
-
-	// Get the array of pixels
-    glReadBuffer(buffer);
-	glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, colorId.data());
-
-	// Restore Background color
-	glClearColor(m_BackgroundColor.redF(), m_BackgroundColor.greenF(), m_BackgroundColor.blueF(), 1.0f);
-
-	QHash<GLC_uint, int> idHash;
-	QList<int> idWeight;
+	Q_ASSERT(NULL != pCollection);
+	return pCollection->instancesInsideFrustum(selectionFrustum(x1, y1, x2, y2), fullyInside);
+}
 
-	// Find the most meaningful color
-	GLC_uint returnId= 0;
-	// There is nothing at the center
-	int maxWeight= 0;
-	int currentIndex= 0;
-	for (int i= 0; i < squareSize; ++i)
+QSet<GLC_uint> GLC_Viewport::selectInsidePolygon(GLC_3DViewCollection* pCollection, const QPolygon& polygon, bool fullyInside) const
+{
+	Q_ASSERT(NULL != pCollection);
+	QSet<GLC_uint> selectedSet;
+	if (polygon.size() < 3) return selectedSet;
+
+	// Instances of the polygon bounding rectangle
+	const QRect rect(polygon.boundingRect());
+	const QSet<GLC_uint> candidateSet(selectInsideSquare(pCollection, rect.left(), rect.top(), rect.right() + 1, rect.bottom() + 1, fullyInside));
+
+	// Compare the candidates bounding box silhouette with the polygon
+	const QPolygonF lasso(polygon);
+	const GLC_Matrix4x4 matrix(compositionMatrix());
+	QVector<QPointF> corners;
+	QSet<GLC_uint>::const_iterator iId= candidateSet.constBegin();
+	while (candidateSet.constEnd() != iId)
 	{
-		GLC_uint id= glc::decodeRgbId(&colorId[i * 4]);
-		if (idHash.contains(id))
+		const GLC_uint id= *iId;
+		++iId;
+		if (!projectCorners(matrix.getData(), pCollection->instanceHandle(id)->boundingBox(), m_Width, m_Height, &corners))
 		{
-			const int currentWeight= ++(idWeight[idHash.value(id)]);
-			if (maxWeight < currentWeight)
-			{
-				returnId= id;
-				maxWeight= currentWeight;
-			}
+			// The bounding box crosses the eye plane
+			if (!fullyInside) selectedSet.insert(id);
+			continue;
 		}
-		else if (id != 0)
+		const QPolygonF silhouette(convexHull(corners));
+		bool isSelected= false;
+		if (fullyInside)
 		{
-			idHash.insert(id, currentIndex++);
-			idWeight.append(1);
-			if (maxWeight < 1)
+			isSelected= !polygonEdgesCross(lasso, silhouette);
+			const int size= silhouette.size();
+			for (int i= 0; isSelected && (i < size); ++i)
 			{
-				returnId= id;
-				maxWeight= 1;
+				isSelected= lasso.containsPoint(silhouette.at(i), Qt::OddEvenFill);
 			}
 		}
+		else
+		{
+			isSelected= lasso.containsPoint(silhouette.first(), Qt::OddEvenFill) || silhouette.containsPoint(lasso.first(), Qt::OddEvenFill)
+					|| polygonEdgesCross(lasso, silhouette);
+		}
+		if (isSelected) selectedSet.insert(id);
 	}
 
-	return returnId;
+	return selectedSet;
+}
+
+GLC_uint GLC_Viewport::meaningfullIdInsideSquare(GLint x, GLint y, GLsizei width, GLsizei height, GLenum buffer)
+{
+	const int squareSize= width * height;
+	const GLsizei arraySize= squareSize * 4; // 4 -> R G B A
+	m_SelectionBuffer.resize(arraySize);
+
+	// Get the array of pixels
+    glReadBuffer(buffer);
+	glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, m_SelectionBuffer.data());
+
+	// Restore Background color
+	glClearColor(m_BackgroundColor.redF(), m_BackgroundColor.greenF(), m_BackgroundColor.blueF(), 1.0f);
+
+	return meaningfullId(m_SelectionBuffer);
 }
 
 QSet<GLC_uint> GLC_Viewport::listOfIdInsideSquare(GLint x, GLint y, GLsizei width, GLsizei height, GLenum buffer)
 {
 	const int squareSize= width * height;
 	const GLsizei arraySize= squareSize * 4; // 4 -> R G B A
-	QVector<GLubyte> colorId(arraySize);
+	m_SelectionBuffer.resize(arraySize);
 
 	// Get the array of pixels
     glReadBuffer(buffer);
-	glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, colorId.data());
+	glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, m_SelectionBuffer.data());
 
 	// Restore Background color
 	glClearColor(m_BackgroundColor.redF(), m_BackgroundColor.greenF(), m_BackgroundColor.blueF(), 1.0f);
@@ -737,7 +938,7 @@ QSet<GLC_uint> GLC_Viewport::listOfIdInsideSquare(GLint x, GLint y, GLsizei widt
 	// get the color inside square
 	for (int i= 0; i < squareSize; ++i)
 	{
-		GLC_uint id= glc::decodeRgbId(&colorId[i * 4]);
+		GLC_uint id= glc::decodeRgbId(&m_SelectionBuffer.at(i * 4));
 		idSet << id;
 	}
 
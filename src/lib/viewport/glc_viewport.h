@@ -28,12 +28,14 @@
 #include <QPair>
 #include <QHash>
 #include <QObject>
+#include <QPolygon>
 
 #include "glc_camera.h"
 #include "glc_imageplane.h"
 #include "../glc_boundingbox.h"
 #include "glc_frustum.h"
 #include "../maths/glc_plane.h"
+#include "../maths/glc_line3d.h"
 #include "../sceneGraph/glc_3dviewcollection.h"
 
 #include "../glc_config.h"
@@ -115,6 +117,10 @@ public:
 	//! Map normalyse Screen position to OpenGL position (On image Plane) according to this viewport
 	GLC_Vector3d mapNormalyzePosMouse(double Posx, double Posy) const;
 
+	//! Return the ray from the near plane through the given screen position
+	/*! The ray can be picked with GLC_RayPicker, this function doesn't use OpenGL*/
+	GLC_Line3d pickingRay(int x, int y) const;
+
 	//! Get this viewport's camera's angle of view
 	inline double viewAngle() const
 	{ return m_ViewAngle;}
@@ -140,6 +146,12 @@ public:
 	inline GLsizei selectionSquareSize() const
 	{return m_SelectionSquareSize;}
 
+	//! Return the selection square of the given screen position in OpenGL window coordinates
+	QRect selectionSquare(int x, int y) const;
+
+	//! Return the most frequent non null color ID of the given RGBA pixels
+	static GLC_uint meaningfullId(const QVector<GLubyte>& colorId);
+
 	//! Return this viewport's the projection matrix
 	inline GLC_Matrix4x4 projectionMatrix() const
 	{return m_ProjectionMatrix;}
@@ -167,6 +179,18 @@ public:
 	inline double minimumDynamicPixelCullingRatio() const
 	{return m_MinimumDynamicRatioSize;}
 
+	//! Return the maximum screen space error in pixels of the LOD chosen from their accuracy
+	inline double screenSpaceError() const
+	{return m_ScreenSpaceError;}
+
+	//! Return the ratio of the screen space error under which a coarser LOD is chosen
+	inline double lodHysteresis() const
+	{return m_LodHysteresis;}
+
+	//! Return the maximum number of triangles drawn by frame, 0 if there is no limit
+	inline unsigned int triangleBudget() const
+	{return m_TriangleBudget;}
+
 //@}
 
 //////////////////////////////////////////////////////////////////////
@@ -196,9 +220,17 @@ public:
 	//! Return the frustum associated to a selection coordinate
 	GLC_Frustum selectionFrustum(int, int) const;
 
+	//! Return the frustum associated to the given selection rectangle
+	/*! The rectangle corners are given in window coordinates, nothing is read from OpenGL*/
+	GLC_Frustum selectionFrustum(int x1, int y1, int x2, int y2) const;
+
 	//! Return the world 3d point from the given screen coordinate
     GLC_Point3d unproject(int, int, GLenum buffer= GL_FRONT, bool onGeometry= false) const;
 
+	//! Return the world 3d point from the given screen coordinate and depth buffer value
+	/*! The depth can come from an asynchronous read, nothing is read from OpenGL*/
+	GLC_Point3d unprojectDepth(int x, int y, GLfloat depth, bool onGeometry= false) const;
+
     //! Return the screen coordinate from the world 3D point
     GLC_Point2d project(const GLC_Point3d& point, bool useCameraMatrix= true) const;
 
@@ -264,6 +296,17 @@ public:
 	//! Select objects inside specified square and return its UID in a set
     QSet<GLC_uint> selectInsideSquare(int x1, int y1, int x2, int y2, GLenum buffer= GL_BACK);
 
+	//! Return the UID of the given collection instances inside the specified square
+	/*! Nothing is rendered : the instances bounding boxes are localized in the square selection frustum.
+	 *  If fullyInside is true, only instances with a bounding box inside the square are returned*/
+	QSet<GLC_uint> selectInsideSquare(GLC_3DViewCollection* pCollection, int x1, int y1, int x2, int y2, bool fullyInside= false) const;
+
+	//! Return the UID of the given collection instances inside the specified polygon
+	/*! The polygon is a lasso in window coordinates, implicitly closed.
+	 *  Nothing is rendered : the instances of the polygon bounding rectangle are kept if the
+	 *  screen silhouette of their bounding box overlaps the polygon, or is inside it if fullyInside is true*/
+	QSet<GLC_uint> selectInsidePolygon(GLC_3DViewCollection* pCollection, const QPolygon& polygon, bool fullyInside= false) const;
+
 	//! load background image from file in this viewport
     void loadBackGroundImage(const QString& imageFile, bool preserveRatio= false);
 
@@ -335,6 +378,21 @@ public:
 		m_MinimumStaticPixelSize= size;
 		updateMinimumRatioSize();
 	}
+
+	//! Set the maximum screen space error in pixels of the LOD chosen from their accuracy
+	/*! Used if GLC_State::isScreenSpaceErrorLodActivated()*/
+	inline void setScreenSpaceError(double error)
+	{m_ScreenSpaceError= error;}
+
+	//! Set the ratio of the screen space error under which a coarser LOD is chosen
+	/*! The ratio must be in the range ]0, 1], a lower ratio avoids LOD popping*/
+	inline void setLodHysteresis(double ratio)
+	{m_LodHysteresis= ratio;}
+
+	//! Set the maximum number of triangles drawn by frame, 0 if there is no limit
+	/*! The farthest bodies use their coarsest LOD until the budget is reached*/
+	inline void setTriangleBudget(unsigned int count)
+	{m_TriangleBudget= count;}
 //@}
 
 
@@ -436,8 +494,20 @@ private:
 	//! The minimum dynamic size ratio
 	double m_MinimumDynamicRatioSize;
 
+	//! The maximum screen space error of LOD in pixels
+	double m_ScreenSpaceError;
+
+	//! The screen space error ratio under which a coarser LOD is chosen
+	double m_LodHysteresis;
+
+	//! The maximum number of triangles drawn by frame
+	unsigned int m_TriangleBudget;
+
     //! Text rendering collection
     GLC_3DViewCollection m_TextRenderingCollection;
+
+	//! The color ID read in selection, kept to avoid allocations
+	QVector<GLubyte> m_SelectionBuffer;
 };
 
 GLC_Matrix4x4 GLC_Viewport::compositionMatrix() const